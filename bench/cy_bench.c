@@ -0,0 +1,912 @@
+/// Microbenchmarks of the Cy core hot paths. The core runs on an in-memory platform without a transport,
+/// so only the cost of the core logic itself is measured. The virtual time is frozen, the PRNG is seeded,
+/// and the parameters of every case are fixed, so the work done per operation is identical between runs.
+///
+/// The results are printed to stdout in the JSON Lines format, one object per case, to allow automatic comparison
+/// between releases. The first line describes the configuration of the core, since it affects the results.
+///
+/// Usage: cy_bench [name_filter [min_sample_ms]]
+/// Only the cases whose name contains the filter substring are run; an empty filter matches all.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+/// Enable clock_gettime().
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#endif
+
+#include "cy_platform.h"
+#include "cy_wire.h"
+#include <time.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#define SAMPLE_COUNT          5U
+#define MIN_SAMPLE_DEFAULT_ms 50U
+#define NAMESPACE             "bench"
+#define NODE_ID_BLOOM_WORDS   16U
+#define PAYLOAD_SIZE          8U
+#define TOPIC_AGE_OLD         (1ULL << 30U) ///< Old enough to win every arbitration against the remote topics below.
+
+static const char*   g_filter        = "";
+static uint64_t      g_min_sample_ns = MIN_SAMPLE_DEFAULT_ms * 1000000ULL;
+static const cy_us_t g_now           = 1000000000LL;
+
+/// Keeps the results observable so that the compiler cannot elide the work.
+static volatile size_t g_sink;
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                      PLATFORM
+// ---------------------------------------------------------------------------------------------------------------------
+
+/// Every allocation made by a node is tracked so that all of them can be freed at once when the node is destroyed,
+/// because the core does not implement cy_destroy() yet. The live size is tracked for the memory footprint cases.
+typedef union block_t
+{
+    struct
+    {
+        union block_t* prev;
+        union block_t* next;
+        size_t         size;
+    } link;
+    max_align_t _align_;
+} block_t;
+
+typedef struct
+{
+    cy_t         cy; ///< Shall be the first field.
+    cy_bloom64_t bloom;
+    uint64_t     bloom_storage[NODE_ID_BLOOM_WORDS * CY_BLOOM64_GENERATIONS];
+    uint64_t     prng_state;
+    block_t*     blocks;
+    size_t       bytes; ///< The total size of the live allocations excluding the headers.
+} node_t;
+
+// This is required because the core is built with tracing enabled. The output is discarded.
+void cy_trace(cy_t* const         cy,
+              const char* const   file,
+              const uint_fast16_t line,
+              const char* const   func,
+              const char* const   format,
+              ...)
+{
+    (void)cy;
+    (void)file;
+    (void)line;
+    (void)func;
+    (void)format;
+}
+
+static void fatal(const char* const format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    (void)vfprintf(stderr, format, ap);
+    va_end(ap);
+    (void)fputc('\n', stderr);
+    exit(1);
+}
+
+static void block_link(node_t* const node, block_t* const block)
+{
+    block->link.prev = NULL;
+    block->link.next = node->blocks;
+    if (node->blocks != NULL) {
+        node->blocks->link.prev = block;
+    }
+    node->blocks = block;
+    node->bytes += block->link.size;
+}
+
+static void block_unlink(node_t* const node, block_t* const block)
+{
+    if (block->link.prev != NULL) {
+        block->link.prev->link.next = block->link.next;
+    } else {
+        node->blocks = block->link.next;
+    }
+    if (block->link.next != NULL) {
+        block->link.next->link.prev = block->link.prev;
+    }
+    node->bytes -= block->link.size;
+}
+
+static void* platform_realloc(cy_t* const cy, void* const ptr, const size_t size)
+{
+    node_t* const node  = (node_t*)cy;
+    block_t*      block = (ptr != NULL) ? (((block_t*)ptr) - 1) : NULL;
+    if (block != NULL) {
+        block_unlink(node, block);
+    }
+    if (size == 0) {
+        free(block);
+        return NULL;
+    }
+    block_t* const out = realloc(block, sizeof(block_t) + size);
+    if (out == NULL) {
+        if (block != NULL) {
+            block_link(node, block); // The old block remains valid.
+        }
+        return NULL;
+    }
+    out->link.size = size;
+    block_link(node, out);
+    return out + 1;
+}
+
+static cy_us_t platform_now(const cy_t* const cy)
+{
+    (void)cy;
+    return g_now;
+}
+
+/// SplitMix64.
+static uint64_t platform_prng(const cy_t* const cy)
+{
+    node_t* const node = (node_t*)cy;
+    uint64_t      z    = (node->prng_state += 0x9E3779B97F4A7C15ULL);
+    z                  = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z                  = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+}
+
+/// The payloads fed into the core are static, so there is nothing to free.
+static void platform_buffer_release(cy_t* const cy, const cy_buffer_owned_t buf)
+{
+    (void)cy;
+    (void)buf;
+}
+
+static cy_err_t platform_node_id_set(cy_t* const cy)
+{
+    (void)cy;
+    return CY_OK;
+}
+
+static void platform_node_id_clear(cy_t* const cy)
+{
+    (void)cy;
+}
+
+static cy_bloom64_t* platform_node_id_bloom(cy_t* const cy)
+{
+    return &((node_t*)cy)->bloom;
+}
+
+static cy_err_t platform_p2p(cy_t* const                  cy,
+                             const uint16_t               service_id,
+                             const cy_transfer_metadata_t metadata,
+                             const cy_us_t                tx_deadline,
+                             const cy_buffer_borrowed_t   payload)
+{
+    (void)cy;
+    (void)service_id;
+    (void)metadata;
+    (void)tx_deadline;
+    (void)payload;
+    return CY_OK;
+}
+
+static cy_topic_t* platform_topic_new(cy_t* const cy)
+{
+    cy_topic_t* const topic = platform_realloc(cy, NULL, sizeof(cy_topic_t));
+    if (topic != NULL) {
+        memset(topic, 0, sizeof(*topic));
+    }
+    return topic;
+}
+
+static void platform_topic_destroy(cy_t* const cy, cy_topic_t* const topic)
+{
+    (void)platform_realloc(cy, topic, 0);
+}
+
+static cy_err_t platform_topic_publish(cy_t* const                cy,
+                                       cy_publisher_t* const      pub,
+                                       const cy_us_t              tx_deadline,
+                                       const uint64_t             transfer_id,
+                                       const cy_buffer_borrowed_t payload)
+{
+    (void)cy;
+    (void)pub;
+    (void)tx_deadline;
+    (void)transfer_id;
+    g_sink += payload.view.size;
+    return CY_OK;
+}
+
+static cy_err_t platform_topic_subscribe(cy_t* const                    cy,
+                                         cy_topic_t* const              topic,
+                                         const cy_subscription_params_t params)
+{
+    (void)cy;
+    (void)topic;
+    (void)params;
+    return CY_OK;
+}
+
+static void platform_topic_unsubscribe(cy_t* const cy, cy_topic_t* const topic)
+{
+    (void)cy;
+    (void)topic;
+}
+
+static void platform_topic_advertise(cy_t* const cy, cy_topic_t* const topic, const size_t response_extent)
+{
+    (void)cy;
+    (void)topic;
+    (void)response_extent;
+}
+
+static void platform_topic_on_subscription_error(cy_t* const cy, cy_topic_t* const topic, const cy_err_t error)
+{
+    (void)cy;
+    (void)topic;
+    fatal("Subscription error %d", error);
+}
+
+static const cy_platform_t g_platform = {
+    .now                         = platform_now,
+    .realloc                     = platform_realloc,
+    .prng                        = platform_prng,
+    .buffer_release              = platform_buffer_release,
+    .node_id_set                 = platform_node_id_set,
+    .node_id_clear               = platform_node_id_clear,
+    .node_id_bloom               = platform_node_id_bloom,
+    .p2p                         = platform_p2p,
+    .topic_new                   = platform_topic_new,
+    .topic_destroy               = platform_topic_destroy,
+    .topic_publish               = platform_topic_publish,
+    .topic_subscribe             = platform_topic_subscribe,
+    .topic_unsubscribe           = platform_topic_unsubscribe,
+    .topic_advertise             = platform_topic_advertise,
+    .topic_on_subscription_error = platform_topic_on_subscription_error,
+    .node_id_max                 = 65534U,
+    .transfer_id_mask            = UINT64_MAX,
+};
+
+/// The node is joined from the start because the node-ID is given explicitly.
+static node_t* node_new(const uint64_t uid, const uint16_t node_id)
+{
+    node_t* const node = calloc(1, sizeof(node_t));
+    if (node == NULL) {
+        fatal("Out of memory");
+    }
+    node->bloom = (cy_bloom64_t){ .n_bits = NODE_ID_BLOOM_WORDS * 64U, .popcount = 0, .storage = node->bloom_storage };
+    node->prng_state   = uid;
+    node->blocks       = NULL;
+    const cy_err_t res = cy_new(&node->cy, &g_platform, uid, node_id, wkv_key(NAMESPACE));
+    if (res != CY_OK) {
+        fatal("cy_new failed: %d", res);
+    }
+    return node;
+}
+
+static void node_destroy(node_t* const node)
+{
+    while (node->blocks != NULL) {
+        block_t* const block = node->blocks;
+        block_unlink(node, block);
+        free(block);
+    }
+    free(node);
+}
+
+static cy_topic_t* node_advertise(node_t* const node, cy_publisher_t* const pub, const char* const name)
+{
+    const cy_err_t res = cy_advertise_c(&node->cy, pub, name, 0);
+    if (res != CY_OK) {
+        fatal("cy_advertise failed on '%s': %d", name, res);
+    }
+    return pub->topic;
+}
+
+static void on_arrival(cy_t* const cy, const cy_arrival_t* const evt)
+{
+    (void)cy;
+    (*(size_t*)evt->subscriber->user)++;
+}
+
+static void node_subscribe(node_t* const          node,
+                           cy_subscriber_t* const sub,
+                           const char* const      name,
+                           size_t* const          counter,
+                           const bool             conflate)
+{
+    const cy_subscription_params_t params = { PAYLOAD_SIZE, CY_TRANSFER_ID_TIMEOUT_DEFAULT_us, conflate };
+    const cy_err_t                 res    = cy_subscribe_with_params_c(&node->cy, sub, name, params, &on_arrival);
+    if (res != CY_OK) {
+        fatal("cy_subscribe failed on '%s': %d", name, res);
+    }
+    sub->user = counter;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                      HARNESS
+// ---------------------------------------------------------------------------------------------------------------------
+
+typedef void (*bench_fn_t)(void* ctx, size_t iterations);
+
+static bool bench_enabled(const char* const name)
+{
+    return strstr(name, g_filter) != NULL;
+}
+
+static uint64_t clock_ns(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (((uint64_t)ts.tv_sec) * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_sample(const bench_fn_t fn, void* const ctx, const size_t iterations)
+{
+    const uint64_t started = clock_ns();
+    fn(ctx, iterations);
+    return clock_ns() - started;
+}
+
+static int compare_double(const void* const a, const void* const b)
+{
+    const double x = *(const double*)a;
+    const double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/// The iteration count is doubled until one sample takes at least the minimum sample time;
+/// then, several samples are taken and the median and the minimum per-operation times are reported.
+static void bench_run(const char* const name, const size_t param, const bench_fn_t fn, void* const ctx)
+{
+    size_t iterations = 1;
+    while ((bench_sample(fn, ctx, iterations) < g_min_sample_ns) && (iterations < (SIZE_MAX / 2U))) {
+        iterations *= 2U;
+    }
+    double ns_per_op[SAMPLE_COUNT];
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        ns_per_op[i] = ((double)bench_sample(fn, ctx, iterations)) / (double)iterations;
+    }
+    qsort(ns_per_op, SAMPLE_COUNT, sizeof(double), &compare_double);
+    (void)printf("{\"name\":\"%s\",\"param\":%zu,\"iterations\":%zu,\"samples\":%u,"
+                 "\"ns_per_op\":%.2f,\"ns_per_op_min\":%.2f}\n",
+                 name,
+                 param,
+                 iterations,
+                 SAMPLE_COUNT,
+                 ns_per_op[SAMPLE_COUNT / 2U],
+                 ns_per_op[0]);
+    (void)fflush(stdout);
+}
+
+static void print_config(void)
+{
+#ifdef CY_CONFIG_PREFERRED_TOPIC_OVERRIDE
+    const long long override = (long long)CY_CONFIG_PREFERRED_TOPIC_OVERRIDE;
+#else
+    const long long override = -1; // Not defined.
+#endif
+    (void)printf("{\"name\":\"config\",\"topic_flat_index\":%d,\"preferred_topic_override\":%lld,\"trace\":%d}\n",
+                 (int)CY_CONFIG_TOPIC_FLAT_INDEX,
+                 override,
+                 (int)CY_CONFIG_TRACE);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                      HEARTBEAT FORGING
+// ---------------------------------------------------------------------------------------------------------------------
+
+/// A heartbeat with a single gossip record. Returns the total size.
+static size_t heartbeat_forge(unsigned char* const buffer,
+                              const uint64_t       uid,
+                              const uint64_t       hash,
+                              const uint32_t       evictions,
+                              const int_fast8_t    log_age,
+                              const wkv_str_t      name)
+{
+    gossip_t msg = { .topic_hash      = hash,
+                     .topic_evictions = evictions,
+                     ._reserved_      = 0,
+                     .topic_log_age   = (int8_t)log_age,
+                     .flags           = FLAG_PUBLISHING,
+                     .topic_name_len  = (uint8_t)name.len };
+    memcpy(msg.topic_name, name.str, name.len);
+    heartbeat_header_serialize(0, uid, buffer);
+    return HEARTBEAT_HEADER_SIZE + gossip_serialize(&msg, &buffer[HEARTBEAT_HEADER_SIZE]);
+}
+
+static cy_transfer_owned_t transfer_make(const uint16_t       remote_node_id,
+                                         const uint64_t       transfer_id,
+                                         const size_t         size,
+                                         unsigned char* const data)
+{
+    return (cy_transfer_owned_t){
+        .timestamp = g_now,
+        .metadata  = { .priority = cy_prio_nominal, .remote_node_id = remote_node_id, .transfer_id = transfer_id },
+        .payload   = { .base = { .next = NULL, .view = { .size = size, .data = data } },
+                       .origin = { .size = size, .data = data } },
+    };
+}
+
+/// A remote topic created on the scratch node and moved to the specified subject-ID; the scratch node stays alive
+/// for as long as the name is needed.
+static cy_topic_t* remote_topic_at(node_t* const         scratch,
+                                   cy_publisher_t* const pub,
+                                   const char* const     name,
+                                   const uint16_t        subject_id)
+{
+    cy_topic_t* const topic = node_advertise(scratch, pub, name);
+    cy_topic_hint(&scratch->cy, topic, subject_id);
+    if (cy_topic_subject_id(topic) != subject_id) {
+        fatal("Could not place '%s' at subject-ID %u", name, subject_id);
+    }
+    return topic;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//                                                      CASES
+// ---------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+    node_t*        node;
+    cy_publisher_t pub;
+    unsigned char  payload[PAYLOAD_SIZE];
+} publish_ctx_t;
+
+static void publish_fn(void* const ctx, const size_t iterations)
+{
+    publish_ctx_t* const       self    = ctx;
+    const cy_buffer_borrowed_t payload = { .next = NULL,
+                                           .view = { .size = sizeof(self->payload), .data = self->payload } };
+    for (size_t i = 0; i < iterations; i++) {
+        (void)cy_publish1(&self->node->cy, &self->pub, g_now + 1000, payload);
+    }
+}
+
+static void bench_publish(void)
+{
+    if (bench_enabled("publish")) {
+        publish_ctx_t ctx = { .node = node_new(0xB000000000000001ULL, 1), .payload = { 0 } };
+        (void)node_advertise(ctx.node, &ctx.pub, "/bench/publish");
+        bench_run("publish", PAYLOAD_SIZE, &publish_fn, &ctx);
+        node_destroy(ctx.node);
+    }
+    if (bench_enabled("publish/batched")) {
+        publish_ctx_t ctx = { .node = node_new(0xB000000000000001ULL, 1), .payload = { 0 } };
+        (void)node_advertise(ctx.node, &ctx.pub, "/bench/publish");
+        (void)cy_publisher_batching(&ctx.node->cy, &ctx.pub, 1400U, 1000000);
+        bench_run("publish/batched", PAYLOAD_SIZE, &publish_fn, &ctx);
+        node_destroy(ctx.node);
+    }
+}
+
+/// The same heartbeat is ingested repeatedly; it is restored before every ingestion because the core may alter it.
+typedef struct
+{
+    node_t*       node;
+    size_t        size;
+    unsigned char heartbeat[HEARTBEAT_SINGLE_SIZE_MAX];
+} heartbeat_ctx_t;
+
+static void heartbeat_fn(void* const ctx, const size_t iterations)
+{
+    heartbeat_ctx_t* const self  = ctx;
+    cy_t* const            cy    = &self->node->cy;
+    cy_topic_t* const      topic = cy->heartbeat_pub.topic;
+    for (size_t i = 0; i < iterations; i++) {
+        cy_ingest_topic_transfer(cy, topic, transfer_make(2, i, self->size, self->heartbeat));
+    }
+}
+
+static void bench_heartbeat(void)
+{
+    static const char* const cases[] = {
+        "heartbeat/hit",
+        "heartbeat/miss",
+        "heartbeat/collision",
+        "heartbeat/divergence",
+    };
+    for (size_t i = 0; i < (sizeof(cases) / sizeof(cases[0])); i++) {
+        if (!bench_enabled(cases[i])) {
+            continue;
+        }
+        static heartbeat_ctx_t ctx;
+        cy_publisher_t         pub_local;
+        cy_publisher_t         pub_remote;
+        node_t* const          remote = node_new(0xB000000000000002ULL, 2);
+        const uint64_t         uid    = remote->cy.uid;
+
+        ctx.node                = node_new(0xB000000000000001ULL, 1);
+        cy_topic_t* const local = node_advertise(ctx.node, &pub_local, "/bench/local");
+        local->age              = TOPIC_AGE_OLD; // The local topic wins all conflicts, so nothing moves.
+        switch (i) {
+            case 0: {
+                ctx.size = heartbeat_forge(ctx.heartbeat, uid, local->hash, local->evictions, 0, cy_topic_name(local));
+                break;
+            }
+            case 1: {
+                uint16_t free_sid = 0;
+                while (cy_topic_find_by_subject_id(&ctx.node->cy, free_sid) != NULL) {
+                    free_sid++;
+                }
+                const cy_topic_t* const other = remote_topic_at(remote, &pub_remote, "/bench/remote", free_sid);
+                ctx.size = heartbeat_forge(ctx.heartbeat, uid, other->hash, other->evictions, 0, cy_topic_name(other));
+                break;
+            }
+            case 2: {
+                const cy_topic_t* const other =
+                  remote_topic_at(remote, &pub_remote, "/bench/remote", cy_topic_subject_id(local));
+                ctx.size = heartbeat_forge(ctx.heartbeat, uid, other->hash, other->evictions, 0, cy_topic_name(other));
+                break;
+            }
+            default: {
+                ctx.size =
+                  heartbeat_forge(ctx.heartbeat, uid, local->hash, local->evictions + 1U, 0, cy_topic_name(local));
+                break;
+            }
+        }
+        bench_run(cases[i], 1, &heartbeat_fn, &ctx);
+        node_destroy(ctx.node);
+        node_destroy(remote);
+    }
+}
+
+/// Every iteration makes one of the local topics lose a divergence arbitration, forcing topic_allocate() to move it.
+/// At high occupancy, the topic has to probe many subject-IDs and may displace others, which cascades further.
+typedef struct
+{
+    node_t*         node;
+    size_t          count;
+    size_t          cursor;
+    cy_publisher_t* pubs;
+    unsigned char   heartbeat[HEARTBEAT_SINGLE_SIZE_MAX];
+} allocate_ctx_t;
+
+static void allocate_fn(void* const ctx, const size_t iterations)
+{
+    allocate_ctx_t* const self = ctx;
+    cy_t* const           cy   = &self->node->cy;
+    for (size_t i = 0; i < iterations; i++) {
+        cy_topic_t* const topic = self->pubs[self->cursor].topic;
+        self->cursor            = (self->cursor + 1U) % self->count;
+        topic->age              = 0; // Younger than the remote, so it loses.
+        const size_t size =
+          heartbeat_forge(self->heartbeat, 2, topic->hash, topic->evictions + 1U, 0, cy_topic_name(topic));
+        cy_ingest_topic_transfer(cy, cy->heartbeat_pub.topic, transfer_make(2, i, size, self->heartbeat));
+    }
+}
+
+static void bench_allocate(void)
+{
+    static const size_t counts[] = { 100, 1000, 6000 };
+    if (!bench_enabled("allocate")) {
+        return;
+    }
+    for (size_t i = 0; i < (sizeof(counts) / sizeof(counts[0])); i++) {
+        static allocate_ctx_t ctx;
+        ctx.node   = node_new(0xB000000000000001ULL, 1);
+        ctx.count  = counts[i];
+        ctx.cursor = 0;
+        ctx.pubs   = calloc(ctx.count, sizeof(cy_publisher_t));
+        if (ctx.pubs == NULL) {
+            fatal("Out of memory");
+        }
+        for (size_t k = 0; k < ctx.count; k++) {
+            char name[64];
+            (void)snprintf(name, sizeof(name), "/bench/allocate/%zu", k);
+            (void)node_advertise(ctx.node, &ctx.pubs[k], name);
+        }
+        bench_run("allocate", ctx.count, &allocate_fn, &ctx);
+        free(ctx.pubs);
+        node_destroy(ctx.node);
+    }
+}
+
+/// The name has enough segments to construct this many distinct patterns matching it.
+#define FANOUT_NAME            "/bench/a/b/c/d/e/f/g/h"
+#define FANOUT_SEGMENTS        8U
+#define FANOUT_SEGMENT_OFFSET  7U ///< Length of "/bench/".
+#define FANOUT_COUPLINGS_MAX   (1U << FANOUT_SEGMENTS)
+#define FANOUT_SUBSCRIBERS_MAX 256U
+
+typedef struct
+{
+    node_t*          node;
+    cy_topic_t*      topic;
+    size_t           arrivals;
+    cy_subscriber_t* subs;
+    unsigned char    payload[PAYLOAD_SIZE];
+} fanout_ctx_t;
+
+static void fanout_fn(void* const ctx, const size_t iterations)
+{
+    fanout_ctx_t* const self = ctx;
+    for (size_t i = 0; i < iterations; i++) {
+        cy_ingest_topic_transfer(&self->node->cy, self->topic, transfer_make(2, i, PAYLOAD_SIZE, self->payload));
+    }
+    g_sink += self->arrivals;
+}
+
+/// The first subscriber is verbatim; the couplings are made by the patterns that replace segments with '?'.
+/// The conflating subscribers are not invoked on ingestion, so their cost should not depend on their number.
+static void fanout_setup(fanout_ctx_t* const ctx,
+                         const size_t        couplings,
+                         const size_t        subscribers_per_coupling,
+                         const bool          conflate)
+{
+    ctx->node     = node_new(0xB000000000000001ULL, 1);
+    ctx->arrivals = 0;
+    ctx->subs     = calloc(couplings * subscribers_per_coupling, sizeof(cy_subscriber_t));
+    if (ctx->subs == NULL) {
+        fatal("Out of memory");
+    }
+    for (size_t c = 0; c < couplings; c++) {
+        char name[] = FANOUT_NAME;
+        for (size_t s = 0; s < FANOUT_SEGMENTS; s++) {
+            if ((c & (1U << s)) != 0) {
+                name[FANOUT_SEGMENT_OFFSET + (s * 2U)] = '?';
+            }
+        }
+        for (size_t s = 0; s < subscribers_per_coupling; s++) {
+            node_subscribe(ctx->node, &ctx->subs[(c * subscribers_per_coupling) + s], name, &ctx->arrivals, conflate);
+        }
+    }
+    ctx->topic = cy_topic_find_by_name_c(&ctx->node->cy, &FANOUT_NAME[1]); // Resolved names have no leading "/".
+    if (ctx->topic == NULL) {
+        fatal("Fan-out topic not found");
+    }
+}
+
+static void bench_fanout(void)
+{
+    static const size_t params[] = { 1, 16, FANOUT_COUPLINGS_MAX };
+    for (size_t i = 0; i < (sizeof(params) / sizeof(params[0])); i++) {
+        static fanout_ctx_t ctx;
+        if (bench_enabled("ingest/couplings")) {
+            fanout_setup(&ctx, params[i], 1, false);
+            bench_run("ingest/couplings", params[i], &fanout_fn, &ctx);
+            free(ctx.subs);
+            node_destroy(ctx.node);
+        }
+        if (bench_enabled("ingest/subscribers") && (params[i] <= FANOUT_SUBSCRIBERS_MAX)) {
+            fanout_setup(&ctx, 1, params[i], false);
+            bench_run("ingest/subscribers", params[i], &fanout_fn, &ctx);
+            free(ctx.subs);
+            node_destroy(ctx.node);
+        }
+        if (bench_enabled("ingest/conflated") && (params[i] <= FANOUT_SUBSCRIBERS_MAX)) {
+            fanout_setup(&ctx, 1, params[i], true);
+            bench_run("ingest/conflated", params[i], &fanout_fn, &ctx);
+            free(ctx.subs);
+            node_destroy(ctx.node);
+        }
+    }
+}
+
+/// The queries are concrete names; half of them match one pattern each, the other half match nothing.
+/// This is the lookup done for every gossip of an unknown topic and for every new topic.
+typedef struct
+{
+    node_t* node;
+    size_t  count;
+    size_t  matches;
+    char (*queries)[64];
+} pattern_ctx_t;
+
+static void* pattern_count_cb(const wkv_event_t evt)
+{
+    (*(size_t*)evt.context)++;
+    return NULL;
+}
+
+static void pattern_route_fn(void* const ctx, const size_t iterations)
+{
+    pattern_ctx_t* const self = ctx;
+    for (size_t i = 0; i < iterations; i++) {
+        (void)wkv_route(&self->node->cy.subscribers_by_pattern,
+                        wkv_key(self->queries[i % (self->count * 2U)]),
+                        &self->matches,
+                        &pattern_count_cb);
+    }
+    g_sink += self->matches;
+}
+
+/// The queries are patterns matching one topic each, like when a new pattern subscriber or a scout arrives.
+static void pattern_match_fn(void* const ctx, const size_t iterations)
+{
+    pattern_ctx_t* const self = ctx;
+    for (size_t i = 0; i < iterations; i++) {
+        (void)wkv_match(&self->node->cy.topics_by_name,
+                        wkv_key(self->queries[i % self->count]),
+                        &self->matches,
+                        &pattern_count_cb);
+    }
+    g_sink += self->matches;
+}
+
+static void bench_pattern(void)
+{
+    static const size_t counts[] = { 16, 256, 4096 };
+    for (size_t i = 0; i < (sizeof(counts) / sizeof(counts[0])); i++) {
+        static pattern_ctx_t ctx;
+        ctx.count   = counts[i];
+        ctx.matches = 0;
+        ctx.queries = calloc(ctx.count * 2U, sizeof(*ctx.queries));
+        if (ctx.queries == NULL) {
+            fatal("Out of memory");
+        }
+        if (bench_enabled("pattern/route")) {
+            ctx.node                    = node_new(0xB000000000000001ULL, 1);
+            cy_subscriber_t* const subs = calloc(ctx.count, sizeof(cy_subscriber_t));
+            if (subs == NULL) {
+                fatal("Out of memory");
+            }
+            for (size_t k = 0; k < ctx.count; k++) {
+                char pattern[64];
+                (void)snprintf(pattern, sizeof(pattern), "/bench/p%zu/?", k);
+                node_subscribe(ctx.node, &subs[k], pattern, &ctx.matches, false);
+            }
+            for (size_t k = 0; k < (ctx.count * 2U); k++) {
+                (void)snprintf(ctx.queries[k], sizeof(ctx.queries[k]), "/bench/p%zu/x", k);
+            }
+            bench_run("pattern/route", ctx.count, &pattern_route_fn, &ctx);
+            free(subs);
+            node_destroy(ctx.node);
+        }
+        if (bench_enabled("pattern/match") && (ctx.count < CY_TOPIC_SUBJECT_COUNT)) {
+            ctx.node                   = node_new(0xB000000000000001ULL, 1);
+            cy_publisher_t* const pubs = calloc(ctx.count, sizeof(cy_publisher_t));
+            if (pubs == NULL) {
+                fatal("Out of memory");
+            }
+            for (size_t k = 0; k < ctx.count; k++) {
+                char name[64];
+                (void)snprintf(name, sizeof(name), "/bench/t%zu/x", k);
+                (void)node_advertise(ctx.node, &pubs[k], name);
+                (void)snprintf(ctx.queries[k], sizeof(ctx.queries[k]), "/bench/t%zu/?", k);
+            }
+            bench_run("pattern/match", ctx.count, &pattern_match_fn, &ctx);
+            free(pubs);
+            node_destroy(ctx.node);
+        }
+        free(ctx.queries);
+    }
+}
+
+/// A request-response client with a fixed number of requests in flight: every iteration completes the oldest
+/// pending request by ingesting its response and publishes a new one reusing the same future.
+/// The deadlines are spread over a second so that the futures land in different timer wheel slots and levels.
+typedef struct
+{
+    node_t*        node;
+    cy_publisher_t pub;
+    size_t         count;
+    size_t         cursor;
+    cy_future_t*   futures;
+    unsigned char  payload[PAYLOAD_SIZE];
+    unsigned char  response[sizeof(uint64_t) + PAYLOAD_SIZE];
+} rpc_ctx_t;
+
+static void rpc_request(rpc_ctx_t* const self, cy_future_t* const future)
+{
+    const cy_buffer_borrowed_t payload = { .next = NULL,
+                                           .view = { .size = sizeof(self->payload), .data = self->payload } };
+    const cy_us_t deadline = g_now + 1000 + (cy_us_t)((self->pub.topic->pub_transfer_id % 1000U) * 1000U);
+    const cy_err_t res     = cy_publish(&self->node->cy, &self->pub, g_now + 1000, payload, deadline, future);
+    if (res != CY_OK) {
+        fatal("cy_publish failed: %d", res);
+    }
+}
+
+static void rpc_fn(void* const ctx, const size_t iterations)
+{
+    rpc_ctx_t* const self = ctx;
+    cy_t* const      cy   = &self->node->cy;
+    for (size_t i = 0; i < iterations; i++) {
+        cy_future_t* const future = &self->futures[self->cursor];
+        self->cursor              = (self->cursor + 1U) % self->count;
+        cy_ingest_topic_response_transfer(
+          cy, transfer_make(2, future->transfer_id_masked, sizeof(self->response), self->response));
+        if (future->state != cy_future_success) {
+            fatal("Response not matched");
+        }
+        rpc_request(self, future);
+    }
+}
+
+static void bench_rpc(void)
+{
+    static const size_t counts[] = { 16, 1024, 16384 };
+    if (!bench_enabled("rpc/inflight")) {
+        return;
+    }
+    for (size_t i = 0; i < (sizeof(counts) / sizeof(counts[0])); i++) {
+        static rpc_ctx_t ctx;
+        ctx.node    = node_new(0xB000000000000001ULL, 1);
+        ctx.count   = counts[i];
+        ctx.cursor  = 0;
+        ctx.futures = calloc(ctx.count, sizeof(cy_future_t));
+        if (ctx.futures == NULL) {
+            fatal("Out of memory");
+        }
+        const cy_topic_t* const topic = node_advertise(ctx.node, &ctx.pub, "/bench/rpc");
+        memcpy(ctx.response, &topic->hash, sizeof(topic->hash)); // The response header is the topic hash.
+        for (size_t k = 0; k < ctx.count; k++) {
+            cy_future_new(&ctx.futures[k], NULL, NULL);
+            rpc_request(&ctx, &ctx.futures[k]);
+        }
+        bench_run("rpc/inflight", ctx.count, &rpc_fn, &ctx);
+        free(ctx.futures);
+        node_destroy(ctx.node);
+    }
+}
+
+/// The memory footprint is measured in the bytes allocated by the core per topic, including the name index and the
+/// subscription state; the application-owned publisher and subscriber objects are excluded. Not a timing case.
+static void bench_memory_report(const char* const name, const size_t count, const size_t bytes)
+{
+    (void)printf("{\"name\":\"%s\",\"param\":%zu,\"bytes_per_topic\":%.1f,\"sizeof_topic\":%zu}\n",
+                 name,
+                 count,
+                 ((double)bytes) / ((double)count),
+                 sizeof(cy_topic_t));
+}
+
+static void bench_memory(void)
+{
+    static const size_t count = 1024;
+    if (bench_enabled("memory/published")) {
+        node_t* const         node = node_new(0xB000000000000001ULL, 1);
+        cy_publisher_t* const pubs = calloc(count, sizeof(cy_publisher_t));
+        if (pubs == NULL) {
+            fatal("Out of memory");
+        }
+        const size_t before = node->bytes;
+        for (size_t k = 0; k < count; k++) {
+            char name[64];
+            (void)snprintf(name, sizeof(name), "/bench/memory/%zu", k);
+            (void)node_advertise(node, &pubs[k], name);
+        }
+        bench_memory_report("memory/published", count, node->bytes - before);
+        free(pubs);
+        node_destroy(node);
+    }
+    if (bench_enabled("memory/subscribed")) {
+        node_t* const          node = node_new(0xB000000000000001ULL, 1);
+        cy_subscriber_t* const subs = calloc(count, sizeof(cy_subscriber_t));
+        if (subs == NULL) {
+            fatal("Out of memory");
+        }
+        size_t       arrivals = 0;
+        const size_t before   = node->bytes;
+        for (size_t k = 0; k < count; k++) {
+            char name[64];
+            (void)snprintf(name, sizeof(name), "/bench/memory/%zu", k);
+            node_subscribe(node, &subs[k], name, &arrivals, false);
+        }
+        bench_memory_report("memory/subscribed", count, node->bytes - before);
+        free(subs);
+        node_destroy(node);
+    }
+}
+
+int main(const int argc, char* const argv[])
+{
+    if (argc > 1) {
+        g_filter = argv[1];
+    }
+    if (argc > 2) {
+        g_min_sample_ns = strtoull(argv[2], NULL, 10) * 1000000ULL;
+    }
+    print_config();
+    bench_publish();
+    bench_heartbeat();
+    bench_allocate();
+    bench_fanout();
+    bench_pattern();
+    bench_rpc();
+    bench_memory();
+    return 0;
+}
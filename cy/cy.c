@@ -10,6 +10,7 @@
 
 // ReSharper disable CppDFATimeOver
 #include "cy_platform.h"
+#include "cy_wire.h"
 
 #define CAVL2_RELATION int32_t
 #define CAVL2_T        cy_tree_t
@@ -43,6 +44,7 @@
 // clang-format off
 static   size_t smaller(const size_t a,   const size_t b)   { return (a < b) ? a : b; }
 static   size_t  larger(const size_t a,   const size_t b)   { return (a > b) ? a : b; }
+static  int64_t min_i64(const int64_t a,  const int64_t b)  { return (a < b) ? a : b; }
 static  int64_t max_i64(const int64_t a,  const int64_t b)  { return (a > b) ? a : b; }
 static uint64_t max_u64(const uint64_t a, const uint64_t b) { return (a > b) ? a : b; }
 // clang-format on
@@ -65,6 +67,12 @@ static uint64_t pow2(const int_fast8_t exp)
     return 1ULL << exp;
 }
 
+static void stat_histogram_add(struct cy_stats_histogram_counters_t* const hist, const cy_us_t value)
+{
+    const int_fast8_t lg = (value > 0) ? log2_floor((uint64_t)value) : -1;
+    cy_stat_add(&hist->buckets[smaller((size_t)(lg + 1), CY_STATS_HISTOGRAM_BUCKET_COUNT - 1U)], 1U);
+}
+
 static uint64_t random_u64(const cy_t* const cy)
 {
     const uint64_t seed[2] = { cy->platform->prng(cy), cy->uid };
@@ -165,53 +173,194 @@ static int32_t cavl_comp_topic_hash(const void* const user, const cy_tree_t* con
     return (outer >= inner->hash) ? +1 : -1;
 }
 
-static int32_t cavl_comp_topic_subject_id(const void* const user, const cy_tree_t* const node)
+// =====================================================================================================================
+//                                                  GOSSIP SCHEDULE
+// =====================================================================================================================
+
+#define GOSSIP_HEAP_INITIAL_CAPACITY 16U
+
+/// The topic at the root of the heap has the highest priority, then the lowest gossip time.
+/// Gossip times are not unique, so the ties are broken by the scheduling sequence number, which makes the order FIFO.
+static bool gossip_before(const cy_topic_t* const left, const cy_topic_t* const right)
 {
-    assert((user != NULL) && (node != NULL));
-    const cy_topic_t* const inner = CAVL2_TO_OWNER(node, cy_topic_t, index_subject_id);
-    return (int32_t)(*(uint16_t*)user) - ((int32_t)cy_topic_subject_id(inner));
+    if (left->gossip_priority != right->gossip_priority) {
+        return left->gossip_priority > right->gossip_priority;
+    }
+    if (left->ts_gossiped != right->ts_gossiped) {
+        return left->ts_gossiped < right->ts_gossiped;
+    }
+    return left->gossip_seq < right->gossip_seq;
 }
 
-/// Gossip times are not unique, so this comparator never returns 0.
-/// Leftmost node has the highest priority, then the lowest gossip time.
-static int32_t cavl_comp_topic_gossip_order(const void* const user, const cy_tree_t* const node)
+static void gossip_heap_place(cy_t* const cy, cy_topic_t* const topic, const size_t index)
 {
-    assert((user != NULL) && (node != NULL));
-    const cy_topic_t* const outer = (const cy_topic_t*)user;
-    const cy_topic_t* const inner = CAVL2_TO_OWNER(node, cy_topic_t, index_gossip_order);
-    if (outer->gossip_priority != inner->gossip_priority) {
-        return (outer->gossip_priority > inner->gossip_priority) ? -1 : +1;
+    cy->topics_by_gossip_time[index] = topic;
+    topic->gossip_heap_index         = index;
+}
+
+static void gossip_heap_sift_up(cy_t* const cy, size_t index)
+{
+    cy_topic_t* const topic = cy->topics_by_gossip_time[index];
+    while (index > 0) {
+        const size_t parent = (index - 1U) / 2U;
+        if (!gossip_before(topic, cy->topics_by_gossip_time[parent])) {
+            break;
+        }
+        gossip_heap_place(cy, cy->topics_by_gossip_time[parent], index);
+        index = parent;
     }
-    return (outer->ts_gossiped >= inner->ts_gossiped) ? +1 : -1;
+    gossip_heap_place(cy, topic, index);
 }
 
-static int32_t cavl_comp_future_transfer_id_masked(const void* const user, const cy_tree_t* const node)
+static void gossip_heap_sift_down(cy_t* const cy, size_t index)
 {
-    assert((user != NULL) && (node != NULL));
-    const uint64_t           outer = *(uint64_t*)user;
-    const cy_future_t* const inner = CAVL2_TO_OWNER(node, cy_future_t, index_transfer_id);
-    if (outer == inner->transfer_id_masked) {
-        return 0;
+    cy_topic_t* const topic = cy->topics_by_gossip_time[index];
+    while (true) {
+        size_t child = (index * 2U) + 1U;
+        if (child >= cy->gossip_heap_size) {
+            break;
+        }
+        if (((child + 1U) < cy->gossip_heap_size) &&
+            gossip_before(cy->topics_by_gossip_time[child + 1U], cy->topics_by_gossip_time[child])) {
+            child++;
+        }
+        if (!gossip_before(cy->topics_by_gossip_time[child], topic)) {
+            break;
+        }
+        gossip_heap_place(cy, cy->topics_by_gossip_time[child], index);
+        index = child;
     }
-    return (outer >= inner->transfer_id_masked) ? +1 : -1;
+    gossip_heap_place(cy, topic, index);
 }
 
-/// Deadlines are not unique, so this comparator never returns 0.
-static int32_t cavl_comp_future_deadline(const void* const user, const cy_tree_t* const node)
+/// Ensures that one more topic can be inserted without allocation. Returns false if out of memory.
+static bool gossip_heap_reserve(cy_t* const cy)
 {
-    assert((user != NULL) && (node != NULL));
-    const cy_future_t* const inner = CAVL2_TO_OWNER(node, cy_future_t, index_deadline);
-    return ((*(cy_us_t*)user) >= inner->deadline) ? +1 : -1;
+    if (cy->gossip_heap_size >= cy->gossip_heap_capacity) {
+        const size_t capacity = larger(cy->gossip_heap_capacity * 2U, GOSSIP_HEAP_INITIAL_CAPACITY);
+        cy_topic_t** const heap =
+          cy->platform->realloc(cy, cy->topics_by_gossip_time, capacity * sizeof(cy_topic_t*));
+        if (heap == NULL) {
+            return false;
+        }
+        cy->topics_by_gossip_time = heap;
+        cy->gossip_heap_capacity  = capacity;
+    }
+    return true;
+}
+
+/// The capacity shall be reserved beforehand.
+static void gossip_heap_insert(cy_t* const cy, cy_topic_t* const topic)
+{
+    assert(cy->gossip_heap_size < cy->gossip_heap_capacity);
+    topic->gossip_seq = cy->gossip_seq++;
+    gossip_heap_place(cy, topic, cy->gossip_heap_size++);
+    gossip_heap_sift_up(cy, topic->gossip_heap_index);
+}
+
+/// Restores the heap order after the priority or the gossip time of the topic was changed.
+/// The topic is placed after all others that have the same priority and gossip time.
+static void gossip_heap_update(cy_t* const cy, cy_topic_t* const topic)
+{
+    assert(topic->gossip_heap_index < cy->gossip_heap_size);
+    assert(cy->topics_by_gossip_time[topic->gossip_heap_index] == topic);
+    topic->gossip_seq = cy->gossip_seq++;
+    gossip_heap_sift_up(cy, topic->gossip_heap_index);
+    gossip_heap_sift_down(cy, topic->gossip_heap_index);
+}
+
+// =====================================================================================================================
+//                                                  TOPIC INDEXES
+// =====================================================================================================================
+
+#if CY_CONFIG_TOPIC_FLAT_INDEX
+
+#define TOPIC_HASH_INDEX_INITIAL_CAPACITY 64U
+
+/// The hashes of pinned topics are small consecutive integers, so they are scrambled using Fibonacci hashing
+/// to avoid long probe sequences; the hashes of ordinary topics are already well mixed.
+static size_t topic_hash_slot(const uint64_t hash, const size_t capacity)
+{
+    return ((size_t)((hash * 0x9E3779B97F4A7C15ULL) >> 32U)) & (capacity - 1U);
+}
+
+static void topic_hash_flat_put(cy_topic_t** const table, const size_t capacity, cy_topic_t* const topic)
+{
+    size_t i = topic_hash_slot(topic->hash, capacity);
+    while (table[i] != NULL) {
+        assert(table[i]->hash != topic->hash);
+        i = (i + 1U) & (capacity - 1U);
+    }
+    table[i] = topic;
+}
+
+/// Ensures that one more topic can be indexed without allocation. Returns false if out of memory.
+static bool topic_index_reserve(cy_t* const cy)
+{
+    if (((cy->topic_count + 1U) * 2U) > cy->topics_by_hash_flat_capacity) {
+        const size_t       capacity = larger(cy->topics_by_hash_flat_capacity * 2U, TOPIC_HASH_INDEX_INITIAL_CAPACITY);
+        cy_topic_t** const table    = mem_alloc(cy, capacity * sizeof(cy_topic_t*));
+        if (table == NULL) {
+            return false;
+        }
+        memset(table, 0, capacity * sizeof(cy_topic_t*));
+        for (size_t i = 0; i < cy->topics_by_hash_flat_capacity; i++) {
+            if (cy->topics_by_hash_flat[i] != NULL) {
+                topic_hash_flat_put(table, capacity, cy->topics_by_hash_flat[i]);
+            }
+        }
+        mem_free(cy, cy->topics_by_hash_flat);
+        cy->topics_by_hash_flat          = table;
+        cy->topics_by_hash_flat_capacity = capacity;
+    }
+    return true;
+}
+
+static cy_topic_t* topic_index_find_by_hash(const cy_t* const cy, const uint64_t hash)
+{
+    const size_t capacity = cy->topics_by_hash_flat_capacity;
+    if (capacity == 0) {
+        return NULL;
+    }
+    // The probe sequence is finite because the table is never more than half full.
+    for (size_t i = topic_hash_slot(hash, capacity);; i = (i + 1U) & (capacity - 1U)) {
+        cy_topic_t* const topic = cy->topics_by_hash_flat[i];
+        if ((topic == NULL) || (topic->hash == hash)) {
+            return topic;
+        }
+    }
+}
+
+static cy_topic_t* topic_index_find_by_subject_id(const cy_t* const cy, const uint16_t subject_id)
+{
+    return (subject_id < CY_TOTAL_SUBJECT_COUNT) ? cy->topics_by_subject_id[subject_id] : NULL;
+}
+
+/// Puts the topic at the specified subject-ID unless it is occupied. Returns the current tenant of the subject-ID,
+/// which is the topic itself if the insertion took place.
+static cy_topic_t* topic_index_claim_subject_id(cy_t* const cy, cy_topic_t* const topic, const uint16_t subject_id)
+{
+    assert(subject_id < CY_TOTAL_SUBJECT_COUNT);
+    if (cy->topics_by_subject_id[subject_id] == NULL) {
+        cy->topics_by_subject_id[subject_id] = topic;
+    }
+    return cy->topics_by_subject_id[subject_id];
 }
 
-static cy_tree_t* cavl_factory_future_transfer_id(void* const user)
+static void topic_index_release_subject_id(cy_t* const cy, cy_topic_t* const topic)
 {
-    return &((cy_future_t*)user)->index_transfer_id;
+    const uint16_t subject_id = cy_topic_subject_id(topic);
+    assert((subject_id < CY_TOTAL_SUBJECT_COUNT) && (cy->topics_by_subject_id[subject_id] == topic));
+    cy->topics_by_subject_id[subject_id] = NULL;
 }
 
-static cy_tree_t* cavl_factory_future_deadline(void* const user)
+#else
+
+static int32_t cavl_comp_topic_subject_id(const void* const user, const cy_tree_t* const node)
 {
-    return &((cy_future_t*)user)->index_deadline;
+    assert((user != NULL) && (node != NULL));
+    const cy_topic_t* const inner = CAVL2_TO_OWNER(node, cy_topic_t, index_subject_id);
+    return (int32_t)(*(uint16_t*)user) - ((int32_t)cy_topic_subject_id(inner));
 }
 
 static cy_tree_t* cavl_factory_topic_subject_id(void* const user)
@@ -219,9 +368,80 @@ static cy_tree_t* cavl_factory_topic_subject_id(void* const user)
     return &((cy_topic_t*)user)->index_subject_id;
 }
 
-static cy_tree_t* cavl_factory_topic_gossip_order(void* const user)
+/// The AVL indexes do not require preallocation.
+static bool topic_index_reserve(cy_t* const cy)
+{
+    (void)cy;
+    return true;
+}
+
+static cy_topic_t* topic_index_find_by_hash(const cy_t* const cy, const uint64_t hash)
+{
+    return (cy_topic_t*)cavl2_find(cy->topics_by_hash, &hash, &cavl_comp_topic_hash);
+}
+
+static cy_topic_t* topic_index_find_by_subject_id(const cy_t* const cy, const uint16_t subject_id)
+{
+    cy_tree_t* const t = cavl2_find(cy->topics_by_subject_id, &subject_id, &cavl_comp_topic_subject_id);
+    return (t != NULL) ? CAVL2_TO_OWNER(t, cy_topic_t, index_subject_id) : NULL;
+}
+
+/// Puts the topic at the specified subject-ID unless it is occupied. Returns the current tenant of the subject-ID,
+/// which is the topic itself if the insertion took place.
+static cy_topic_t* topic_index_claim_subject_id(cy_t* const cy, cy_topic_t* const topic, const uint16_t subject_id)
+{
+    cy_tree_t* const t = cavl2_find_or_insert(
+      &cy->topics_by_subject_id, &subject_id, &cavl_comp_topic_subject_id, topic, &cavl_factory_topic_subject_id);
+    assert(t != NULL); // we will create it if not found, meaning allocation succeeded
+    return CAVL2_TO_OWNER(t, cy_topic_t, index_subject_id);
+}
+
+static void topic_index_release_subject_id(cy_t* const cy, cy_topic_t* const topic)
+{
+    cavl2_remove(&cy->topics_by_subject_id, &topic->index_subject_id);
+}
+
+#endif
+
+/// The capacity shall be reserved beforehand. The topic shall not be indexed already.
+static void topic_index_insert_hash(cy_t* const cy, cy_topic_t* const topic)
+{
+    const cy_tree_t* const res_tree =
+      cavl2_find_or_insert(&cy->topics_by_hash, &topic->hash, &cavl_comp_topic_hash, topic, &cavl2_trivial_factory);
+    assert(res_tree == &topic->index_hash); // Cannot invoke this if such topic already exists!
+    (void)res_tree;
+#if CY_CONFIG_TOPIC_FLAT_INDEX
+    assert(((cy->topic_count + 1U) * 2U) <= cy->topics_by_hash_flat_capacity);
+    topic_hash_flat_put(cy->topics_by_hash_flat, cy->topics_by_hash_flat_capacity, topic);
+#endif
+}
+
+/// A topic allocation imported from a snapshot; see cy_snapshot_load().
+typedef struct cy_snapshot_topic_t
+{
+    uint64_t hash;
+    uint32_t evictions;
+    uint64_t age;
+} cy_snapshot_topic_t;
+
+/// Binary search over the snapshot table, which is sorted by hash. NULL if there is no such entry.
+static const cy_snapshot_topic_t* snapshot_find(const cy_t* const cy, const uint64_t hash)
 {
-    return &((cy_topic_t*)user)->index_gossip_order;
+    size_t lo = 0;
+    size_t hi = cy->snapshot_topic_count;
+    while (lo < hi) {
+        const size_t               mid   = lo + ((hi - lo) / 2U);
+        const cy_snapshot_topic_t* entry = &cy->snapshot_topics[mid];
+        if (entry->hash == hash) {
+            return entry;
+        }
+        if (entry->hash < hash) {
+            lo = mid + 1U;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
 }
 
 // =====================================================================================================================
@@ -231,7 +451,8 @@ static cy_tree_t* cavl_factory_topic_gossip_order(void* const user)
 // ReSharper disable CppParameterMayBeConstPtrOrRef
 
 /// A Bloom filter is a set-only structure so there is no way to clear a bit after it has been set.
-/// It is only possible to purge the entire filter state.
+/// The stale entries are expired by rotating the generations instead, see cy_bloom64_t.
+/// New entries are always set in the current generation, which occupies the first n_bits of the storage.
 static void bloom64_set(cy_bloom64_t* const bloom, const size_t value)
 {
     assert(bloom != NULL);
@@ -244,17 +465,41 @@ static void bloom64_set(cy_bloom64_t* const bloom, const size_t value)
     assert(bloom->popcount <= bloom->n_bits);
 }
 
+/// The union of all generations at the specified word index.
+static uint64_t bloom64_word(const cy_bloom64_t* const bloom, const size_t word_index)
+{
+    assert((bloom != NULL) && (word_index < (bloom->n_bits / 64U)));
+    uint64_t out = 0;
+    for (size_t gen = 0; gen < CY_BLOOM64_GENERATIONS; gen++) {
+        out |= bloom->storage[(gen * (bloom->n_bits / 64U)) + word_index];
+    }
+    return out;
+}
+
 static bool bloom64_get(const cy_bloom64_t* const bloom, const size_t value)
 {
     assert(bloom != NULL);
     const size_t index = value % bloom->n_bits;
-    return (bloom->storage[index / 64U] & (1ULL << (index % 64U))) != 0;
+    return (bloom64_word(bloom, index / 64U) & (1ULL << (index % 64U))) != 0;
+}
+
+/// Drops the oldest generation and starts a new empty current one. The entries of the other generations are retained,
+/// so the nodes that were seen recently are still considered present, unlike purging the filter.
+static void bloom64_rotate(cy_bloom64_t* const bloom)
+{
+    assert(bloom != NULL);
+    const size_t words = bloom->n_bits / 64U;
+    memmove(&bloom->storage[words], &bloom->storage[0], (CY_BLOOM64_GENERATIONS - 1U) * words * sizeof(uint64_t));
+    for (size_t i = 0; i < words; i++) {
+        bloom->storage[i] = 0U;
+    }
+    bloom->popcount = 0U;
 }
 
 static void bloom64_purge(cy_bloom64_t* const bloom)
 {
     assert(bloom != NULL);
-    for (size_t i = 0; i < (bloom->n_bits + 63U) / 64U; i++) { // dear compiler please unroll this
+    for (size_t i = 0; i < ((bloom->n_bits / 64U) * CY_BLOOM64_GENERATIONS); i++) { // dear compiler please unroll this
         bloom->storage[i] = 0U; // I suppose this is better than memset cuz we're aligned to 64 bits.
     }
     bloom->popcount = 0U;
@@ -283,12 +528,12 @@ static uint16_t pick_node_id(const cy_t* const cy, cy_bloom64_t* const bloom, co
     const size_t num_words  = (smaller(node_id_max, bloom->n_bits) + 63U) / 64U;
     size_t       word_index = (size_t)random_uint(cy, 0U, num_words - 1U);
     for (size_t i = 0; i < num_words; i++) {
-        if (bloom->storage[word_index] != UINT64_MAX) {
+        if (bloom64_word(bloom, word_index) != UINT64_MAX) {
             break;
         }
         word_index = (word_index + 1U) % num_words;
     }
-    const uint64_t word = bloom->storage[word_index];
+    const uint64_t word = bloom64_word(bloom, word_index);
     if (word == UINT64_MAX) {
         return (uint16_t)random_uint(cy, 0U, node_id_max); // The filter is full, fallback to random node-ID.
     }
@@ -338,6 +583,16 @@ static cy_err_t ensure_joined(cy_t* const cy)
     return res;
 }
 
+/// Expires the tombstones of the nodes that have left the network gradually; see cy_bloom64_t.
+static void node_id_bloom_rotate(cy_t* const cy, const cy_us_t now)
+{
+    cy_bloom64_t* const bloom = cy->platform->node_id_bloom(cy);
+    assert(bloom != NULL);
+    CY_TRACE(cy, "🌻 Rotating bloom generations; popcount of the generation being retired %zu", bloom->popcount);
+    bloom64_rotate(bloom);
+    cy->ts_bloom_rotated = now;
+}
+
 // =====================================================================================================================
 //                                                  TOPIC UTILITIES
 // =====================================================================================================================
@@ -364,6 +619,55 @@ typedef struct cy_topic_coupling_t
     cy_substitution_t substitutions[CY_TOPIC_NAME_MAX]; ///< Flex array.
 } cy_topic_coupling_t;
 
+/// One entry of the flattened dispatch array of a topic; the order matches the order of the coupling walk.
+/// The callback is not cached because the application is allowed to change it at any moment.
+typedef struct cy_topic_dispatch_t
+{
+    cy_subscriber_t*         subscriber;
+    const cy_substitution_t* substitutions; ///< Points into the coupling, which outlives the entry.
+    size_t                   substitution_count;
+} cy_topic_dispatch_t;
+
+/// The subscriber-side state of a topic; allocated when the topic is first coupled with a subscriber and kept for
+/// the lifetime of the topic. The dispatch fields come first because they are read on every received transfer.
+///
+/// The merged parameters of all subscribers coupled with the topic are updated whenever a coupling or a subscriber
+/// is added, so that resubscription does not need to rescan them.
+///
+/// The subscribers coupled with the topic are flattened into one contiguous array to avoid walking the couplings
+/// and the subscriber lists on every received transfer. Any change of the couplings or their subscribers
+/// increments sub_version; the array is rebuilt on the next received transfer if dispatch_version differs.
+///
+/// The remote reliable publishers that we receive from are kept in a small array for deduplication and
+/// acknowledgment; see cy_publisher_reliable().
+///
+/// The latest transfer for the conflating subscribers is allocated when the first one is to be retained.
+struct cy_topic_rx_t
+{
+    cy_topic_dispatch_t*      dispatch;
+    size_t                    dispatch_count;
+    size_t                    dispatch_split; ///< The conflating subscribers are at this index and after.
+    uint64_t                  dispatch_version;
+    uint64_t                  sub_version;
+    size_t                    reliable_rx_count;
+    struct cy_reliable_rx_t*  reliable_rx;
+    size_t                    reliable_rx_capacity;
+    size_t                    dispatch_capacity;
+    cy_subscription_params_t  sub_params;
+    struct cy_topic_latest_t* latest;
+};
+
+/// The transfer is owned by the topic while valid. It is queued for the notification of the conflating subscribers
+/// while fresh; a fresh transfer that is superseded is released without being seen by them.
+struct cy_topic_latest_t
+{
+    cy_transfer_owned_t       transfer;
+    cy_topic_t*               topic;
+    struct cy_topic_latest_t* next_fresh;
+    bool                      valid;
+    bool                      fresh;
+};
+
 void topic_destroy(cy_t* const cy, cy_topic_t* const topic)
 {
     assert(cy != NULL);
@@ -385,27 +689,21 @@ static bool left_wins(const cy_topic_t* const left, const int_fast8_t r_lage, co
     return (l_lage != r_lage) ? (l_lage > r_lage) : left->hash < r_hash; // older topic wins
 }
 
-/// log(N) index update requires removal and reinsertion.
+/// log(N) heap update; no allocation is involved.
 static void update_gossip_order(cy_t* const        cy,
                                 cy_topic_t* const  topic,
                                 const cy_us_t      ts_gossiped,
                                 const uint_fast8_t priority)
 {
-    assert(cy->topics_by_gossip_time != NULL); // This index is never empty if we have topics
-    cavl2_remove(&cy->topics_by_gossip_time, &topic->index_gossip_order);
-    topic->gossip_priority      = priority;
-    topic->ts_gossiped          = ts_gossiped;
-    const cy_tree_t* const tree = cavl2_find_or_insert(&cy->topics_by_gossip_time, //
-                                                       topic,
-                                                       cavl_comp_topic_gossip_order,
-                                                       topic,
-                                                       cavl_factory_topic_gossip_order);
-    assert(tree == &topic->index_gossip_order);
+    assert(cy->gossip_heap_size > 0); // This index is never empty if we have topics
+    topic->gossip_priority = priority;
+    topic->ts_gossiped     = ts_gossiped;
+    gossip_heap_update(cy, topic);
 }
 
 static void prioritize_gossip(cy_t* const cy, cy_topic_t* const topic, uint_fast8_t priority)
 {
-    assert(cy->topics_by_gossip_time != NULL); // This index is never empty if we have topics
+    assert(cy->gossip_heap_size > 0); // This index is never empty if we have topics
     // Priority fine-tuning:
     // - If this is a pinned topic, it normally cannot collide with another one; we are publishing it just to announce
     // that we have it; as such, the urgency of this action is a bit lower than that of an actual colliding topic
@@ -558,20 +856,19 @@ static uint16_t topic_subject_id(const uint64_t hash, const uint32_t evictions)
 #endif
 }
 
-/// This is linear complexity but we expect to have few subscribers per topic, so it is acceptable.
-/// If this becomes a problem, we can simply store the subscription parameters in the topic fields.
+/// This is linear complexity, which is why the result is cached in the topic; see topic_subscribers_changed().
 static cy_subscription_params_t deduce_subscription_params(const cy_topic_t* const topic)
 {
-    cy_subscription_params_t out = { 0, 0 };
+    cy_subscription_params_t out = { topic->batching ? CY_CONFIG_BATCH_EXTENT : 0, 0, false };
     // Go over all couplings and all subscribers in each coupling.
     const cy_topic_coupling_t* cpl = topic->couplings;
-    assert(cpl != NULL);
     while (cpl != NULL) {
         const cy_subscriber_t* sub = cpl->root->head;
         assert(sub != NULL);
         while (sub != NULL) {
             out.extent              = larger(out.extent, sub->params.extent);
             out.transfer_id_timeout = max_i64(out.transfer_id_timeout, sub->params.transfer_id_timeout);
+            out.conflate            = out.conflate || sub->params.conflate; // Whether to retain the latest transfer.
             sub                     = sub->next;
         }
         cpl = cpl->next;
@@ -579,12 +876,75 @@ static cy_subscription_params_t deduce_subscription_params(const cy_topic_t* con
     return out;
 }
 
+/// Must be invoked whenever a coupling is added to the topic or a subscriber is added to a coupled root.
+/// Refreshes the cached subscription params and invalidates the dispatch array, which is rebuilt lazily.
+static void topic_subscribers_changed(cy_topic_t* const topic)
+{
+    assert(topic->rx != NULL);
+    topic->rx->sub_params = deduce_subscription_params(topic);
+    topic->rx->sub_version++;
+}
+
+/// Flattens the couplings into the dispatch array. Returns false on OOM, leaving the array stale.
+/// This is only invoked at the beginning of the dispatch, so the array is never changed while the callbacks
+/// are iterating over it even if they subscribe.
+static bool topic_dispatch_rebuild(cy_t* const cy, cy_topic_t* const topic)
+{
+    struct cy_topic_rx_t* const rx    = topic->rx;
+    size_t                      count = 0;
+    const cy_topic_coupling_t*  cpl   = topic->couplings;
+    while (cpl != NULL) {
+        for (const cy_subscriber_t* sub = cpl->root->head; sub != NULL; sub = sub->next) {
+            count++;
+        }
+        cpl = cpl->next;
+    }
+    if (count > rx->dispatch_capacity) {
+        cy_topic_dispatch_t* const mem = cy->platform->realloc(cy, rx->dispatch, count * sizeof(cy_topic_dispatch_t));
+        if (mem == NULL) {
+            return false;
+        }
+        rx->dispatch          = mem;
+        rx->dispatch_capacity = count;
+    }
+    // The conflating subscribers are placed after the others so that either kind can be dispatched without the other.
+    size_t i = 0;
+    for (uint_fast8_t pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            rx->dispatch_split = i;
+        }
+        for (cpl = topic->couplings; cpl != NULL; cpl = cpl->next) {
+            for (cy_subscriber_t* sub = cpl->root->head; sub != NULL; sub = sub->next) {
+                if (sub->params.conflate == (pass == 1)) {
+                    rx->dispatch[i++] = (cy_topic_dispatch_t){ .subscriber         = sub,
+                                                               .substitutions      = cpl->substitutions,
+                                                               .substitution_count = cpl->substitution_count };
+                }
+            }
+        }
+    }
+    assert(i == count);
+    rx->dispatch_count   = count;
+    rx->dispatch_version = rx->sub_version;
+    return true;
+}
+
+/// The coupling with the specified subscriber root if one exists. Linear but there are normally few couplings.
+static cy_topic_coupling_t* topic_find_coupling(const cy_topic_t* const topic, const cy_subscriber_root_t* const subr)
+{
+    cy_topic_coupling_t* cpl = topic->couplings;
+    while ((cpl != NULL) && (cpl->root != subr)) {
+        cpl = cpl->next;
+    }
+    return cpl;
+}
+
 /// If a subscription is needed but is not active, this function will attempt to resubscribe.
 /// Errors are handled via the platform handler, so from the caller's perspective this is infallible.
 static void topic_ensure_subscribed(cy_t* const cy, cy_topic_t* const topic)
 {
     if ((topic->couplings != NULL) && (!topic->subscribed)) {
-        const cy_subscription_params_t params = deduce_subscription_params(topic);
+        const cy_subscription_params_t params = topic->rx->sub_params;
         const cy_err_t                 res    = cy->platform->topic_subscribe(cy, topic, params);
         topic->subscribed                     = res == CY_OK;
         CY_TRACE(cy,
@@ -601,24 +961,82 @@ static void topic_ensure_subscribed(cy_t* const cy, cy_topic_t* const topic)
     }
 }
 
+/// Raises the extent of the topic to fit the batches, resubscribing if necessary. The flag is gossiped, so that the
+/// subscribers that join later learn of the batches from any participant of the topic before they arrive.
+/// It is never cleared, because there is no way to tell when the last batching publisher is gone.
+static void topic_batching_discovered(cy_t* const cy, cy_topic_t* const topic)
+{
+    if (!topic->batching) {
+        topic->batching = true;
+        if ((topic->rx != NULL) && (topic->rx->sub_params.extent < CY_CONFIG_BATCH_EXTENT)) {
+            topic->rx->sub_params.extent = CY_CONFIG_BATCH_EXTENT;
+            CY_TRACE(cy, "📦'%s' extent=%zu", topic->name, topic->rx->sub_params.extent);
+            if (topic->subscribed) {
+                cy->platform->topic_unsubscribe(cy, topic);
+                topic->subscribed = false;
+            }
+            topic_ensure_subscribed(cy, topic);
+        }
+    }
+}
+
+/// The state of one topic_allocate() call. Both lists are intrusive, so the memory use is bounded regardless of
+/// the length of the eviction chain.
+typedef struct
+{
+    cy_topic_t* pending; ///< Topics that are out of the subject-ID index awaiting placement; LIFO.
+    cy_topic_t* touched; ///< Every topic affected by this call, each listed once.
+} topic_alloc_batch_t;
+
+/// Removes the topic from the subject-ID index (unless virgin) and puts it on the worklist with the new eviction
+/// counter. The underlying subscription is released when the topic is first affected in the current batch.
+static void topic_displace(cy_t* const                cy,
+                           topic_alloc_batch_t* const batch,
+                           cy_topic_t* const          topic,
+                           const uint32_t             new_evictions,
+                           const bool                 virgin)
+{
+    if (!topic->alloc_touched) {
+        topic->alloc_touched           = true;
+        topic->alloc_subject_id_before = virgin ? UINT16_MAX : cy_topic_subject_id(topic);
+        topic->alloc_next_touched      = batch->touched;
+        batch->touched                 = topic;
+        // We need to make sure no underlying resources are sitting on this topic before we move it.
+        // Otherwise, changing the subject-ID field on the go may break something underneath.
+        if (topic->subscribed) {
+            assert(topic->couplings != NULL);
+            cy->platform->topic_unsubscribe(cy, topic);
+            topic->subscribed = false;
+        }
+    }
+    // We're not allowed to alter the eviction counter as long as the topic remains in the index! So remove it first.
+    if (!virgin) {
+        topic_index_release_subject_id(cy, topic);
+    }
+    // Note that it is possible that (hash+old_evictions)%6144 == (hash+new_evictions)%6144, which means that we
+    // stay with the same subject-ID. No special case is required for this, we handle this normally.
+    topic->evictions          = new_evictions;
+    topic->alloc_next_pending = batch->pending;
+    batch->pending            = topic;
+}
+
 /// This function will schedule all affected topics for gossip, including the one that is being moved.
 /// If this is undesirable, the caller can restore the next gossip time after the call.
 ///
-/// The complexity is O(N log(N)) where N is the number of local topics. This is because we have to search the AVL
-/// index tree on every iteration, and there may be as many iterations as there are local topics in the theoretical
-/// worst case. The amortized worst case is only O(log(N)) because the topics are sparsely distributed thanks to the
-/// topic hash function, unless there is a large number of topics (~>1000).
+/// The eviction chain is resolved iteratively using a worklist: a topic that loses its slot is put on the list and
+/// placed after the current one, so the stack usage is constant. The platform is not involved until the whole
+/// chain is resolved; then, every affected topic is resubscribed exactly once.
+///
+/// Every iteration of the worklist claims one subject-ID in the index, which is O(log(N)) with the default tree index
+/// and constant-time with CY_CONFIG_TOPIC_FLAT_INDEX, where N is the number of local topics. In the theoretical
+/// worst case, the chain visits every local topic and each topic takes up to N slot probes, but the amortized cost is
+/// a small constant number of claims per call because the topics are sparsely distributed thanks to the topic hash
+/// function, unless there is a large number of topics (~>1000). The memory use is constant regardless of the chain.
 static void topic_allocate(cy_t* const cy, cy_topic_t* const topic, const uint32_t new_evictions, const bool virgin)
 {
     assert(cy->topic_count <= CY_TOPIC_SUBJECT_COUNT); // There is certain to be a free subject-ID!
-
-    static const int         call_depth_indent = 2;
-    static _Thread_local int call_depth        = 0U;
-    call_depth++;
     CY_TRACE(cy,
-             "🔜%*s'%s' #%016llx @%04x evict=%llu->%llu age=%llu subscribed=%d couplings=%p",
-             (call_depth - 1) * call_depth_indent,
-             "",
+             "🔜'%s' #%016llx @%04x evict=%llu->%llu age=%llu subscribed=%d couplings=%p",
              topic->name,
              (unsigned long long)topic->hash,
              cy_topic_subject_id(topic),
@@ -628,76 +1046,67 @@ static void topic_allocate(cy_t* const cy, cy_topic_t* const topic, const uint32
              (int)topic->subscribed,
              (void*)topic->couplings);
 
-    // We need to make sure no underlying resources are sitting on this topic before we move it.
-    // Otherwise, changing the subject-ID field on the go may break something underneath.
-    if (topic->subscribed) {
-        assert(topic->couplings != NULL);
-        cy->platform->topic_unsubscribe(cy, topic);
-        topic->subscribed = false;
-    }
-
-    // We're not allowed to alter the eviction counter as long as the topic remains in the tree! So we remove it first.
-    if (!virgin) {
-        cavl2_remove(&cy->topics_by_subject_id, &topic->index_subject_id);
-    }
-
-    // Find a free slot. Every time we find an occupied slot, we have to arbitrate against its current tenant.
-    // Note that it is possible that (hash+old_evictions)%6144 == (hash+new_evictions)%6144, which means that we
-    // stay with the same subject-ID. No special case is required for this, we handle this normally.
-    topic->evictions  = new_evictions;
-    size_t iter_count = 0;
-    while (true) {
-        assert(iter_count <= cy->topic_count);
-        iter_count++;
-        const uint16_t   sid = topic_subject_id(topic->hash, topic->evictions);
-        cy_tree_t* const t   = cavl2_find_or_insert(
-          &cy->topics_by_subject_id, &sid, &cavl_comp_topic_subject_id, topic, &cavl_factory_topic_subject_id);
-        assert(t != NULL); // we will create it if not found, meaning allocation succeeded
-        if (t == &topic->index_subject_id) {
-            break; // Done!
-        }
-        // Someone else is sitting on that subject-ID. We need to arbitrate.
-        cy_topic_t* const other = CAVL2_TO_OWNER(t, cy_topic_t, index_subject_id);
-        assert(topic->hash != other->hash); // This would mean that we inserted the same topic twice, impossible
-        if (left_wins(topic, log2_floor(other->age), other->hash)) {
-            // This is our slot now! The other topic has to move.
-            // This can trigger a chain reaction that in the worst case can leave no topic unturned.
-            // One issue is that the worst-case recursive call depth equals the number of topics in the system.
-            topic_allocate(cy, other, other->evictions + 1U, false);
-            // Remember that we're still out of tree at the moment. We pushed the other topic out of its slot,
-            // but it is possible that there was a chain reaction that caused someone else to occupy this slot.
-            // Since that someone else was ultimately pushed out by the topic that just lost arbitration to us,
-            // we know that the new squatter will lose arbitration to us again.
-            // We will handle it in the exact same way on the next iteration, so we just continue with the loop.
-            // Now, moving that one could also cause a chain reaction, but we know that eventually we will run
-            // out of low-rank topics to move and will succeed.
-        } else {
-            topic->evictions++; // We lost arbitration, keep looking.
+    topic_alloc_batch_t batch = { .pending = NULL, .touched = NULL };
+    topic_displace(cy, &batch, topic, new_evictions, virgin);
+    size_t displaced_count = 0;
+    while (batch.pending != NULL) {
+        cy_topic_t* const tp   = batch.pending;
+        batch.pending          = tp->alloc_next_pending;
+        tp->alloc_next_pending = NULL;
+        // Find a free slot. Every time we find an occupied slot, we have to arbitrate against its current tenant.
+        size_t iter_count = 0;
+        while (true) {
+            assert(iter_count <= cy->topic_count);
+            iter_count++;
+            const uint16_t    sid   = topic_subject_id(tp->hash, tp->evictions);
+            cy_topic_t* const other = topic_index_claim_subject_id(cy, tp, sid);
+            if (other == tp) {
+                break; // Done!
+            }
+            // Someone else is sitting on that subject-ID. We need to arbitrate.
+            assert(tp->hash != other->hash); // This would mean that we inserted the same topic twice, impossible
+            if (left_wins(tp, log2_floor(other->age), other->hash)) {
+                // This is our slot now! The other topic has to move; it will be placed once we are done here.
+                // This can trigger a chain reaction that in the worst case can leave no topic unturned.
+                // If the chain brings a topic back to this slot later, it will lose arbitration to us again,
+                // since it was ultimately pushed out by the topic that just lost to us.
+                topic_displace(cy, &batch, other, other->evictions + 1U, false);
+                cy_stat_add(&other->stats.evictions, 1U);
+                displaced_count++;
+            } else {
+                tp->evictions++; // We lost arbitration, keep looking.
+                cy_stat_add(&tp->stats.evictions, 1U);
+            }
         }
+        CY_TRACE(cy,
+                 "🔚'%s' #%016llx @%04x evict=%llu age=%llu iters=%zu",
+                 tp->name,
+                 (unsigned long long)tp->hash,
+                 cy_topic_subject_id(tp),
+                 (unsigned long long)tp->evictions,
+                 (unsigned long long)tp->age,
+                 iter_count);
     }
 
-    // Whenever we alter a topic, we need to make sure that everyone knows about it.
-    // Recursively we can alter a lot of topics like this.
-    prioritize_gossip(cy, topic, 50);
-
+    // The allocation is settled. Whenever we alter a topic, we need to make sure that everyone knows about it.
     // If a subscription is needed, restore it. Notice that if this call failed in the past, we will retry here
     // as long as there is at least one live subscriber.
-    assert(!topic->subscribed);
-    topic_ensure_subscribed(cy, topic);
-
-    CY_TRACE(cy,
-             "🔚%*s'%s' #%016llx @%04x evict=%llu age=%llu subscribed=%d iters=%zu",
-             (call_depth - 1) * call_depth_indent,
-             "",
-             topic->name,
-             (unsigned long long)topic->hash,
-             cy_topic_subject_id(topic),
-             (unsigned long long)topic->evictions,
-             (unsigned long long)topic->age,
-             (int)topic->subscribed,
-             iter_count);
-    assert(call_depth > 0);
-    call_depth--;
+    while (batch.touched != NULL) {
+        cy_topic_t* const tp   = batch.touched;
+        batch.touched          = tp->alloc_next_touched;
+        tp->alloc_next_touched = NULL;
+        tp->alloc_touched      = false;
+        // The topic may land on the same subject-ID after all; that is not a reallocation.
+        if ((tp->alloc_subject_id_before != UINT16_MAX) && (tp->alloc_subject_id_before != cy_topic_subject_id(tp))) {
+            cy_stat_add(&tp->stats.reallocations, 1U);
+        }
+        prioritize_gossip(cy, tp, 50);
+        assert(!tp->subscribed);
+        topic_ensure_subscribed(cy, tp);
+    }
+    if (displaced_count > 0) {
+        CY_TRACE(cy, "🔀'%s' displaced %zu topic(s)", topic->name, displaced_count);
+    }
 }
 
 static void topic_age(cy_topic_t* const topic, const cy_us_t now)
@@ -712,10 +1121,13 @@ static void topic_age(cy_topic_t* const topic, const cy_us_t now)
 
 /// UB if the topic under this name already exists.
 /// out_topic may be new if the reference is not immediately needed (it can be found later via indexes).
+/// If the topic is learned from the network, the eviction counter is the remote one, which may be zero;
+/// otherwise, it is ignored and the topic starts from the snapshot, if any, or from zero.
 static cy_err_t topic_new(cy_t* const        cy,
                           cy_topic_t** const out_topic,
                           const wkv_str_t    resolved_name,
                           const uint64_t     hash,
+                          const bool         remote,
                           const uint32_t     evictions)
 {
     cy_topic_t* const topic = cy->platform->topic_new(cy);
@@ -726,34 +1138,62 @@ static cy_err_t topic_new(cy_t* const        cy,
     if ((resolved_name.len == 0) || (resolved_name.len > CY_TOPIC_NAME_MAX)) {
         goto bad_name;
     }
+    topic->name = mem_alloc(cy, resolved_name.len + 1U);
+    if (topic->name == NULL) {
+        goto oom;
+    }
     memcpy(topic->name, resolved_name.str, resolved_name.len);
     topic->name[resolved_name.len] = '\0';
 
+    // If the topic allocation was restored from a snapshot, start from there as if it was just gossiped to us.
+    // The eviction counter learned from the network takes precedence even if it is zero; the age is merged.
+    const cy_snapshot_topic_t* const snap     = is_pinned(hash) ? NULL : snapshot_find(cy, hash);
+    const bool                       restored = snap != NULL;
+
     topic->hash      = hash;
-    topic->evictions = evictions;
-    topic->age       = 0;
+    topic->evictions = remote ? evictions : (restored ? snap->evictions : 0U);
+    topic->age       = restored ? snap->age : 0;
 
     topic->ts_aged      = cy_now(cy);
     topic->ts_gossiped  = BIG_BANG;
     topic->ts_received  = BIG_BANG;
     topic->ts_testified = cy_now(cy);
+    topic->ts_named     = BIG_BANG;
 
-    topic->gossip_priority = 10; // Gossip ASAP because this is a new topic.
+    topic->gossip_priority       = 10; // Gossip ASAP because this is a new topic.
+    topic->gossip_name_requested = false;
 
     topic->mortal_next = NULL;
     topic->mortal_prev = NULL;
 
+    topic->alloc_next_pending = NULL;
+    topic->alloc_next_touched      = NULL;
+    topic->alloc_touched           = false;
+    topic->alloc_subject_id_before = UINT16_MAX;
+
     topic->pub_transfer_id = random_u64(cy); // https://forum.opencyphal.org/t/improve-the-transfer-id-timeout/2375
     topic->pub_count       = 0;
 
     topic->couplings  = NULL;
     topic->subscribed = false;
+    topic->rx         = NULL; // Allocated when the first subscriber is coupled.
 
-    cy->ts_event = cy->ts_local_event = cy_now(cy);
+    topic->reliable_tx = NULL;
+    topic->ack_next    = NULL;
+    topic->ack_pending = false;
+    topic->batching    = false;
+
+    // A restored topic is not a new event because its allocation is expected to be already settled network-wide.
+    if (!restored) {
+        cy->ts_event = cy->ts_local_event = cy_now(cy);
+    }
 
     if (cy->topic_count >= CY_TOPIC_SUBJECT_COUNT) {
         goto bad_name;
     }
+    if (!gossip_heap_reserve(cy) || !topic_index_reserve(cy)) {
+        goto oom;
+    }
 
     topic->index_name = wkv_set(&cy->topics_by_name, resolved_name);
     if (topic->index_name == NULL) {
@@ -762,21 +1202,18 @@ static cy_err_t topic_new(cy_t* const        cy,
     assert(topic->index_name->value == NULL); // Cannot invoke this if such topic already exists!
     topic->index_name->value = topic;
 
-    // Insert the new topic into the name index tree. If it's not unique, bail out.
-    const cy_tree_t* const res_tree =
-      cavl2_find_or_insert(&cy->topics_by_hash, &topic->hash, &cavl_comp_topic_hash, topic, &cavl2_trivial_factory);
-    assert(res_tree == &topic->index_hash); // Cannot invoke this if such topic already exists!
+    // Insert the new topic into the hash index. It is known to be unique because the name is unique.
+    topic_index_insert_hash(cy, topic);
 
     // Ensure the topic is in the gossip index. This is needed for allocation.
-    (void)cavl2_find_or_insert(
-      &cy->topics_by_gossip_time, topic, &cavl_comp_topic_gossip_order, topic, &cavl_factory_topic_gossip_order);
+    gossip_heap_insert(cy, topic);
 
     // Allocate a subject-ID for the topic and insert it into the subject index tree.
     // Pinned topics all have canonical names, and we have already ascertained that the name is unique,
     // meaning that another pinned topic is not occupying the same subject-ID.
     // Remember that topics arbitrate locally the same way they do externally, meaning that adding a new local topic
     // may displace another local one.
-    topic_allocate(cy, topic, 0, true);
+    topic_allocate(cy, topic, topic->evictions, true);
 
     if (out_topic != NULL) {
         *out_topic = topic;
@@ -795,10 +1232,12 @@ static cy_err_t topic_new(cy_t* const        cy,
     return 0;
 
 oom: // TODO correct deinitialization
+    mem_free(cy, topic->name);
     cy->platform->topic_destroy(cy, topic);
     return CY_ERR_NAME;
 
 bad_name: // TODO correct deinitialization
+    mem_free(cy, topic->name);
     cy->platform->topic_destroy(cy, topic);
     return CY_ERR_NAME;
 }
@@ -812,7 +1251,7 @@ static cy_err_t topic_ensure(cy_t* const cy, cy_topic_t** const out_topic, const
         }
         return 0;
     }
-    return topic_new(cy, out_topic, resolved_name, topic_hash(resolved_name), 0);
+    return topic_new(cy, out_topic, resolved_name, topic_hash(resolved_name), false, 0);
 }
 
 /// Create a new coupling between a topic and a subscriber.
@@ -836,6 +1275,14 @@ static cy_err_t topic_couple(cy_t* const                 cy,
              subr_name,
              substitution_count);
 #endif
+    // The subscriber-side state is allocated with the first coupling and is never released afterward.
+    if (topic->rx == NULL) {
+        topic->rx = (struct cy_topic_rx_t*)mem_alloc(cy, sizeof(struct cy_topic_rx_t));
+        if (topic->rx == NULL) {
+            return CY_ERR_MEMORY;
+        }
+        memset(topic->rx, 0, sizeof(struct cy_topic_rx_t));
+    }
     // Allocate the new coupling object with the substitutions flex array.
     // Each topic keeps its own couplings because the sets of subscription names and topic names are orthogonal.
     cy_topic_coupling_t* const cpl = (cy_topic_coupling_t*)mem_alloc(
@@ -847,13 +1294,14 @@ static cy_err_t topic_couple(cy_t* const                 cy,
         cpl->substitution_count = substitution_count;
         // When we copy the substitutions, we assume that the lifetime of the substituted string segments is at least
         // the same as the lifetime of the topic, which is true because the substitutions point into the topic name
-        // string, which is part of the topic object.
+        // string, which is owned by the topic object.
         const wkv_substitution_t* s = substitutions;
         for (size_t i = 0U; s != NULL; i++) {
             assert(i < cpl->substitution_count);
             cpl->substitutions[i] = (cy_substitution_t){ .str = s->str, .ordinal = s->ordinal };
             s                     = s->next;
         }
+        topic_subscribers_changed(topic);
         // If this is a verbatim subscriber, the topic is no (longer) mortal.
         if ((subr->index_pattern == NULL) && is_mortal(cy, topic)) {
             mortal_delist(cy, topic);
@@ -877,8 +1325,25 @@ static void* wkv_cb_couple_new_topic(const wkv_event_t evt)
     return (0 == res) ? NULL : "";
 }
 
+static_assert((CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY > 0) &&
+                (CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY & (CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY - 1U)) == 0,
+              "CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY shall be a power of two");
+
+/// True if the topic with this hash is known to match none of the current patterns.
+static bool pattern_miss_known(const cy_t* const cy, const uint64_t hash)
+{
+    return (hash != 0) && (cy->pattern_misses[hash & (CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY - 1U)] == hash);
+}
+
+/// Evicts the previous entry occupying the same slot, if any.
+static void pattern_miss_remember(cy_t* const cy, const uint64_t hash)
+{
+    cy->pattern_misses[hash & (CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY - 1U)] = hash;
+}
+
 /// If there is a pattern subscriber matching the name of this topic, attempt to create a new subscription.
 /// If a new subscription is created, the new topic will be returned.
+/// The names that match nothing are remembered by hash, so the repeated gossips of the same topic are cheap.
 static cy_topic_t* topic_subscribe_if_matching(cy_t* const     cy,
                                                const wkv_str_t resolved_name,
                                                const uint64_t  hash,
@@ -888,14 +1353,22 @@ static cy_topic_t* topic_subscribe_if_matching(cy_t* const     cy,
     if (resolved_name.len == 0) {
         return NULL; // Ensure the remote is not trying to feed us an empty name, that's bad.
     }
+    if (cy->pattern_subscription_count == 0) {
+        return NULL; // Nothing to match against; no point caching the miss.
+    }
+    if (pattern_miss_known(cy, hash)) {
+        cy_stat_add(&cy->stats.pattern_miss_cache_hits, 1U);
+        return NULL;
+    }
     if (NULL == wkv_route(&cy->subscribers_by_pattern, resolved_name, NULL, wkv_cb_first)) {
+        pattern_miss_remember(cy, hash);
         return NULL; // No match.
     }
     CY_TRACE(cy, "✨'%s'", resolved_name.str);
     // Create the new topic.
     cy_topic_t* topic = NULL;
     {
-        const cy_err_t res = topic_new(cy, &topic, resolved_name, hash, evictions);
+        const cy_err_t res = topic_new(cy, &topic, resolved_name, hash, true, evictions);
         if (res != CY_OK) {
             cy->platform->topic_on_subscription_error(cy, NULL, res);
             return NULL;
@@ -920,103 +1393,642 @@ static void* wkv_cb_topic_scout_response(const wkv_event_t evt)
     cy_t* const       cy    = (cy_t*)evt.context;
     cy_topic_t* const topic = (cy_topic_t*)evt.node->value;
     CY_TRACE(cy, "📢'%s' #%016llx @%04x", topic->name, (unsigned long long)(topic->hash), cy_topic_subject_id(topic));
+    topic->gossip_name_requested = true; // The scout matches the names, so a nameless response would be useless.
     prioritize_gossip(cy, topic, 10);
     return NULL;
 }
 
 // =====================================================================================================================
-//                                                      HEARTBEAT
+//                                                  RELIABLE DELIVERY
 // =====================================================================================================================
 
-#define FLAG_PUBLISHING 1U ///< Source is actively publishing this topic.
-#define FLAG_SUBSCRIBED 2U ///< Source is subscribed to this topic.
-#define FLAG_RECEIVING  4U ///< At least one transfer was received on this topic since last gossip.
-#define FLAG_SCOUT      8U ///< Scout message requesting everyone who knows matching topics to respond.
+/// The pending set of a retained transfer is a bitmask over the peers of its publisher, hence the limit.
+#define RELIABLE_PEERS_MAX 64U
+
+/// A peer that has not been heard from for this long is assumed gone; its acknowledgments are no longer awaited.
+/// Same for a remote reliable publisher that we keep acknowledging.
+#define RELIABLE_PEER_TIMEOUT_us (30 * MEGA)
+
+/// Retransmission timeout bounds per RFC 6298; the initial value is used until the first round-trip sample.
+#define RELIABLE_RTO_INITIAL_us (200 * KILO)
+#define RELIABLE_RTO_MIN_us     (2 * KILO)
+#define RELIABLE_RTO_MAX_us     (2 * MEGA)
+
+#define RELIABLE_ACK_KIND_MESSAGE 0U
 
-/// We could have used Nunavut, but we only need a single message and it's very simple, so we do it manually.
 typedef struct
 {
-    uint32_t uptime;
-    uint8_t  user_word[3]; ///< Used to be: health, mode, vendor-specific status code. Now opaque user-defined 24 bits.
-    uint8_t  version;      ///< Union tag; Cyphal v1.0 -- 0; Cyphal v1.1 -- 1.
-    // The following fields are conditional on version=1.
-    uint64_t uid;
-    uint64_t topic_hash;
-    uint32_t topic_evictions;
-    uint8_t  _reserved_;    ///< May be used in the future to extend the evictions counter to 40 bits if needed.
-    int8_t   topic_log_age; ///< floor(log2(topic_age)), range [-1,63], where -1 represents floor(log2(0)).
-    uint8_t  flags;
-    uint8_t  topic_name_len;
-    char     topic_name[CY_TOPIC_NAME_MAX + 1];
-} heartbeat_t;
-
-static cy_err_t publish_heartbeat(cy_t* const cy, const cy_us_t now, heartbeat_t* const message)
+    uint16_t node_id;
+    cy_us_t  ts_seen;
+} reliable_peer_t;
+
+/// A published transfer retained until every peer in the pending set has acknowledged it.
+typedef struct
 {
-    cy_err_t res = ensure_joined(cy);
-    if (res != CY_OK) {
-        return res;
-    }
+    uint64_t transfer_id;
+    uint64_t pending; ///< Bit N set: awaiting acknowledgment from peers[N].
+    cy_us_t  ts_published;
+    cy_us_t  ts_retransmit;
+    cy_us_t  deadline;
+    uint32_t attempts;
+    size_t   size;
+    void*    data;
+} reliable_entry_t;
 
-    // Fill and serialize the message.
-    message->uptime           = (uint32_t)((now - cy->ts_started) / MEGA);
-    message->version          = 1;
-    message->uid              = cy->uid;
-    const size_t message_size = offsetof(heartbeat_t, topic_name) + message->topic_name_len;
-    assert(message_size <= sizeof(heartbeat_t));
-    assert(message->topic_name_len <= CY_TOPIC_NAME_MAX);
-    const cy_buffer_borrowed_t payload = { .next = NULL, .view = { .data = message, .size = message_size } };
+/// The retained transfers form a ring ordered by transfer-ID. An acknowledged transfer in the middle keeps its place
+/// until those before it are acknowledged or timed out, so the window bounds the span of the outstanding transfers.
+struct cy_reliable_tx_t
+{
+    cy_publisher_t*          pub;
+    struct cy_reliable_tx_t* next_in_topic;
+    struct cy_reliable_tx_t* next;
 
-    // Publish the message.
-    assert(cy->node_id <= cy->platform->node_id_max);
-    res = cy->platform->topic_publish(cy, &cy->heartbeat_pub, now + HEARTBEAT_PUB_TIMEOUT_us, payload);
-    cy->heartbeat_pub.topic->pub_transfer_id++;
+    cy_us_t delivery_timeout;
+    cy_us_t srtt;
+    cy_us_t rttvar;
+    cy_us_t rto;
 
-    // Schedule the next heartbeat.
-    // If this heartbeat failed to publish, we simply give up and move on to try again in the next period.
-    cy->heartbeat_next += cy->heartbeat_period_max; // Do not accumulate heartbeat phase slip.
-    cy->heartbeat_last = now;
-    return res;
+    reliable_peer_t peers[RELIABLE_PEERS_MAX];
+    uint64_t        peer_mask;
+
+    size_t           window;
+    size_t           head;
+    size_t           count;
+    reliable_entry_t entries[];
+};
+
+/// The deduplication and acknowledgment state of one remote reliable publisher on a local topic.
+struct cy_reliable_rx_t
+{
+    uint16_t node_id;
+    bool     started;
+    bool     dirty; ///< Received something not yet acknowledged.
+    uint64_t latest;
+    uint64_t mask; ///< Bit N set: latest-1-N was received.
+    cy_us_t  ts_seen;
+};
+
+static reliable_entry_t* reliable_entry(struct cy_reliable_tx_t* const tx, const size_t index)
+{
+    assert(index < tx->count);
+    return &tx->entries[(tx->head + index) % tx->window];
 }
 
-static cy_err_t publish_heartbeat_gossip(cy_t* const cy, cy_topic_t* const topic, const cy_us_t now)
+static void reliable_entry_release(cy_t* const cy, reliable_entry_t* const entry)
 {
+    entry->pending = 0;
+    mem_free(cy, entry->data);
+    entry->data = NULL;
+}
+
+/// Removes the completed transfers from the head of the ring to make room for new ones.
+static void reliable_compact(cy_t* const cy, struct cy_reliable_tx_t* const tx)
+{
+    while ((tx->count > 0) && (tx->entries[tx->head].pending == 0)) {
+        reliable_entry_release(cy, &tx->entries[tx->head]);
+        tx->head = (tx->head + 1U) % tx->window;
+        tx->count--;
+    }
+}
+
+static int_fast8_t reliable_peer_find(const struct cy_reliable_tx_t* const tx, const uint16_t node_id)
+{
+    for (int_fast8_t i = 0; i < (int_fast8_t)RELIABLE_PEERS_MAX; i++) {
+        if (((tx->peer_mask & (1ULL << i)) != 0) && (tx->peers[i].node_id == node_id)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/// Returns the index of the peer, adding it if new; negative if there is no room for more peers.
+static int_fast8_t reliable_peer_ensure(cy_t* const                    cy,
+                                        struct cy_reliable_tx_t* const tx,
+                                        const uint16_t                 node_id,
+                                        const cy_us_t                  ts)
+{
+    int_fast8_t i = reliable_peer_find(tx, node_id);
+    if ((i < 0) && (tx->peer_mask != UINT64_MAX)) {
+        i = 0;
+        while ((tx->peer_mask & (1ULL << i)) != 0) {
+            i++;
+        }
+        tx->peers[i].node_id = node_id;
+        tx->peer_mask |= 1ULL << i;
+        CY_TRACE(cy, "🤝'%s' subscriber %04x joined", tx->pub->topic->name, node_id);
+    }
+    if (i >= 0) {
+        tx->peers[i].ts_seen = ts;
+    }
+    return i;
+}
+
+/// The subscriber is gone, so none of the retained transfers will wait for it anymore.
+static void reliable_peer_remove(cy_t* const cy, struct cy_reliable_tx_t* const tx, const int_fast8_t index)
+{
+    assert((index >= 0) && ((tx->peer_mask & (1ULL << index)) != 0));
+    CY_TRACE(cy, "🤝'%s' subscriber %04x left", tx->pub->topic->name, tx->peers[index].node_id);
+    tx->peer_mask &= ~(1ULL << index);
+    for (size_t k = 0; k < tx->count; k++) {
+        reliable_entry(tx, k)->pending &= ~(1ULL << index);
+    }
+}
+
+/// RFC 6298 with Karn's rule: only the transfers that were never retransmitted are sampled.
+static void reliable_rtt_sample(struct cy_reliable_tx_t* const tx, const cy_us_t rtt)
+{
+    if (tx->srtt == 0) {
+        tx->srtt   = rtt;
+        tx->rttvar = rtt / 2;
+    } else {
+        const cy_us_t err = (tx->srtt > rtt) ? (tx->srtt - rtt) : (rtt - tx->srtt);
+        tx->rttvar        = ((3 * tx->rttvar) + err) / 4;
+        tx->srtt          = ((7 * tx->srtt) + rtt) / 8;
+    }
+    tx->rto = tx->srtt + max_i64(RELIABLE_RTO_MIN_us, 4 * tx->rttvar);
+    tx->rto = (tx->rto < RELIABLE_RTO_MAX_us) ? tx->rto : RELIABLE_RTO_MAX_us;
+}
+
+/// Publishes the retained transfer again under its original transfer-ID.
+static void reliable_retransmit(cy_t* const                    cy,
+                                struct cy_reliable_tx_t* const tx,
+                                reliable_entry_t* const        entry,
+                                const cy_us_t                  now)
+{
+    cy_topic_t* const          topic   = tx->pub->topic;
+    const cy_buffer_borrowed_t payload = { .next = NULL, .view = { .size = entry->size, .data = entry->data } };
+    const cy_err_t res = cy->platform->topic_publish(cy, tx->pub, now + tx->rto, entry->transfer_id, payload);
+    if (res == CY_OK) {
+        cy_stat_add(&topic->stats.retransmissions, 1U);
+    } else {
+        cy_stat_add(&topic->stats.drops, 1U);
+    }
+    // Exponential backoff; the attempt counter also disqualifies this transfer from the round-trip sampling.
+    const uint_fast8_t shift = (uint_fast8_t)smaller(entry->attempts, 16U);
+    const cy_us_t      rto   = tx->rto << shift;
+    entry->ts_retransmit     = now + ((rto < RELIABLE_RTO_MAX_us) ? rto : RELIABLE_RTO_MAX_us);
+    entry->attempts++;
+}
+
+/// Retransmits the overdue transfers, diagnoses the failed ones, and forgets the peers that went silent.
+static void reliable_tx_update(cy_t* const cy, struct cy_reliable_tx_t* const tx, const cy_us_t now)
+{
+    for (int_fast8_t i = 0; i < (int_fast8_t)RELIABLE_PEERS_MAX; i++) {
+        if (((tx->peer_mask & (1ULL << i)) != 0) && ((tx->peers[i].ts_seen + RELIABLE_PEER_TIMEOUT_us) < now)) {
+            reliable_peer_remove(cy, tx, i);
+        }
+    }
+    for (size_t k = 0; k < tx->count; k++) {
+        reliable_entry_t* const entry = reliable_entry(tx, k);
+        if (entry->pending == 0) {
+            continue;
+        }
+        if (now >= entry->deadline) {
+            CY_TRACE(cy,
+                     "⌛'%s' tid=%llu undelivered after %u attempts; pending=%016llx",
+                     tx->pub->topic->name,
+                     (unsigned long long)entry->transfer_id,
+                     (unsigned)entry->attempts,
+                     (unsigned long long)entry->pending);
+            cy_stat_add(&tx->pub->topic->stats.delivery_failures, 1U);
+            reliable_entry_release(cy, entry);
+        } else if (now >= entry->ts_retransmit) {
+            reliable_retransmit(cy, tx, entry, now);
+        }
+    }
+    reliable_compact(cy, tx);
+}
+
+/// The earliest retransmission or delivery timeout among the pending entries, not later than the bound.
+/// The peer timeouts are not considered because they are long and the heartbeat wakes up the node regularly anyway.
+static cy_us_t reliable_next_deadline(const cy_t* const cy, cy_us_t bound)
+{
+    for (const struct cy_reliable_tx_t* tx = cy->reliable_tx_head; tx != NULL; tx = tx->next) {
+        for (size_t k = 0; k < tx->count; k++) {
+            const reliable_entry_t* const entry = &tx->entries[(tx->head + k) % tx->window];
+            if (entry->pending != 0) {
+                bound = min_i64(bound, min_i64(entry->ts_retransmit, entry->deadline));
+            }
+        }
+    }
+    return bound;
+}
+
+/// Checked before the publication so that a full window is reported before any side effects take place.
+static cy_err_t reliable_admit(cy_t* const cy, struct cy_reliable_tx_t* const tx)
+{
+    reliable_compact(cy, tx);
+    return (tx->count < tx->window) ? CY_OK : CY_ERR_CAPACITY;
+}
+
+/// Makes a private copy of the payload for retransmission. NULL data is returned if there is nobody to deliver to.
+static cy_err_t reliable_copy(cy_t* const                          cy,
+                              const struct cy_reliable_tx_t* const tx,
+                              const cy_buffer_borrowed_t           payload,
+                              cy_bytes_mut_t* const                out)
+{
+    *out = (cy_bytes_mut_t){ .size = 0, .data = NULL };
+    if (tx->peer_mask != 0) {
+        out->size = cy_buffer_borrowed_size(payload);
+        out->data = mem_alloc(cy, larger(out->size, 1U));
+        if (out->data == NULL) {
+            return CY_ERR_MEMORY;
+        }
+        (void)cy_buffer_borrowed_gather(payload, *out);
+    }
+    return CY_OK;
+}
+
+/// Takes ownership of the copy made by reliable_copy() after the transfer has been published.
+static void reliable_retain(cy_t* const                    cy,
+                            struct cy_reliable_tx_t* const tx,
+                            const uint64_t                 transfer_id,
+                            const cy_bytes_mut_t           copy)
+{
+    assert((tx->count < tx->window) && (copy.data != NULL));
+    const cy_us_t           now   = cy_now(cy);
+    reliable_entry_t* const entry = &tx->entries[(tx->head + tx->count) % tx->window];
+    tx->count++;
+    *entry = (reliable_entry_t){ .transfer_id   = transfer_id,
+                                 .pending       = tx->peer_mask,
+                                 .ts_published  = now,
+                                 .ts_retransmit = now + tx->rto,
+                                 .deadline      = now + tx->delivery_timeout,
+                                 .attempts      = 1,
+                                 .size          = copy.size,
+                                 .data          = copy.data };
+}
+
+/// NULL if not found, which is always the case if the topic has no subscriber-side state.
+static struct cy_reliable_rx_t* reliable_rx_find(const cy_topic_t* const topic, const uint16_t node_id)
+{
+    const struct cy_topic_rx_t* const trx = topic->rx;
+    for (size_t i = 0; (trx != NULL) && (i < trx->reliable_rx_count); i++) {
+        if (trx->reliable_rx[i].node_id == node_id) {
+            return &trx->reliable_rx[i];
+        }
+    }
+    return NULL;
+}
+
+static void reliable_rx_remove(cy_topic_t* const topic, struct cy_reliable_rx_t* const rx)
+{
+    struct cy_topic_rx_t* const trx = topic->rx;
+    assert((trx != NULL) && (rx >= trx->reliable_rx) && (rx < (trx->reliable_rx + trx->reliable_rx_count)));
+    *rx = trx->reliable_rx[--trx->reliable_rx_count];
+}
+
+/// Returns NULL if out of memory. The streams that went silent are dropped here since this is invoked regularly.
+/// The topic shall have the subscriber-side state.
+static struct cy_reliable_rx_t* reliable_rx_ensure(cy_t* const       cy,
+                                                   cy_topic_t* const topic,
+                                                   const uint16_t    node_id,
+                                                   const cy_us_t     ts,
+                                                   bool* const       out_new)
+{
+    struct cy_topic_rx_t* const trx = topic->rx;
+    assert(trx != NULL);
+    *out_new = false;
+    for (size_t i = 0; i < trx->reliable_rx_count;) {
+        if ((trx->reliable_rx[i].node_id != node_id) &&
+            ((trx->reliable_rx[i].ts_seen + RELIABLE_PEER_TIMEOUT_us) < ts)) {
+            reliable_rx_remove(topic, &trx->reliable_rx[i]);
+        } else {
+            i++;
+        }
+    }
+    struct cy_reliable_rx_t* rx = reliable_rx_find(topic, node_id);
+    if (rx == NULL) {
+        if (trx->reliable_rx_count >= trx->reliable_rx_capacity) {
+            const size_t                   capacity = larger(trx->reliable_rx_capacity * 2U, 4U);
+            struct cy_reliable_rx_t* const mem =
+              cy->platform->realloc(cy, trx->reliable_rx, capacity * sizeof(struct cy_reliable_rx_t));
+            if (mem == NULL) {
+                return NULL;
+            }
+            trx->reliable_rx          = mem;
+            trx->reliable_rx_capacity = capacity;
+        }
+        rx       = &trx->reliable_rx[trx->reliable_rx_count++];
+        *rx      = (struct cy_reliable_rx_t){ .node_id = node_id };
+        *out_new = true;
+    }
+    rx->ts_seen = ts;
+    return rx;
+}
+
+static cy_err_t reliable_ack_send(cy_t* const             cy,
+                                  const cy_topic_t* const topic,
+                                  const uint16_t          node_id,
+                                  const uint64_t          transfer_id,
+                                  const uint64_t          mask)
+{
+    unsigned char  buffer[CY_RELIABLE_ACK_EXTENT];
+    unsigned char* ptr = serialize_u64(buffer, topic->hash);
+    ptr                = serialize_u64(ptr, transfer_id);
+    *ptr++             = RELIABLE_ACK_KIND_MESSAGE;
+    ptr                = serialize_u64(ptr, mask);
+    assert(ptr == (buffer + sizeof(buffer)));
+    const cy_transfer_metadata_t meta    = { .priority       = cy_prio_high,
+                                             .remote_node_id = node_id,
+                                             .transfer_id    = transfer_id };
+    const cy_buffer_borrowed_t   payload = { .next = NULL, .view = { .size = sizeof(buffer), .data = buffer } };
+    return cy->platform->p2p(cy, CY_P2P_SERVICE_ID_RELIABLE_ACK, meta, cy_now(cy) + RELIABLE_RTO_MIN_us, payload);
+}
+
+static void reliable_ack_schedule(cy_t* const cy, cy_topic_t* const topic)
+{
+    if (!topic->ack_pending) {
+        topic->ack_pending   = true;
+        topic->ack_next      = cy->ack_pending_head;
+        cy->ack_pending_head = topic;
+    }
+}
+
+/// Sends one acknowledgment per remote publisher that has sent anything since the last flush.
+static void reliable_ack_flush(cy_t* const cy)
+{
+    while (cy->ack_pending_head != NULL) {
+        cy_topic_t* const topic = cy->ack_pending_head;
+        cy->ack_pending_head    = topic->ack_next;
+        topic->ack_next         = NULL;
+        topic->ack_pending      = false;
+        assert(topic->rx != NULL); // Only the topics with remote reliable publishers are scheduled.
+        for (size_t i = 0; i < topic->rx->reliable_rx_count; i++) {
+            struct cy_reliable_rx_t* const rx = &topic->rx->reliable_rx[i];
+            if (rx->dirty) {
+                rx->dirty = false;
+                (void)reliable_ack_send(cy, topic, rx->node_id, rx->latest, rx->mask);
+            }
+        }
+    }
+}
+
+/// Returns true if the transfer is a duplicate and shall not be delivered.
+/// The transfer-IDs are compared modulo the transport mask; the window is much narrower than half of its range.
+static bool reliable_rx_is_duplicate(cy_t* const cy, cy_topic_t* const topic, const cy_transfer_owned_t* const transfer)
+{
+    struct cy_reliable_rx_t* const rx = reliable_rx_find(topic, transfer->metadata.remote_node_id);
+    if (rx == NULL) {
+        return false; // Not a reliable publisher, no deduplication.
+    }
+    const uint64_t tid_mask = cy->platform->transfer_id_mask;
+    const uint64_t tid      = transfer->metadata.transfer_id & tid_mask;
+    rx->ts_seen             = transfer->timestamp;
+    reliable_ack_schedule(cy, topic);
+    if (!rx->started) {
+        rx->started = true;
+        rx->latest  = tid;
+        rx->mask    = 0;
+        rx->dirty   = true;
+        return false;
+    }
+    const uint64_t behind = (rx->latest - tid) & tid_mask;
+    if (behind == 0) {
+        rx->dirty = true; // Our acknowledgment was lost; repeat it.
+        return true;
+    }
+    if (behind <= (tid_mask / 2U)) {
+        if (behind > 64U) { // Too old to be represented in the mask; acknowledge separately.
+            // We cannot tell if it was received before, so deliver it rather than risk losing it.
+            (void)reliable_ack_send(cy, topic, rx->node_id, tid, 0);
+            return false;
+        }
+        const uint64_t bit = 1ULL << (behind - 1U);
+        const bool     dup = (rx->mask & bit) != 0;
+        rx->mask |= bit;
+        rx->dirty = true;
+        return dup;
+    }
+    const uint64_t ahead = (tid - rx->latest) & tid_mask;
+    if (rx->dirty && (ahead > 64U)) { // The shift would drop unacknowledged transfers from the mask.
+        (void)reliable_ack_send(cy, topic, rx->node_id, rx->latest, rx->mask);
+    }
+    rx->mask   = (ahead > 64U) ? 0 : ((ahead == 64U) ? 1ULL << 63U : ((rx->mask << 1U) | 1U) << (ahead - 1U));
+    rx->latest = tid;
+    rx->dirty  = true;
+    return false;
+}
+
+/// Clears the pending bit of the acknowledging peer in every retained transfer covered by the acknowledgment.
+static void reliable_on_ack(cy_t* const                    cy,
+                            struct cy_reliable_tx_t* const tx,
+                            const uint16_t                 node_id,
+                            const uint64_t                 transfer_id,
+                            const uint64_t                 mask,
+                            const cy_us_t                  ts)
+{
+    const int_fast8_t peer = reliable_peer_ensure(cy, tx, node_id, ts);
+    if (peer < 0) {
+        return; // Too many subscribers; this one receives best-effort only.
+    }
+    const uint64_t bit      = 1ULL << peer;
+    const uint64_t tid_mask = cy->platform->transfer_id_mask;
+    for (size_t k = 0; k < tx->count; k++) {
+        reliable_entry_t* const entry = reliable_entry(tx, k);
+        if ((entry->pending & bit) == 0) {
+            continue;
+        }
+        const uint64_t behind = (transfer_id - entry->transfer_id) & tid_mask;
+        if ((behind == 0) || ((behind <= 64U) && (((mask >> (behind - 1U)) & 1U) != 0))) {
+            entry->pending &= ~bit;
+            if ((entry->pending == 0) && (entry->attempts == 1)) {
+                reliable_rtt_sample(tx, ts - entry->ts_published);
+            }
+        }
+    }
+    reliable_compact(cy, tx);
+}
+
+/// Learns the subscribers of the local reliable publishers and the remote reliable publishers of the local topics.
+static void reliable_on_gossip(cy_t* const       cy,
+                               cy_topic_t* const topic,
+                               const uint16_t    remote_node_id,
+                               const bool        remote_subscribed,
+                               const bool        remote_reliable_publishing,
+                               const cy_us_t     ts)
+{
+    if (remote_node_id > cy->platform->node_id_max) {
+        return;
+    }
+    for (struct cy_reliable_tx_t* tx = topic->reliable_tx; tx != NULL; tx = tx->next_in_topic) {
+        if (remote_subscribed) {
+            (void)reliable_peer_ensure(cy, tx, remote_node_id, ts);
+        } else {
+            const int_fast8_t i = reliable_peer_find(tx, remote_node_id);
+            if (i >= 0) {
+                reliable_peer_remove(cy, tx, i);
+            }
+        }
+    }
+    if (remote_reliable_publishing && (topic->couplings != NULL)) {
+        bool is_new = false;
+        (void)reliable_rx_ensure(cy, topic, remote_node_id, ts, &is_new);
+        if (is_new) { // Let the publisher know about us ASAP so that it starts retaining the transfers for us.
+            prioritize_gossip(cy, topic, 10);
+        }
+    } else {
+        struct cy_reliable_rx_t* const rx = reliable_rx_find(topic, remote_node_id);
+        if (rx != NULL) {
+            reliable_rx_remove(topic, rx);
+        }
+    }
+}
+
+// =====================================================================================================================
+//                                                      HEARTBEAT
+// =====================================================================================================================
+
+/// Gossips of this priority and higher are only published when the allocation of a topic changes or conflicts with
+/// that of a remote node. Such gossips omit the topic name, unless the topic has never been gossiped before,
+/// because the other participants of the topic already know it by the hash, and the conflicts are resolved using the
+/// hash and the evictions alone. Pinned topics have the priority decremented by one, hence the odd threshold.
+///
+/// The other gossips omit the name as well if it has been seen on the network within the last heartbeat period,
+/// either in our own gossip or in that of a peer on the same topic. All nodes hear the same heartbeats, so the name
+/// is repeated about once per period no matter how many nodes share the topic. A node that missed it and wants
+/// to know whether the topic matches its patterns asks for the name using a nameless scout.
+#define HEARTBEAT_NAMELESS_PRIORITY_MIN 49U
+
+/// The wire format of the heartbeat is defined in cy_wire.h.
+static_assert(CY_CONFIG_HEARTBEAT_EXTENT >= HEARTBEAT_SINGLE_SIZE_MAX, "Heartbeat extent too small for one gossip");
+
+/// The header is populated here; the records shall be already serialized after it.
+static cy_err_t publish_heartbeat(cy_t* const cy, const cy_us_t now, unsigned char* const buffer, const size_t size)
+{
+    cy_err_t res = ensure_joined(cy);
+    if (res != CY_OK) {
+        return res;
+    }
+    assert((size > HEARTBEAT_HEADER_SIZE) && (size <= CY_CONFIG_HEARTBEAT_EXTENT));
+    heartbeat_header_serialize((uint32_t)((now - cy->ts_started) / MEGA), cy->uid, buffer);
+    const cy_buffer_borrowed_t payload = { .next = NULL, .view = { .data = buffer, .size = size } };
+
+    // Publish the message.
+    assert(cy->node_id <= cy->platform->node_id_max);
+    res = cy->platform->topic_publish(
+      cy, &cy->heartbeat_pub, now + HEARTBEAT_PUB_TIMEOUT_us, cy->heartbeat_pub.topic->pub_transfer_id, payload);
+    cy->heartbeat_pub.topic->pub_transfer_id++;
+    if (res == CY_OK) {
+        cy_stat_add(&cy->stats.heartbeats_out, 1U);
+        cy_stat_add(&cy->heartbeat_pub.topic->stats.transfers_out, 1U);
+        cy_stat_add(&cy->heartbeat_pub.topic->stats.bytes_out, size);
+    } else {
+        cy_stat_add(&cy->heartbeat_pub.topic->stats.drops, 1U);
+    }
+
+    // Schedule the next heartbeat.
+    // If this heartbeat failed to publish, we simply give up and move on to try again in the next period.
+    cy->heartbeat_next += cy->heartbeat_period_max; // Do not accumulate heartbeat phase slip.
+    cy->heartbeat_last = now;
+    return res;
+}
+
+/// Serializes the gossip record of the topic into the buffer and reschedules the topic.
+/// Returns the record size, or zero if it does not fit into the remaining space; the topic is not modified then.
+static size_t gossip_topic(cy_t* const          cy,
+                           cy_topic_t* const    topic,
+                           const cy_us_t        now,
+                           const size_t         capacity,
+                           unsigned char* const buffer)
+{
+    // We don't transmit the topic name if the message is published in response to an allocation change or if the name
+    // has been heard recently, unless this is the first gossip of the topic or someone has asked for the name.
+    const bool   urgent   = topic->gossip_priority >= HEARTBEAT_NAMELESS_PRIORITY_MIN;
+    const bool   heard    = (topic->ts_named != BIG_BANG) && ((now - topic->ts_named) < cy->heartbeat_period_max);
+    const bool   nameless = (urgent || heard) && (topic->ts_gossiped != BIG_BANG) && !topic->gossip_name_requested;
+    const size_t name_len = nameless ? 0U : topic->index_name->key_len;
+    if ((GOSSIP_HEADER_SIZE + name_len) > capacity) {
+        return 0;
+    }
     topic_age(topic, now);
     topic_ensure_subscribed(cy, topic); // use this opportunity to repair the subscription if broken
     const uint_fast8_t flags = ((topic->pub_count > 0) ? FLAG_PUBLISHING : 0U) |     //
                                ((topic->couplings != NULL) ? FLAG_SUBSCRIBED : 0U) | //
-                               ((topic->ts_received >= topic->ts_gossiped) ? FLAG_RECEIVING : 0U);
-    // Possible optimization: we don't have to transmit the topic name if the message is urgent, i.e.,
-    // if it is published in response to a divergent allocation or possibly a collision.
-    heartbeat_t msg = { .topic_hash      = topic->hash,
-                        .topic_evictions = topic->evictions,
-                        ._reserved_      = 0,
-                        .topic_log_age   = log2_floor(topic->age),
-                        .flags           = flags,
-                        .topic_name_len  = (uint_fast8_t)topic->index_name->key_len };
-    memcpy(msg.topic_name, topic->name, topic->index_name->key_len);
+                               ((topic->ts_received >= topic->ts_gossiped) ? FLAG_RECEIVING : 0U) | //
+                               ((topic->reliable_tx != NULL) ? FLAG_RELIABLE : 0U) | //
+                               (topic->batching ? FLAG_BATCHING : 0U);
+
+    gossip_t msg = { .topic_hash      = topic->hash,
+                     .topic_evictions = topic->evictions,
+                     ._reserved_      = 0,
+                     .topic_log_age   = log2_floor(topic->age),
+                     .flags           = (uint8_t)flags,
+                     .topic_name_len  = (uint8_t)name_len };
+    memcpy(msg.topic_name, topic->name, name_len);
     if (topic->gossip_priority > 0) {
         CY_TRACE(cy,
-                 "🗣️'%s' #%016llx @%04x prio=%d flags=0x%02x",
+                 "🗣️'%s' #%016llx @%04x prio=%d flags=0x%02x nameless=%d",
                  topic->name,
                  (unsigned long long)topic->hash,
                  cy_topic_subject_id(topic),
                  topic->gossip_priority,
-                 flags);
+                 flags,
+                 (int)nameless);
     }
     // Update gossip time even if failed so we don't get stuck publishing same gossip if error reporting is broken.
+    topic->gossip_name_requested = false;
+    topic->ts_named              = nameless ? topic->ts_named : now;
     update_gossip_order(cy, topic, now, 0);
-    return publish_heartbeat(cy, now, &msg);
+    return gossip_serialize(&msg, buffer);
+}
+
+/// Packs as many gossips as fit into the heartbeat, taking the topics in the gossip order.
+/// If the heartbeat is sent early due to urgent gossips, only the urgent ones are included to limit the traffic.
+/// Every topic is included at most once, so a small node will not repeat itself.
+static cy_err_t publish_heartbeat_gossip(cy_t* const cy, const cy_us_t now, const bool urgent_only)
+{
+    unsigned char buffer[CY_CONFIG_HEARTBEAT_EXTENT];
+    const size_t  capacity =
+      smaller(larger(cy->heartbeat_size_max, HEARTBEAT_SINGLE_SIZE_MAX), CY_CONFIG_HEARTBEAT_EXTENT);
+    size_t size  = HEARTBEAT_HEADER_SIZE;
+    size_t count = 0;
+    while (count < cy->gossip_heap_size) {
+        cy_topic_t* const topic = cy->topics_by_gossip_time[0];
+        // Nonurgent topics gossiped now have been included already because they are ordered after all others.
+        if ((count > 0) && (topic->gossip_priority == 0) && (urgent_only || (topic->ts_gossiped >= now))) {
+            break;
+        }
+        const size_t record_size = gossip_topic(cy, topic, now, capacity - size, &buffer[size]);
+        if (record_size == 0) {
+            assert(count > 0); // The first record always fits.
+            break;
+        }
+        size += record_size;
+        count++;
+    }
+    return publish_heartbeat(cy, now, buffer, size);
+}
+
+/// Asks the network for the name of a topic that was announced without one.
+static cy_err_t publish_heartbeat_name_request(cy_t* const cy, const cy_us_t now)
+{
+    assert(cy->name_request_pending);
+    unsigned char  buffer[HEARTBEAT_SINGLE_SIZE_MAX];
+    const gossip_t msg  = { .topic_hash = cy->name_request_hash, .flags = FLAG_SCOUT, .topic_name_len = 0 };
+    const size_t   size = HEARTBEAT_HEADER_SIZE + gossip_serialize(&msg, &buffer[HEARTBEAT_HEADER_SIZE]);
+    const cy_err_t res  = publish_heartbeat(cy, now, buffer, size);
+    CY_TRACE(cy, "📢 #%016llx result=%d", (unsigned long long)cy->name_request_hash, res);
+    if (res == CY_OK) {
+        cy->name_request_pending = false;
+    }
+    return res;
 }
 
 static cy_err_t publish_heartbeat_scout(cy_t* const cy, const cy_us_t now)
 {
+    if (cy->name_request_pending) {
+        return publish_heartbeat_name_request(cy, now);
+    }
     const cy_subscriber_root_t* subr = cy->next_scout;
     assert(subr != NULL); // https://github.com/pavel-kirienko/cy/issues/12#issuecomment-2953184238
-    heartbeat_t msg = { .topic_hash     = 8185,
-                        .flags          = FLAG_SCOUT,
-                        .topic_name_len = (uint_fast8_t)subr->index_name->key_len };
+    gossip_t msg = { .topic_hash     = 8185,
+                     .flags          = FLAG_SCOUT,
+                     .topic_name_len = (uint8_t)subr->index_name->key_len };
     wkv_get_key(&cy->subscribers_by_name, subr->index_name, msg.topic_name);
-    const cy_err_t res = publish_heartbeat(cy, now, &msg);
+    unsigned char  buffer[HEARTBEAT_SINGLE_SIZE_MAX];
+    const size_t   size = HEARTBEAT_HEADER_SIZE + gossip_serialize(&msg, &buffer[HEARTBEAT_HEADER_SIZE]);
+    const cy_err_t res  = publish_heartbeat(cy, now, buffer, size);
     CY_TRACE(cy, "📢'%s' result=%d", msg.topic_name, res);
     if (res == CY_OK) {
         cy->next_scout = subr->next_scout; // delist the scout if publication succeeded
@@ -1024,31 +2036,30 @@ static cy_err_t publish_heartbeat_scout(cy_t* const cy, const cy_us_t now)
     return res;
 }
 
-// ReSharper disable once CppParameterMayBeConstPtrOrRef
-static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
+static void on_gossip(cy_t* const           cy,
+                      const cy_us_t         ts,
+                      const uint64_t        uid,
+                      const uint16_t        remote_node_id,
+                      const gossip_t* const gossip)
 {
-    assert((evt->subscriber != NULL) && (evt->topic != NULL) && (evt->transfer != NULL));
-    // Deserialize the message. TODO: deserialize properly.
-    heartbeat_t  heartbeat = { 0 };
-    const size_t msg_size =
-      cy_buffer_owned_gather(evt->transfer->payload, (cy_bytes_mut_t){ .size = sizeof(heartbeat), .data = &heartbeat });
-    if ((msg_size < offsetof(heartbeat_t, topic_name)) || (heartbeat.version != 1)) {
-        return;
-    }
-    const cy_us_t                 ts              = evt->transfer->timestamp;
-    const cy_transfer_metadata_t* meta            = &evt->transfer->metadata;
-    const uint64_t                other_hash      = heartbeat.topic_hash;
-    const uint32_t                other_evictions = heartbeat.topic_evictions;
-    const int_fast8_t             other_lage      = heartbeat.topic_log_age;
-    const bool                    is_scout        = (heartbeat.flags & FLAG_SCOUT) != 0U;
-    const wkv_str_t               key             = { .len = heartbeat.topic_name_len, .str = heartbeat.topic_name };
+    const uint64_t    other_hash      = gossip->topic_hash;
+    const uint32_t    other_evictions = gossip->topic_evictions;
+    const int_fast8_t other_lage      = gossip->topic_log_age;
+    const bool        is_scout        = (gossip->flags & FLAG_SCOUT) != 0U;
+    const wkv_str_t   key             = { .len = gossip->topic_name_len, .str = gossip->topic_name };
+    (void)uid; // Only used for tracing.
     //
     if (!is_scout) {
         // Find the topic in our local database.
         cy_topic_t* mine = cy_topic_find_by_hash(cy, other_hash);
-        if ((heartbeat.flags & (FLAG_PUBLISHING | FLAG_RECEIVING)) != 0) {
-            if (mine == NULL) {
+        if ((gossip->flags & (FLAG_PUBLISHING | FLAG_RECEIVING)) != 0) {
+            if ((mine == NULL) && (key.len > 0)) {
                 mine = topic_subscribe_if_matching(cy, key, other_hash, other_evictions);
+            } else if ((mine == NULL) && (cy->pattern_subscription_count > 0) && !pattern_miss_known(cy, other_hash)) {
+                // The name was omitted, so we can't tell if we want this topic. Ask for the name to find out.
+                // Only the latest request is kept; any others will be satisfied by the regular gossip eventually.
+                cy->name_request_hash    = other_hash;
+                cy->name_request_pending = true;
             }
             if (mine != NULL) {
                 mortal_animate(cy, mine);
@@ -1065,8 +2076,8 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
                          "\t remote @%04x evict=%llu log2(age)=%+d",
                          mine->name,
                          (unsigned long long)mine->hash,
-                         (unsigned long long)heartbeat.uid,
-                         meta->remote_node_id,
+                         (unsigned long long)uid,
+                         remote_node_id,
                          cy_topic_subject_id(mine),
                          (unsigned long long)mine->evictions,
                          (unsigned long long)mine->age,
@@ -1075,6 +2086,7 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
                          (unsigned long long)other_evictions,
                          other_lage);
                 assert(mine->evictions != other_evictions);
+                cy_stat_add(&cy->stats.divergences, 1U);
                 if ((mine_lage > other_lage) || ((mine_lage == other_lage) && (mine->evictions > other_evictions))) {
                     CY_TRACE(cy, "We won, existing allocation not altered; expecting remote to adjust.");
                     prioritize_gossip(cy, mine, 100);
@@ -1096,7 +2108,17 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
             } else {
                 topic_ensure_subscribed(cy, mine); // use this opportunity to repair the subscription if broken
             }
-            mine->age = max_u64(mine->age, pow2(other_lage));
+            mine->age      = max_u64(mine->age, pow2(other_lage));
+            mine->ts_named = (key.len > 0) ? ts : mine->ts_named;
+            if ((gossip->flags & FLAG_BATCHING) != 0U) {
+                topic_batching_discovered(cy, mine);
+            }
+            reliable_on_gossip(cy,
+                               mine,
+                               remote_node_id,
+                               (gossip->flags & FLAG_SUBSCRIBED) != 0U,
+                               (gossip->flags & (FLAG_PUBLISHING | FLAG_RELIABLE)) == (FLAG_PUBLISHING | FLAG_RELIABLE),
+                               ts);
         } else { // We don't know this topic; check for a subject-ID collision and do auto-subscription.
             mine = cy_topic_find_by_subject_id(cy, topic_subject_id(other_hash, other_evictions));
             if (mine == NULL) {
@@ -1109,8 +2131,8 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
                      "\t local  #%016llx evict=%llu log2(age=%llu)=%+d '%s'\n"
                      "\t remote #%016llx evict=%llu log2(age)=%+d '%s'",
                      cy_topic_subject_id(mine),
-                     (unsigned long long)heartbeat.uid,
-                     meta->remote_node_id,
+                     (unsigned long long)uid,
+                     remote_node_id,
                      (win ? "WIN" : "LOSE"),
                      (unsigned long long)mine->hash,
                      (unsigned long long)mine->evictions,
@@ -1120,13 +2142,15 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
                      (unsigned long long)other_hash,
                      (unsigned long long)other_evictions,
                      other_lage,
-                     heartbeat.topic_name);
+                     gossip->topic_name);
             // We don't need to do anything if we won, but we need to announce to the network (in particular to the
             // infringing node) that we are using this subject-ID, so that the loser knows that it has to move.
             // If we lost, we need to gossip this topic ASAP as well because every other participant on this topic
             // will also move, but the trick is that the others could have settled on different subject-IDs.
             // Everyone needs to publish their own new allocation and then we will pick max subject-ID out of that.
+            cy_stat_add(&cy->stats.collisions, 1U);
             if (!win) {
+                cy_stat_add(&mine->stats.evictions, 1U);
                 topic_allocate(cy, mine, mine->evictions + 1U, false);
                 cy->ts_local_event = ts;
             } else {
@@ -1134,13 +2158,25 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
             }
             cy->ts_event = ts;
         }
+    } else if (key.len == 0) {
+        // A nameless scout is asking for the name of a topic that was announced without it.
+        // The response is heard by everyone, so our own request for the same name is no longer needed.
+        if (cy->name_request_pending && (cy->name_request_hash == other_hash)) {
+            cy->name_request_pending = false;
+        }
+        cy_topic_t* const mine = cy_topic_find_by_hash(cy, other_hash);
+        if (mine != NULL) {
+            CY_TRACE(cy, "📢 Name request from uid=%016llx for '%s'", (unsigned long long)uid, mine->name);
+            mine->gossip_name_requested = true;
+            prioritize_gossip(cy, mine, 10);
+        }
     } else {
         // A scout message is simply asking us to check if we have any matching topics, and gossip them ASAP if so.
         CY_TRACE(cy,
                  "📢 Scout from uid=%016llx nid=%04x: query='%s' hash=%016llx evict=%llu log2(age)=%d",
-                 (unsigned long long)heartbeat.uid,
-                 meta->remote_node_id,
-                 heartbeat.topic_name,
+                 (unsigned long long)uid,
+                 remote_node_id,
+                 gossip->topic_name,
                  (unsigned long long)other_hash,
                  (unsigned long long)other_evictions,
                  other_lage);
@@ -1148,29 +2184,350 @@ static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
     }
 }
 
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void on_heartbeat(cy_t* const cy, const cy_arrival_t* const evt)
+{
+    assert((evt->subscriber != NULL) && (evt->topic != NULL) && (evt->transfer != NULL));
+    unsigned char buffer[CY_CONFIG_HEARTBEAT_EXTENT];
+    const size_t  msg_size =
+      cy_buffer_owned_gather(evt->transfer->payload, (cy_bytes_mut_t){ .size = sizeof(buffer), .data = buffer });
+    if ((msg_size < HEARTBEAT_HEADER_SIZE) || (buffer[HEARTBEAT_OFFSET_VERSION] != 1U)) {
+        return;
+    }
+    cy_stat_add(&cy->stats.heartbeats_in, 1U);
+    const uint64_t uid    = deserialize_u64(&buffer[HEARTBEAT_OFFSET_VERSION + 1U]);
+    size_t         offset = HEARTBEAT_HEADER_SIZE;
+    while (offset < msg_size) {
+        gossip_t     gossip = { 0 };
+        const size_t size   = gossip_deserialize(msg_size - offset, &buffer[offset], &gossip);
+        if (size == 0) {
+            break; // Malformed or truncated; the preceding records are still valid.
+        }
+        on_gossip(cy, evt->transfer->timestamp, uid, evt->transfer->metadata.remote_node_id, &gossip);
+        offset += size;
+    }
+}
+
 // =====================================================================================================================
-//                                                      PUBLISHER
+//                                                      FUTURES
 // =====================================================================================================================
 
-static void retire_timed_out_futures(cy_t* cy, const cy_us_t now)
+#define FUTURE_WHEEL_TICK_LOG2        10U
+#define FUTURE_WHEEL_SLOT_LOG2        6U
+#define FUTURE_WHEEL_SPAN_LOG2        (FUTURE_WHEEL_SLOT_LOG2 * CY_FUTURE_WHEEL_LEVELS)
+#define FUTURE_SLOTS_INITIAL_CAPACITY 8U
+
+static_assert((1U << FUTURE_WHEEL_SLOT_LOG2) == CY_FUTURE_WHEEL_SLOTS, "Wheel geometry mismatch");
+static_assert(CY_FUTURE_WHEEL_SLOTS <= 64U, "The occupancy bitmaps are 64-bit");
+
+static uint64_t future_wheel_tick_of(const cy_us_t ts)
+{
+    return (ts > 0) ? (((uint64_t)ts) >> FUTURE_WHEEL_TICK_LOG2) : 0U;
+}
+
+/// The level is chosen by the distance from the current tick such that the slot is moved one level down at the
+/// start of the span containing the deadline. Deadlines in the past go to the current tick, which is examined on
+/// every update, and the ones beyond the wheel span are parked in the farthest slot to be placed again later.
+static void future_wheel_link(cy_t* const cy, cy_future_t* const fut)
 {
-    cy_future_t* fut = (cy_future_t*)cavl2_min(cy->futures_by_deadline);
-    while ((fut != NULL) && (fut->deadline < now)) {
-        assert(fut->state == cy_future_pending);
-        cavl2_remove(&cy->futures_by_deadline, &fut->index_deadline);
-        cavl2_remove(&fut->publisher->topic->futures_by_transfer_id, &fut->index_transfer_id);
-        fut->state = cy_future_response_timeout;
-        if (fut->callback != NULL) {
-            fut->callback(cy, fut);
+    const uint64_t now_tick = cy->futures_wheel_tick;
+    uint64_t       tick     = max_u64(future_wheel_tick_of(fut->deadline), now_tick);
+    if (((tick - now_tick) >> FUTURE_WHEEL_SPAN_LOG2) != 0) {
+        tick = now_tick + (1ULL << FUTURE_WHEEL_SPAN_LOG2) - 1U;
+    }
+    const uint64_t delta = tick - now_tick;
+    uint_fast8_t   level = 0;
+    while ((delta >> (FUTURE_WHEEL_SLOT_LOG2 * (level + 1U))) != 0) {
+        level++;
+    }
+    assert(level < CY_FUTURE_WHEEL_LEVELS);
+    const size_t        slot = (size_t)(tick >> (FUTURE_WHEEL_SLOT_LOG2 * level)) & (CY_FUTURE_WHEEL_SLOTS - 1U);
+    cy_future_t** const head = &cy->futures_by_deadline[level][slot];
+    fut->wheel_next          = *head;
+    fut->wheel_pprev         = head;
+    if (*head != NULL) {
+        (*head)->wheel_pprev = &fut->wheel_next;
+    }
+    *head = fut;
+    cy->futures_wheel_occupancy[level] |= 1ULL << slot;
+}
+
+/// The occupancy bit is left set even if the slot becomes empty; it is cleared when the slot is next visited.
+static void future_wheel_unlink(cy_future_t* const fut)
+{
+    assert(fut->wheel_pprev != NULL);
+    *fut->wheel_pprev = fut->wheel_next;
+    if (fut->wheel_next != NULL) {
+        fut->wheel_next->wheel_pprev = fut->wheel_pprev;
+    }
+    fut->wheel_next  = NULL;
+    fut->wheel_pprev = NULL;
+}
+
+/// Moves the futures from the slot of the specified level that is due at the current tick to the lower levels.
+static void future_wheel_cascade(cy_t* const cy, const uint_fast8_t level)
+{
+    const size_t slot = (size_t)(cy->futures_wheel_tick >> (FUTURE_WHEEL_SLOT_LOG2 * level)) & //
+                        (CY_FUTURE_WHEEL_SLOTS - 1U);
+    cy_future_t* fut                     = cy->futures_by_deadline[level][slot];
+    cy->futures_by_deadline[level][slot] = NULL;
+    cy->futures_wheel_occupancy[level] &= ~(1ULL << slot);
+    while (fut != NULL) {
+        cy_future_t* const next = fut->wheel_next;
+        future_wheel_link(cy, fut);
+        fut = next;
+    }
+}
+
+static cy_future_t* future_slot_find(const cy_topic_t* const topic, const uint64_t transfer_id_masked)
+{
+    if (topic->futures_capacity == 0) {
+        return NULL;
+    }
+    cy_future_t* fut = topic->futures_by_transfer_id[transfer_id_masked & (topic->futures_capacity - 1U)];
+    while ((fut != NULL) && (fut->transfer_id_masked != transfer_id_masked)) {
+        fut = fut->slot_next;
+    }
+    return fut;
+}
+
+/// Fails with CY_ERR_CAPACITY if there is already a pending future with the same masked transfer-ID, which can
+/// only happen if the transfer-ID is cyclic and the whole set is exhausted. The table grows at load factor one.
+static cy_err_t future_slot_insert(cy_t* const cy, cy_topic_t* const topic, cy_future_t* const fut)
+{
+    if (future_slot_find(topic, fut->transfer_id_masked) != NULL) {
+        return CY_ERR_CAPACITY;
+    }
+    if (topic->futures_count >= topic->futures_capacity) {
+        const size_t        capacity = larger(topic->futures_capacity * 2U, FUTURE_SLOTS_INITIAL_CAPACITY);
+        cy_future_t** const slots    = (cy_future_t**)mem_alloc(cy, capacity * sizeof(cy_future_t*));
+        if (slots == NULL) {
+            return CY_ERR_MEMORY;
+        }
+        memset(slots, 0, capacity * sizeof(cy_future_t*));
+        for (size_t i = 0; i < topic->futures_capacity; i++) {
+            cy_future_t* item = topic->futures_by_transfer_id[i];
+            while (item != NULL) {
+                cy_future_t* const next  = item->slot_next;
+                const size_t       index = (size_t)(item->transfer_id_masked & (capacity - 1U));
+                item->slot_next          = slots[index];
+                slots[index]             = item;
+                item                     = next;
+            }
+        }
+        mem_free(cy, topic->futures_by_transfer_id);
+        topic->futures_by_transfer_id = slots;
+        topic->futures_capacity       = capacity;
+    }
+    cy_future_t** const head = &topic->futures_by_transfer_id[fut->transfer_id_masked & (topic->futures_capacity - 1U)];
+    fut->slot_next           = *head;
+    *head                    = fut;
+    topic->futures_count++;
+    return CY_OK;
+}
+
+static void future_slot_remove(cy_topic_t* const topic, cy_future_t* const fut)
+{
+    assert(topic->futures_capacity > 0);
+    cy_future_t** link = &topic->futures_by_transfer_id[fut->transfer_id_masked & (topic->futures_capacity - 1U)];
+    while (*link != fut) {
+        assert(*link != NULL);
+        link = &(*link)->slot_next;
+    }
+    *link          = fut->slot_next;
+    fut->slot_next = NULL;
+    assert(topic->futures_count > 0);
+    topic->futures_count--;
+}
+
+/// Removes the pending future from both indexes; the state is to be changed by the caller.
+static void future_retire(cy_t* const cy, cy_future_t* const fut)
+{
+    future_wheel_unlink(fut);
+    assert(cy->futures_pending > 0);
+    cy->futures_pending--;
+    future_slot_remove(fut->publisher->topic, fut);
+}
+
+static void future_time_out(cy_t* const cy, cy_future_t* const fut)
+{
+    assert(fut->state == cy_future_pending);
+    future_retire(cy, fut);
+    fut->state = cy_future_response_timeout;
+    cy_stat_add(&cy->stats.response_timeouts, 1U);
+    if (fut->callback != NULL) {
+        fut->callback(cy, fut);
+    }
+}
+
+/// The earliest time when retire_timed_out_futures() will have something to do, or heartbeat_next if nothing.
+/// A level-0 slot holds a single tick, so the timeout is found exactly by walking the first non-empty one;
+/// the occupancy bits are cleared lazily, so some of them may refer to empty slots. On the upper levels the start
+/// of the span of the first occupied slot is used, which is when the slot is cascaded down; a stale bit there only
+/// causes an early wakeup. The current slot of an upper level only holds the futures one full revolution ahead.
+static cy_us_t future_wheel_next_deadline(const cy_t* const cy)
+{
+    cy_us_t out = cy->heartbeat_next;
+    if (cy->futures_pending == 0) {
+        return out;
+    }
+    for (uint_fast8_t lvl = 0; lvl < CY_FUTURE_WHEEL_LEVELS; lvl++) {
+        const uint_fast8_t shift   = (uint_fast8_t)(FUTURE_WHEEL_SLOT_LOG2 * lvl);
+        const uint64_t     occ     = cy->futures_wheel_occupancy[lvl];
+        const uint_fast8_t current = (uint_fast8_t)((cy->futures_wheel_tick >> shift) & (CY_FUTURE_WHEEL_SLOTS - 1U));
+        uint64_t           rotated = (occ >> current) | ((current > 0) ? (occ << (64U - current)) : 0U);
+        if (lvl == 0) {
+            while (rotated != 0) {
+                const uint_fast8_t ahead = (uint_fast8_t)__builtin_ctzll(rotated);
+                const cy_future_t* fut   = cy->futures_by_deadline[0][(current + ahead) & (CY_FUTURE_WHEEL_SLOTS - 1U)];
+                rotated &= rotated - 1U;
+                if (fut != NULL) {
+                    for (; fut != NULL; fut = fut->wheel_next) {
+                        out = min_i64(out, fut->deadline + 1); // Timed out when the deadline is in the past.
+                    }
+                    break;
+                }
+            }
+        } else if (rotated != 0) {
+            const uint_fast8_t ahead = (uint_fast8_t)__builtin_ctzll(rotated);
+            const uint64_t span = (cy->futures_wheel_tick >> shift) + ((ahead > 0) ? ahead : CY_FUTURE_WHEEL_SLOTS);
+            out                 = min_i64(out, (cy_us_t)((span << shift) << FUTURE_WHEEL_TICK_LOG2));
+        }
+    }
+    return out;
+}
+
+/// The wheel is advanced tick by tick, skipping the spans where the lower levels are empty. All futures in the
+/// level-0 slot of a past tick are expired; the ones in the current tick are compared against the time exactly.
+/// The callbacks may publish new requests and thus add futures to the wheel at any point.
+static void retire_timed_out_futures(cy_t* const cy, const cy_us_t now)
+{
+    const uint64_t now_tick = future_wheel_tick_of(now);
+    while (cy->futures_wheel_tick < now_tick) {
+        if (cy->futures_pending == 0) {
+            cy->futures_wheel_tick = now_tick;
+            break;
+        }
+        const size_t slot = (size_t)(cy->futures_wheel_tick & (CY_FUTURE_WHEEL_SLOTS - 1U));
+        while (cy->futures_by_deadline[0][slot] != NULL) {
+            future_time_out(cy, cy->futures_by_deadline[0][slot]);
+        }
+        cy->futures_wheel_occupancy[0] &= ~(1ULL << slot);
+        // If the lower levels are empty, nothing can happen until the next slot of the first non-empty level is due.
+        uint64_t next = cy->futures_wheel_tick + 1U;
+        for (uint_fast8_t lvl = 0; (lvl < (CY_FUTURE_WHEEL_LEVELS - 1U)) && (cy->futures_wheel_occupancy[lvl] == 0);
+             lvl++) {
+            const uint64_t span = 1ULL << (FUTURE_WHEEL_SLOT_LOG2 * (lvl + 1U));
+            next                = (cy->futures_wheel_tick + span) & ~(span - 1U);
+        }
+        cy->futures_wheel_tick = (next < now_tick) ? next : now_tick;
+        for (uint_fast8_t lvl = 1; lvl < CY_FUTURE_WHEEL_LEVELS; lvl++) {
+            if ((cy->futures_wheel_tick & ((1ULL << (FUTURE_WHEEL_SLOT_LOG2 * lvl)) - 1U)) != 0) {
+                break;
+            }
+            future_wheel_cascade(cy, lvl);
+        }
+    }
+    // Detach the current slot so that the futures that are not yet due can be put back without being revisited.
+    const size_t slot    = (size_t)(cy->futures_wheel_tick & (CY_FUTURE_WHEEL_SLOTS - 1U));
+    cy_future_t* current = cy->futures_by_deadline[0][slot];
+    if (current != NULL) {
+        cy->futures_by_deadline[0][slot] = NULL;
+        current->wheel_pprev             = &current;
+        while (current != NULL) {
+            cy_future_t* const fut = current;
+            if (fut->deadline < now) {
+                future_time_out(cy, fut);
+            } else {
+                future_wheel_unlink(fut);
+                future_wheel_link(cy, fut);
+            }
         }
-        // We could have trivially avoided having to search the tree again by replacing this with a
-        // cavl2_next_greater(), which is very efficient, but the problem here is that the user callback may modify
-        // the tree unpredictably, and we don't want to put constraints on the callback behavior.
-        // A more sophisticated solution is to mark the tree as modified, but it's not worth the effort.
-        fut = (cy_future_t*)cavl2_min(cy->futures_by_deadline);
     }
 }
 
+// =====================================================================================================================
+//                                                  LATENCY TRACING
+// =====================================================================================================================
+
+/// True once every latency_sample_period calls; the countdown is restarted from the current period.
+static bool latency_sample(const cy_t* const cy, uint32_t* const countdown)
+{
+    if (cy->latency_sample_period == 0) {
+        return false;
+    }
+    if ((*countdown == 0) || (*countdown > cy->latency_sample_period)) {
+        *countdown = cy->latency_sample_period;
+    }
+    return --*countdown == 0;
+}
+
+static void latency_report(cy_t* const cy, const cy_latency_trace_t* const trace)
+{
+    if (trace->outgoing) {
+        stat_histogram_add(&cy->stats.tx_wire_latency, trace->ts_wire - trace->ts_published);
+    } else {
+        stat_histogram_add(&cy->stats.rx_stack_latency, trace->ts_ingested - trace->ts_wire);
+        stat_histogram_add(&cy->stats.rx_callback_latency, trace->ts_delivered - trace->ts_ingested);
+    }
+    if (cy->latency_callback != NULL) {
+        cy->latency_callback(cy, trace);
+    }
+}
+
+/// Returns the token to be exposed to the platform during the publication, or zero if the transfer is not traced.
+/// An older probe still awaiting its departure report is overwritten; its report is then ignored.
+static uint32_t latency_tx_begin(cy_t* const cy, const cy_topic_t* const topic)
+{
+    if (!latency_sample(cy, &cy->latency_tx_countdown)) {
+        return 0;
+    }
+    cy->latency_tx_token_last += (cy->latency_tx_token_last == UINT32_MAX) ? 2U : 1U; // Zero is reserved.
+    const uint32_t                   token = cy->latency_tx_token_last;
+    struct cy_latency_probe_t* const probe = &cy->latency_tx[token % CY_LATENCY_TX_PROBES];
+    probe->token                           = token;
+    probe->trace                           = (cy_latency_trace_t){ .topic_hash     = topic->hash,
+                                                                   .transfer_id    = topic->pub_transfer_id,
+                                                                   .remote_node_id = CY_NODE_ID_INVALID,
+                                                                   .outgoing       = true,
+                                                                   .ts_published   = cy_now(cy) };
+    return token;
+}
+
+/// Releases the probe if the publication failed; the departure may have been reported already, which is fine.
+static void latency_tx_abort(cy_t* const cy, const uint32_t token)
+{
+    struct cy_latency_probe_t* const probe = &cy->latency_tx[token % CY_LATENCY_TX_PROBES];
+    if ((token != 0) && (probe->token == token)) {
+        probe->token = 0;
+    }
+}
+
+void cy_notify_tx_departure(cy_t* const cy, const uint32_t token, const cy_us_t ts)
+{
+    assert(cy != NULL);
+    struct cy_latency_probe_t* const probe = &cy->latency_tx[token % CY_LATENCY_TX_PROBES];
+    if ((token != 0) && (probe->token == token)) {
+        probe->token                   = 0;
+        probe->trace.ts_wire           = ts;
+        const cy_latency_trace_t trace = probe->trace; // The probe may be reused by the callback.
+        latency_report(cy, &trace);
+    }
+}
+
+void cy_latency_tracing(cy_t* const cy, const uint32_t sample_period, const cy_latency_callback_t callback)
+{
+    assert(cy != NULL);
+    cy->latency_sample_period = sample_period;
+    cy->latency_callback      = callback;
+    cy->latency_rx_countdown  = 0;
+    cy->latency_tx_countdown  = 0;
+}
+
+// =====================================================================================================================
+//                                                      PUBLISHER
+// =====================================================================================================================
+
 cy_err_t cy_advertise(cy_t* const cy, cy_publisher_t* const pub, const wkv_str_t name, const size_t response_extent)
 {
     assert((pub != NULL) && (cy != NULL));
@@ -1209,19 +2566,194 @@ cy_err_t cy_advertise(cy_t* const cy, cy_publisher_t* const pub, const wkv_str_t
     return res;
 }
 
-void cy_unadvertise(cy_t* const cy, cy_publisher_t* pub)
+void cy_unadvertise(cy_t* const cy, cy_publisher_t* pub)
+{
+    (void)cy;
+    (void)pub;
+}
+
+void cy_future_new(cy_future_t* const future, const cy_future_callback_t callback, void* const user)
+{
+    assert(future != NULL);
+    memset(future, 0, sizeof(*future));
+    future->state    = cy_future_fresh;
+    future->callback = callback;
+    future->user     = user;
+}
+
+/// Publishes one transfer bypassing the batching, if any.
+static cy_err_t publish_transfer(cy_t* const                cy,
+                                 cy_publisher_t* const      pub,
+                                 const cy_us_t              tx_deadline,
+                                 const cy_buffer_borrowed_t payload,
+                                 const cy_us_t              response_deadline,
+                                 cy_future_t* const         future)
+{
+    assert(pub != NULL);
+    cy_topic_t* const topic = pub->topic;
+    assert(topic != NULL);
+    assert(topic->pub_count > 0);
+
+    // If we still don't have a node-ID, force allocation right now.
+    // Normally, however, the application should wait for cy_join() to complete before publishing anything.
+    cy_err_t res = ensure_joined(cy);
+    if (res != CY_OK) {
+        return res;
+    }
+
+    // A reliable publisher needs room in its window and a private copy of the payload for retransmission.
+    cy_bytes_mut_t copy = { .size = 0, .data = NULL };
+    if (pub->reliable != NULL) {
+        res = reliable_admit(cy, pub->reliable);
+        if (res == CY_OK) {
+            res = reliable_copy(cy, pub->reliable, payload, &copy);
+        }
+        if (res != CY_OK) {
+            return res;
+        }
+    }
+
+    // Set up the response future first. If publication fails, we will have to undo it later.
+    // The reason we can't do it afterward is that if the transport has a cyclic transfer-ID, insertion may fail if
+    // we have exhausted the transfer-ID set.
+    if (future != NULL) {
+        future->wheel_next         = NULL;
+        future->wheel_pprev        = NULL;
+        future->slot_next          = NULL;
+        future->publisher          = pub;
+        future->state              = cy_future_pending;
+        future->transfer_id_masked = topic->pub_transfer_id & cy->platform->transfer_id_mask;
+        future->deadline           = response_deadline;
+        future->ts_published       = cy_now(cy);
+        future->last_response      = (cy_transfer_owned_t){ 0 };
+        // NB: we don't touch the callback and the user pointer, as they are to be initialized by the user.
+        res = future_slot_insert(cy, topic, future);
+        if (res != CY_OK) {
+            mem_free(cy, copy.data);
+            return res;
+        }
+    }
+
+    cy->latency_tx_probe = latency_tx_begin(cy, topic);
+    res                  = cy->platform->topic_publish(cy, pub, tx_deadline, topic->pub_transfer_id, payload);
+    if (res == CY_OK) {
+        cy_stat_add(&topic->stats.transfers_out, 1U);
+        cy_stat_add(&topic->stats.bytes_out, cy_buffer_borrowed_size(payload));
+    } else {
+        cy_stat_add(&topic->stats.drops, 1U);
+        latency_tx_abort(cy, cy->latency_tx_probe);
+    }
+    cy->latency_tx_probe = 0;
+
+    if (future != NULL) {
+        if (res == CY_OK) {
+            future_wheel_link(cy, future);
+            cy->futures_pending++;
+        } else {
+            future_slot_remove(topic, future);
+        }
+    }
+
+    if ((res == CY_OK) && (copy.data != NULL)) {
+        reliable_retain(cy, pub->reliable, topic->pub_transfer_id, copy);
+    } else {
+        mem_free(cy, copy.data);
+    }
+
+    topic->pub_transfer_id++;
+    return res;
+}
+
+/// The first 8 bytes of a batch are the topic hash mixed with this value, which tells the subscribers to unpack it.
+/// The hash is included so that the marker differs per topic; an ordinary payload matches it by accident with the
+/// probability of about 2^-64.
+#define BATCH_MARKER 0xB47C4F1A9E3D2C61ULL
+
+/// The state of a batching publisher; see cy_publisher_batching(). The batch is serialized in place as follows:
+///
+///     uint64 marker             # topic_hash ^ BATCH_MARKER
+///     (uint16 size, byte[size]) # repeated for every message; the sizes are little-endian
+///
+/// The batch is empty if its size is zero; otherwise, the header is included in the size.
+struct cy_batch_tx_t
+{
+    cy_publisher_t*       pub;
+    struct cy_batch_tx_t* next; ///< All batching publishers of the node.
+    size_t                capacity;
+    size_t                size;
+    size_t                count;
+    cy_us_t               max_latency;
+    cy_us_t               ts_flush;    ///< The oldest message will have waited max_latency by then, or tx_deadline.
+    cy_us_t               tx_deadline; ///< The earliest TX deadline of the batched messages.
+    unsigned char         buffer[];
+};
+
+/// Publishes the accumulated messages as one transfer. The batch is empty afterward even if the publication failed.
+static cy_err_t batch_flush(cy_t* const cy, struct cy_batch_tx_t* const batch)
+{
+    cy_err_t res = CY_OK;
+    if (batch->size > 0) {
+        const cy_buffer_borrowed_t payload = { .next = NULL, .view = { .size = batch->size, .data = batch->buffer } };
+        res = publish_transfer(cy, batch->pub, batch->tx_deadline, payload, 0, NULL); // The payload is copied.
+        CY_TRACE(cy, "📦'%s' count=%zu size=%zu res=%d", batch->pub->topic->name, batch->count, batch->size, res);
+        batch->size  = 0;
+        batch->count = 0;
+    }
+    return res;
+}
+
+/// The message is appended to the batch, which is flushed first if the message does not fit.
+/// The error is only returned if the flush failed, in which case the preceding messages were lost.
+static cy_err_t batch_append(cy_t* const                 cy,
+                             struct cy_batch_tx_t* const batch,
+                             const cy_us_t               tx_deadline,
+                             const cy_buffer_borrowed_t  payload,
+                             const size_t                size)
+{
+    cy_err_t res = CY_OK;
+    if ((batch->size + CY_BATCH_RECORD_OVERHEAD + size) > batch->capacity) {
+        res = batch_flush(cy, batch);
+    }
+    if (batch->size == 0) {
+        (void)serialize_u64(batch->buffer, batch->pub->topic->hash ^ BATCH_MARKER);
+        batch->size        = CY_BATCH_HEADER_SIZE;
+        batch->ts_flush    = cy_now(cy) + batch->max_latency;
+        batch->tx_deadline = tx_deadline;
+    }
+    unsigned char* const ptr = serialize_u16(&batch->buffer[batch->size], (uint16_t)size);
+    const size_t         n   = cy_buffer_borrowed_gather(payload, (cy_bytes_mut_t){ .size = size, .data = ptr });
+    assert(n == size);
+    batch->size += CY_BATCH_RECORD_OVERHEAD + n;
+    batch->count++;
+    batch->tx_deadline = min_i64(batch->tx_deadline, tx_deadline);
+    batch->ts_flush    = min_i64(batch->ts_flush, tx_deadline); // Waiting past the deadline would drop the batch.
+    cy_stat_add(&batch->pub->topic->stats.batched, 1U);
+    // There is no point in waiting if not even an empty message would fit anymore.
+    if ((batch->size + CY_BATCH_RECORD_OVERHEAD) >= batch->capacity) {
+        const cy_err_t flush_res = batch_flush(cy, batch);
+        res                      = (res == CY_OK) ? flush_res : res;
+    }
+    return res;
+}
+
+/// Flushes the batches whose oldest message has waited long enough.
+static void batch_flush_due(cy_t* const cy, const cy_us_t now)
 {
-    (void)cy;
-    (void)pub;
+    for (struct cy_batch_tx_t* batch = cy->batch_tx_head; batch != NULL; batch = batch->next) {
+        if ((batch->size > 0) && (now >= batch->ts_flush)) {
+            (void)batch_flush(cy, batch); // The failure is accounted for in the topic statistics.
+        }
+    }
 }
 
-void cy_future_new(cy_future_t* const future, const cy_future_callback_t callback, void* const user)
+static cy_us_t batch_next_deadline(const cy_t* const cy, cy_us_t bound)
 {
-    assert(future != NULL);
-    memset(future, 0, sizeof(*future));
-    future->state    = cy_future_fresh;
-    future->callback = callback;
-    future->user     = user;
+    for (const struct cy_batch_tx_t* batch = cy->batch_tx_head; batch != NULL; batch = batch->next) {
+        if (batch->size > 0) {
+            bound = min_i64(bound, batch->ts_flush);
+        }
+    }
+    return bound;
 }
 
 cy_err_t cy_publish(cy_t* const                cy,
@@ -1232,56 +2764,140 @@ cy_err_t cy_publish(cy_t* const                cy,
                     cy_future_t* const         future)
 {
     assert(pub != NULL);
-    cy_topic_t* const topic = pub->topic;
-    assert(topic != NULL);
-    assert(topic->pub_count > 0);
+    struct cy_batch_tx_t* const batch = pub->batch;
+    if (batch != NULL) {
+        // A message expecting a response needs a transfer-ID of its own, and a large one would not fit.
+        // Either is published alone, after the messages batched before it to preserve the order.
+        const size_t size = cy_buffer_borrowed_size(payload);
+        if ((future == NULL) && ((CY_BATCH_HEADER_SIZE + CY_BATCH_RECORD_OVERHEAD + size) <= batch->capacity)) {
+            return batch_append(cy, batch, tx_deadline, payload, size);
+        }
+        (void)batch_flush(cy, batch);
+    }
+    return publish_transfer(cy, pub, tx_deadline, payload, response_deadline, future);
+}
 
-    // If we still don't have a node-ID, force allocation right now.
-    // Normally, however, the application should wait for cy_join() to complete before publishing anything.
-    cy_err_t res = ensure_joined(cy);
-    if (res != CY_OK) {
-        return res;
+cy_err_t cy_publisher_reliable(cy_t* const           cy,
+                               cy_publisher_t* const pub,
+                               const size_t          window,
+                               const cy_us_t         delivery_timeout)
+{
+    assert((cy != NULL) && (pub != NULL) && (pub->topic != NULL));
+    if ((pub->reliable != NULL) || (window == 0) || (window > CY_RELIABLE_WINDOW_MAX) ||
+        (window > (cy->platform->transfer_id_mask / 2U)) || (delivery_timeout <= 0)) {
+        return CY_ERR_ARGUMENT;
     }
+    struct cy_reliable_tx_t* const tx =
+      mem_alloc(cy, sizeof(struct cy_reliable_tx_t) + (window * sizeof(reliable_entry_t)));
+    if (tx == NULL) {
+        return CY_ERR_MEMORY;
+    }
+    memset(tx, 0, sizeof(struct cy_reliable_tx_t) + (window * sizeof(reliable_entry_t)));
+    tx->pub              = pub;
+    tx->delivery_timeout = delivery_timeout;
+    tx->rto              = RELIABLE_RTO_INITIAL_us;
+    tx->window           = window;
+    tx->next_in_topic    = pub->topic->reliable_tx;
+    tx->next             = cy->reliable_tx_head;
+    pub->topic->reliable_tx = tx;
+    cy->reliable_tx_head    = tx;
+    pub->reliable           = tx;
+    // Ask the subscribers to start acknowledging ASAP; they will reveal themselves in their response gossip.
+    prioritize_gossip(cy, pub->topic, 10);
+    CY_TRACE(cy, "🤝'%s' window=%zu timeout=%lld", pub->topic->name, window, (long long)delivery_timeout);
+    return CY_OK;
+}
 
-    // Set up the response future first. If publication fails, we will have to undo it later.
-    // The reason we can't do it afterward is that if the transport has a cyclic transfer-ID, insertion may fail if
-    // we have exhausted the transfer-ID set.
-    if (future != NULL) {
-        future->index_deadline     = (cy_tree_t){ 0 };
-        future->index_transfer_id  = (cy_tree_t){ 0 };
-        future->publisher          = pub;
-        future->state              = cy_future_pending;
-        future->transfer_id_masked = topic->pub_transfer_id & cy->platform->transfer_id_mask;
-        future->deadline           = response_deadline;
-        future->last_response      = (cy_transfer_owned_t){ 0 };
-        // NB: we don't touch the callback and the user pointer, as they are to be initialized by the user.
-        const cy_tree_t* const tr = cavl2_find_or_insert(&topic->futures_by_transfer_id,
-                                                         &future->transfer_id_masked,
-                                                         &cavl_comp_future_transfer_id_masked,
-                                                         future,
-                                                         &cavl_factory_future_transfer_id);
-        if (tr != &future->index_transfer_id) {
-            return CY_ERR_CAPACITY;
+size_t cy_publisher_unacknowledged(const cy_publisher_t* const pub)
+{
+    assert(pub != NULL);
+    size_t out = 0;
+    if (pub->reliable != NULL) {
+        for (size_t k = 0; k < pub->reliable->count; k++) {
+            out += (reliable_entry(pub->reliable, k)->pending != 0) ? 1U : 0U;
         }
     }
+    return out;
+}
 
-    res = cy->platform->topic_publish(cy, pub, tx_deadline, payload);
+size_t cy_publisher_subscriber_count(const cy_publisher_t* const pub)
+{
+    assert(pub != NULL);
+    return (pub->reliable != NULL) ? (size_t)__builtin_popcountll(pub->reliable->peer_mask) : 0U;
+}
 
-    if (future != NULL) {
-        if (res == CY_OK) {
-            const cy_tree_t* const tr = cavl2_find_or_insert(&cy->futures_by_deadline,
-                                                             &response_deadline,
-                                                             &cavl_comp_future_deadline,
-                                                             future,
-                                                             &cavl_factory_future_deadline);
-            assert(tr == &future->index_deadline);
-        } else {
-            cavl2_remove(&topic->futures_by_transfer_id, &future->index_transfer_id);
-        }
+cy_err_t cy_publisher_batching(cy_t* const           cy,
+                               cy_publisher_t* const pub,
+                               const size_t          max_bytes,
+                               const cy_us_t         max_latency)
+{
+    assert((cy != NULL) && (pub != NULL) && (pub->topic != NULL));
+    if ((pub->batch != NULL) || (max_latency < 0) ||
+        (max_bytes <= (CY_BATCH_HEADER_SIZE + CY_BATCH_RECORD_OVERHEAD)) ||
+        (max_bytes > (CY_BATCH_HEADER_SIZE + CY_BATCH_RECORD_OVERHEAD + UINT16_MAX)) ||
+        (max_bytes > CY_CONFIG_BATCH_EXTENT)) {
+        return CY_ERR_ARGUMENT;
+    }
+    struct cy_batch_tx_t* const batch = mem_alloc(cy, sizeof(struct cy_batch_tx_t) + max_bytes);
+    if (batch == NULL) {
+        return CY_ERR_MEMORY;
     }
+    memset(batch, 0, sizeof(struct cy_batch_tx_t));
+    batch->pub         = pub;
+    batch->capacity    = max_bytes;
+    batch->max_latency = max_latency;
+    batch->next        = cy->batch_tx_head;
+    cy->batch_tx_head  = batch;
+    pub->batch         = batch;
+    topic_batching_discovered(cy, pub->topic); // In case the transport delivers our own batches to us.
+    CY_TRACE(cy, "📦'%s' max_bytes=%zu max_latency=%lld", pub->topic->name, max_bytes, (long long)max_latency);
+    return CY_OK;
+}
 
-    topic->pub_transfer_id++;
-    return res;
+cy_err_t cy_publisher_flush(cy_t* const cy, cy_publisher_t* const pub)
+{
+    assert((cy != NULL) && (pub != NULL));
+    return (pub->batch != NULL) ? batch_flush(cy, pub->batch) : CY_OK;
+}
+
+void cy_submit(cy_t* const cy, cy_submission_t* const submission)
+{
+    assert((cy != NULL) && (submission != NULL) && (submission->publisher != NULL));
+    cy_submission_t* head = atomic_load_explicit(&cy->submissions, memory_order_relaxed);
+    do {
+        submission->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+      &cy->submissions, &head, submission, memory_order_release, memory_order_relaxed));
+    if (cy->platform->wake != NULL) {
+        cy->platform->wake(cy);
+    }
+}
+
+/// Takes all pending submissions at once, so the producers are never blocked by the event loop;
+/// the stack is reversed to publish in the order of submission.
+static void publish_submissions(cy_t* const cy)
+{
+    if (atomic_load_explicit(&cy->submissions, memory_order_relaxed) == NULL) {
+        return; // Avoid the read-modify-write in the common case.
+    }
+    cy_submission_t* stack = atomic_exchange_explicit(&cy->submissions, NULL, memory_order_acquire);
+    cy_submission_t* queue = NULL;
+    while (stack != NULL) {
+        cy_submission_t* const next = stack->next;
+        stack->next                 = queue;
+        queue                       = stack;
+        stack                       = next;
+    }
+    while (queue != NULL) {
+        cy_submission_t* const sub = queue;
+        queue                      = sub->next; // The callback may resubmit the object.
+        sub->next                  = NULL;
+        sub->result =
+          cy_publish(cy, sub->publisher, sub->tx_deadline, sub->payload, sub->response_deadline, sub->future);
+        if (sub->callback != NULL) {
+            sub->callback(cy, sub);
+        }
+    }
 }
 
 // =====================================================================================================================
@@ -1297,14 +2913,20 @@ void* wkv_cb_couple_new_subscription(const wkv_event_t evt)
     // If the new subscription parameters are different, we will need to resubscribe this topic.
     bool resubscribe = false;
     if (topic->subscribed) {
-        const cy_subscription_params_t param_old = deduce_subscription_params(topic);
+        const cy_subscription_params_t param_old = topic->rx->sub_params;
         const cy_subscription_params_t param_new = sub->params;
         resubscribe = (param_new.extent > param_old.extent) || //-------------------------------------
                       (param_new.transfer_id_timeout > param_old.transfer_id_timeout);
     }
-    // Create the coupling.
-    const cy_err_t res = topic_couple(cy, topic, sub->root, evt.substitution_count, evt.substitutions);
-    // Refresh the subscription if needed. Due to the new coupling, the params are now different.
+    // Create the coupling unless the root of this subscriber is already coupled, which is the case if this is not
+    // the first subscriber under the same name; the new subscriber is already in the list of the root then.
+    cy_err_t res = CY_OK;
+    if (topic_find_coupling(topic, sub->root) == NULL) {
+        res = topic_couple(cy, topic, sub->root, evt.substitution_count, evt.substitutions);
+    } else {
+        topic_subscribers_changed(topic);
+    }
+    // Refresh the subscription if needed. Due to the new subscriber, the params are now different.
     if (res == CY_OK) {
         if (resubscribe) {
             cy->platform->topic_unsubscribe(cy, topic);
@@ -1357,6 +2979,9 @@ static cy_err_t ensure_subscriber_root(cy_t* const                  cy,
         }
         assert(root->index_pattern->value == NULL);
         root->index_pattern->value = root;
+        cy->pattern_subscription_count++;
+        // The new pattern may match the topics that were dismissed earlier.
+        memset(cy->pattern_misses, 0, sizeof(cy->pattern_misses));
     } else {
         root->index_pattern = NULL;
         const cy_err_t res  = topic_ensure(cy, NULL, resolved_name);
@@ -1390,7 +3015,7 @@ cy_err_t cy_subscribe_with_params(cy_t* const                    cy,
                                   const cy_subscription_params_t params,
                                   const cy_subscriber_callback_t callback)
 {
-    if ((sub == NULL) || (cy == NULL) || (params.transfer_id_timeout < 0) || (callback == NULL)) {
+    if ((sub == NULL) || (cy == NULL) || (params.transfer_id_timeout < 0) || ((callback == NULL) && !params.conflate)) {
         return CY_ERR_ARGUMENT;
     }
     char name_buf[CY_TOPIC_NAME_MAX + 1U];
@@ -1475,22 +3100,143 @@ bool cy_ready(const cy_t* const cy)
 
 void cy_topic_hint(cy_t* const cy, cy_topic_t* const topic, const uint16_t subject_id)
 {
-    if ((topic != NULL) && (subject_id < CY_TOTAL_SUBJECT_COUNT) && (!is_pinned(topic->hash)) &&
+    if ((topic != NULL) && (subject_id < CY_TOPIC_SUBJECT_COUNT) && (!is_pinned(topic->hash)) &&
         (topic->evictions == 0)) {
-        // Existing subscriptions need to be deactivated first, if any.
-        if (topic->subscribed) {
-            assert(topic->couplings != NULL);
-            cy->platform->topic_unsubscribe(cy, topic);
-        }
         // Fit the lowest evictions counter such that we land at the specified subject-ID.
         // Avoid negative remainders, so we don't use simple evictions=(subject_id-hash)%6144.
-        while (topic_subject_id(topic->hash, topic->evictions) != subject_id) {
-            topic->evictions++;
+        uint32_t evictions = 0;
+        while (topic_subject_id(topic->hash, evictions) != subject_id) {
+            evictions++;
         }
-        assert(cy_topic_subject_id(topic) == subject_id);
-        // Restore the subscriptions.
-        topic_ensure_subscribed(cy, topic);
+        // Go through the normal allocation path to keep the subject-ID index consistent. This also takes care of
+        // the subscriptions and arbitrates against the local topics that may already occupy the subject-ID.
+        topic_allocate(cy, topic, evictions, false);
+    }
+}
+
+#define SNAPSHOT_VERSION      1U
+#define SNAPSHOT_HEADER_SIZE  20U
+#define SNAPSHOT_RECORD_SIZE  20U
+#define SNAPSHOT_TRAILER_SIZE 8U
+
+static const unsigned char g_snapshot_magic[3] = { 'C', 'y', 'S' };
+
+/// Pinned topics are not included because their allocation is fixed.
+static size_t snapshot_topic_count(const cy_t* const cy)
+{
+    size_t out = 0;
+    for (const cy_topic_t* topic = cy_topic_iter_first(cy); topic != NULL;
+         topic                   = cy_topic_iter_next((cy_topic_t*)topic)) {
+        out += is_pinned(topic->hash) ? 0U : 1U;
+    }
+    return out;
+}
+
+size_t cy_snapshot_size(const cy_t* const cy)
+{
+    assert(cy != NULL);
+    return SNAPSHOT_HEADER_SIZE + (snapshot_topic_count(cy) * SNAPSHOT_RECORD_SIZE) + SNAPSHOT_TRAILER_SIZE;
+}
+
+size_t cy_snapshot_save(const cy_t* const cy, const cy_bytes_mut_t out)
+{
+    assert(cy != NULL);
+    const size_t count = snapshot_topic_count(cy);
+    const size_t size  = SNAPSHOT_HEADER_SIZE + (count * SNAPSHOT_RECORD_SIZE) + SNAPSHOT_TRAILER_SIZE;
+    if ((out.data == NULL) || (out.size < size)) {
+        return 0;
+    }
+    unsigned char* const buffer = (unsigned char*)out.data;
+    unsigned char*       ptr    = buffer;
+    memcpy(ptr, g_snapshot_magic, sizeof(g_snapshot_magic));
+    ptr += sizeof(g_snapshot_magic);
+    *ptr++ = SNAPSHOT_VERSION;
+    ptr    = serialize_u64(ptr, cy->uid);
+    ptr    = serialize_u16(ptr, cy_joined(cy) ? cy->node_id : CY_NODE_ID_INVALID);
+    ptr    = serialize_u16(ptr, 0); // reserved
+    ptr    = serialize_u32(ptr, (uint32_t)count);
+    // The topics are iterated in the ascending order of their hashes, which is relied upon when loading.
+    for (const cy_topic_t* topic = cy_topic_iter_first(cy); topic != NULL;
+         topic                   = cy_topic_iter_next((cy_topic_t*)topic)) {
+        if (!is_pinned(topic->hash)) {
+            ptr = serialize_u64(ptr, topic->hash);
+            ptr = serialize_u32(ptr, topic->evictions);
+            ptr = serialize_u64(ptr, topic->age);
+        }
+    }
+    ptr = serialize_u64(ptr, rapidhash(buffer, (size_t)(ptr - buffer)));
+    assert(ptr == (buffer + size));
+    return size;
+}
+
+cy_err_t cy_snapshot_load(cy_t* const cy, const cy_bytes_t snapshot)
+{
+    assert(cy != NULL);
+    const unsigned char* const buffer = (const unsigned char*)snapshot.data;
+    if ((buffer == NULL) || (snapshot.size < (SNAPSHOT_HEADER_SIZE + SNAPSHOT_TRAILER_SIZE)) ||
+        (memcmp(buffer, g_snapshot_magic, sizeof(g_snapshot_magic)) != 0) || (buffer[3] != SNAPSHOT_VERSION)) {
+        return CY_ERR_ARGUMENT;
+    }
+    const uint64_t uid     = deserialize_u64(&buffer[4]);
+    const uint16_t node_id = deserialize_u16(&buffer[12]);
+    const size_t   count   = deserialize_u32(&buffer[16]);
+    if ((count > CY_TOPIC_SUBJECT_COUNT) ||
+        (snapshot.size != (SNAPSHOT_HEADER_SIZE + (count * SNAPSHOT_RECORD_SIZE) + SNAPSHOT_TRAILER_SIZE))) {
+        return CY_ERR_ARGUMENT;
+    }
+    const size_t body_size = snapshot.size - SNAPSHOT_TRAILER_SIZE;
+    if (rapidhash(buffer, body_size) != deserialize_u64(&buffer[body_size])) {
+        return CY_ERR_ARGUMENT; // Corrupted.
+    }
+
+    // Import the topic allocations. The entries shall be strictly ordered by hash to allow binary search.
+    cy_snapshot_topic_t* const topics = (count > 0) ? mem_alloc(cy, count * sizeof(cy_snapshot_topic_t)) : NULL;
+    if ((count > 0) && (topics == NULL)) {
+        return CY_ERR_MEMORY;
     }
+    const unsigned char* ptr = &buffer[SNAPSHOT_HEADER_SIZE];
+    for (size_t i = 0; i < count; i++) {
+        topics[i].hash      = deserialize_u64(ptr);
+        topics[i].evictions = deserialize_u32(ptr + 8U);
+        topics[i].age       = deserialize_u64(ptr + 12U);
+        ptr += SNAPSHOT_RECORD_SIZE;
+        if (is_pinned(topics[i].hash) || ((i > 0) && (topics[i].hash <= topics[i - 1U].hash))) {
+            mem_free(cy, topics);
+            return CY_ERR_ARGUMENT;
+        }
+    }
+    mem_free(cy, cy->snapshot_topics);
+    cy->snapshot_topics      = topics;
+    cy->snapshot_topic_count = count;
+
+    // Topics created later will pick up their allocations in topic_new(). Those that already exist are moved now.
+    // The set of topics is not mutated here because the allocation does not affect the hash index.
+    for (cy_topic_t* topic = cy_topic_iter_first(cy); topic != NULL; topic = cy_topic_iter_next(topic)) {
+        const cy_snapshot_topic_t* const snap = is_pinned(topic->hash) ? NULL : snapshot_find(cy, topic->hash);
+        if (snap != NULL) {
+            topic->age = max_u64(topic->age, snap->age);
+            if (topic->evictions != snap->evictions) {
+                topic_allocate(cy, topic, snap->evictions, false);
+            }
+        }
+    }
+
+    // The node-ID is only restored if the snapshot was made by this node and no node-ID is assigned yet.
+    // Like an explicitly assigned node-ID, it is claimed immediately; if it is taken by now, it will be moved.
+    if ((uid == cy->uid) && (node_id <= cy->platform->node_id_max) && !cy_joined(cy)) {
+        cy_bloom64_t* const bloom = cy->platform->node_id_bloom(cy);
+        assert(bloom != NULL);
+        cy->node_id        = node_id;
+        const cy_err_t res = cy->platform->node_id_set(cy);
+        if (res != CY_OK) {
+            cy->node_id = CY_NODE_ID_INVALID;
+            return res;
+        }
+        bloom64_set(bloom, node_id);
+        cy->heartbeat_next = cy_now(cy);
+        CY_TRACE(cy, "☝️ Restored own node-ID %04x from snapshot", cy->node_id);
+    }
+    return CY_OK;
 }
 
 cy_topic_t* cy_topic_find_by_name(const cy_t* const cy, const wkv_str_t name)
@@ -1504,7 +3250,7 @@ cy_topic_t* cy_topic_find_by_name(const cy_t* const cy, const wkv_str_t name)
 cy_topic_t* cy_topic_find_by_hash(const cy_t* const cy, const uint64_t hash)
 {
     assert(cy != NULL);
-    cy_topic_t* const topic = (cy_topic_t*)cavl2_find(cy->topics_by_hash, &hash, &cavl_comp_topic_hash);
+    cy_topic_t* const topic = topic_index_find_by_hash(cy, hash);
     if (topic == NULL) {
         return NULL;
     }
@@ -1515,11 +3261,10 @@ cy_topic_t* cy_topic_find_by_hash(const cy_t* const cy, const uint64_t hash)
 cy_topic_t* cy_topic_find_by_subject_id(const cy_t* const cy, const uint16_t subject_id)
 {
     assert(cy != NULL);
-    cy_tree_t* const t = cavl2_find(cy->topics_by_subject_id, &subject_id, &cavl_comp_topic_subject_id);
-    if (t == NULL) {
+    cy_topic_t* const topic = topic_index_find_by_subject_id(cy, subject_id);
+    if (topic == NULL) {
         return NULL;
     }
-    cy_topic_t* topic = CAVL2_TO_OWNER(t, cy_topic_t, index_subject_id);
     assert(cy_topic_subject_id(topic) == subject_id);
     return topic;
 }
@@ -1551,6 +3296,66 @@ bool cy_has_substitution_tokens(const wkv_str_t name)
     return wkv_has_substitution_tokens(&kv, name);
 }
 
+// =====================================================================================================================
+//                                                      STATISTICS
+// =====================================================================================================================
+
+// C++ sees the counters as plain 64-bit words aligned at 8 bytes; see cy_stat_t.
+static_assert((sizeof(cy_stat_t) == 8U) && (_Alignof(cy_stat_t) == 8U), "cy_stat_t layout differs from C++");
+static_assert((sizeof(_Atomic(cy_submission_t*)) == sizeof(cy_submission_t*)) &&
+                (_Alignof(_Atomic(cy_submission_t*)) == _Alignof(cy_submission_t*)),
+              "cy_t layout differs from C++");
+
+static uint64_t stat_load(const cy_stat_t* const counter)
+{
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static void stat_histogram_load(const struct cy_stats_histogram_counters_t* const hist, cy_stats_histogram_t* const out)
+{
+    for (size_t i = 0; i < CY_STATS_HISTOGRAM_BUCKET_COUNT; i++) {
+        out->buckets[i] = stat_load(&hist->buckets[i]);
+    }
+}
+
+void cy_topic_stats(const cy_topic_t* const topic, cy_topic_stats_t* const out)
+{
+    assert((topic != NULL) && (out != NULL));
+    out->transfers_in  = stat_load(&topic->stats.transfers_in);
+    out->bytes_in      = stat_load(&topic->stats.bytes_in);
+    out->transfers_out = stat_load(&topic->stats.transfers_out);
+    out->bytes_out     = stat_load(&topic->stats.bytes_out);
+    out->drops         = stat_load(&topic->stats.drops);
+    out->reallocations = stat_load(&topic->stats.reallocations);
+    out->evictions     = stat_load(&topic->stats.evictions);
+
+    out->retransmissions   = stat_load(&topic->stats.retransmissions);
+    out->delivery_failures = stat_load(&topic->stats.delivery_failures);
+    out->duplicates        = stat_load(&topic->stats.duplicates);
+    out->conflated         = stat_load(&topic->stats.conflated);
+    out->batched           = stat_load(&topic->stats.batched);
+    out->unbatched         = stat_load(&topic->stats.unbatched);
+}
+
+void cy_stats(const cy_t* const cy, cy_stats_t* const out)
+{
+    assert((cy != NULL) && (out != NULL));
+    out->heartbeats_in      = stat_load(&cy->stats.heartbeats_in);
+    out->heartbeats_out     = stat_load(&cy->stats.heartbeats_out);
+    out->collisions         = stat_load(&cy->stats.collisions);
+    out->divergences        = stat_load(&cy->stats.divergences);
+    out->node_id_collisions = stat_load(&cy->stats.node_id_collisions);
+    out->bloom_purges       = stat_load(&cy->stats.bloom_purges);
+    out->response_timeouts  = stat_load(&cy->stats.response_timeouts);
+
+    out->pattern_miss_cache_hits = stat_load(&cy->stats.pattern_miss_cache_hits);
+    stat_histogram_load(&cy->stats.tx_latency, &out->tx_latency);
+    stat_histogram_load(&cy->stats.response_rtt, &out->response_rtt);
+    stat_histogram_load(&cy->stats.tx_wire_latency, &out->tx_wire_latency);
+    stat_histogram_load(&cy->stats.rx_stack_latency, &out->rx_stack_latency);
+    stat_histogram_load(&cy->stats.rx_callback_latency, &out->rx_callback_latency);
+}
+
 // =====================================================================================================================
 //                                                      BUFFERS
 // =====================================================================================================================
@@ -1648,12 +3453,33 @@ cy_err_t cy_new(cy_t* const                cy,
                    (unsigned)(uid >> 48U) & UINT16_MAX,
                    (unsigned)(uid >> 32U) & UINT16_MAX,
                    (unsigned long)(uid & UINT32_MAX));
-    cy->topics_by_hash        = NULL;
-    cy->topics_by_subject_id  = NULL;
-    cy->topics_by_gossip_time = NULL;
-    cy->next_scout            = NULL;
-    cy->topic_count           = 0;
-    cy->user                  = NULL;
+    cy->topics_by_hash             = NULL;
+    cy->topics_by_gossip_time      = NULL;
+    cy->gossip_heap_size           = 0;
+    cy->gossip_heap_capacity       = 0;
+    cy->gossip_seq                 = 0;
+    cy->next_scout                 = NULL;
+    cy->name_request_hash          = 0;
+    cy->name_request_pending       = false;
+    cy->pattern_subscription_count = 0;
+    cy->reliable_tx_head           = NULL;
+    cy->ack_pending_head           = NULL;
+    cy->latest_fresh_head          = NULL;
+    cy->batch_tx_head              = NULL;
+    cy->latency_sample_period      = 0;
+    cy->latency_callback           = NULL;
+    cy->latency_tx_probe           = 0;
+    atomic_init(&cy->submissions, NULL);
+    cy->snapshot_topics            = NULL;
+    cy->snapshot_topic_count       = 0;
+    cy->topic_count                = 0;
+    cy->user                       = NULL;
+#if CY_CONFIG_TOPIC_FLAT_INDEX
+    cy->topics_by_hash_flat          = NULL; // The subject-ID table is zeroed along with the rest of the object.
+    cy->topics_by_hash_flat_capacity = 0;
+#else
+    cy->topics_by_subject_id = NULL;
+#endif
 
     wkv_init(&cy->topics_by_name, &wkv_realloc);
     cy->topics_by_name.context = cy;
@@ -1667,6 +3493,8 @@ cy_err_t cy_new(cy_t* const                cy,
     // Postpone calling the functions until after the object is set up.
     cy->ts_started = cy_now(cy);
 
+    cy->futures_wheel_tick = future_wheel_tick_of(cy->ts_started);
+
     cy->mortal_topic_timeout = MORTAL_TOPIC_DEFAULT_TIMEOUT_us;
     cy->mortal_head          = NULL;
     cy->mortal_tail          = NULL;
@@ -1676,6 +3504,7 @@ cy_err_t cy_new(cy_t* const                cy,
     assert(node_id_bloom->n_bits > 0);
     assert((node_id_bloom->n_bits % 64) == 0);
     bloom64_purge(node_id_bloom);
+    cy->ts_bloom_rotated = cy->ts_started;
 
     // If a node-ID is given explicitly, we want to publish our heartbeat ASAP to speed up network convergence
     // and to claim the address; if it's already taken, we will want to cause a collision to move the other node,
@@ -1683,6 +3512,7 @@ cy_err_t cy_new(cy_t* const                cy,
     // If we are not given a node-ID, we need to first listen to the network.
     cy->heartbeat_period_max = HEARTBEAT_DEFAULT_PERIOD_us;
     cy->heartbeat_period_min = cy->heartbeat_period_max / 100;
+    cy->heartbeat_size_max   = HEARTBEAT_SINGLE_SIZE_MAX;
     cy->heartbeat_next       = cy->ts_started;
     cy->heartbeat_last       = BIG_BANG;
     cy_err_t res             = CY_OK;
@@ -1701,7 +3531,7 @@ cy_err_t cy_new(cy_t* const                cy,
         res = cy_advertise_c(cy, &cy->heartbeat_pub, CY_CONFIG_HEARTBEAT_TOPIC_NAME, 0);
         if (res == CY_OK) {
             res = cy_subscribe_c(
-              cy, &cy->heartbeat_sub, CY_CONFIG_HEARTBEAT_TOPIC_NAME, sizeof(heartbeat_t), &on_heartbeat);
+              cy, &cy->heartbeat_sub, CY_CONFIG_HEARTBEAT_TOPIC_NAME, CY_CONFIG_HEARTBEAT_EXTENT, &on_heartbeat);
             if (res != CY_OK) {
                 cy_unadvertise(cy, &cy->heartbeat_pub);
             }
@@ -1718,12 +3548,14 @@ static void mark_neighbor(cy_t* const cy, const uint16_t remote_node_id)
 {
     cy_bloom64_t* const bloom = cy->platform->node_id_bloom(cy);
     assert((bloom != NULL) && (bloom->n_bits > 0) && ((bloom->n_bits % 64) == 0) && (bloom->popcount <= bloom->n_bits));
-    // A large population count indicates that the filter contains tombstones (marks for nodes that have left the
-    // network). We can't remove them individually, so we purge the filter and start over.
+    // The tombstones (marks for nodes that have left the network) are normally expired by the periodic rotation
+    // in cy_update(). If the current generation gets congested before that, the network is too large for the filter,
+    // so we rotate early; the previous generations remain, so the neighbors seen recently are not forgotten.
     const bool bloom_congested = bloom->popcount > ((bloom->n_bits * 31ULL) / 32U);
     if (bloom_congested) {
-        CY_TRACE(cy, "🌻 bloom filter congested: popcount=%zu; purging to remove tombstones", bloom->popcount);
-        bloom64_purge(bloom);
+        CY_TRACE(cy, "🌻 bloom filter congested: popcount=%zu; rotating early", bloom->popcount);
+        node_id_bloom_rotate(cy, cy_now(cy));
+        cy_stat_add(&cy->stats.bloom_purges, 1U);
         assert(bloom->popcount == 0);
     }
     if ((cy->node_id > cy->platform->node_id_max) && !bloom64_get(bloom, remote_node_id)) {
@@ -1733,42 +3565,248 @@ static void mark_neighbor(cy_t* const cy, const uint16_t remote_node_id)
     bloom64_set(bloom, remote_node_id);
 }
 
-void cy_ingest_topic_transfer(cy_t* const cy, cy_topic_t* const topic, cy_transfer_owned_t transfer)
+/// The slow path of the transfer dispatch used when the dispatch array cannot be rebuilt due to OOM.
+/// The callback may unsubscribe, so we have to store the next pointer early.
+static void dispatch_by_couplings(cy_t* const                cy,
+                                  cy_topic_t* const          topic,
+                                  cy_transfer_owned_t* const transfer,
+                                  const bool                 conflated)
 {
-    assert(topic != NULL);
-
-    mark_neighbor(cy, transfer.metadata.remote_node_id);
-
-    // Experimental: age the topic with received transfers. Not with the published ones because we don't want
-    // unconnected publishers to inflate the age.
-    topic->age++;
-
-    // Record activity so that the topic is not retired.
-    mortal_animate(cy, topic);
-    topic->ts_received = transfer.timestamp;
-
-    // Simply invoke all callbacks that match this topic name.
-    // The callback may unsubscribe, so we have to store the next pointer early.
     const cy_topic_coupling_t* cpl = topic->couplings;
     while (cpl != NULL) {
         cy_subscriber_t* sub = cpl->root->head;
         assert(sub != NULL);
         const cy_topic_coupling_t* const next_cpl = cpl->next;
-        cy_subscriber_t* const           next_sub = sub->next;
         while (sub != NULL) {
+            cy_subscriber_t* const next_sub = sub->next;
             const cy_arrival_t evt = { .subscriber         = sub,
                                        .topic              = topic,
-                                       .transfer           = &transfer,
+                                       .transfer           = transfer,
                                        .substitution_count = cpl->substitution_count,
                                        .substitutions      = cpl->substitutions };
-            sub->callback(cy, &evt);
+            if ((sub->params.conflate == conflated) && (sub->callback != NULL)) {
+                sub->callback(cy, &evt);
+            }
             sub = next_sub;
         }
         cpl = next_cpl;
     }
+}
+
+/// Invokes the callbacks of either the conflating or the other subscribers that match the topic.
+/// The flattened array is used if it can be brought up to date; otherwise (OOM) we fall back to walking the couplings,
+/// which is slower but equivalent. A topic without the subscriber-side state has no couplings, so the fallback is a
+/// no-op then.
+static void topic_dispatch(cy_t* const                cy,
+                           cy_topic_t* const          topic,
+                           cy_transfer_owned_t* const transfer,
+                           const bool                 conflated)
+{
+    struct cy_topic_rx_t* const rx = topic->rx;
+    if ((rx != NULL) && ((rx->dispatch_version == rx->sub_version) || topic_dispatch_rebuild(cy, topic))) {
+        const cy_topic_dispatch_t* const dispatch = rx->dispatch;
+        const size_t                     end      = conflated ? rx->dispatch_count : rx->dispatch_split;
+        for (size_t i = conflated ? rx->dispatch_split : 0U; i < end; i++) {
+            cy_subscriber_t* const sub = dispatch[i].subscriber;
+            const cy_arrival_t     evt = { .subscriber         = sub,
+                                           .topic              = topic,
+                                           .transfer           = transfer,
+                                           .substitution_count = dispatch[i].substitution_count,
+                                           .substitutions      = dispatch[i].substitutions };
+            if (sub->callback != NULL) { // May be NULL for the conflating subscribers.
+                sub->callback(cy, &evt);
+            }
+        }
+    } else {
+        dispatch_by_couplings(cy, topic, transfer, conflated);
+    }
+}
+
+/// A transfer that arrives after a newer one from the same publisher, such as a retransmission that was overtaken,
+/// does not replace it. Beyond the transfer-ID timeout, the publisher may have restarted, so the arrival order wins.
+static bool topic_latest_is_stale(const cy_t* const                     cy,
+                                  const struct cy_topic_latest_t* const latest,
+                                  const cy_transfer_owned_t* const      transfer,
+                                  const cy_us_t                         transfer_id_timeout)
+{
+    const cy_transfer_owned_t* const old   = &latest->transfer;
+    const uint64_t                   mask  = cy->platform->transfer_id_mask;
+    const uint64_t                   ahead = (transfer->metadata.transfer_id - old->metadata.transfer_id) & mask;
+    return latest->valid && (transfer->metadata.remote_node_id == old->metadata.remote_node_id) &&
+           ((transfer->timestamp - old->timestamp) < transfer_id_timeout) && ((ahead == 0) || (ahead > (mask / 2U)));
+}
+
+/// Takes ownership of the payload, replacing the previous latest transfer of the topic, which is released.
+/// On OOM the transfer is left as is, so the conflating subscribers miss it.
+static void topic_latest_retain(cy_t* const cy, cy_topic_t* const topic, cy_transfer_owned_t* const transfer)
+{
+    struct cy_topic_rx_t* const rx = topic->rx;
+    if (rx->latest == NULL) {
+        rx->latest = (struct cy_topic_latest_t*)mem_alloc(cy, sizeof(struct cy_topic_latest_t));
+        if (rx->latest == NULL) {
+            cy_stat_add(&topic->stats.drops, 1U);
+            return;
+        }
+        memset(rx->latest, 0, sizeof(*rx->latest));
+        rx->latest->topic = topic;
+    }
+    struct cy_topic_latest_t* const latest = rx->latest;
+    if (topic_latest_is_stale(cy, latest, transfer, rx->sub_params.transfer_id_timeout)) {
+        cy_stat_add(&topic->stats.conflated, 1U);
+        return;
+    }
+    if (latest->valid) {
+        cy->platform->buffer_release(cy, latest->transfer.payload);
+        if (latest->fresh) {
+            cy_stat_add(&topic->stats.conflated, 1U);
+        }
+    }
+    latest->transfer              = *transfer;
+    latest->valid                 = true;
+    transfer->payload.origin.data = NULL; // Now owned by the topic, see cy_arrival_t.
+    if (!latest->fresh) {
+        latest->fresh         = true;
+        latest->next_fresh    = cy->latest_fresh_head;
+        cy->latest_fresh_head = latest;
+    }
+}
+
+/// Invokes the conflating subscribers once per topic that has received anything since the last update.
+static void topic_latest_notify(cy_t* const cy)
+{
+    while (cy->latest_fresh_head != NULL) {
+        struct cy_topic_latest_t* const latest = cy->latest_fresh_head;
+        cy->latest_fresh_head                  = latest->next_fresh;
+        latest->next_fresh                     = NULL;
+        latest->fresh                          = false;
+        if (latest->valid) {
+            topic_dispatch(cy, latest->topic, &latest->transfer, true);
+            latest->valid = latest->transfer.payload.origin.data != NULL; // A subscriber may have taken it.
+        }
+    }
+}
+
+/// The marker is required to be in the first fragment, like the topic hash of the responses.
+static bool batch_is(const cy_topic_t* const topic, const cy_buffer_borrowed_t payload)
+{
+    return (payload.view.size >= CY_BATCH_HEADER_SIZE) &&
+           (deserialize_u64((const unsigned char*)payload.view.data) == (topic->hash ^ BATCH_MARKER));
+}
+
+/// Delivers every message of the batch to the non-conflating subscribers as a separate arrival. A fragmented batch
+/// is gathered into a temporary buffer first. Returns true if the payload view of the transfer was narrowed down to
+/// the last message for the conflating subscribers; false if there is no such message or it cannot be retained.
+static bool batch_dispatch(cy_t* const cy, cy_topic_t* const topic, cy_transfer_owned_t* const transfer)
+{
+    const bool           contiguous = transfer->payload.base.next == NULL;
+    const size_t         size       = cy_buffer_owned_size(transfer->payload);
+    unsigned char* const scratch    = contiguous ? NULL : (unsigned char*)mem_alloc(cy, size);
+    if (!contiguous) {
+        if (scratch == NULL) {
+            cy_stat_add(&topic->stats.drops, 1U);
+            return false;
+        }
+        (void)cy_buffer_owned_gather(transfer->payload, (cy_bytes_mut_t){ .size = size, .data = scratch });
+    }
+    const unsigned char* const data      = contiguous ? transfer->payload.base.view.data : scratch;
+    const unsigned char*       last      = NULL;
+    size_t                     last_size = 0;
+    size_t                     off       = CY_BATCH_HEADER_SIZE;
+    while ((off + CY_BATCH_RECORD_OVERHEAD) <= size) {
+        const size_t rec_size = deserialize_u16(&data[off]);
+        off += CY_BATCH_RECORD_OVERHEAD;
+        if ((off + rec_size) > size) {
+            cy_stat_add(&topic->stats.drops, 1U); // Malformed; the messages before it are delivered regardless.
+            break;
+        }
+        // The message is borrowed from the batch, so its origin is empty and taking it over has no effect.
+        cy_transfer_owned_t msg = { .timestamp = transfer->timestamp, .metadata = transfer->metadata };
+        msg.payload.base.view   = (cy_bytes_t){ .size = rec_size, .data = &data[off] };
+        cy_stat_add(&topic->stats.unbatched, 1U);
+        topic_dispatch(cy, topic, &msg, false);
+        last      = &data[off];
+        last_size = rec_size;
+        off += rec_size;
+    }
+    mem_free(cy, scratch);
+    if (contiguous && (last != NULL)) {
+        transfer->payload.base.view = (cy_bytes_t){ .size = last_size, .data = last };
+        return true;
+    }
+    return false;
+}
+
+const cy_transfer_owned_t* cy_topic_latest(const cy_topic_t* const topic)
+{
+    const struct cy_topic_latest_t* const latest = ((topic != NULL) && (topic->rx != NULL)) ? topic->rx->latest : NULL;
+    const bool owned = (latest != NULL) && latest->valid && (latest->transfer.payload.origin.data != NULL);
+    return owned ? &latest->transfer : NULL;
+}
+
+bool cy_topic_has_reliable_sources(const cy_topic_t* const topic)
+{
+    return (topic != NULL) && (topic->rx != NULL) && (topic->rx->reliable_rx_count > 0);
+}
+
+bool cy_topic_is_reliable_source(const cy_topic_t* const topic, const uint16_t node_id)
+{
+    return (topic != NULL) && (reliable_rx_find(topic, node_id) != NULL);
+}
+
+void cy_ingest_topic_transfer(cy_t* const cy, cy_topic_t* const topic, cy_transfer_owned_t transfer)
+{
+    assert(topic != NULL);
+
+    mark_neighbor(cy, transfer.metadata.remote_node_id);
+
+    // Retransmissions from reliable publishers are acknowledged again but not delivered twice.
+    struct cy_topic_rx_t* const rx = topic->rx;
+    if ((rx != NULL) && (rx->reliable_rx_count > 0) && reliable_rx_is_duplicate(cy, topic, &transfer)) {
+        cy_stat_add(&topic->stats.duplicates, 1U);
+        cy->platform->buffer_release(cy, transfer.payload);
+        return;
+    }
+
+    // Experimental: age the topic with received transfers. Not with the published ones because we don't want
+    // unconnected publishers to inflate the age.
+    topic->age++;
+    cy_stat_add(&topic->stats.transfers_in, 1U);
+    cy_stat_add(&topic->stats.bytes_in, cy_buffer_owned_size(transfer.payload));
+
+    // Record activity so that the topic is not retired.
+    mortal_animate(cy, topic);
+    topic->ts_received = transfer.timestamp;
+
+    // The metadata is captured before the dispatch because the subscribers may take ownership of the transfer.
+    const bool         traced = latency_sample(cy, &cy->latency_rx_countdown);
+    cy_latency_trace_t trace  = { 0 };
+    if (traced) {
+        trace = (cy_latency_trace_t){ .topic_hash     = topic->hash,
+                                      .transfer_id    = transfer.metadata.transfer_id,
+                                      .remote_node_id = transfer.metadata.remote_node_id,
+                                      .outgoing       = false,
+                                      .ts_wire        = transfer.timestamp,
+                                      .ts_ingested    = cy_now(cy) };
+    }
+
+    bool retainable = true;
+    if (batch_is(topic, transfer.payload.base)) {
+        retainable = batch_dispatch(cy, topic, &transfer);
+    } else {
+        topic_dispatch(cy, topic, &transfer, false);
+    }
+    if (traced) {
+        trace.ts_delivered = cy_now(cy);
+        latency_report(cy, &trace);
+    }
+
+    // The conflating subscribers will see the transfer in the next update, unless it is superseded by then.
+    if (retainable && (rx != NULL) && rx->sub_params.conflate && (transfer.payload.origin.data != NULL)) {
+        topic_latest_retain(cy, topic, &transfer);
+    }
 
     // Release the payload at the end, unless the subscriber(s) took ownership of it.
-    if (transfer.payload.base.view.data != NULL) {
+    if (transfer.payload.origin.data != NULL) {
         cy->platform->buffer_release(cy, transfer.payload);
     }
 }
@@ -1797,37 +3835,71 @@ void cy_ingest_topic_response_transfer(cy_t* const cy, cy_transfer_owned_t trans
         return; // We don't know this topic, ignore it.
     }
 
-    // Find the matching pending response future -- log(N) lookup.
+    // Find the matching pending response future -- constant-time lookup.
     // TODO FIXME: the transfer ID comes from the message, not from the transfer metadata!
-    const uint64_t   transfer_id_masked = transfer.metadata.transfer_id & cy->platform->transfer_id_mask;
-    cy_tree_t* const tr =
-      cavl2_find(topic->futures_by_transfer_id, &transfer_id_masked, &cavl_comp_future_transfer_id_masked);
-    if (tr == NULL) {
+    const uint64_t     transfer_id_masked = transfer.metadata.transfer_id & cy->platform->transfer_id_mask;
+    cy_future_t* const fut                = future_slot_find(topic, transfer_id_masked);
+    if (fut == NULL) {
+        cy_stat_add(&topic->stats.drops, 1U);
         cy->platform->buffer_release(cy, transfer.payload);
         return; // Unexpected or duplicate response. TODO: Linger completed futures for multiple responses?
     }
-    cy_future_t* const fut = CAVL2_TO_OWNER(tr, cy_future_t, index_transfer_id);
     assert(fut->state == cy_future_pending);
 
     // Finalize and retire the future.
+    stat_histogram_add(&cy->stats.response_rtt, transfer.timestamp - fut->ts_published);
     fut->state = cy_future_success;
     cy_buffer_owned_release(cy, &fut->last_response.payload); // does nothing if already released
     fut->last_response = transfer;
-    cavl2_remove(&cy->futures_by_deadline, &fut->index_deadline);
-    cavl2_remove(&topic->futures_by_transfer_id, &fut->index_transfer_id);
+    future_retire(cy, fut);
     if (fut->callback != NULL) {
         fut->callback(cy, fut);
     }
 }
 
+void cy_ingest_reliable_ack_transfer(cy_t* const cy, cy_transfer_owned_t transfer)
+{
+    assert(cy != NULL);
+    mark_neighbor(cy, transfer.metadata.remote_node_id);
+    unsigned char  buffer[CY_RELIABLE_ACK_EXTENT];
+    const size_t   size =
+      cy_buffer_owned_gather(transfer.payload, (cy_bytes_mut_t){ .size = sizeof(buffer), .data = buffer });
+    cy->platform->buffer_release(cy, transfer.payload);
+    if ((size < sizeof(buffer)) || (buffer[16] != RELIABLE_ACK_KIND_MESSAGE)) {
+        return; // Malformed, or an acknowledgment of a reliable response, which is not supported yet.
+    }
+    cy_topic_t* const topic = cy_topic_find_by_hash(cy, deserialize_u64(&buffer[0]));
+    if (topic == NULL) {
+        return;
+    }
+    const uint64_t transfer_id = deserialize_u64(&buffer[8]) & cy->platform->transfer_id_mask;
+    const uint64_t mask        = deserialize_u64(&buffer[17]);
+    for (struct cy_reliable_tx_t* tx = topic->reliable_tx; tx != NULL; tx = tx->next_in_topic) {
+        reliable_on_ack(cy, tx, transfer.metadata.remote_node_id, transfer_id, mask, transfer.timestamp);
+    }
+}
+
 cy_err_t cy_update(cy_t* const cy)
 {
     cy_err_t      res = CY_OK;
     const cy_us_t now = cy_now(cy);
 
+    publish_submissions(cy);
+    batch_flush_due(cy, now); // After the submissions, which may have been batched.
+    topic_latest_notify(cy);
     retire_timed_out_futures(cy, now);
     mortal_retire_timed_out(cy, now);
 
+    // Acknowledge everything received since the last update in one go, then retransmit what was not acknowledged.
+    reliable_ack_flush(cy);
+    for (struct cy_reliable_tx_t* tx = cy->reliable_tx_head; tx != NULL; tx = tx->next) {
+        reliable_tx_update(cy, tx, now);
+    }
+
+    if (now >= (cy->ts_bloom_rotated + CY_CONFIG_NODE_ID_BLOOM_GENERATION_us)) {
+        node_id_bloom_rotate(cy, now);
+    }
+
     if (cy->node_id_collision) {
         CY_TRACE(cy, "🧠 Processing the delayed node-ID collision event now.");
         assert(cy->node_id <= cy->platform->node_id_max);
@@ -1838,18 +3910,18 @@ cy_err_t cy_update(cy_t* const cy)
     }
 
     // Find the next topic to gossip. We always have at least the heartbeat topic, so the index is never empty.
-    // It is a bit wasteful to fetch the min node every update; consider switching from AVL to perhaps a heap?
-    cy_topic_t* const topic_next_gossip =
-      CAVL2_TO_OWNER(cavl2_min(cy->topics_by_gossip_time), cy_topic_t, index_gossip_order);
+    assert(cy->gossip_heap_size > 0);
+    cy_topic_t* const topic_next_gossip = cy->topics_by_gossip_time[0];
 
     // Decide if it is time to publish a heartbeat.
     const bool due_normal = now >= cy->heartbeat_next;
     const bool due_urgent = cy_joined(cy) &&                                            //
                             (now >= (cy->heartbeat_last + cy->heartbeat_period_min)) && //
-                            ((topic_next_gossip->gossip_priority > 0) || (cy->next_scout != NULL));
+                            ((topic_next_gossip->gossip_priority > 0) || (cy->next_scout != NULL) ||
+                             cy->name_request_pending);
     if (due_normal || due_urgent) {
-        if ((topic_next_gossip->gossip_priority > 0) || (cy->next_scout == NULL)) {
-            res = publish_heartbeat_gossip(cy, topic_next_gossip, now);
+        if ((topic_next_gossip->gossip_priority > 0) || ((cy->next_scout == NULL) && !cy->name_request_pending)) {
+            res = publish_heartbeat_gossip(cy, now, !due_normal);
         } else {
             res = publish_heartbeat_scout(cy, now);
         }
@@ -1857,18 +3929,48 @@ cy_err_t cy_update(cy_t* const cy)
     return res;
 }
 
+cy_us_t cy_next_deadline(const cy_t* const cy)
+{
+    assert(cy != NULL);
+    // Submissions cannot wait, and neither can the node-ID collision nor the acknowledgments and the conflated
+    // notifications, although the latter are normally handled by the update that follows the ingestion.
+    if ((atomic_load_explicit(&cy->submissions, memory_order_relaxed) != NULL) || cy->node_id_collision ||
+        (cy->ack_pending_head != NULL) || (cy->latest_fresh_head != NULL)) {
+        return BIG_BANG;
+    }
+    cy_us_t out = future_wheel_next_deadline(cy); // Not later than the next heartbeat.
+    assert(cy->gossip_heap_size > 0);
+    const cy_topic_t* const topic_next_gossip = cy->topics_by_gossip_time[0];
+    if (cy_joined(cy) &&
+        ((topic_next_gossip->gossip_priority > 0) || (cy->next_scout != NULL) || cy->name_request_pending)) {
+        out = min_i64(out, cy->heartbeat_last + cy->heartbeat_period_min); // Urgent heartbeat, see cy_update().
+    }
+    const cy_topic_t* const mortal = cy->mortal_tail;
+    if (mortal != NULL) {
+        out = min_i64(out, max_i64(mortal->ts_received, mortal->ts_testified) + cy->mortal_topic_timeout + 1);
+    }
+    return batch_next_deadline(cy, reliable_next_deadline(cy, out));
+}
+
 void cy_notify_topic_hash_collision(cy_t* const cy, cy_topic_t* const topic)
 {
-    if (topic != NULL) { // Topics with the same time will be ordered FIFO -- the tree is stable.
+    if (topic != NULL) { // Topics with the same time will be ordered FIFO -- the heap is stabilized.
         prioritize_gossip(cy, topic, 100);
     }
 }
 
+void cy_notify_tx_latency(cy_t* const cy, const cy_us_t latency)
+{
+    assert(cy != NULL);
+    stat_histogram_add(&cy->stats.tx_latency, latency);
+}
+
 void cy_notify_node_id_collision(cy_t* const cy)
 {
     assert(cy != NULL);
     if ((!cy->node_id_collision) && (cy->node_id <= cy->platform->node_id_max)) {
         cy->node_id_collision = true;
+        cy_stat_add(&cy->stats.node_id_collisions, 1U);
         CY_TRACE(cy, "💥 %04x", cy->node_id);
     }
 }
@@ -107,10 +107,15 @@ typedef struct cy_transfer_metadata_t   cy_transfer_metadata_t;
 typedef struct cy_transfer_owned_t      cy_transfer_owned_t;
 typedef struct cy_publisher_t           cy_publisher_t;
 typedef struct cy_future_t              cy_future_t;
+typedef struct cy_submission_t          cy_submission_t;
 typedef struct cy_substitution_t        cy_substitution_t;
 typedef struct cy_arrival_t             cy_arrival_t;
 typedef struct cy_subscription_params_t cy_subscription_params_t;
 typedef struct cy_subscriber_t          cy_subscriber_t;
+typedef struct cy_stats_histogram_t     cy_stats_histogram_t;
+typedef struct cy_topic_stats_t         cy_topic_stats_t;
+typedef struct cy_stats_t               cy_stats_t;
+typedef struct cy_latency_trace_t       cy_latency_trace_t;
 #endif
 
 typedef enum cy_prio_t
@@ -197,6 +202,9 @@ struct cy_publisher_t
     cy_topic_t* topic;    ///< Many-to-one relationship, never NULL; the topic is reference counted.
     cy_prio_t   priority; ///< Defaults to cy_prio_nominal; can be overridden by the user at any time.
     void*       user;
+
+    struct cy_reliable_tx_t* reliable; ///< NULL unless cy_publisher_reliable() was called.
+    struct cy_batch_tx_t*    batch;    ///< NULL unless cy_publisher_batching() was called.
 };
 
 /// Future lifecycle:
@@ -220,13 +228,16 @@ typedef void (*cy_future_callback_t)(cy_t*, cy_future_t*);
 /// The future will enter the failure state to indicate that the response was not received before the deadline.
 struct cy_future_t
 {
-    cy_tree_t index_deadline;
-    cy_tree_t index_transfer_id;
+    /// Intrusive links of the deadline timer wheel and of the per-topic transfer-ID slot table; internal use only.
+    cy_future_t*  wheel_next;
+    cy_future_t** wheel_pprev;
+    cy_future_t*  slot_next;
 
     cy_publisher_t*   publisher;
     cy_future_state_t state;
     uint64_t          transfer_id_masked; ///< Masked as (platform->transfer_id_mask & transfer_id)
     cy_us_t           deadline;           ///< We're indexing on this so it shall not be changed after insertion.
+    cy_us_t           ts_published;       ///< Used for the response round-trip time statistics.
 
     /// These fields are populated once the response is received.
     /// The payload ownership is transferred to this structure.
@@ -291,6 +302,99 @@ static inline cy_err_t cy_publish1(cy_t* const                cy,
     return cy_publish(cy, pub, tx_deadline, payload, 0, NULL);
 }
 
+/// The largest window of a reliable publisher; it is limited by the width of the selective acknowledgment mask.
+#define CY_RELIABLE_WINDOW_MAX 64U
+
+/// Makes the publisher reliable: every transfer published afterward is retained and retransmitted with the same
+/// transfer-ID until it is acknowledged by every subscriber known at the time of publication, or until the delivery
+/// timeout expires. Up to window transfers may await acknowledgment at once, so the throughput is not bound by the
+/// round-trip time; while the window is full, cy_publish() fails with CY_ERR_CAPACITY, which is the back-pressure
+/// signal. The retransmission timeout adapts to the round-trip time measured from the acknowledgments.
+///
+/// The topic is gossiped with a flag that makes its subscribers acknowledge the transfers from this node; the
+/// acknowledgments are selective and batched per publisher, and duplicates are not delivered to the application,
+/// except that a retransmission lagging more than 64 transfers behind the latest one from the same publisher
+/// cannot be told apart from a first arrival and is delivered again: the delivery is at-least-once.
+/// The subscribers are learned from the gossip and from their acknowledgments, so the transfers published before
+/// the first subscriber is discovered are not retained; the application can wait for cy_publisher_subscriber_count().
+///
+/// The payloads are copied into the memory obtained from the platform. The window shall be in
+/// [1, CY_RELIABLE_WINDOW_MAX] and the delivery timeout shall be positive. Once reliable, a publisher stays so.
+cy_err_t cy_publisher_reliable(cy_t* const           cy,
+                               cy_publisher_t* const pub,
+                               const size_t          window,
+                               const cy_us_t         delivery_timeout);
+
+/// The number of transfers published reliably that are still awaiting acknowledgment; zero if not reliable.
+size_t cy_publisher_unacknowledged(const cy_publisher_t* const pub);
+
+/// The number of remote subscribers a reliable publisher currently expects acknowledgments from.
+size_t cy_publisher_subscriber_count(const cy_publisher_t* const pub);
+
+/// The framing overhead of a batch and of each message in it; see cy_publisher_batching().
+#define CY_BATCH_HEADER_SIZE     8U
+#define CY_BATCH_RECORD_OVERHEAD 2U
+
+/// Makes the publisher pack the messages published afterward into shared transfers, which cuts the per-transfer
+/// overhead of the transport (headers, queue items, system calls) for small messages published at a high rate.
+/// A message is appended to the current batch by cy_publish(), which then returns immediately; the batch is
+/// published as one transfer once the next message would not fit into max_bytes (including the framing overhead),
+/// once its oldest message has waited for max_latency (checked by cy_update(), so zero flushes on the next update),
+/// or when cy_publisher_flush() is called. The TX deadline of the batch is the earliest of its messages, and its
+/// priority is that of the publisher at the time of flushing. The messages expecting a response and the messages
+/// that would not fit into an empty batch are published alone, after the batch that was accumulated before them.
+///
+/// The subscribers unpack the batches transparently: every message arrives as a separate cy_arrival_t with the
+/// metadata of the batch, so the messages of one batch share the transfer-ID, and their payloads cannot be taken
+/// over by the subscriber. The conflating subscribers receive the last message of the batch, provided that the
+/// batch was not fragmented by the transport; to ensure this, max_bytes should not exceed the transport MTU.
+/// All nodes on the topic need to support batching. A batching publisher can also be reliable, in which case the
+/// batches are retransmitted as a whole. Once batching, a publisher stays so.
+///
+/// The transports truncate the transfers to the extent of the subscription, which is normally sized for one message.
+/// Hence, the topic is gossiped as batching, and the subscribers raise its extent to CY_CONFIG_BATCH_EXTENT upon
+/// learning of it; the batches that arrive before that may be truncated, and their trailing messages are dropped.
+///
+/// The batch buffer of max_bytes is obtained from the platform. Returns CY_ERR_ARGUMENT if already batching,
+/// if max_latency is negative, if max_bytes exceeds CY_CONFIG_BATCH_EXTENT, or if max_bytes does not leave room for
+/// a non-empty message of at most 65535 bytes.
+cy_err_t cy_publisher_batching(cy_t* const           cy,
+                               cy_publisher_t* const pub,
+                               const size_t          max_bytes,
+                               const cy_us_t         max_latency);
+
+/// Publishes the batched messages now, if there are any. No effect unless batching.
+cy_err_t cy_publisher_flush(cy_t* const cy, cy_publisher_t* const pub);
+
+typedef void (*cy_submission_callback_t)(cy_t*, cy_submission_t*);
+
+/// A publication requested from a thread other than the one that runs the event loop; see cy_submit().
+/// The fields mirror the arguments of cy_publish(). The submission, the payload, and the future are owned by Cy
+/// from cy_submit() until the callback is invoked; the future is then owned by Cy until it is no longer pending.
+struct cy_submission_t
+{
+    cy_publisher_t*      publisher;
+    cy_us_t              tx_deadline;
+    cy_buffer_borrowed_t payload;
+    cy_us_t              response_deadline;
+    cy_future_t*         future; ///< May be NULL if no response is expected.
+
+    /// Invoked from the event loop thread once published, with the result of cy_publish() stored in the submission.
+    /// This is where the submitting thread can be notified, e.g., by signaling a condition variable or resuming a
+    /// coroutine; the completion of the future can be awaited the same way via its callback. May be NULL.
+    cy_submission_callback_t callback;
+    void*                    user;
+    cy_err_t                 result;
+
+    cy_submission_t* next; ///< Internal use only.
+};
+
+/// This is the only function of Cy that may be invoked from any thread; it is lock-free and constant-time.
+/// The submission is published in the next cy_update() in the order of submission per submitting thread;
+/// the platform is asked to wake up the event loop so that it does not wait for the next heartbeat.
+/// Thereby, the application threads can produce data without locking and without copying the payload.
+void cy_submit(cy_t* const cy, cy_submission_t* const submission);
+
 // =====================================================================================================================
 //                                                      SUBSCRIBER
 // =====================================================================================================================
@@ -331,6 +435,14 @@ struct cy_subscription_params_t
 {
     size_t  extent;
     cy_us_t transfer_id_timeout;
+
+    /// If set, the subscriber is only interested in the latest value of the topic, which suits high-rate state data.
+    /// Instead of being invoked on every received transfer, its callback is invoked from cy_update() at most once per
+    /// topic with the latest transfer received since the previous invocation; the superseded transfers are released
+    /// immediately. The latest transfer is retained by the topic until superseded, so it can also be pulled at any
+    /// time using cy_topic_latest(); for pull-only subscribers the callback may be NULL.
+    /// The transfers whose payload has been taken by a non-conflating subscriber of the same topic are not seen.
+    bool conflate;
 };
 
 /// Subscribers SHALL NOT be copied/moved after initialization until destroyed.
@@ -376,7 +488,7 @@ static inline cy_err_t cy_subscribe_c(cy_t* const                    cy,
                                       const size_t                   extent,
                                       const cy_subscriber_callback_t callback)
 {
-    const cy_subscription_params_t params = { extent, CY_TRANSFER_ID_TIMEOUT_DEFAULT_us };
+    const cy_subscription_params_t params = { extent, CY_TRANSFER_ID_TIMEOUT_DEFAULT_us, false };
     return cy_subscribe_with_params_c(cy, sub, name, params, callback);
 }
 void cy_unsubscribe(cy_t* const cy, cy_subscriber_t* const sub);
@@ -399,6 +511,12 @@ cy_err_t cy_respond(cy_t* const                  cy,
 /// Copies the subscriber name into the user-supplied buffer.
 void cy_subscriber_name(const cy_t* const cy, const cy_subscriber_t* const sub, char* const out_name);
 
+/// The latest transfer retained by the topic for its conflating subscribers, see cy_subscription_params_t.
+/// NULL if there is none; e.g., if nothing has been received yet, or if a subscriber took ownership of the payload.
+/// The transfer remains owned by the topic; it is valid until the next transfer is received on the topic,
+/// which happens only while the event loop is running.
+const cy_transfer_owned_t* cy_topic_latest(const cy_topic_t* const topic);
+
 // =====================================================================================================================
 //                                                  NODE & TOPIC
 // =====================================================================================================================
@@ -443,6 +561,32 @@ bool cy_ready(const cy_t* const cy);
 /// The hint will be silently ignored if it is invalid, inapplicable, or if the topic is not freshly created.
 void cy_topic_hint(cy_t* const cy, cy_topic_t* const topic, const uint16_t subject_id);
 
+/// The snapshot is a compact binary image of the local node-ID and of the allocations of all non-pinned topics.
+/// It can be stored in non-volatile memory before shutdown and loaded back at the next startup to skip the
+/// node-ID autoconfiguration and the topic allocation consensus, making the node operational almost immediately.
+/// This is a bulk alternative to cy_topic_hint() that does not require the application to know the topic names.
+///
+/// cy_snapshot_size() returns the number of bytes required to save the current state.
+/// cy_snapshot_save() writes the snapshot into the buffer and returns the number of bytes written,
+/// or zero if the buffer is too small. The snapshot is protected by a checksum.
+size_t cy_snapshot_size(const cy_t* const cy);
+size_t cy_snapshot_save(const cy_t* const cy, const cy_bytes_mut_t out);
+
+/// Load a snapshot made by cy_snapshot_save(), normally by the same node in an earlier run.
+/// This should be invoked immediately after cy_new(), preferably before the application topics are created.
+/// It is not a parameter of cy_new() because cy_new() is invoked by the platform constructors, which would all have
+/// to forward it; nothing is published until the first cy_update(), so loading right after is equally effective.
+/// The allocations of the listed topics are applied when the topics are created; the topics that already exist
+/// are reallocated on the spot. The restored state is only a starting point: conflicts and divergences discovered
+/// later are handled normally, without any preference to the snapshot.
+///
+/// The node-ID is restored only if the snapshot was made by the node with the same UID and no node-ID was given
+/// to cy_new(). Loading a new snapshot replaces the previously loaded one.
+///
+/// Returns CY_ERR_ARGUMENT if the snapshot is malformed or corrupted, CY_ERR_MEMORY if out of memory;
+/// the state is not modified in these cases. An error from platform->node_id_set() is returned as-is.
+cy_err_t cy_snapshot_load(cy_t* const cy, const cy_bytes_t snapshot);
+
 /// Complexity is logarithmic in the number of topics. NULL if not found.
 /// In practical terms, these queries are very fast and efficient.
 cy_topic_t*               cy_topic_find_by_name(const cy_t* const cy, const wkv_str_t name);
@@ -479,6 +623,98 @@ static inline bool cy_has_substitution_tokens_c(const char* const name)
     return cy_has_substitution_tokens(wkv_key(name));
 }
 
+// =====================================================================================================================
+//                                                      STATISTICS
+// =====================================================================================================================
+
+/// Durations are counted in logarithmic buckets of microseconds: bucket 0 counts zero (and negative) values,
+/// bucket k counts values in [2**(k-1), 2**k); the last bucket also counts all values that are larger.
+#define CY_STATS_HISTOGRAM_BUCKET_COUNT 32U
+
+struct cy_stats_histogram_t
+{
+    uint64_t buckets[CY_STATS_HISTOGRAM_BUCKET_COUNT];
+};
+
+/// All counters start from zero when the topic is created and wrap around on overflow.
+struct cy_topic_stats_t
+{
+    uint64_t transfers_in;  ///< Transfers delivered to the subscribers.
+    uint64_t bytes_in;      ///< Payload bytes of the above.
+    uint64_t transfers_out; ///< Transfers accepted by the transport for publication, including heartbeats.
+    uint64_t bytes_out;     ///< Payload bytes of the above.
+    uint64_t drops;         ///< Transfers the transport failed to publish or receive, and unexpected responses.
+    uint64_t reallocations; ///< Subject-ID changes after the initial allocation, for any reason.
+    uint64_t evictions;     ///< Arbitrations against other topics, local or remote, lost by this topic.
+
+    /// Reliable delivery; see cy_publisher_reliable().
+    uint64_t retransmissions;   ///< Transfers published again because some subscribers did not acknowledge them.
+    uint64_t delivery_failures; ///< Transfers not acknowledged by all subscribers before the delivery timeout.
+    uint64_t duplicates;        ///< Received retransmissions of the transfers that had already been delivered.
+
+    /// Transfers superseded by a newer one before the conflating subscribers were notified.
+    uint64_t conflated;
+
+    /// Batching; see cy_publisher_batching().
+    uint64_t batched;   ///< Messages appended to the batches by the local publishers.
+    uint64_t unbatched; ///< Messages unpacked from the received batches.
+};
+
+/// All counters start from zero when the node is created and wrap around on overflow.
+struct cy_stats_t
+{
+    uint64_t heartbeats_in;
+    uint64_t heartbeats_out;
+    uint64_t collisions;         ///< Gossips from remote topics that occupy the subject-ID of a local topic.
+    uint64_t divergences;        ///< Gossips of local topics that are allocated differently on the remote.
+    uint64_t node_id_collisions; ///< See cy_notify_node_id_collision().
+    uint64_t bloom_purges;       ///< The node-ID Bloom filter generations were rotated early due to congestion.
+    uint64_t response_timeouts;  ///< Futures that timed out without a response.
+
+    /// Gossips of unknown topics dismissed by the negative cache without matching the name against the patterns.
+    uint64_t pattern_miss_cache_hits;
+
+    /// The time a transfer waited in the transmission queue of the transport before it was sent.
+    /// This is only populated if the platform layer supports it; see cy_notify_tx_latency().
+    cy_stats_histogram_t tx_latency;
+
+    /// The time from cy_publish() to the arrival of the response, for futures that succeeded.
+    cy_stats_histogram_t response_rtt;
+
+    /// The stages of the traced transfers; see cy_latency_tracing(). Empty unless tracing is enabled.
+    cy_stats_histogram_t tx_wire_latency;     ///< From cy_publish() until the last frame has left the host.
+    cy_stats_histogram_t rx_stack_latency;    ///< From the arrival of the first frame until the ingestion by Cy.
+    cy_stats_histogram_t rx_callback_latency; ///< From the ingestion until the last subscriber callback returned.
+};
+
+/// These can be invoked from any thread concurrently with the thread running Cy; no locking is involved.
+/// Each counter is read atomically, but the counters are not a consistent snapshot of each other.
+/// The topic pointer shall remain valid during the call.
+void cy_topic_stats(const cy_topic_t* const topic, cy_topic_stats_t* const out);
+void cy_stats(const cy_t* const cy, cy_stats_t* const out);
+
+/// The timeline of one traced transfer. The time points that do not apply to its direction are zero.
+struct cy_latency_trace_t
+{
+    uint64_t topic_hash;
+    uint64_t transfer_id;
+    uint16_t remote_node_id; ///< The publisher of an incoming transfer; CY_NODE_ID_INVALID if outgoing.
+    bool     outgoing;
+
+    cy_us_t ts_published; ///< Outgoing: cy_publish() was invoked.
+    cy_us_t ts_wire;      ///< Outgoing: the last frame has left the host. Incoming: the first frame has arrived.
+    cy_us_t ts_ingested;  ///< Incoming: the transfer was reassembled and handed over to Cy.
+    cy_us_t ts_delivered; ///< Incoming: the last subscriber callback returned.
+};
+typedef void (*cy_latency_callback_t)(cy_t*, const cy_latency_trace_t*);
+
+/// Traces every sample_period-th transfer in each direction: of those published via cy_publish() and of those
+/// delivered to the subscribers; zero disables the tracing, which is the default. The stage latencies are added to
+/// the histograms in cy_stats_t, and the complete trace is passed to the callback unless it is NULL.
+/// The wire time is as precise as the platform can provide; with kernel timestamping it excludes the time spent
+/// waiting for the event loop. The outgoing transfers are only traced if the platform reports their departure.
+void cy_latency_tracing(cy_t* const cy, const uint32_t sample_period, const cy_latency_callback_t callback);
+
 // =====================================================================================================================
 //                                                      BUFFERS
 // =====================================================================================================================
@@ -12,6 +12,11 @@
 #pragma once
 
 #include "cy.h"
+#ifdef __cplusplus
+#include <atomic>
+#else
+#include <stdatomic.h>
+#endif
 
 // =====================================================================================================================
 //                                              BUILD TIME CONFIG OPTIONS
@@ -32,6 +37,41 @@
 // Not defined by default; the normal subject expression is used instead: subject_id=(hash+evictions)%6144
 #endif
 
+/// If nonzero, the topic lookups by hash and by subject-ID use flat tables instead of the AVL trees:
+/// a direct-mapped subject-ID table and an open-addressing hash table keyed on the topic hash, both constant-time.
+/// The AVL hash index is still maintained for ordered iteration.
+/// The cost is CY_TOTAL_SUBJECT_COUNT pointers in cy_t plus up to four pointers per topic on the heap.
+/// This value shall be identical for all translation units, since it affects the layout of cy_t.
+#ifndef CY_CONFIG_TOPIC_FLAT_INDEX
+#define CY_CONFIG_TOPIC_FLAT_INDEX 0
+#endif
+
+/// The number of entries in the cache of the remote topic hashes known to match no local pattern subscriber;
+/// see cy_t::pattern_misses. Shall be a power of two. The cost is eight bytes per entry in cy_t.
+#ifndef CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY
+#define CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY 256U
+#endif
+
+/// The node-ID occupancy Bloom filter forgets the nodes that have not been heard from for one to two periods of this
+/// duration; see cy_bloom64_t. It shall be several times greater than the heartbeat period of the slowest node
+/// in the network, which does not exceed 1 second; otherwise, live nodes may be forgotten between their heartbeats.
+#ifndef CY_CONFIG_NODE_ID_BLOOM_GENERATION_us
+#define CY_CONFIG_NODE_ID_BLOOM_GENERATION_us 10000000L
+#endif
+
+/// The largest heartbeat that can be received in full; see cy_t::heartbeat_size_max.
+/// It is also the upper limit of the heartbeat size that a node will publish.
+#ifndef CY_CONFIG_HEARTBEAT_EXTENT
+#define CY_CONFIG_HEARTBEAT_EXTENT 1400U
+#endif
+
+/// The largest batch that can be received in full; see cy_publisher_batching(). The transports truncate the transfers
+/// to the extent of the subscription, so the extent of a topic is raised to this value once a batching publisher is
+/// discovered on it, and the publishers cannot batch more than this. It shall be the same on all nodes.
+#ifndef CY_CONFIG_BATCH_EXTENT
+#define CY_CONFIG_BATCH_EXTENT 1400U
+#endif
+
 /// If CY_CONFIG_TRACE is defined and is non-zero, cy_trace() shall be defined externally.
 #ifndef CY_CONFIG_TRACE
 #define CY_CONFIG_TRACE 0
@@ -52,6 +92,72 @@ typedef struct cy_bloom64_t  cy_bloom64_t;
 typedef struct cy_platform_t cy_platform_t;
 #endif
 
+/// The statistics counters are written only by the thread running Cy, so a relaxed load-store pair suffices to update
+/// them; there is no read-modify-write. They are loaded atomically by cy_stats() and cy_topic_stats(), which can
+/// thus be used from any thread without locking, provided that 64-bit atomics are lock-free on the target.
+/// The fields mirror the public snapshot types; see cy_stats_t and cy_topic_stats_t for the semantics.
+/// _Atomic is not valid C++, so C++ translation units see a layout-compatible wrapper that is only accessed via
+/// cy_stat_add(); the layout equivalence is enforced in cy.c.
+#ifndef __cplusplus
+typedef _Atomic uint64_t cy_stat_t;
+#else
+typedef struct cy_stat_t
+{
+    alignas(8) uint64_t value_;
+} cy_stat_t;
+#endif
+
+struct cy_stats_histogram_counters_t
+{
+    cy_stat_t buckets[CY_STATS_HISTOGRAM_BUCKET_COUNT];
+};
+
+struct cy_topic_counters_t
+{
+    cy_stat_t transfers_in;
+    cy_stat_t bytes_in;
+    cy_stat_t transfers_out;
+    cy_stat_t bytes_out;
+    cy_stat_t drops;
+    cy_stat_t reallocations;
+    cy_stat_t evictions;
+    cy_stat_t retransmissions;
+    cy_stat_t delivery_failures;
+    cy_stat_t duplicates;
+    cy_stat_t conflated;
+    cy_stat_t batched;
+    cy_stat_t unbatched;
+};
+
+struct cy_node_counters_t
+{
+    cy_stat_t                            heartbeats_in;
+    cy_stat_t                            heartbeats_out;
+    cy_stat_t                            collisions;
+    cy_stat_t                            divergences;
+    cy_stat_t                            node_id_collisions;
+    cy_stat_t                            bloom_purges;
+    cy_stat_t                            response_timeouts;
+    cy_stat_t                            pattern_miss_cache_hits;
+    struct cy_stats_histogram_counters_t tx_latency;
+    struct cy_stats_histogram_counters_t response_rtt;
+    struct cy_stats_histogram_counters_t tx_wire_latency;
+    struct cy_stats_histogram_counters_t rx_stack_latency;
+    struct cy_stats_histogram_counters_t rx_callback_latency;
+};
+
+/// The platform layer may use this to account for the events that only it can see; e.g., the topic drops.
+/// Shall only be invoked from the thread running Cy.
+static inline void cy_stat_add(cy_stat_t* const counter, const uint64_t value)
+{
+#ifndef __cplusplus
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+#else
+    std::atomic_ref<uint64_t> ref(counter->value_);
+    ref.store(ref.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+#endif
+}
+
 /// When a response to a received message is sent, it is delivered as a P2P transfer to this service-ID.
 /// The receiver of the response will be able to match the response with a specific request using the transfer-ID.
 /// The response user data is immediately prefixed with the following data (in DSDL notation):
@@ -67,21 +173,49 @@ typedef struct cy_platform_t cy_platform_t;
 ///
 /// The transfer-ID of the acknowledgment is the same as the transfer-ID of the original message/response.
 ///
-/// Each acknowledgement transfer is sent twice to reduce the risk of loss, since the loss of an acknowledgment
-/// is costly in terms of bandwidth and latency.
+/// The acknowledgments are selective: one acknowledgment covers the specified transfer and up to 64 transfers
+/// preceding it from the same publisher on the same topic. The receiver sends one acknowledgment per publisher
+/// per cy_update() covering everything received since the last one, so the loss of an acknowledgment is repaired
+/// by the next one without additional traffic.
 ///
 /// The format of the acknowledgment message is as follows (in DSDL notation):
 ///
 ///     uint64 topic_hash   # Like in the topic response.
 ///     uint64 transfer_id  # The masked transfer-ID of the transfer that this ack is for.
 ///     uint8  kind         # 0 -- message positive ack; 1 -- response positive ack.
+///     uint64 mask         # Bit N set: transfer_id-1-N was also received. Only present in message acks.
 #define CY_P2P_SERVICE_ID_RELIABLE_ACK 511
 
-/// An ordinary Bloom filter with 64-bit words.
+/// The geometry of the response future deadline timer wheel; see cy_t::futures_by_deadline.
+/// One tick is 1024 microseconds; with 4 levels of 64 slots the wheel spans 2^24 ticks, or about 4.7 hours.
+/// The futures with more distant deadlines are parked in the last slot and re-examined when it comes due.
+#define CY_FUTURE_WHEEL_LEVELS 4U
+#define CY_FUTURE_WHEEL_SLOTS  64U
+
+/// The number of outgoing traced transfers that can await the report of their departure from the platform at once.
+#define CY_LATENCY_TX_PROBES 8U
+
+/// An outgoing traced transfer awaiting cy_notify_tx_departure(). The token is zero if the probe is free.
+struct cy_latency_probe_t
+{
+    uint32_t           token;
+    cy_latency_trace_t trace;
+};
+
+/// A Bloom filter has no way to clear an individual bit, so the marks left by the nodes that have gone offline
+/// (tombstones) would accumulate until the filter is full. To expire them gradually, the filter is generational:
+/// the storage holds CY_BLOOM64_GENERATIONS filters of n_bits each, the first being the current generation.
+/// New entries are set in the current generation, while lookups consult all of them. The core rotates the
+/// generations every CY_CONFIG_NODE_ID_BLOOM_GENERATION_us, dropping the oldest one, so a node that keeps transmitting
+/// is never lost from the filter, while a tombstone is gone after at most CY_BLOOM64_GENERATIONS rotations.
+#define CY_BLOOM64_GENERATIONS 2U
+
+/// A generational Bloom filter with 64-bit words; see CY_BLOOM64_GENERATIONS.
+/// The platform provides the storage of CY_BLOOM64_GENERATIONS*n_bits/64 words; the core manages the contents.
 struct cy_bloom64_t
 {
-    size_t    n_bits;   ///< The total number of bits in the filter, a multiple of 64.
-    size_t    popcount; ///< (popcount <= n_bits)
+    size_t    n_bits;   ///< The number of bits in one generation, a multiple of 64.
+    size_t    popcount; ///< Bits set in the current generation (popcount <= n_bits).
     uint64_t* storage;
 };
 
@@ -118,17 +252,38 @@ struct cy_bloom64_t
 ///     2. winner has seen more evictions (i.e., larger subject-ID mod max_topics).
 /// When a topic is reallocated, it retains its current age.
 /// Conflict resolution may result in a temporary jitter if it happens to occur near log2(age) integer boundary.
+/// The layout is chosen to keep the per-topic memory small, because a gateway may carry thousands of topics most of
+/// which are cold. The fields read on every publication and every received transfer share the first cache line
+/// (on 64-bit targets); the rest is only touched by the gossip, the allocator, and the bookkeeping. The name is
+/// stored in an allocation of its exact size, and the subscriber-side state is only allocated when the topic is
+/// first coupled with a subscriber. The per-topic byte budget on a 64-bit target is therefore:
+///
+///     sizeof(cy_topic_t)                                          -- reported by the memory/* cases of cy_bench
+///     + name length + 1                                           -- one heap block
+///     + sizeof(struct cy_topic_rx_t)                              -- only if subscribed
+///     + the couplings, the dispatch array, the reliable RX array   -- only if subscribed
+///     + the latest transfer                                       -- only if there are conflating subscribers
+///     + the future slots                                          -- only if the responses are awaited
+///     + the platform-specific extension                           -- see the transport documentation
+///     + an entry in each index (the name trie, the gossip heap)
 struct cy_topic_t
 {
     cy_tree_t index_hash; ///< Hash index handle MUST be the first field.
-    cy_tree_t index_subject_id;
-    cy_tree_t index_gossip_order;
 
-    wkv_node_t* index_name;
+    /// Assuming we have 1000 topics, the probability of a topic name hash collision is:
+    /// >>> from decimal import Decimal
+    /// >>> n = 1000
+    /// >>> d = Decimal(2**64)
+    /// >>> 1 - ((d-1)/d) ** ((n*(n-1))//2)
+    /// About 2.7e-14, or one in 37 trillion.
+    /// For pinned topics, the name hash equals the subject-ID.
+    uint64_t hash;
 
-    /// The name length is stored in index_name.
-    /// We need to store the full name to allow valid references from name substitutions during pattern matching.
-    char name[CY_TOPIC_NAME_MAX + 1];
+    /// Only used if the application publishes data on this topic.
+    uint64_t pub_transfer_id;
+
+    /// The subscriber-side state; NULL until the topic is first coupled with a subscriber. The contents are private.
+    struct cy_topic_rx_t* rx;
 
     /// Whenever a topic conflicts with another one locally, arbitration is performed, and the loser has its
     /// eviction counter incremented. The eviction counter is used as a Lamport clock counting the loss events.
@@ -138,14 +293,22 @@ struct cy_topic_t
     /// Remember that the subject-ID is (for non-pinned topics): (hash+evictions)%topic_count.
     uint32_t evictions;
 
-    /// Assuming we have 1000 topics, the probability of a topic name hash collision is:
-    /// >>> from decimal import Decimal
-    /// >>> n = 1000
-    /// >>> d = Decimal(2**64)
-    /// >>> 1 - ((d-1)/d) ** ((n*(n-1))//2)
-    /// About 2.7e-14, or one in 37 trillion.
-    /// For pinned topics, the name hash equals the subject-ID.
-    uint64_t hash;
+    /// Only used if the application subscribes on this topic.
+    bool subscribed; ///< May be (tentatively) false even with couplings!=NULL on resubscription error.
+
+    // ------------------------------------------ end of the hot fields ------------------------------------------
+
+    struct cy_topic_coupling_t* couplings;
+
+#if !CY_CONFIG_TOPIC_FLAT_INDEX
+    cy_tree_t index_subject_id;
+#endif
+
+    wkv_node_t* index_name;
+
+    /// The name length is stored in index_name; the allocation holds exactly that many bytes plus the terminator.
+    /// We need to store the full name to allow valid references from name substitutions during pattern matching.
+    char* name;
 
     /// Currently, the age is increased locally as follows:
     ///
@@ -170,29 +333,53 @@ struct cy_topic_t
     cy_us_t ts_gossiped;  ///< Gossip last published at this time.
     cy_us_t ts_received;  ///< Transfer last received at this time.
     cy_us_t ts_testified; ///< Gossip received at this time, except gossips from subscribers that receive no transfers.
+    cy_us_t ts_named;     ///< Gossip with the topic name last published or received at this time.
 
     /// The next topic to gossip is chosen with the highest priority, then with the lowest ts_gossiped.
     /// Topics with zero priority are gossiped at the max gossip period; others force the min period.
     /// Once a gossip is published, the priority is reset to the minimum.
-    uint_fast8_t gossip_priority;
+    /// The sequence number is assigned whenever the topic is rescheduled; it keeps the order FIFO for equal times.
+    uint64_t gossip_seq;
+    size_t   gossip_heap_index; ///< Position in cy_t::topics_by_gossip_time.
 
     /// Mortal topics are ordered by last animation time, which is used to determine which topic to retire next.
     /// Mortal topics are distinguished from ordinary topics by being in the list.
     cy_topic_t* mortal_next;
     cy_topic_t* mortal_prev;
 
-    /// Used for matching futures against received responses.
-    cy_tree_t* futures_by_transfer_id;
+    /// Only used by the subject-ID allocator to track the eviction chain without recursion.
+    cy_topic_t* alloc_next_pending;
+    cy_topic_t* alloc_next_touched;
+
+    /// Used for matching futures against received responses. The pending futures are chained into the slots
+    /// indexed by the masked transfer-ID modulo the capacity. Since the transfer-ID is incremented with every
+    /// publication, the futures in flight map onto distinct slots as long as the load factor is kept below one.
+    struct cy_future_t** futures_by_transfer_id;
+    size_t               futures_capacity; ///< Zero or a power of two.
+    size_t               futures_count;
 
-    /// Only used if the application publishes data on this topic.
     /// pub_count tracks the number of existing advertisements on this topic; when this number reaches zero
     /// and there are no live subscriptions, the topic will be garbage collected by Cy.
-    uint64_t pub_transfer_id;
-    size_t   pub_count;
+    size_t pub_count;
+
+    /// Reliable delivery; see cy_publisher_reliable(). The local reliable publishers on this topic are listed
+    /// and the topic is gossiped with the reliable flag while there are any. The remote reliable publishers that we
+    /// receive from are tracked in the subscriber-side state for deduplication and acknowledgment; the topic is put
+    /// on the list of the topics with acknowledgments to send whenever a transfer from any of them arrives.
+    struct cy_reliable_tx_t* reliable_tx;
+    cy_topic_t*              ack_next;
+
+    /// The small fields are packed together at the end to avoid padding.
+    /// alloc_subject_id_before is the subject-ID before the current allocation batch, UINT16_MAX if there was none.
+    uint16_t     alloc_subject_id_before;
+    uint_fast8_t gossip_priority;
+    bool         gossip_name_requested; ///< Set when a remote asks for the name or scouts; the next gossip includes it.
+    bool         alloc_touched;
+    bool         ack_pending;
+    bool         batching; ///< A batching publisher was seen on the topic; the extent covers CY_CONFIG_BATCH_EXTENT.
 
-    /// Only used if the application subscribes on this topic.
-    struct cy_topic_coupling_t* couplings;
-    bool subscribed; ///< May be (tentatively) false even with couplings!=NULL on resubscription error.
+    /// See cy_topic_stats().
+    struct cy_topic_counters_t stats;
 };
 
 /// Returns the current monotonic time in microseconds. The initial time shall be non-negative.
@@ -267,9 +454,11 @@ typedef cy_topic_t* (*cy_platform_topic_new_t)(cy_t*);
 
 typedef void (*cy_platform_topic_destroy_t)(cy_t*, cy_topic_t*);
 
-/// Instructs the underlying transport layer to publish a new message on the topic.
+/// Instructs the underlying transport layer to publish a message on the topic with the specified transfer-ID.
+/// The transfer-ID is normally the current value of the counter of the topic, but the retransmissions of the reliable
+/// publishers reuse the transfer-ID of the original transfer, so the counter of the topic shall not be used here.
 /// The function shall not increment the transfer-ID counter; Cy will do it.
-typedef cy_err_t (*cy_platform_topic_publish_t)(cy_t*, cy_publisher_t*, cy_us_t, cy_buffer_borrowed_t);
+typedef cy_err_t (*cy_platform_topic_publish_t)(cy_t*, cy_publisher_t*, cy_us_t, uint64_t, cy_buffer_borrowed_t);
 
 /// Instructs the underlying transport layer to create a new subscription on the topic.
 typedef cy_err_t (*cy_platform_topic_subscribe_t)(cy_t*, cy_topic_t*, cy_subscription_params_t);
@@ -297,6 +486,12 @@ typedef void (*cy_platform_topic_advertise_t)(cy_t*, cy_topic_t*, size_t respons
 /// Cy will keep attempting to repair the topic periodically when relevant heartbeats are received.
 typedef void (*cy_platform_topic_on_subscription_error_t)(cy_t*, cy_topic_t*, const cy_err_t);
 
+/// Unblocks the thread that runs the event loop if it is waiting for events, so that it invokes cy_update() soon.
+/// This is the only platform function that is invoked from arbitrary threads, namely from cy_submit();
+/// it shall be thread-safe and should be cheap if invoked repeatedly before the event loop wakes up.
+/// May be NULL if the event loop never blocks for long, in which case the submissions wait for the next update.
+typedef void (*cy_platform_wake_t)(cy_t*);
+
 /// The platform- and transport-specific entities. These can be underpinned by libcanard, libudpard, libserard,
 /// or any other transport library, plus the platform-specific logic.
 /// None of the entities are mutable; instances of this struct are mostly intended to be static const singletons.
@@ -321,6 +516,8 @@ struct cy_platform_t
     cy_platform_topic_advertise_t             topic_advertise;
     cy_platform_topic_on_subscription_error_t topic_on_subscription_error;
 
+    cy_platform_wake_t wake;
+
     /// 127 for Cyphal/CAN, 65534 for Cyphal/UDP and Cyphal/Serial, etc.
     /// This is used for the automatic node-ID allocation.
     uint16_t node_id_max;
@@ -333,7 +530,7 @@ struct cy_platform_t
 };
 
 /// There are only three functions (plus convenience wrappers) whose invocations may result in network traffic:
-/// - cy_update()  -- heartbeat only, at most one per call.
+/// - cy_update()  -- heartbeat (at most one per call), reliable delivery, and the submissions from other threads.
 /// - cy_publish() -- user transfers only.
 /// - cy_respond() -- user transfers only.
 /// Creation of a new topic may cause resubscription of any existing topics (all in the worst case).
@@ -359,6 +556,7 @@ struct cy_t
     cy_us_t ts_started;
     cy_us_t ts_event;
     cy_us_t ts_local_event;
+    cy_us_t ts_bloom_rotated; ///< When the current generation of the node-ID Bloom filter was started.
 
     /// Set from cy_notify_node_id_collision(). The actual handling is delayed.
     bool node_id_collision;
@@ -380,11 +578,29 @@ struct cy_t
     cy_us_t         heartbeat_period_max; ///< Not greater than 1 second.
     cy_us_t         heartbeat_period_min; ///< Not greater than heartbeat_period_max.
 
+    /// A heartbeat carries as many topic gossips as fit into this many bytes, taken in the gossip order.
+    /// The default fits only one gossip with the longest name. The platform layer should raise it after cy_new()
+    /// to the largest payload that fits into one transport frame. Values outside [default, CY_CONFIG_HEARTBEAT_EXTENT]
+    /// are clamped. May be changed at any time.
+    size_t heartbeat_size_max;
+
     /// Topics have multiple indexes.
     cy_tree_t* topics_by_hash;
-    cy_tree_t* topics_by_subject_id;
-    cy_tree_t* topics_by_gossip_time;
     wkv_t      topics_by_name;
+#if CY_CONFIG_TOPIC_FLAT_INDEX
+    cy_topic_t*  topics_by_subject_id[CY_TOTAL_SUBJECT_COUNT];
+    cy_topic_t** topics_by_hash_flat; ///< Open addressing with linear probing; the load factor is at most 1/2.
+    size_t       topics_by_hash_flat_capacity;
+#else
+    cy_tree_t* topics_by_subject_id;
+#endif
+
+    /// The gossip schedule is a binary min-heap stored in a growable array; the next topic to gossip is at the root.
+    /// Fetching it is constant-time, rescheduling a topic is logarithmic without any allocation.
+    cy_topic_t** topics_by_gossip_time;
+    size_t       gossip_heap_size;
+    size_t       gossip_heap_capacity;
+    uint64_t     gossip_seq;
 
     /// When a heartbeat is received, its topic name will be compared against the patterns,
     /// and if a match is found, a new subscription will be constructed automatically.
@@ -395,12 +611,69 @@ struct cy_t
     /// Only for pattern subscriptions.
     struct cy_subscriber_root_t* next_scout;
 
-    /// For detecting timed out futures. This index spans all topics.
-    cy_tree_t* futures_by_deadline;
+    /// The hash of a topic that was announced without the name, which we may want to subscribe to.
+    /// The name will be requested via a nameless scout. Only the latest request is kept.
+    uint64_t name_request_hash;
+    bool     name_request_pending;
+    size_t   pattern_subscription_count;
+
+    /// Hashes of the remote topics whose names are known to match none of the pattern subscribers, so that the
+    /// repeated gossips of such topics are rejected with one probe instead of a pattern match. Direct-mapped on the
+    /// low bits of the hash, which are uniformly distributed; zero marks an empty slot, so hash zero is never cached.
+    /// Cleared whenever a new pattern is added, since it may match the topics that did not match before.
+    uint64_t pattern_misses[CY_CONFIG_PATTERN_MISS_CACHE_CAPACITY];
+
+    /// Topic allocations imported via cy_snapshot_load(), sorted by hash. Each entry is applied when the matching
+    /// topic is created, so that a warm-started node can skip the consensus phase.
+    struct cy_snapshot_topic_t* snapshot_topics;
+    size_t                      snapshot_topic_count;
+
+    /// The publications submitted from other threads via cy_submit() in the reverse order of submission.
+    /// This is a lock-free stack: the producers push with CAS, the event loop takes all of it at once with exchange.
+    /// C++ translation units see a plain pointer of the same layout (enforced in cy.c) and shall not access it.
+#ifndef __cplusplus
+    _Atomic(cy_submission_t*) submissions;
+#else
+    cy_submission_t* submissions;
+#endif
+
+    /// All reliable publishers, for retransmission, and the topics that have acknowledgments to send.
+    struct cy_reliable_tx_t* reliable_tx_head;
+    cy_topic_t*              ack_pending_head;
+
+    /// The topics whose conflating subscribers are to be notified of a new latest transfer in the next cy_update().
+    struct cy_topic_latest_t* latest_fresh_head;
+
+    /// All batching publishers, for flushing on the latency budget; see cy_publisher_batching().
+    struct cy_batch_tx_t* batch_tx_head;
+
+    /// For detecting timed out futures. This index spans all topics. It is a hierarchical timer wheel: level L
+    /// slot S holds the futures expiring within the S-th span of CY_FUTURE_WHEEL_SLOTS^L ticks ahead of the current
+    /// tick; the futures are moved to the lower levels as the time approaches their deadlines.
+    /// The occupancy bitmaps allow skipping the empty spans quickly.
+    struct cy_future_t* futures_by_deadline[CY_FUTURE_WHEEL_LEVELS][CY_FUTURE_WHEEL_SLOTS];
+    uint64_t            futures_wheel_occupancy[CY_FUTURE_WHEEL_LEVELS];
+    uint64_t            futures_wheel_tick; ///< All ticks before this one have been processed.
+    size_t              futures_pending;
 
     /// This is to ensure we don't exhaust the subject-ID space.
     size_t topic_count;
 
+    /// See cy_stats().
+    struct cy_node_counters_t stats;
+
+    /// See cy_latency_tracing(). The probes are indexed by the token modulo their number.
+    /// While platform->topic_publish() is executing, latency_tx_probe is the token of the transfer if it is traced,
+    /// zero otherwise. The platform that can tell when the last frame has left the host should keep the token with
+    /// the frame and pass it to cy_notify_tx_departure() afterward; other platforms may ignore it.
+    uint32_t                  latency_sample_period;
+    cy_latency_callback_t     latency_callback;
+    uint32_t                  latency_rx_countdown;
+    uint32_t                  latency_tx_countdown;
+    uint32_t                  latency_tx_probe;
+    uint32_t                  latency_tx_token_last;
+    struct cy_latency_probe_t latency_tx[CY_LATENCY_TX_PROBES];
+
     /// The user can use this field for arbitrary purposes.
     void* user;
 };
@@ -422,8 +695,8 @@ cy_err_t cy_new(cy_t* const                cy,
 void     cy_destroy(cy_t* const cy);
 
 /// This function must be invoked periodically to let the library publish heartbeats and handle response timeouts.
-/// The most efficient invocation schedule is guided by cy->heartbeat_next, but not less often than every 10 ms;
-/// if a fixed-rate updates are desired, then the recommended period is 1 millisecond.
+/// The most efficient invocation schedule is guided by cy_next_deadline(); the update is also needed after every
+/// ingestion. If a fixed-rate updates are desired, then the recommended period is 1 millisecond.
 ///
 /// This is the only function that generates heartbeat -- the only kind of auxiliary traffic needed by the protocol.
 /// The returned value indicates the success of the heartbeat publication, if any took place, or zero.
@@ -436,6 +709,14 @@ void     cy_destroy(cy_t* const cy);
 /// Excluding the transport_publish dependency, the time complexity is logarithmic in the number of topics.
 cy_err_t cy_update(cy_t* const cy);
 
+/// The latest time by which cy_update() shall be invoked next, unless new transfers are ingested in the meantime,
+/// considering the heartbeat, the response deadlines, the mortal topic expiration, and the reliable delivery.
+/// The event loop can sleep until then waiting for I/O instead of waking up at a fixed rate.
+/// The result is never later than cy->heartbeat_next and may be in the past, meaning that an update is due now.
+/// The time complexity is linear in the number of futures expiring within the next wheel tick
+/// and in the number of unacknowledged reliable publications.
+cy_us_t cy_next_deadline(const cy_t* const cy);
+
 /// When the transport library detects a topic hash error, it will notify Cy about it to let it rectify the
 /// problem. Transport frames with mismatched topic hash must be dropped; no processing at the transport layer
 /// is needed. This function is not essential for the protocol to function, but it speeds up collision repair.
@@ -462,6 +743,16 @@ void cy_notify_topic_hash_collision(cy_t* const cy, cy_topic_t* const topic);
 /// arriving from that ID cannot be robustly reassembled.
 void cy_notify_node_id_collision(cy_t* const cy);
 
+/// The platform layer should invoke this whenever a transport frame leaves the transmission queue,
+/// passing the time it spent in the queue, to populate the transmission latency histogram; see cy_stats().
+/// The function does not perform any IO; the time complexity is constant.
+void cy_notify_tx_latency(cy_t* const cy, const cy_us_t latency);
+
+/// The platform layer should invoke this when the last frame of a traced transfer has left the host, passing the
+/// token that was in cy->latency_tx_probe when the transfer was published; see there. Tokens that are unknown,
+/// e.g., because the probe was already reused for a newer transfer, are ignored. The time complexity is constant.
+void cy_notify_tx_departure(cy_t* const cy, const uint32_t token, const cy_us_t ts);
+
 /// This is invoked whenever a new transfer on the topic is received.
 /// The library will dispatch it to the appropriate subscriber callbacks.
 /// Excluding the callbacks, the time complexity is constant.
@@ -471,14 +762,32 @@ void cy_notify_node_id_collision(cy_t* const cy);
 /// to ensure that the latest state updates are reflected in the next heartbeat message.
 void cy_ingest_topic_transfer(cy_t* const cy, cy_topic_t* const topic, cy_transfer_owned_t transfer);
 
+/// The transfers from the remote reliable publishers are deduplicated by Cy itself using a window of transfer-IDs per
+/// publisher. Their retransmissions reuse the transfer-ID and shall reach cy_ingest_topic_transfer() even if the
+/// transfer-ID has been seen before, because the acknowledgment that was lost is only repeated in response to them.
+/// Hence, the transport shall not drop the transfers with a repeated transfer-ID from a reliable source, e.g.,
+/// by its transfer-ID timeout; the duplicates from the other sources (such as those arriving via the redundant
+/// interfaces) should still be filtered out as usual.
+/// The first function is constant-time; the second is linear in the number of reliable sources of the topic.
+bool cy_topic_has_reliable_sources(const cy_topic_t* const topic);
+bool cy_topic_is_reliable_source(const cy_topic_t* const topic, const uint16_t node_id);
+
 /// Cy does not manage P2P endpoints explicitly; it is the responsibility of the transport-specific glue logic.
 /// Currently, the following P2P endpoints must be implemented in the glue logic:
 ///
 ///     - CY_P2P_SERVICE_ID_TOPIC_RESPONSE handler.
 ///       Delivers the optional response to a message published on a topic.
 ///       The first 8 bytes of the transfer payload are the topic hash to which the response is sent.
+///
+///     - CY_P2P_SERVICE_ID_RELIABLE_ACK handler, see cy_ingest_reliable_ack_transfer().
+///       The extent of this endpoint is CY_RELIABLE_ACK_EXTENT; duplicate transfer-IDs shall not be filtered out.
 void cy_ingest_topic_response_transfer(cy_t* const cy, cy_transfer_owned_t transfer);
 
+/// Delivers an acknowledgment of a transfer published by a reliable local publisher to the library.
+/// The time complexity is linear in the window size of the reliable publishers of the topic.
+#define CY_RELIABLE_ACK_EXTENT 25U
+void cy_ingest_reliable_ack_transfer(cy_t* const cy, cy_transfer_owned_t transfer);
+
 /// For diagnostics and logging only. Do not use in embedded and real-time applications.
 /// This function is only required if CY_CONFIG_TRACE is defined and is nonzero; otherwise it should be left undefined.
 /// Other modules that build on Cy can also use it; e.g., transport-specific glue modules.
@@ -0,0 +1,176 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// The wire format helpers and the heartbeat layout of the Cy library. This is not part of the API; it is only shared
+/// between the core and the tools that need to forge or parse the heartbeats, such as the benchmarks.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include "cy.h"
+#include <assert.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// Little-endian serialization helpers. The serializers return the pointer past the last written byte.
+static inline unsigned char* serialize_u16(unsigned char* ptr, const uint16_t value)
+{
+    *ptr++ = (unsigned char)(value & UINT8_MAX);
+    *ptr++ = (unsigned char)((value >> 8U) & UINT8_MAX);
+    return ptr;
+}
+
+static inline unsigned char* serialize_u32(unsigned char* ptr, const uint32_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * 8U)) & UINT8_MAX);
+    }
+    return ptr;
+}
+
+static inline unsigned char* serialize_u64(unsigned char* ptr, const uint64_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * 8U)) & UINT8_MAX);
+    }
+    return ptr;
+}
+
+static inline uint16_t deserialize_u16(const unsigned char* const ptr)
+{
+    return (uint16_t)(((unsigned)ptr[0]) | (((unsigned)ptr[1]) << 8U));
+}
+
+static inline uint32_t deserialize_u32(const unsigned char* const ptr)
+{
+    uint32_t out = 0;
+    for (size_t i = 0; i < sizeof(out); i++) {
+        out |= ((uint32_t)ptr[i]) << (i * 8U);
+    }
+    return out;
+}
+
+static inline uint64_t deserialize_u64(const unsigned char* const ptr)
+{
+    uint64_t out = 0;
+    for (size_t i = 0; i < sizeof(out); i++) {
+        out |= ((uint64_t)ptr[i]) << (i * 8U);
+    }
+    return out;
+}
+
+#define FLAG_PUBLISHING 1U ///< Source is actively publishing this topic.
+#define FLAG_SUBSCRIBED 2U ///< Source is subscribed to this topic.
+#define FLAG_RECEIVING  4U ///< At least one transfer was received on this topic since last gossip.
+#define FLAG_SCOUT      8U ///< Scout message requesting everyone who knows matching topics to respond.
+#define FLAG_RELIABLE   16U ///< Source publishes this topic reliably and expects acknowledgments from subscribers.
+#define FLAG_BATCHING   32U ///< Source knows of a batching publisher on this topic; see cy_publisher_batching().
+
+/// The heartbeat is a fixed header followed by one or more gossip records packed back to back.
+/// All multi-byte fields are little-endian. The header layout:
+///
+///     offset  size  field
+///     0       4     uptime, seconds
+///     4       3     user word
+///     7       1     version; the records are only present if it is 1
+///     8       8     UID
+///
+/// The gossip record layout, offsets relative to the start of the record:
+///
+///     offset  size  field
+///     0       8     topic hash
+///     8       4     topic evictions
+///     12      1     reserved
+///     13      1     floor(log2(topic age)), signed
+///     14      1     flags
+///     15      1     topic name length, zero if omitted
+///     16      *     topic name, not NUL-terminated
+///
+/// Nodes that only understand one record per heartbeat will just ignore the trailing records.
+/// A heartbeat truncated by the transport is not a problem either, because an incomplete trailing record is ignored.
+///
+/// Topic names cannot be empty, so zero length says that the name is omitted. An omitted name in a scout means
+/// that the scout is asking for the name of the topic with the specified hash instead of querying a pattern;
+/// this is used to learn the names omitted from the urgent gossips.
+#define HEARTBEAT_HEADER_SIZE     16U
+#define HEARTBEAT_OFFSET_VERSION  7U
+#define GOSSIP_HEADER_SIZE        16U
+#define GOSSIP_SIZE_MAX           (GOSSIP_HEADER_SIZE + CY_TOPIC_NAME_MAX)
+#define HEARTBEAT_SINGLE_SIZE_MAX (HEARTBEAT_HEADER_SIZE + GOSSIP_SIZE_MAX)
+
+/// We could have used Nunavut, but we only need a single message and it's very simple, so we do it manually.
+/// This is the in-memory representation of one gossip record; see gossip_serialize() and gossip_deserialize().
+typedef struct
+{
+    uint64_t topic_hash;
+    uint32_t topic_evictions;
+    uint8_t  _reserved_;    ///< May be used in the future to extend the evictions counter to 40 bits if needed.
+    int8_t   topic_log_age; ///< floor(log2(topic_age)), range [-1,63], where -1 represents floor(log2(0)).
+    uint8_t  flags;
+    uint8_t  topic_name_len;
+    char     topic_name[CY_TOPIC_NAME_MAX + 1]; ///< NUL-terminated after deserialization.
+} gossip_t;
+
+/// The user word is not used yet, so it is always zero.
+static inline void heartbeat_header_serialize(const uint32_t uptime_s, const uint64_t uid, unsigned char* const buffer)
+{
+    unsigned char* ptr = serialize_u32(buffer, uptime_s);
+    memset(ptr, 0, 3U);
+    ptr += 3U;
+    *ptr++ = 1U; // version
+    ptr    = serialize_u64(ptr, uid);
+    assert(ptr == (buffer + HEARTBEAT_HEADER_SIZE));
+    (void)ptr;
+}
+
+/// The buffer shall be at least GOSSIP_SIZE_MAX bytes large. Returns the number of bytes written.
+static inline size_t gossip_serialize(const gossip_t* const msg, unsigned char* const buffer)
+{
+    assert(msg->topic_name_len <= CY_TOPIC_NAME_MAX);
+    unsigned char* ptr = serialize_u64(buffer, msg->topic_hash);
+    ptr                = serialize_u32(ptr, msg->topic_evictions);
+    *ptr++             = msg->_reserved_;
+    *ptr++             = (unsigned char)msg->topic_log_age;
+    *ptr++             = msg->flags;
+    *ptr++             = msg->topic_name_len;
+    assert(ptr == (buffer + GOSSIP_HEADER_SIZE));
+    memcpy(ptr, msg->topic_name, msg->topic_name_len);
+    return GOSSIP_HEADER_SIZE + msg->topic_name_len;
+}
+
+/// Returns the number of bytes consumed, or zero if the record is malformed or incomplete.
+static inline size_t gossip_deserialize(const size_t size, const unsigned char* const buffer, gossip_t* const out)
+{
+    if (size < GOSSIP_HEADER_SIZE) {
+        return 0;
+    }
+    const unsigned char* ptr = buffer;
+    out->topic_hash          = deserialize_u64(ptr);
+    ptr += 8U;
+    out->topic_evictions = deserialize_u32(ptr);
+    ptr += 4U;
+    out->_reserved_     = *ptr++;
+    out->topic_log_age  = (int8_t)*ptr++;
+    out->flags          = *ptr++;
+    out->topic_name_len = *ptr++;
+    assert(ptr == (buffer + GOSSIP_HEADER_SIZE));
+    if ((out->topic_name_len > CY_TOPIC_NAME_MAX) || ((GOSSIP_HEADER_SIZE + (size_t)out->topic_name_len) > size)) {
+        return 0;
+    }
+    memcpy(out->topic_name, ptr, out->topic_name_len);
+    out->topic_name[out->topic_name_len] = '\0';
+    return GOSSIP_HEADER_SIZE + out->topic_name_len;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,293 @@
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#include "cy_bulk.h"
+#include <assert.h>
+#include <string.h>
+
+#define MEGA 1000000LL
+
+#define RESPONSE_TIMEOUT_DEFAULT_us (1 * MEGA)
+#define ATTEMPTS_DEFAULT            5U
+#define RESPONSE_TX_TIMEOUT_us      (1 * MEGA)
+
+static unsigned char* serialize_u16(unsigned char* ptr, const uint16_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * 8U)) & 0xFFU);
+    }
+    return ptr;
+}
+
+static unsigned char* serialize_u32(unsigned char* ptr, const uint32_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * 8U)) & 0xFFU);
+    }
+    return ptr;
+}
+
+static unsigned char* serialize_u64(unsigned char* ptr, const uint64_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * 8U)) & 0xFFU);
+    }
+    return ptr;
+}
+
+static uint64_t deserialize_le(const unsigned char* const ptr, const size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+        value |= ((uint64_t)ptr[i]) << (i * 8U);
+    }
+    return value;
+}
+
+// ---------------------------------------- READER ----------------------------------------
+
+/// The chunks are assigned to the slots round-robin, so the slot of a chunk is known from its offset and a chunk
+/// can only be requested once the chunk that occupied its slot before has been delivered. This makes the slots
+/// a sliding window.
+static cy_bulk_slot_t* slot_of(const cy_bulk_reader_t* const reader, const uint64_t offset)
+{
+    const uint64_t index = offset / reader->chunk_size;
+    return &reader->slots[index % reader->slot_count];
+}
+
+static cy_err_t request(cy_t* const cy, cy_bulk_reader_t* const reader, cy_bulk_slot_t* const slot)
+{
+    unsigned char  buffer[CY_BULK_REQUEST_SIZE_MAX];
+    unsigned char* ptr = serialize_u64(buffer, slot->offset);
+    ptr                = serialize_u32(ptr, reader->chunk_size);
+    ptr                = serialize_u16(ptr, reader->name_len);
+    memcpy(ptr, reader->name, reader->name_len);
+    const cy_buffer_borrowed_t payload = {
+        .next = NULL,
+        .view = { .size = CY_BULK_REQUEST_HEADER_SIZE + reader->name_len, .data = buffer },
+    };
+    cy_buffer_owned_release(cy, &slot->future.last_response.payload); // does nothing if already released
+    const cy_us_t  now = cy_now(cy);
+    const cy_err_t res = cy_publish(
+      cy, &reader->pub, now + reader->response_timeout, payload, now + reader->response_timeout, &slot->future);
+    if (res == CY_OK) {
+        slot->attempts++;
+        slot->busy = true;
+    } else {
+        slot->future.state = cy_future_response_timeout; // The future is not registered; try again next time.
+    }
+    return res;
+}
+
+/// Returns the application-specific error or one of CY_BULK_ERROR_*; zero on success.
+/// The data is delivered as-is without copying, one invocation of the callback per fragment of the response.
+static uint32_t deliver(cy_t* const cy, cy_bulk_reader_t* const reader, cy_bulk_slot_t* const slot)
+{
+    const cy_buffer_owned_t payload = slot->future.last_response.payload;
+    unsigned char           header[CY_BULK_RESPONSE_HEADER_SIZE];
+    const size_t            size = cy_buffer_owned_size(payload);
+    if ((cy_buffer_owned_gather(payload, (cy_bytes_mut_t){ .size = sizeof(header), .data = header }) <
+         sizeof(header)) ||
+        ((size - sizeof(header)) > reader->chunk_size) || (deserialize_le(&header[4], 8) != slot->offset)) {
+        return CY_BULK_ERROR_MALFORMED;
+    }
+    const uint32_t error = (uint32_t)deserialize_le(&header[0], 4);
+    if (error != 0) {
+        return error;
+    }
+    size_t skip = sizeof(header);
+    for (const cy_buffer_borrowed_t* frag = &payload.base; frag != NULL; frag = frag->next) {
+        if (frag->view.size > skip) {
+            const cy_bytes_t data = { .size = frag->view.size - skip,
+                                      .data = ((const unsigned char*)frag->view.data) + skip };
+            if (reader->callback != NULL) {
+                reader->callback(cy, reader, reader->offset_delivered, data);
+            }
+            reader->offset_delivered += data.size;
+        }
+        skip -= (frag->view.size < skip) ? frag->view.size : skip;
+    }
+    if ((size - sizeof(header)) < reader->chunk_size) {
+        reader->offset_end = reader->offset_delivered; // A short chunk marks the end of the resource.
+    }
+    return 0;
+}
+
+cy_err_t cy_bulk_reader_new(cy_t* const             cy,
+                            cy_bulk_reader_t* const reader,
+                            const wkv_str_t         topic_name,
+                            const uint32_t          chunk_size,
+                            cy_bulk_slot_t* const   slots,
+                            const size_t            slot_count)
+{
+    assert((cy != NULL) && (reader != NULL));
+    if ((chunk_size == 0) || (slots == NULL) || (slot_count == 0)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memset(reader, 0, sizeof(*reader));
+    reader->slots            = slots;
+    reader->slot_count       = slot_count;
+    reader->chunk_size       = chunk_size;
+    reader->response_timeout = RESPONSE_TIMEOUT_DEFAULT_us;
+    reader->attempts_max     = ATTEMPTS_DEFAULT;
+    reader->state            = cy_bulk_idle;
+    for (size_t i = 0; i < slot_count; i++) {
+        cy_future_new(&slots[i].future, NULL, reader);
+        slots[i].offset   = 0;
+        slots[i].attempts = 0;
+        slots[i].busy     = false;
+    }
+    return cy_advertise(cy, &reader->pub, topic_name, CY_BULK_RESPONSE_HEADER_SIZE + (size_t)chunk_size);
+}
+
+cy_err_t cy_bulk_read_start(cy_t* const                    cy,
+                            cy_bulk_reader_t* const        reader,
+                            const wkv_str_t                name,
+                            const uint64_t                 offset,
+                            const cy_bulk_chunk_callback_t callback)
+{
+    assert((cy != NULL) && (reader != NULL));
+    if ((reader->state == cy_bulk_reading) || (name.len > CY_BULK_NAME_MAX)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memcpy(reader->name, name.str, name.len);
+    reader->name_len         = (uint16_t)name.len;
+    reader->state            = cy_bulk_reading;
+    reader->error            = 0;
+    reader->offset_requested = offset;
+    reader->offset_delivered = offset;
+    reader->offset_end       = UINT64_MAX;
+    reader->callback         = callback;
+    return cy_bulk_read_update(cy, reader);
+}
+
+cy_err_t cy_bulk_read_update(cy_t* const cy, cy_bulk_reader_t* const reader)
+{
+    assert((cy != NULL) && (reader != NULL));
+    if (reader->state != cy_bulk_reading) {
+        return CY_OK;
+    }
+    cy_err_t res = CY_OK;
+
+    // Deliver the chunks in order. A completed chunk behind an outstanding one stays in its slot until its turn.
+    while (reader->error == 0) {
+        cy_bulk_slot_t* const slot = slot_of(reader, reader->offset_delivered);
+        if ((reader->offset_delivered >= reader->offset_end) || !slot->busy ||
+            (slot->offset != reader->offset_delivered) || (slot->future.state != cy_future_success)) {
+            break;
+        }
+        reader->error = deliver(cy, reader, slot);
+        cy_buffer_owned_release(cy, &slot->future.last_response.payload);
+        slot->busy = false;
+    }
+
+    // Request the chunks that were not answered in time again, and reap the slots that are no longer needed.
+    bool busy = false;
+    for (size_t i = 0; i < reader->slot_count; i++) {
+        cy_bulk_slot_t* const slot   = &reader->slots[i];
+        const bool            needed = (reader->error == 0) && (slot->offset < reader->offset_end);
+        if (!slot->busy || (slot->future.state == cy_future_pending)) {
+            busy = busy || slot->busy;
+            continue;
+        }
+        if (!needed) {
+            cy_buffer_owned_release(cy, &slot->future.last_response.payload);
+            slot->busy = false;
+        } else if (slot->future.state == cy_future_response_timeout) {
+            if (slot->attempts < reader->attempts_max) {
+                reader->retries++;
+                const cy_err_t r = request(cy, reader, slot);
+                res              = (r != CY_OK) ? r : res;
+            } else {
+                reader->error = CY_BULK_ERROR_TIMEOUT;
+                slot->busy    = false;
+            }
+        }
+        busy = busy || slot->busy;
+    }
+
+    // Fill the free slots with new requests in the order of the offsets.
+    while ((reader->error == 0) && (reader->offset_requested < reader->offset_end)) {
+        cy_bulk_slot_t* const slot = slot_of(reader, reader->offset_requested);
+        if (slot->busy) {
+            break;
+        }
+        slot->offset   = reader->offset_requested;
+        slot->attempts = 0;
+        const cy_err_t r = request(cy, reader, slot);
+        if (r != CY_OK) {
+            res = r;
+            break;
+        }
+        reader->offset_requested += reader->chunk_size;
+        busy = true;
+    }
+
+    // The read is over once the outcome is known and no requests are left pending, so the slots can be reused.
+    if (!busy && ((reader->error != 0) || (reader->offset_delivered >= reader->offset_end))) {
+        reader->state = (reader->error == 0) ? cy_bulk_done : cy_bulk_failed;
+    }
+    return res;
+}
+
+// ---------------------------------------- SERVER ----------------------------------------
+
+static void respond(cy_t* const                cy,
+                    const cy_arrival_t* const  arv,
+                    const uint64_t             offset,
+                    const uint32_t             error,
+                    const cy_buffer_borrowed_t data)
+{
+    unsigned char  header[CY_BULK_RESPONSE_HEADER_SIZE];
+    unsigned char* ptr = serialize_u32(header, error);
+    (void)serialize_u64(ptr, offset);
+    const cy_buffer_borrowed_t payload = { .next = &data, .view = { .size = sizeof(header), .data = header } };
+    (void)cy_respond(
+      cy, arv->topic, arv->transfer->timestamp + RESPONSE_TX_TIMEOUT_us, arv->transfer->metadata, payload);
+}
+
+static void on_request(cy_t* const cy, const cy_arrival_t* const arv)
+{
+    cy_bulk_server_t* const server = (cy_bulk_server_t*)arv->subscriber; // The subscriber is the first member.
+    server->requests++;
+    unsigned char  buffer[CY_BULK_REQUEST_SIZE_MAX] = { 0 };
+    const size_t   size =
+      cy_buffer_owned_gather(arv->transfer->payload, (cy_bytes_mut_t){ .size = sizeof(buffer), .data = buffer });
+    const uint64_t offset   = deserialize_le(&buffer[0], 8);
+    const size_t   chunk    = (size_t)deserialize_le(&buffer[8], 4);
+    const size_t   name_len = (size_t)deserialize_le(&buffer[12], 2);
+
+    uint32_t       error = 0;
+    cy_bytes_mut_t data  = { .size = 0, .data = ((unsigned char*)server->buffer.data) + CY_BULK_RESPONSE_HEADER_SIZE };
+    if ((size < CY_BULK_REQUEST_HEADER_SIZE) || (name_len > (size - CY_BULK_REQUEST_HEADER_SIZE))) {
+        error = CY_BULK_ERROR_MALFORMED;
+    } else if (chunk > (server->buffer.size - CY_BULK_RESPONSE_HEADER_SIZE)) {
+        error = CY_BULK_ERROR_TOO_LARGE;
+    } else {
+        data.size            = chunk;
+        const wkv_str_t name = { .len = name_len, .str = (const char*)&buffer[CY_BULK_REQUEST_HEADER_SIZE] };
+        error                = server->handler(cy, server, name, offset, &data);
+        assert(data.size <= chunk);
+    }
+    if (error != 0) {
+        server->errors++;
+        data.size = 0;
+    }
+    respond(cy, arv, offset, error, (cy_buffer_borrowed_t){ .view = { .size = data.size, .data = data.data } });
+}
+
+cy_err_t cy_bulk_server_new(cy_t* const             cy,
+                            cy_bulk_server_t* const server,
+                            const wkv_str_t         topic_name,
+                            const cy_bytes_mut_t    buffer,
+                            const cy_bulk_handler_t handler)
+{
+    assert((cy != NULL) && (server != NULL));
+    if ((handler == NULL) || (buffer.data == NULL) || (buffer.size <= CY_BULK_RESPONSE_HEADER_SIZE)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memset(server, 0, sizeof(*server));
+    server->buffer  = buffer;
+    server->handler = handler;
+    const cy_subscription_params_t params = { CY_BULK_REQUEST_SIZE_MAX, CY_TRANSFER_ID_TIMEOUT_DEFAULT_us, false };
+    return cy_subscribe_with_params(cy, &server->sub, topic_name, params, on_request);
+}
@@ -0,0 +1,163 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// Bulk reads of large named resources (files, memory regions, logs) over an ordinary topic and its responses.
+/// The reader splits the resource into fixed-size chunks and keeps up to one request per slot in flight, so the
+/// throughput is bound by the link rather than by the round-trip time. The responses may arrive in any order and are
+/// delivered to the application in the order of their offsets; a chunk that is not answered in time is requested
+/// again. A reader can be started at any offset, which is how an interrupted read is resumed.
+///
+/// The server is stateless: every request names the resource and the offset, and is answered with one chunk.
+/// The wire format (little-endian) is as follows:
+///
+///     # Request, published on the topic:
+///     uint64 offset
+///     uint32 size               # The chunk size; the response is shorter only at the end of the resource.
+///     uint16 name_len
+///     utf8   name[<=CY_BULK_NAME_MAX]
+///
+///     # Response:
+///     uint32 error              # Zero on success; either an application-specific code or CY_BULK_ERROR_*.
+///     uint64 offset             # Echoes the request.
+///     byte[] data
+///
+/// This module is transport-agnostic; it only uses the public API of Cy and does not allocate memory.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include <cy.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CY_BULK_NAME_MAX             256U
+#define CY_BULK_REQUEST_HEADER_SIZE  14U
+#define CY_BULK_REQUEST_SIZE_MAX     (CY_BULK_REQUEST_HEADER_SIZE + CY_BULK_NAME_MAX)
+#define CY_BULK_RESPONSE_HEADER_SIZE 12U
+
+/// The error codes reported by the library itself are taken from the top of the range to avoid conflicts with the
+/// application-specific codes returned by the server handler, such as errno.
+#define CY_BULK_ERROR_TIMEOUT   0xFFFFFFFFUL ///< The chunk was not answered after all attempts.
+#define CY_BULK_ERROR_MALFORMED 0xFFFFFFFEUL ///< The request or the response could not be parsed.
+#define CY_BULK_ERROR_TOO_LARGE 0xFFFFFFFDUL ///< The requested chunk size exceeds the server buffer.
+
+#ifndef __cplusplus
+typedef struct cy_bulk_slot_t   cy_bulk_slot_t;
+typedef struct cy_bulk_reader_t cy_bulk_reader_t;
+typedef struct cy_bulk_server_t cy_bulk_server_t;
+#endif
+
+typedef enum cy_bulk_state_t
+{
+    cy_bulk_idle,
+    cy_bulk_reading,
+    cy_bulk_done,
+    cy_bulk_failed,
+} cy_bulk_state_t;
+
+/// Invoked for every chunk in the order of the offsets without gaps. The data is only valid during the call.
+typedef void (*cy_bulk_chunk_callback_t)(cy_t*, cy_bulk_reader_t*, uint64_t offset, cy_bytes_t data);
+
+/// One request in flight. The completed chunks are held in their slots until all chunks before them are delivered,
+/// so the slot count bounds both the pipeline depth and the reordering distance.
+struct cy_bulk_slot_t
+{
+    cy_future_t future;
+    uint64_t    offset;
+    uint32_t    attempts;
+    bool        busy;
+};
+
+struct cy_bulk_reader_t
+{
+    cy_publisher_t pub;
+
+    cy_bulk_slot_t* slots;
+    size_t          slot_count;
+    uint32_t        chunk_size;
+
+    /// The settings may be changed by the user at any time.
+    cy_us_t  response_timeout;
+    uint32_t attempts_max;
+
+    char     name[CY_BULK_NAME_MAX];
+    uint16_t name_len;
+
+    cy_bulk_state_t state;
+    uint32_t        error;            ///< The reason of cy_bulk_failed; zero otherwise.
+    uint64_t        offset_requested; ///< The offset of the next chunk to request.
+    uint64_t        offset_delivered; ///< Everything before this offset has been delivered; resume from here.
+    uint64_t        offset_end;       ///< The size of the resource once known; UINT64_MAX until then.
+    uint64_t        retries;          ///< Chunks requested again because they were not answered in time.
+
+    cy_bulk_chunk_callback_t callback;
+    void*                    user;
+};
+
+/// The handler reads up to data->size bytes of the named resource at the offset into data->data and sets data->size
+/// to the number of bytes read, which shall be less than requested only at the end of the resource.
+/// Returns zero on success or an application-specific error code that is forwarded to the reader.
+typedef uint32_t (*cy_bulk_handler_t)(cy_t*,
+                                      cy_bulk_server_t*,
+                                      wkv_str_t             name,
+                                      uint64_t              offset,
+                                      cy_bytes_mut_t* const data);
+
+struct cy_bulk_server_t
+{
+    cy_subscriber_t sub;
+
+    /// The response is serialized here before sending, so its size bounds the chunk size the server accepts.
+    cy_bytes_mut_t    buffer;
+    cy_bulk_handler_t handler;
+
+    uint64_t requests;
+    uint64_t errors;
+
+    void* user;
+};
+
+/// Advertises the topic with the response extent sufficient for the chunk size and binds the slots to the reader.
+/// The chunk size should be chosen close to the transport limits for best throughput; a larger number of slots
+/// is needed to fill the link if the round-trip time is large. The reader does not start reading until
+/// cy_bulk_read_start() is called. The slots shall outlive the reader.
+cy_err_t cy_bulk_reader_new(cy_t* const             cy,
+                            cy_bulk_reader_t* const reader,
+                            const wkv_str_t         topic_name,
+                            const uint32_t          chunk_size,
+                            cy_bulk_slot_t* const   slots,
+                            const size_t            slot_count);
+
+/// Begins reading the named resource at the specified offset; the chunks are delivered via the callback.
+/// Returns CY_ERR_ARGUMENT if the reader is still busy, meaning that some of its requests are pending,
+/// or if the name is too long. The reader becomes idle again when the state is either done or failed.
+cy_err_t cy_bulk_read_start(cy_t* const                    cy,
+                            cy_bulk_reader_t* const        reader,
+                            const wkv_str_t                name,
+                            const uint64_t                 offset,
+                            const cy_bulk_chunk_callback_t callback);
+
+/// Shall be invoked after every iteration of the event loop while the state is cy_bulk_reading.
+/// Delivers the chunks that are ready, requests the chunks that timed out again, and fills the free slots
+/// with new requests. The time complexity is linear in the number of slots.
+/// The error is only returned if the transport failed to publish a request; the read continues regardless.
+cy_err_t cy_bulk_read_update(cy_t* const cy, cy_bulk_reader_t* const reader);
+
+/// Subscribes to the topic and serves the requests using the handler. The buffer shall outlive the server.
+cy_err_t cy_bulk_server_new(cy_t* const             cy,
+                            cy_bulk_server_t* const server,
+                            const wkv_str_t         topic_name,
+                            const cy_bytes_mut_t    buffer,
+                            const cy_bulk_handler_t handler);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,612 @@
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#include "cy_loopback.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The default Cyphal/UDP MTU, which is the Ethernet MTU minus the IPv4, UDP, and Cyphal/UDP headers.
+#define LOOPBACK_MTU_DEFAULT 1408U
+
+/// The bus memory grows geometrically starting from this many pending deliveries.
+#define LOOPBACK_HEAP_CAPACITY_MIN 256U
+
+/// A published transfer shared by all of its deliveries. Freed when the last delivery is done with it.
+typedef struct
+{
+    size_t                 refcount;
+    cy_loopback_t*         source;
+    bool                   is_p2p;
+    uint16_t               port_id; ///< The subject-ID for messages, the service-ID for P2P transfers.
+    uint16_t               destination_node_id;
+    uint64_t               topic_hash;
+    cy_transfer_metadata_t metadata; ///< The remote node-ID is that of the source.
+    size_t                 size;
+    unsigned char          data[];
+} loopback_transfer_t;
+
+/// The header of every allocation made for a node; see cy_loopback_t::blocks.
+union cy_loopback_block_t
+{
+    struct
+    {
+        cy_loopback_block_t* prev;
+        cy_loopback_block_t* next;
+    } link;
+    max_align_t _align_;
+};
+
+struct cy_loopback_delivery_t
+{
+    cy_us_t              at;
+    uint64_t             seq;
+    loopback_transfer_t* transfer;
+    cy_loopback_t*       receiver;
+};
+
+// ---------------------------------------- MISCELLANEOUS ----------------------------------------
+
+/// SplitMix64; statistically adequate for the simulation and, unlike rand(), identical on all platforms.
+static uint64_t prng_next(cy_loopback_bus_t* const bus)
+{
+    bus->prng_state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = bus->prng_state;
+    z          = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31U);
+}
+
+/// Uniformly distributed in [0, 1).
+static double prng_unit(cy_loopback_bus_t* const bus)
+{
+    return (double)(prng_next(bus) >> 11U) * 0x1.0p-53;
+}
+
+static cy_us_t pick_latency(cy_loopback_bus_t* const bus)
+{
+    const uint64_t span = (uint64_t)(bus->config.latency_max - bus->config.latency_min);
+    return bus->config.latency_min + ((span > 0) ? (cy_us_t)(prng_next(bus) % (span + 1U)) : 0);
+}
+
+/// A transfer is delivered only if all of its frames are.
+static bool is_lost(cy_loopback_bus_t* const bus, const size_t size)
+{
+    if (bus->config.loss <= 0.0) {
+        return false;
+    }
+    const size_t mtu         = bus->config.mtu;
+    const size_t frame_count = ((mtu > 0) && (size > mtu)) ? ((size + mtu - 1U) / mtu) : 1U;
+    for (size_t i = 0; i < frame_count; i++) {
+        if (prng_unit(bus) < bus->config.loss) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void block_link(cy_loopback_t* const node, cy_loopback_block_t* const block)
+{
+    block->link.prev = NULL;
+    block->link.next = node->blocks;
+    if (node->blocks != NULL) {
+        node->blocks->link.prev = block;
+    }
+    node->blocks = block;
+}
+
+static void block_unlink(cy_loopback_t* const node, cy_loopback_block_t* const block)
+{
+    if (block->link.prev != NULL) {
+        block->link.prev->link.next = block->link.next;
+    } else {
+        node->blocks = block->link.next;
+    }
+    if (block->link.next != NULL) {
+        block->link.next->link.prev = block->link.prev;
+    }
+}
+
+/// Like realloc(), but the memory is tracked per node so that it can be freed by cy_loopback_destroy().
+static void* node_realloc(cy_loopback_t* const node, void* const ptr, const size_t new_size)
+{
+    cy_loopback_block_t* const block = (ptr != NULL) ? (((cy_loopback_block_t*)ptr) - 1) : NULL;
+    if (block != NULL) {
+        block_unlink(node, block);
+    }
+    if (new_size == 0) {
+        free(block);
+        return NULL;
+    }
+    cy_loopback_block_t* const out = realloc(block, sizeof(cy_loopback_block_t) + new_size);
+    if (out == NULL) {
+        if (block != NULL) {
+            block_link(node, block); // The old block is left intact.
+        }
+        return NULL;
+    }
+    block_link(node, out);
+    return out + 1;
+}
+
+static void transfer_release(loopback_transfer_t* const tr)
+{
+    assert(tr->refcount > 0);
+    tr->refcount--;
+    if (tr->refcount == 0) {
+        free(tr);
+    }
+}
+
+// ---------------------------------------- DELIVERY HEAP ----------------------------------------
+
+static bool delivery_before(const cy_loopback_delivery_t* const a, const cy_loopback_delivery_t* const b)
+{
+    return (a->at < b->at) || ((a->at == b->at) && (a->seq < b->seq));
+}
+
+static void delivery_swap(cy_loopback_delivery_t* const a, cy_loopback_delivery_t* const b)
+{
+    const cy_loopback_delivery_t tmp = *a;
+    *a                               = *b;
+    *b                               = tmp;
+}
+
+static bool heap_push(cy_loopback_bus_t* const bus, const cy_loopback_delivery_t item)
+{
+    if (bus->heap_size >= bus->heap_capacity) {
+        const size_t cap = (bus->heap_capacity > 0) ? (bus->heap_capacity * 2U) : LOOPBACK_HEAP_CAPACITY_MIN;
+        cy_loopback_delivery_t* const heap = realloc(bus->heap, cap * sizeof(cy_loopback_delivery_t));
+        if (heap == NULL) {
+            return false;
+        }
+        bus->heap          = heap;
+        bus->heap_capacity = cap;
+    }
+    size_t i     = bus->heap_size++;
+    bus->heap[i] = item;
+    while (i > 0) {
+        const size_t parent = (i - 1U) / 2U;
+        if (!delivery_before(&bus->heap[i], &bus->heap[parent])) {
+            break;
+        }
+        delivery_swap(&bus->heap[i], &bus->heap[parent]);
+        i = parent;
+    }
+    return true;
+}
+
+static cy_loopback_delivery_t heap_pop(cy_loopback_bus_t* const bus)
+{
+    assert(bus->heap_size > 0);
+    const cy_loopback_delivery_t out = bus->heap[0];
+    bus->heap[0]                     = bus->heap[--bus->heap_size];
+    size_t i                         = 0;
+    for (;;) {
+        const size_t left     = (2U * i) + 1U;
+        const size_t right    = left + 1U;
+        size_t       smallest = i;
+        if ((left < bus->heap_size) && delivery_before(&bus->heap[left], &bus->heap[smallest])) {
+            smallest = left;
+        }
+        if ((right < bus->heap_size) && delivery_before(&bus->heap[right], &bus->heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        delivery_swap(&bus->heap[i], &bus->heap[smallest]);
+        i = smallest;
+    }
+    return out;
+}
+
+// ---------------------------------------- TRANSMISSION ----------------------------------------
+
+/// Whether the node would receive the transfer if it arrived now.
+static cy_loopback_topic_t* find_subscribed_topic(const cy_loopback_t* const node, const uint16_t subject_id)
+{
+    cy_loopback_topic_t* const topic = (cy_loopback_topic_t*)cy_topic_find_by_subject_id(&node->base, subject_id);
+    return ((topic != NULL) && topic->subscribed) ? topic : NULL;
+}
+
+static bool is_addressed_to(const cy_loopback_t* const node, const loopback_transfer_t* const tr)
+{
+    if (tr->is_p2p) {
+        return node->base.node_id == tr->destination_node_id;
+    }
+    return find_subscribed_topic(node, tr->port_id) != NULL;
+}
+
+/// Schedules the deliveries of the transfer to every node that is listening on its port, except the source.
+/// The loss is decided here once per receiver; the deliveries that are lost are not scheduled at all.
+static cy_err_t transmit(cy_loopback_t* const source, loopback_transfer_t* const tr)
+{
+    cy_loopback_bus_t* const bus = source->bus;
+    bus->stats.transfers++;
+    bus->stats.bytes += tr->size;
+    cy_err_t res = CY_OK;
+    tr->refcount = 1; // Held by this function until all deliveries are scheduled.
+    for (cy_loopback_t* node = bus->node_head; node != NULL; node = node->next) {
+        if ((node == source) || !is_addressed_to(node, tr)) {
+            continue;
+        }
+        if (is_lost(bus, tr->size)) {
+            bus->stats.losses++;
+            continue;
+        }
+        const cy_loopback_delivery_t item = {
+            .at = bus->now + pick_latency(bus), .seq = bus->delivery_seq++, .transfer = tr, .receiver = node
+        };
+        if (heap_push(bus, item)) {
+            tr->refcount++;
+        } else {
+            bus->stats.oom++;
+            res = CY_ERR_MEMORY;
+        }
+    }
+    transfer_release(tr);
+    return res;
+}
+
+static loopback_transfer_t* transfer_new(cy_loopback_t* const         source,
+                                         const cy_transfer_metadata_t metadata,
+                                         const cy_buffer_borrowed_t   payload)
+{
+    const size_t               size = cy_buffer_borrowed_size(payload);
+    loopback_transfer_t* const tr   = malloc(sizeof(loopback_transfer_t) + size);
+    if (tr != NULL) {
+        memset(tr, 0, sizeof(loopback_transfer_t));
+        tr->source                  = source;
+        tr->metadata                = metadata;
+        tr->metadata.remote_node_id = source->base.node_id;
+        tr->size = cy_buffer_borrowed_gather(payload, (cy_bytes_mut_t){ .size = size, .data = tr->data });
+    } else {
+        source->bus->stats.oom++;
+    }
+    return tr;
+}
+
+// ---------------------------------------- RECEPTION ----------------------------------------
+
+/// The receiving node gets its own copy of the payload because Cy takes the ownership of it.
+static void deliver(cy_loopback_bus_t* const bus, const cy_loopback_delivery_t item)
+{
+    cy_loopback_t* const             node = item.receiver;
+    const loopback_transfer_t* const tr   = item.transfer;
+
+    // The transport checks the node-ID collisions at the frame level, so this is done before any filtering.
+    if ((tr->metadata.remote_node_id <= bus->config.node_id_max) &&
+        (tr->metadata.remote_node_id == node->base.node_id)) {
+        cy_notify_node_id_collision(&node->base);
+    }
+    // The receiver may have moved the topic or changed its node-ID while the transfer was in flight.
+    if (!is_addressed_to(node, tr) || (tr->is_p2p && (tr->port_id != CY_P2P_SERVICE_ID_TOPIC_RESPONSE) &&
+                                       (tr->port_id != CY_P2P_SERVICE_ID_RELIABLE_ACK))) {
+        return;
+    }
+    cy_loopback_topic_t* const topic = tr->is_p2p ? NULL : find_subscribed_topic(node, tr->port_id);
+    if ((topic != NULL) && bus->config.topic_hash_check && (topic->base.hash != tr->topic_hash)) {
+        cy_notify_topic_hash_collision(&node->base, &topic->base);
+        return;
+    }
+    void* const data = node_realloc(node, NULL, (tr->size > 0) ? tr->size : 1U);
+    if (data == NULL) {
+        bus->stats.oom++;
+        return;
+    }
+    if (tr->size > 0) {
+        memcpy(data, tr->data, tr->size);
+    }
+    bus->stats.deliveries++;
+    const cy_transfer_owned_t transfer = {
+        .timestamp = bus->now,
+        .metadata  = tr->metadata,
+        .payload   = { .base = { .next = NULL, .view = { .size = tr->size, .data = data } },
+                       .origin = { .size = tr->size, .data = data } },
+    };
+    if (topic != NULL) {
+        cy_ingest_topic_transfer(&node->base, &topic->base, transfer);
+    } else if (tr->port_id == CY_P2P_SERVICE_ID_RELIABLE_ACK) {
+        cy_ingest_reliable_ack_transfer(&node->base, transfer);
+    } else {
+        cy_ingest_topic_response_transfer(&node->base, transfer);
+    }
+}
+
+// ---------------------------------------- PLATFORM INTERFACE ----------------------------------------
+
+static cy_us_t platform_now(const cy_t* const cy)
+{
+    return ((const cy_loopback_t*)cy)->bus->now;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void* platform_realloc(cy_t* const cy, void* const ptr, const size_t new_size)
+{
+    return node_realloc((cy_loopback_t*)cy, ptr, new_size);
+}
+
+static uint64_t platform_prng(const cy_t* const cy)
+{
+    return prng_next(((const cy_loopback_t*)cy)->bus);
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void platform_buffer_release(cy_t* const cy, const cy_buffer_owned_t buf)
+{
+    assert(buf.base.next == NULL); // The deliveries are always single-fragment.
+    (void)node_realloc((cy_loopback_t*)cy, buf.origin.data, 0);
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static cy_err_t platform_node_id_set(cy_t* const cy)
+{
+    (void)cy;
+    return CY_OK; // The source node-ID is sampled at the time of publication, so there is nothing to reconfigure.
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void platform_node_id_clear(cy_t* const cy)
+{
+    (void)cy; // The transfers already in flight remain there, just like the frames already on the wire.
+}
+
+static cy_bloom64_t* platform_node_id_bloom(cy_t* const cy)
+{
+    return &((cy_loopback_t*)cy)->node_id_bloom;
+}
+
+static cy_err_t platform_p2p(cy_t* const                  cy,
+                             const uint16_t               service_id,
+                             const cy_transfer_metadata_t metadata,
+                             const cy_us_t                tx_deadline,
+                             const cy_buffer_borrowed_t   payload)
+{
+    (void)tx_deadline; // The bus has no queues, so the transfers never expire.
+    cy_loopback_t* const node = (cy_loopback_t*)cy;
+    if ((cy->node_id > node->bus->config.node_id_max) || (metadata.remote_node_id > node->bus->config.node_id_max)) {
+        return CY_ERR_ARGUMENT; // Anonymous nodes cannot engage in P2P exchanges.
+    }
+    loopback_transfer_t* const tr = transfer_new(node, metadata, payload);
+    if (tr == NULL) {
+        return CY_ERR_MEMORY;
+    }
+    tr->is_p2p              = true;
+    tr->port_id             = service_id;
+    tr->destination_node_id = metadata.remote_node_id;
+    return transmit(node, tr);
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static cy_topic_t* platform_topic_new(cy_t* const cy)
+{
+    cy_loopback_topic_t* const topic = node_realloc((cy_loopback_t*)cy, NULL, sizeof(cy_loopback_topic_t));
+    if (topic != NULL) {
+        memset(topic, 0, sizeof(cy_loopback_topic_t));
+    }
+    return (cy_topic_t*)topic;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void platform_topic_destroy(cy_t* const cy, cy_topic_t* const topic)
+{
+    (void)node_realloc((cy_loopback_t*)cy, topic, 0);
+}
+
+static cy_err_t platform_topic_publish(cy_t* const                cy,
+                                       cy_publisher_t* const      pub,
+                                       const cy_us_t              tx_deadline,
+                                       const uint64_t             transfer_id,
+                                       const cy_buffer_borrowed_t payload)
+{
+    (void)tx_deadline;
+    cy_loopback_t* const         node = (cy_loopback_t*)cy;
+    const cy_transfer_metadata_t meta = { .priority       = pub->priority,
+                                          .remote_node_id = CY_NODE_ID_INVALID,
+                                          .transfer_id    = transfer_id };
+    loopback_transfer_t* const   tr   = transfer_new(node, meta, payload);
+    if (tr == NULL) {
+        return CY_ERR_MEMORY;
+    }
+    tr->port_id             = cy_topic_subject_id(pub->topic);
+    tr->destination_node_id = CY_NODE_ID_INVALID;
+    tr->topic_hash          = pub->topic->hash;
+    if (pub == &cy->heartbeat_pub) {
+        node->bus->stats.heartbeat_transfers++;
+        node->bus->stats.heartbeat_bytes += tr->size;
+    }
+    const cy_err_t res = transmit(node, tr);
+    if (res == CY_OK) { // There is no transmission queue, so the transfer leaves the node immediately.
+        cy_notify_tx_departure(cy, cy->latency_tx_probe, node->bus->now);
+    }
+    return res;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static cy_err_t platform_topic_subscribe(cy_t* const                    cy,
+                                         cy_topic_t* const              cy_topic,
+                                         const cy_subscription_params_t params)
+{
+    (void)cy;
+    (void)params;
+    ((cy_loopback_topic_t*)cy_topic)->subscribed = true;
+    return CY_OK;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void platform_topic_unsubscribe(cy_t* const cy, cy_topic_t* const cy_topic)
+{
+    (void)cy;
+    ((cy_loopback_topic_t*)cy_topic)->subscribed = false;
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void platform_topic_advertise(cy_t* const       cy,
+                                     cy_topic_t* const cy_topic,
+                                     const size_t      response_extent_with_overhead)
+{
+    (void)cy;
+    (void)cy_topic;
+    (void)response_extent_with_overhead; // The deliveries are never truncated.
+}
+
+static void platform_topic_on_subscription_error(cy_t* const cy, cy_topic_t* const cy_topic, const cy_err_t error)
+{
+    ((cy_loopback_t*)cy)->bus->stats.subscription_errors++;
+    CY_TRACE(cy, "⚠️ Subscription error on topic '%s': %d", (cy_topic != NULL) ? cy_topic->name : "", error);
+}
+
+static const cy_platform_t g_platform_template = {
+    .now            = platform_now,
+    .realloc        = platform_realloc,
+    .prng           = platform_prng,
+    .buffer_release = platform_buffer_release,
+
+    .node_id_set   = platform_node_id_set,
+    .node_id_clear = platform_node_id_clear,
+    .node_id_bloom = platform_node_id_bloom,
+
+    .p2p = platform_p2p,
+
+    .topic_new                   = platform_topic_new,
+    .topic_destroy               = platform_topic_destroy,
+    .topic_publish               = platform_topic_publish,
+    .topic_subscribe             = platform_topic_subscribe,
+    .topic_unsubscribe           = platform_topic_unsubscribe,
+    .topic_advertise             = platform_topic_advertise,
+    .topic_on_subscription_error = platform_topic_on_subscription_error,
+
+    .node_id_max      = 0, // Set per bus.
+    .transfer_id_mask = UINT64_MAX,
+};
+
+// ---------------------------------------- PUBLIC API ----------------------------------------
+
+cy_loopback_bus_config_t cy_loopback_bus_config_default(void)
+{
+    return (cy_loopback_bus_config_t){
+        .seed             = 0,
+        .latency_min      = 100,
+        .latency_max      = 1000,
+        .loss             = 0.0,
+        .mtu              = LOOPBACK_MTU_DEFAULT,
+        .node_id_max      = 65534U,
+        .topic_hash_check = false,
+        .update_period    = 1000,
+    };
+}
+
+cy_err_t cy_loopback_bus_new(cy_loopback_bus_t* const bus, const cy_loopback_bus_config_t config)
+{
+    if ((bus == NULL) || (config.latency_min < 0) || (config.latency_max < config.latency_min) ||
+        !((config.loss >= 0.0) && (config.loss <= 1.0)) || (config.update_period <= 0) ||
+        (config.node_id_max >= CY_NODE_ID_INVALID)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memset(bus, 0, sizeof(*bus));
+    bus->config               = config;
+    bus->platform             = g_platform_template;
+    bus->platform.node_id_max = config.node_id_max;
+    bus->prng_state           = config.seed;
+    return CY_OK;
+}
+
+void cy_loopback_bus_destroy(cy_loopback_bus_t* const bus)
+{
+    if (bus != NULL) {
+        for (size_t i = 0; i < bus->heap_size; i++) {
+            transfer_release(bus->heap[i].transfer);
+        }
+        free(bus->heap);
+        bus->heap          = NULL;
+        bus->heap_size     = 0;
+        bus->heap_capacity = 0;
+    }
+}
+
+cy_err_t cy_loopback_new(cy_loopback_t* const     node,
+                         cy_loopback_bus_t* const bus,
+                         const uint64_t           uid,
+                         const uint16_t           node_id,
+                         const wkv_str_t          namespace_)
+{
+    if ((node == NULL) || (bus == NULL)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memset(node, 0, sizeof(*node));
+    node->bus                    = bus;
+    node->node_id_bloom.storage  = node->node_id_bloom_storage;
+    node->node_id_bloom.n_bits   = (sizeof(node->node_id_bloom_storage) * CHAR_BIT) / CY_BLOOM64_GENERATIONS;
+    node->node_id_bloom.popcount = 0;
+    const cy_err_t res           = cy_new(&node->base, &bus->platform, uid, node_id, namespace_);
+    if (res == CY_OK) {
+        if (bus->config.mtu > 0) {
+            node->base.heartbeat_size_max = bus->config.mtu;
+        }
+        if (bus->node_tail != NULL) {
+            bus->node_tail->next = node;
+        } else {
+            bus->node_head = node;
+        }
+        bus->node_tail = node;
+        bus->node_count++;
+    }
+    return res;
+}
+
+void cy_loopback_destroy(cy_loopback_t* const node)
+{
+    if (node != NULL) {
+        cy_loopback_bus_t* const bus  = node->bus;
+        cy_loopback_t*           prev = NULL;
+        for (cy_loopback_t* it = bus->node_head; (it != NULL) && (it != node); it = it->next) {
+            prev = it;
+        }
+        if (prev != NULL) {
+            prev->next = node->next;
+        } else {
+            bus->node_head = node->next;
+        }
+        if (bus->node_tail == node) {
+            bus->node_tail = prev;
+        }
+        bus->node_count--;
+        while (node->blocks != NULL) {
+            cy_loopback_block_t* const block = node->blocks;
+            node->blocks                     = block->link.next;
+            free(block);
+        }
+        memset(node, 0, sizeof(*node));
+    }
+}
+
+size_t cy_loopback_bus_spin_until(cy_loopback_bus_t* const bus, const cy_us_t deadline)
+{
+    size_t count = 0;
+    for (;;) {
+        const bool    delivery_due = (bus->heap_size > 0) && (bus->heap[0].at <= bus->update_next);
+        const cy_us_t next         = delivery_due ? bus->heap[0].at : bus->update_next;
+        if (next > deadline) {
+            break;
+        }
+        assert(next >= bus->now);
+        bus->now = next;
+        if (delivery_due) {
+            const cy_loopback_delivery_t item = heap_pop(bus);
+            deliver(bus, item);
+            transfer_release(item.transfer);
+            count++;
+        } else {
+            for (cy_loopback_t* node = bus->node_head; node != NULL; node = node->next) {
+                (void)cy_update(&node->base);
+            }
+            bus->update_next += bus->config.update_period;
+        }
+    }
+    if (deadline > bus->now) {
+        bus->now = deadline;
+    }
+    return count;
+}
@@ -0,0 +1,153 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// An in-process reference platform that connects many Cy instances through a simulated broadcast bus.
+/// The time is virtual and advanced explicitly by the driver, so a simulation of a large network over minutes of
+/// network time completes as fast as the CPU allows and is exactly reproducible given the same seed.
+/// The bus models the transfer latency, frame loss, and the MTU; it is single-threaded.
+///
+/// The purpose of this module is to study the behavior of the real Cy core at scale, such as the time to convergence
+/// of the topic allocation and the node-ID assignment, and the gossip traffic. It is not meant for production use.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include <cy_platform.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CY_LOOPBACK_NODE_ID_BLOOM_64BIT_WORDS 128
+
+#ifndef __cplusplus
+typedef struct cy_loopback_bus_t      cy_loopback_bus_t;
+typedef struct cy_loopback_t          cy_loopback_t;
+typedef struct cy_loopback_topic_t    cy_loopback_topic_t;
+typedef struct cy_loopback_delivery_t cy_loopback_delivery_t;
+typedef union cy_loopback_block_t     cy_loopback_block_t;
+#endif
+
+typedef struct cy_loopback_bus_config_t
+{
+    /// Seeds the bus PRNG that drives the latency, the loss, and the Cy PRNG of every node.
+    /// Identical seeds and identical driver actions yield identical runs.
+    uint64_t seed;
+
+    /// Every transfer is delivered to every receiver independently after a latency uniformly distributed
+    /// in [latency_min, latency_max]. Hence, the transfers may be reordered if the range is not empty.
+    cy_us_t latency_min;
+    cy_us_t latency_max;
+
+    /// The probability of losing a single frame, independently per receiver. A transfer is lost if any of its
+    /// frames is lost. The value is in [0, 1].
+    double loss;
+
+    /// The transfers larger than this are split into multiple frames, which makes them more likely to be lost.
+    /// The heartbeats of the new nodes are limited to one frame. Zero means that all transfers are single-frame.
+    size_t mtu;
+
+    /// E.g., 127 models Cyphal/CAN, 65534 models Cyphal/UDP.
+    uint16_t node_id_max;
+
+    /// If set, the frames carry the topic hash like in the transports that support it, so a transfer arriving at
+    /// a topic with a different hash is dropped and reported via cy_notify_topic_hash_collision().
+    /// Otherwise, it is delivered to the wrong topic like in Cyphal/UDP, leaving the repair to the gossip.
+    bool topic_hash_check;
+
+    /// The period of cy_update() invocations on every node; see cy_update() for the recommendations.
+    cy_us_t update_period;
+} cy_loopback_bus_config_t;
+
+/// The traffic counters of the entire bus. The transfers are counted once at publication regardless of the
+/// number of receivers, while the deliveries are counted per receiver.
+typedef struct cy_loopback_bus_stats_t
+{
+    uint64_t transfers;
+    uint64_t bytes;
+    uint64_t heartbeat_transfers;
+    uint64_t heartbeat_bytes;
+    uint64_t deliveries;
+    uint64_t losses;
+    uint64_t oom;
+    uint64_t subscription_errors;
+} cy_loopback_bus_stats_t;
+
+struct cy_loopback_bus_t
+{
+    cy_loopback_bus_config_t config;
+    cy_platform_t            platform; ///< Per bus rather than static because node_id_max is configurable.
+
+    cy_us_t  now;
+    cy_us_t  update_next;
+    uint64_t prng_state;
+    uint64_t delivery_seq; ///< Orders the deliveries due at the same time in the order of publication.
+
+    /// A binary min-heap of the pending deliveries ordered by the arrival time.
+    cy_loopback_delivery_t* heap;
+    size_t                  heap_size;
+    size_t                  heap_capacity;
+
+    /// The nodes in the order of creation.
+    cy_loopback_t* node_head;
+    cy_loopback_t* node_tail;
+    size_t         node_count;
+
+    cy_loopback_bus_stats_t stats;
+};
+
+struct cy_loopback_t
+{
+    cy_t               base;
+    cy_loopback_bus_t* bus;
+    cy_loopback_t*     next;
+
+    uint64_t     node_id_bloom_storage[CY_LOOPBACK_NODE_ID_BLOOM_64BIT_WORDS * CY_BLOOM64_GENERATIONS];
+    cy_bloom64_t node_id_bloom;
+
+    /// Every allocation made for the node is listed here, so that cy_loopback_destroy() can free all of them at once,
+    /// because the core does not implement cy_destroy() yet.
+    cy_loopback_block_t* blocks;
+};
+
+struct cy_loopback_topic_t
+{
+    cy_topic_t base;
+    bool       subscribed; ///< Whether the simulated transport delivers the transfers on this topic to this node.
+};
+
+/// The default configuration is a lossless UDP-like network with the default Cyphal/UDP MTU and a small jitter.
+cy_loopback_bus_config_t cy_loopback_bus_config_default(void);
+
+/// The bus does not allocate memory until the first transfer is published.
+cy_err_t cy_loopback_bus_new(cy_loopback_bus_t* const bus, const cy_loopback_bus_config_t config);
+
+/// Drops the pending deliveries and frees the memory held by the bus. The nodes are not affected.
+void cy_loopback_bus_destroy(cy_loopback_bus_t* const bus);
+
+/// Adds a new node to the bus. The node-ID may be set to CY_NODE_ID_INVALID to use the automatic allocation.
+/// The node is updated by the bus from cy_loopback_bus_spin_until() onwards.
+cy_err_t cy_loopback_new(cy_loopback_t* const     node,
+                         cy_loopback_bus_t* const bus,
+                         const uint64_t           uid,
+                         const uint16_t           node_id,
+                         const wkv_str_t          namespace_);
+
+/// Removes the node from the bus and frees all memory held by it and by its Cy instance, which shall not be used
+/// afterward. There shall be no pending deliveries to or from the node, so the bus is to be destroyed first.
+void cy_loopback_destroy(cy_loopback_t* const node);
+
+/// Advances the virtual time up to the deadline. The pending transfers are delivered in the order of their arrival
+/// time, and cy_update() is invoked on every node every update period; a delivery precedes an update due at the
+/// same time. Returns the number of deliveries performed.
+size_t cy_loopback_bus_spin_until(cy_loopback_bus_t* const bus, const cy_us_t deadline);
+
+#ifdef __cplusplus
+}
+#endif
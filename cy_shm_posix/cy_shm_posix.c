@@ -0,0 +1,981 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+/// Enable the futex system call on GNU/Linux. Unlike the other feature macros, this one must precede all includes.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#endif
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#endif
+
+#include "cy_shm_posix.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#define HAS_FUTEX 1
+#else
+#define HAS_FUTEX 0
+#endif
+
+#define KILO 1000LL
+#define MEGA 1000000LL
+
+/// The shared state is laid out such that the data written by different processes does not share cache lines.
+#define CACHE_LINE_SIZE 64U
+
+/// Identifies the segment format; bump the version when the layout changes.
+#define SEG_MAGIC 0x43595F53484D0002ULL
+
+#define BLOCK_NIL UINT32_MAX
+
+/// How long a joining participant waits for the creator of the segment to finish its initialization.
+#define SEG_INIT_TIMEOUT_us (1 * MEGA)
+
+/// The sleep quantum used where a futex is unavailable.
+#define POLL_PERIOD_us (1 * KILO)
+
+#define SUBJECT_WORD_COUNT (CY_TOTAL_SUBJECT_COUNT / 64U)
+
+static_assert((CY_SHM_POSIX_INBOX_CAPACITY & (CY_SHM_POSIX_INBOX_CAPACITY - 1)) == 0, "Must be a power of two");
+static_assert(CY_SHM_POSIX_INBOX_CAPACITY < (1UL << 31U), "The inbox sequence arithmetic requires this");
+static_assert((CY_SHM_POSIX_BLOCK_COUNT > 0) && (CY_SHM_POSIX_BLOCK_COUNT < BLOCK_NIL), "Invalid block count");
+static_assert(CY_SHM_POSIX_BLOCK_SIZE > 0, "Invalid block size");
+static_assert(CY_SHM_POSIX_PARTICIPANT_COUNT_MAX <= 64, "The holder mask of a block chain has one bit per slot");
+// The atomics are shared between processes, which is only well-defined if they are lock-free.
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Lock-free 32-bit atomics are required");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Lock-free 64-bit atomics are required");
+
+typedef enum
+{
+    slot_free = 0,
+    slot_active,
+} slot_state_t;
+
+/// The header of one payload block. The first block of a chain holds the reference count of the entire chain.
+/// A reference is either held by a participant, or it sits in an inbox cell that has not been taken yet.
+/// The former are also recorded in the holder mask (one bit per participant slot), so that the references held
+/// by a dead process can be found and released when its slot is reclaimed; the latter are released by draining
+/// the inbox. The holder mask is zero in all other blocks.
+typedef struct
+{
+    _Atomic uint32_t next_free;
+    _Atomic uint32_t refcount;
+    uint32_t         next; ///< The next block of the same transfer, BLOCK_NIL in the last one.
+    uint32_t         size; ///< The number of payload bytes in this block.
+    _Atomic uint64_t holders;
+} seg_block_t;
+
+/// One inbox entry. The sequence number tells the producers and the consumer whose turn it is to use the cell,
+/// per the well-known bounded queue algorithm by D. Vyukov.
+typedef struct
+{
+    _Atomic uint32_t seq;
+    uint32_t         first_block;
+    uint32_t         size;
+    uint16_t         port_id; ///< The subject-ID for messages, the service-ID for P2P transfers.
+    uint8_t          is_p2p;
+    uint8_t          priority;
+    uint16_t         source_node_id;
+    uint64_t         transfer_id;
+    uint64_t         topic_hash; ///< Zero for P2P transfers.
+} seg_cell_t;
+
+typedef struct
+{
+    alignas(CACHE_LINE_SIZE) _Atomic uint32_t state;
+    _Atomic int32_t  pid;
+    _Atomic uint32_t node_id;
+
+    /// The futex word incremented by the producers after every post; the consumer sleeps on it.
+    alignas(CACHE_LINE_SIZE) _Atomic uint32_t doorbell;
+    _Atomic uint32_t sleeping;
+
+    alignas(CACHE_LINE_SIZE) _Atomic uint32_t inbox_tail; ///< Claimed by the producers.
+    alignas(CACHE_LINE_SIZE) _Atomic uint32_t inbox_head; ///< Advanced by the consumer only.
+
+    alignas(CACHE_LINE_SIZE) _Atomic uint64_t subjects[SUBJECT_WORD_COUNT];
+    seg_cell_t inbox[CY_SHM_POSIX_INBOX_CAPACITY];
+} seg_participant_t;
+
+struct cy_shm_posix_seg_t
+{
+    _Atomic uint64_t magic; ///< Stored last by the creator of the segment.
+    uint32_t         participant_count;
+    uint32_t         inbox_capacity;
+    uint32_t         block_size;
+    uint32_t         block_count;
+
+    /// The pid of the process that holds the lock or zero. Only used for joining and reclamation.
+    alignas(CACHE_LINE_SIZE) _Atomic int32_t join_lock;
+
+    /// The top of the free block stack: the index in the lower half, the ABA tag in the upper half.
+    alignas(CACHE_LINE_SIZE) _Atomic uint64_t free_top;
+    _Atomic uint32_t blocks_free;
+
+    seg_participant_t participants[CY_SHM_POSIX_PARTICIPANT_COUNT_MAX];
+    seg_block_t       blocks[CY_SHM_POSIX_BLOCK_COUNT];
+    alignas(CACHE_LINE_SIZE) unsigned char data[CY_SHM_POSIX_BLOCK_COUNT][CY_SHM_POSIX_BLOCK_SIZE];
+};
+
+typedef struct cy_shm_posix_seg_t seg_t;
+
+static int64_t min_i64(const int64_t a, const int64_t b)
+{
+    return (a < b) ? a : b;
+}
+
+static bool is_process_alive(const int32_t pid)
+{
+    return (pid > 0) && ((kill((pid_t)pid, 0) == 0) || (errno == EPERM));
+}
+
+static void sleep_us(const cy_us_t duration)
+{
+    const struct timespec ts = { .tv_sec = (time_t)(duration / MEGA), .tv_nsec = (long)((duration % MEGA) * KILO) };
+    (void)nanosleep(&ts, NULL);
+}
+
+// ---------------------------------------- BLOCK POOL ----------------------------------------
+
+static uint32_t block_pop(seg_t* const seg)
+{
+    uint64_t top = atomic_load_explicit(&seg->free_top, memory_order_acquire);
+    for (;;) {
+        const uint32_t index = (uint32_t)(top & UINT32_MAX);
+        if (index == BLOCK_NIL) {
+            return BLOCK_NIL;
+        }
+        // The next link may be stale if another process pops concurrently; the tag makes the CAS fail then.
+        const uint32_t next = atomic_load_explicit(&seg->blocks[index].next_free, memory_order_relaxed);
+        const uint64_t tag  = (top >> 32U) + 1U;
+        if (atomic_compare_exchange_weak_explicit(
+              &seg->free_top, &top, (tag << 32U) | next, memory_order_acquire, memory_order_acquire)) {
+            atomic_fetch_sub_explicit(&seg->blocks_free, 1U, memory_order_relaxed);
+            return index;
+        }
+    }
+}
+
+static void block_push(seg_t* const seg, const uint32_t index)
+{
+    assert(index < CY_SHM_POSIX_BLOCK_COUNT);
+    uint64_t top = atomic_load_explicit(&seg->free_top, memory_order_relaxed);
+    for (;;) {
+        atomic_store_explicit(&seg->blocks[index].next_free, (uint32_t)(top & UINT32_MAX), memory_order_relaxed);
+        const uint64_t tag = (top >> 32U) + 1U;
+        if (atomic_compare_exchange_weak_explicit(
+              &seg->free_top, &top, (tag << 32U) | index, memory_order_release, memory_order_relaxed)) {
+            atomic_fetch_add_explicit(&seg->blocks_free, 1U, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+static void chain_free(seg_t* const seg, uint32_t index)
+{
+    while (index != BLOCK_NIL) {
+        const uint32_t next = seg->blocks[index].next;
+        atomic_store_explicit(&seg->blocks[index].holders, 0U, memory_order_relaxed);
+        block_push(seg, index);
+        index = next;
+    }
+}
+
+/// Returns the chain to the pool when the last holder lets go of it.
+static void chain_release(seg_t* const seg, const uint32_t first)
+{
+    assert(first < CY_SHM_POSIX_BLOCK_COUNT);
+    if (atomic_fetch_sub_explicit(&seg->blocks[first].refcount, 1U, memory_order_acq_rel) == 1U) {
+        chain_free(seg, first);
+    }
+}
+
+/// Records that the reference taken from the inbox is now held by the participant in the specified slot.
+static void chain_hold(seg_t* const seg, const uint32_t first, const uint32_t holder)
+{
+    assert((first < CY_SHM_POSIX_BLOCK_COUNT) && (holder < CY_SHM_POSIX_PARTICIPANT_COUNT_MAX));
+    atomic_fetch_or_explicit(&seg->blocks[first].holders, 1ULL << holder, memory_order_relaxed);
+}
+
+/// Releases the reference held by the participant in the specified slot.
+static void chain_drop(seg_t* const seg, const uint32_t first, const uint32_t holder)
+{
+    assert((first < CY_SHM_POSIX_BLOCK_COUNT) && (holder < CY_SHM_POSIX_PARTICIPANT_COUNT_MAX));
+    const uint64_t bit = 1ULL << holder;
+    const uint64_t old = atomic_fetch_and_explicit(&seg->blocks[first].holders, ~bit, memory_order_relaxed);
+    assert((old & bit) != 0U);
+    (void)old;
+    chain_release(seg, first);
+}
+
+/// Copies the payload into a new chain of blocks. The chain is returned with one reference held by the caller.
+/// The reference is recorded in the holder mask as soon as the first block is taken, and every next block is linked
+/// as soon as it is taken, so the blocks of a partially built chain are not lost if the process dies meanwhile.
+static uint32_t chain_new(seg_t* const seg, const cy_buffer_borrowed_t payload, const uint32_t holder)
+{
+    const size_t size  = cy_buffer_borrowed_size(payload);
+    size_t       count = (size + CY_SHM_POSIX_BLOCK_SIZE - 1U) / CY_SHM_POSIX_BLOCK_SIZE;
+    count              = (count > 0) ? count : 1U;
+    uint32_t first     = BLOCK_NIL;
+    uint32_t last      = BLOCK_NIL;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t index = block_pop(seg);
+        if (index == BLOCK_NIL) {
+            chain_free(seg, first);
+            return BLOCK_NIL;
+        }
+        seg->blocks[index].next = BLOCK_NIL;
+        seg->blocks[index].size = 0;
+        if (last == BLOCK_NIL) {
+            first = index;
+            atomic_store_explicit(&seg->blocks[first].refcount, 1U, memory_order_relaxed);
+            atomic_store_explicit(&seg->blocks[first].holders, 1ULL << holder, memory_order_relaxed);
+        } else {
+            seg->blocks[last].next = index;
+        }
+        last = index;
+    }
+
+    // Scatter the fragments over the blocks.
+    uint32_t block = first;
+    for (const cy_buffer_borrowed_t* frag = &payload; frag != NULL; frag = frag->next) {
+        size_t offset = 0;
+        while (offset < frag->view.size) {
+            seg_block_t* const b = &seg->blocks[block];
+            if (b->size >= CY_SHM_POSIX_BLOCK_SIZE) {
+                block = b->next;
+                continue;
+            }
+            const size_t room = CY_SHM_POSIX_BLOCK_SIZE - b->size;
+            const size_t n    = ((frag->view.size - offset) < room) ? (frag->view.size - offset) : room;
+            memcpy(&seg->data[block][b->size], ((const unsigned char*)frag->view.data) + offset, n);
+            b->size += (uint32_t)n;
+            offset += n;
+        }
+    }
+    return first;
+}
+
+// ---------------------------------------- INBOX ----------------------------------------
+
+/// Multi-producer; may be invoked by any process. Returns false if the inbox is full.
+static bool inbox_post(seg_participant_t* const p, const seg_cell_t* const item)
+{
+    uint32_t pos = atomic_load_explicit(&p->inbox_tail, memory_order_relaxed);
+    for (;;) {
+        seg_cell_t* const cell = &p->inbox[pos & (CY_SHM_POSIX_INBOX_CAPACITY - 1U)];
+        const uint32_t    seq  = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        const int32_t     dif  = (int32_t)(seq - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(
+                  &p->inbox_tail, &pos, pos + 1U, memory_order_relaxed, memory_order_relaxed)) {
+                cell->first_block    = item->first_block;
+                cell->size           = item->size;
+                cell->port_id        = item->port_id;
+                cell->is_p2p         = item->is_p2p;
+                cell->priority       = item->priority;
+                cell->source_node_id = item->source_node_id;
+                cell->transfer_id    = item->transfer_id;
+                cell->topic_hash     = item->topic_hash;
+                atomic_store_explicit(&cell->seq, pos + 1U, memory_order_release);
+                return true;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&p->inbox_tail, memory_order_relaxed);
+        }
+    }
+}
+
+/// Single-consumer; invoked by the owner of the slot or by the process reclaiming it. Returns false if empty.
+static bool inbox_take(seg_participant_t* const p, seg_cell_t* const out)
+{
+    const uint32_t    pos  = atomic_load_explicit(&p->inbox_head, memory_order_relaxed);
+    seg_cell_t* const cell = &p->inbox[pos & (CY_SHM_POSIX_INBOX_CAPACITY - 1U)];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != (pos + 1U)) {
+        return false;
+    }
+    out->first_block    = cell->first_block;
+    out->size           = cell->size;
+    out->port_id        = cell->port_id;
+    out->is_p2p         = cell->is_p2p;
+    out->priority       = cell->priority;
+    out->source_node_id = cell->source_node_id;
+    out->transfer_id    = cell->transfer_id;
+    out->topic_hash     = cell->topic_hash;
+    atomic_store_explicit(&cell->seq, pos + CY_SHM_POSIX_INBOX_CAPACITY, memory_order_release);
+    atomic_store_explicit(&p->inbox_head, pos + 1U, memory_order_relaxed);
+    return true;
+}
+
+static bool inbox_is_empty(seg_participant_t* const p)
+{
+    const uint32_t    pos  = atomic_load_explicit(&p->inbox_head, memory_order_relaxed);
+    seg_cell_t* const cell = &p->inbox[pos & (CY_SHM_POSIX_INBOX_CAPACITY - 1U)];
+    return atomic_load_explicit(&cell->seq, memory_order_acquire) != (pos + 1U);
+}
+
+/// The doorbell is incremented after the post, so a consumer that read the old value before going to sleep
+/// is either woken up by the futex or does not go to sleep at all because the value differs.
+static void inbox_ring(seg_participant_t* const p)
+{
+    atomic_fetch_add(&p->doorbell, 1U);
+    if (atomic_load(&p->sleeping) != 0U) {
+#if HAS_FUTEX
+        (void)syscall(SYS_futex, (void*)&p->doorbell, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+    }
+}
+
+/// Blocks until the deadline or until the inbox is rung, whichever is sooner; may return early.
+/// The submissions from other threads ring the inbox as well, so they are checked after the doorbell is read.
+static void inbox_wait(seg_participant_t* const p, const cy_t* const cy, const cy_us_t deadline)
+{
+    const cy_us_t now     = cy_shm_posix_now();
+    const cy_us_t timeout = deadline - min_i64(now, deadline); // The deadline may be BIG_BANG.
+    if (timeout <= 0) {
+        return;
+    }
+    atomic_store(&p->sleeping, 1U);
+    const uint32_t doorbell = atomic_load(&p->doorbell);
+    if (inbox_is_empty(p) && (atomic_load(&cy->submissions) == NULL)) {
+#if HAS_FUTEX
+        const struct timespec ts = { .tv_sec = (time_t)(timeout / MEGA), .tv_nsec = (long)((timeout % MEGA) * KILO) };
+        (void)syscall(SYS_futex, (void*)&p->doorbell, FUTEX_WAIT, doorbell, &ts, NULL, 0);
+#else
+        (void)doorbell;
+        sleep_us(min_i64(timeout, POLL_PERIOD_us));
+#endif
+    }
+    atomic_store(&p->sleeping, 0U);
+}
+
+// ---------------------------------------- PARTICIPANTS ----------------------------------------
+
+static void join_lock(seg_t* const seg)
+{
+    const int32_t self = (int32_t)getpid();
+    for (;;) {
+        int32_t holder = 0;
+        if (atomic_compare_exchange_strong(&seg->join_lock, &holder, self)) {
+            return;
+        }
+        // The holder may have crashed while holding the lock; if so, take it over.
+        if (!is_process_alive(holder) && atomic_compare_exchange_strong(&seg->join_lock, &holder, self)) {
+            return;
+        }
+        sleep_us(POLL_PERIOD_us);
+    }
+}
+
+static void join_unlock(seg_t* const seg)
+{
+    atomic_store(&seg->join_lock, 0);
+}
+
+/// Drains the inbox of a slot whose owner is no longer able to do so, releasing the held payload chains.
+static void participant_drain(seg_t* const seg, seg_participant_t* const p)
+{
+    seg_cell_t cell;
+    while (inbox_take(p, &cell)) {
+        chain_release(seg, cell.first_block);
+    }
+}
+
+/// Releases the references of the participant that were taken from its inbox or created by its publications but
+/// not released yet. Only the slot owner and the reclaimer under the join lock touch the slot's bit in the masks,
+/// and a chain cannot be freed while the bit is set, so a plain scan of the pool is sufficient.
+/// A process killed between taking a cell from its inbox and recording the reference in the mask (a few
+/// instructions) leaks that one chain; the pool recovers fully only if the segment is unlinked and recreated.
+static void participant_sweep(seg_t* const seg, const uint32_t index)
+{
+    const uint64_t bit = 1ULL << index;
+    for (uint32_t i = 0; i < CY_SHM_POSIX_BLOCK_COUNT; i++) {
+        if ((atomic_load_explicit(&seg->blocks[i].holders, memory_order_relaxed) & bit) != 0U) {
+            chain_drop(seg, i, index);
+        }
+    }
+}
+
+/// The inbox indexes are never reset because other processes may be posting into the slot concurrently.
+/// A stray transfer posted to the slot by a publisher that has not yet seen it released is simply dropped
+/// by the next owner.
+static void participant_release(seg_t* const seg, const uint32_t index)
+{
+    seg_participant_t* const p = &seg->participants[index];
+    for (size_t i = 0; i < SUBJECT_WORD_COUNT; i++) {
+        atomic_store_explicit(&p->subjects[i], 0U, memory_order_relaxed);
+    }
+    atomic_store(&p->node_id, CY_NODE_ID_INVALID);
+    participant_drain(seg, p);
+    participant_sweep(seg, index);
+    atomic_store(&p->pid, 0);
+    atomic_store(&p->state, slot_free);
+}
+
+/// Reclaims the slots of dead processes, then claims a free slot. Returns false if none is available.
+static bool participant_claim(seg_t* const seg, uint32_t* const out_index)
+{
+    bool found = false;
+    join_lock(seg);
+    for (uint32_t i = 0; i < CY_SHM_POSIX_PARTICIPANT_COUNT_MAX; i++) {
+        seg_participant_t* const p = &seg->participants[i];
+        if ((atomic_load(&p->state) == slot_active) && !is_process_alive(atomic_load(&p->pid))) {
+            participant_release(seg, i);
+        }
+    }
+    for (uint32_t i = 0; (i < CY_SHM_POSIX_PARTICIPANT_COUNT_MAX) && !found; i++) {
+        seg_participant_t* const p = &seg->participants[i];
+        if (atomic_load(&p->state) == slot_free) {
+            participant_drain(seg, p);
+            atomic_store(&p->node_id, CY_NODE_ID_INVALID);
+            atomic_store(&p->sleeping, 0U);
+            atomic_store(&p->pid, (int32_t)getpid());
+            atomic_store(&p->state, slot_active);
+            *out_index = i;
+            found      = true;
+        }
+    }
+    join_unlock(seg);
+    return found;
+}
+
+static seg_participant_t* self_participant(const cy_shm_posix_t* const cy_shm)
+{
+    return &cy_shm->seg->participants[cy_shm->self_index];
+}
+
+static void subject_set(seg_participant_t* const p, const uint16_t subject_id, const bool value)
+{
+    assert(subject_id < CY_TOTAL_SUBJECT_COUNT);
+    const uint64_t mask = 1ULL << (subject_id % 64U);
+    if (value) {
+        atomic_fetch_or_explicit(&p->subjects[subject_id / 64U], mask, memory_order_release);
+    } else {
+        atomic_fetch_and_explicit(&p->subjects[subject_id / 64U], ~mask, memory_order_release);
+    }
+}
+
+static bool subject_get(seg_participant_t* const p, const uint16_t subject_id)
+{
+    assert(subject_id < CY_TOTAL_SUBJECT_COUNT);
+    const uint64_t word = atomic_load_explicit(&p->subjects[subject_id / 64U], memory_order_acquire);
+    return ((word >> (subject_id % 64U)) & 1U) != 0U;
+}
+
+// ---------------------------------------- TRANSMISSION ----------------------------------------
+
+static bool is_addressed_to(seg_participant_t* const p, const seg_cell_t* const item, const uint16_t destination)
+{
+    if (atomic_load_explicit(&p->state, memory_order_acquire) != slot_active) {
+        return false;
+    }
+    if (item->is_p2p != 0U) {
+        return atomic_load_explicit(&p->node_id, memory_order_relaxed) == destination;
+    }
+    return subject_get(p, item->port_id);
+}
+
+/// Posts the transfer to every participant that listens on its port. The receivers get the payload by reference.
+static cy_err_t transmit(cy_shm_posix_t* const      cy_shm,
+                         seg_cell_t* const          item,
+                         const uint16_t             destination,
+                         const cy_buffer_borrowed_t payload)
+{
+    seg_t* const seg     = cy_shm->seg;
+    item->source_node_id = cy_shm->base.node_id;
+    item->size           = (uint32_t)cy_buffer_borrowed_size(payload);
+    item->first_block    = chain_new(seg, payload, cy_shm->self_index);
+    if (item->first_block == BLOCK_NIL) {
+        cy_shm->tx_oom_count++;
+        return CY_ERR_MEMORY;
+    }
+    seg_block_t* const head     = &seg->blocks[item->first_block];
+    bool               rejected = false;
+    for (uint32_t i = 0; i < CY_SHM_POSIX_PARTICIPANT_COUNT_MAX; i++) {
+        seg_participant_t* const p = &seg->participants[i];
+        if ((i == cy_shm->self_index) || !is_addressed_to(p, item, destination)) {
+            continue;
+        }
+        // The reference is taken before the post because the receiver may release it immediately.
+        atomic_fetch_add_explicit(&head->refcount, 1U, memory_order_relaxed);
+        if (inbox_post(p, item)) {
+            inbox_ring(p);
+        } else {
+            atomic_fetch_sub_explicit(&head->refcount, 1U, memory_order_relaxed); // Ours is still held.
+            rejected = true;
+        }
+    }
+    chain_drop(seg, item->first_block, cy_shm->self_index);
+    if (rejected) {
+        cy_shm->tx_rejected_count++;
+    }
+    return rejected ? CY_ERR_CAPACITY : CY_OK; // Some receivers may have accepted the transfer even if others did not.
+}
+
+// ---------------------------------------- RECEPTION ----------------------------------------
+
+/// The fragments point directly into the shared blocks. The head fragment is returned by value; the rest are
+/// allocated locally and freed together with the blocks when the payload is released.
+static bool make_payload(cy_shm_posix_t* const cy_shm, const seg_cell_t* const cell, cy_buffer_owned_t* const out)
+{
+    seg_t* const seg   = cy_shm->seg;
+    size_t       count = 0;
+    for (uint32_t b = cell->first_block; b != BLOCK_NIL; b = seg->blocks[b].next) {
+        count++;
+    }
+    assert(count > 0);
+    cy_buffer_borrowed_t* const rest =
+      (count > 1) ? (cy_buffer_borrowed_t*)malloc((count - 1U) * sizeof(cy_buffer_borrowed_t)) : NULL;
+    if ((count > 1) && (rest == NULL)) {
+        return false;
+    }
+    const uint32_t first = cell->first_block;
+    out->base.view       = (cy_bytes_t){ .size = seg->blocks[first].size, .data = seg->data[first] };
+    out->base.next       = rest;
+    out->origin          = (cy_bytes_mut_t){ .size = cell->size, .data = &seg->blocks[first] };
+    size_t i             = 0;
+    for (uint32_t b = seg->blocks[first].next; b != BLOCK_NIL; b = seg->blocks[b].next) {
+        rest[i].view = (cy_bytes_t){ .size = seg->blocks[b].size, .data = seg->data[b] };
+        rest[i].next = ((i + 2U) < count) ? &rest[i + 1U] : NULL;
+        i++;
+    }
+    return true;
+}
+
+static void ingest(cy_shm_posix_t* const cy_shm, const cy_us_t ts, const seg_cell_t* const cell)
+{
+    // Check for address collisions; another participant may be sitting at our node-ID.
+    if ((cell->source_node_id <= CY_SHM_POSIX_NODE_ID_MAX) && (cell->source_node_id == cy_shm->base.node_id)) {
+        cy_notify_node_id_collision(&cy_shm->base);
+    }
+    cy_topic_t* topic = NULL;
+    if (cell->is_p2p == 0U) {
+        topic = cy_topic_find_by_subject_id(&cy_shm->base, cell->port_id);
+        if ((topic == NULL) || !((cy_shm_posix_topic_t*)topic)->subscribed) {
+            cy_shm->rx_dropped_count++;
+            chain_drop(cy_shm->seg, cell->first_block, cy_shm->self_index);
+            return; // A stray transfer that was in flight while we were unsubscribing.
+        }
+        if (topic->hash != cell->topic_hash) {
+            cy_shm->rx_dropped_count++;
+            chain_drop(cy_shm->seg, cell->first_block, cy_shm->self_index);
+            cy_notify_topic_hash_collision(&cy_shm->base, topic);
+            return;
+        }
+    } else if ((cell->port_id != CY_P2P_SERVICE_ID_TOPIC_RESPONSE) &&
+               (cell->port_id != CY_P2P_SERVICE_ID_RELIABLE_ACK)) {
+        cy_shm->rx_dropped_count++;
+        chain_drop(cy_shm->seg, cell->first_block, cy_shm->self_index);
+        return;
+    }
+    cy_transfer_owned_t transfer = {
+        .timestamp = ts,
+        .metadata  = { .priority       = (cy_prio_t)cell->priority,
+                       .remote_node_id = cell->source_node_id,
+                       .transfer_id    = cell->transfer_id },
+    };
+    if (!make_payload(cy_shm, cell, &transfer.payload)) {
+        cy_shm->rx_oom_count++;
+        chain_drop(cy_shm->seg, cell->first_block, cy_shm->self_index);
+        return;
+    }
+    if (topic != NULL) {
+        cy_ingest_topic_transfer(&cy_shm->base, topic, transfer);
+    } else if (cell->port_id == CY_P2P_SERVICE_ID_RELIABLE_ACK) {
+        cy_ingest_reliable_ack_transfer(&cy_shm->base, transfer);
+    } else {
+        cy_ingest_topic_response_transfer(&cy_shm->base, transfer);
+    }
+}
+
+static void inbox_drain(cy_shm_posix_t* const cy_shm)
+{
+    seg_participant_t* const p  = self_participant(cy_shm);
+    const cy_us_t            ts = cy_shm_posix_now();
+    seg_cell_t               cell;
+    while (inbox_take(p, &cell)) {
+        chain_hold(cy_shm->seg, cell.first_block, cy_shm->self_index);
+        ingest(cy_shm, ts, &cell);
+    }
+}
+
+// ---------------------------------------- PLATFORM INTERFACE ----------------------------------------
+
+static cy_us_t platform_now(const cy_t* const cy)
+{
+    (void)cy;
+    return cy_shm_posix_now();
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void* platform_realloc(cy_t* const cy, void* const ptr, const size_t new_size)
+{
+    (void)cy;
+    if (new_size > 0) {
+        return realloc(ptr, new_size);
+    }
+    free(ptr);
+    return NULL;
+}
+
+static uint64_t platform_prng(const cy_t* const cy)
+{
+    (void)cy;
+    struct timespec ts;
+    const int       res = clock_gettime(CLOCK_MONOTONIC, &ts);
+    assert(res == 0);
+    (void)res;
+    return (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 32U);
+}
+
+static void platform_buffer_release(cy_t* const cy, const cy_buffer_owned_t buf)
+{
+    cy_shm_posix_t* const cy_shm = (cy_shm_posix_t*)cy;
+    const seg_block_t*    first  = (const seg_block_t*)buf.origin.data;
+    chain_drop(cy_shm->seg, (uint32_t)(first - cy_shm->seg->blocks), cy_shm->self_index);
+    free((void*)buf.base.next); // The tail fragments are allocated in one piece.
+}
+
+static cy_err_t platform_node_id_set(cy_t* const cy)
+{
+    assert(cy->node_id <= CY_SHM_POSIX_NODE_ID_MAX);
+    atomic_store(&self_participant((cy_shm_posix_t*)cy)->node_id, cy->node_id);
+    return CY_OK;
+}
+
+static void platform_node_id_clear(cy_t* const cy)
+{
+    atomic_store(&self_participant((cy_shm_posix_t*)cy)->node_id, CY_NODE_ID_INVALID);
+}
+
+static cy_bloom64_t* platform_node_id_bloom(cy_t* const cy)
+{
+    return &((cy_shm_posix_t*)cy)->node_id_bloom;
+}
+
+static cy_err_t platform_p2p(cy_t* const                  cy,
+                             const uint16_t               service_id,
+                             const cy_transfer_metadata_t metadata,
+                             const cy_us_t                tx_deadline,
+                             const cy_buffer_borrowed_t   payload)
+{
+    (void)tx_deadline; // The transfers are posted immediately, there is no queue to expire in.
+    if ((cy->node_id > CY_SHM_POSIX_NODE_ID_MAX) || (metadata.remote_node_id > CY_SHM_POSIX_NODE_ID_MAX)) {
+        return CY_ERR_ARGUMENT; // Anonymous nodes cannot engage in P2P exchanges.
+    }
+    seg_cell_t item = { .port_id     = service_id,
+                        .is_p2p      = 1U,
+                        .priority    = (uint8_t)metadata.priority,
+                        .transfer_id = metadata.transfer_id };
+    return transmit((cy_shm_posix_t*)cy, &item, metadata.remote_node_id, payload);
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static cy_topic_t* platform_topic_new(cy_t* const cy)
+{
+    (void)cy;
+    return (cy_topic_t*)calloc(1, sizeof(cy_shm_posix_topic_t));
+}
+
+static void platform_topic_destroy(cy_t* const cy, cy_topic_t* const cy_topic)
+{
+    cy_shm_posix_topic_t* const topic = (cy_shm_posix_topic_t*)cy_topic;
+    if (topic->subscribed) {
+        subject_set(self_participant((cy_shm_posix_t*)cy), topic->subscribed_subject_id, false);
+    }
+    free(topic);
+}
+
+static cy_err_t platform_topic_publish(cy_t* const                cy,
+                                       cy_publisher_t* const      pub,
+                                       const cy_us_t              tx_deadline,
+                                       const uint64_t             transfer_id,
+                                       const cy_buffer_borrowed_t payload)
+{
+    (void)tx_deadline;
+    seg_cell_t item = { .port_id     = cy_topic_subject_id(pub->topic),
+                        .is_p2p      = 0U,
+                        .priority    = (uint8_t)pub->priority,
+                        .transfer_id = transfer_id,
+                        .topic_hash  = pub->topic->hash };
+    const cy_err_t res = transmit((cy_shm_posix_t*)cy, &item, CY_NODE_ID_INVALID, payload);
+    if (res == CY_OK) { // The transfer is in the inboxes of the receivers once posted, there is no queue to leave.
+        cy_notify_tx_departure(cy, cy->latency_tx_probe, cy_shm_posix_now());
+    }
+    return res;
+}
+
+static cy_err_t platform_topic_subscribe(cy_t* const                    cy,
+                                         cy_topic_t* const              cy_topic,
+                                         const cy_subscription_params_t params)
+{
+    (void)params; // The transfers are never truncated and never reassembled, so there is nothing to configure.
+    cy_shm_posix_topic_t* const topic = (cy_shm_posix_topic_t*)cy_topic;
+    topic->subscribed_subject_id      = cy_topic_subject_id(cy_topic);
+    topic->subscribed                 = true;
+    subject_set(self_participant((cy_shm_posix_t*)cy), topic->subscribed_subject_id, true);
+    return CY_OK;
+}
+
+static void platform_topic_unsubscribe(cy_t* const cy, cy_topic_t* const cy_topic)
+{
+    cy_shm_posix_topic_t* const topic = (cy_shm_posix_topic_t*)cy_topic;
+    if (topic->subscribed) {
+        subject_set(self_participant((cy_shm_posix_t*)cy), topic->subscribed_subject_id, false);
+        topic->subscribed = false;
+    }
+}
+
+// ReSharper disable once CppParameterMayBeConstPtrOrRef
+static void platform_topic_advertise(cy_t* const       cy,
+                                     cy_topic_t* const cy_topic,
+                                     const size_t      response_extent_with_overhead)
+{
+    (void)cy;
+    (void)cy_topic;
+    (void)response_extent_with_overhead; // The responses are never truncated.
+}
+
+static void platform_topic_on_subscription_error(cy_t* const cy, cy_topic_t* const cy_topic, const cy_err_t error)
+{
+    CY_TRACE(cy, "⚠️ Subscription error on topic '%s': %d", (cy_topic != NULL) ? cy_topic->name : "", error);
+}
+
+static void platform_wake(cy_t* const cy)
+{
+    inbox_ring(self_participant((cy_shm_posix_t*)cy));
+}
+
+static const cy_platform_t g_platform = {
+    .now            = platform_now,
+    .realloc        = platform_realloc,
+    .prng           = platform_prng,
+    .buffer_release = platform_buffer_release,
+
+    .node_id_set   = platform_node_id_set,
+    .node_id_clear = platform_node_id_clear,
+    .node_id_bloom = platform_node_id_bloom,
+
+    .p2p = platform_p2p,
+
+    .topic_new                   = platform_topic_new,
+    .topic_destroy               = platform_topic_destroy,
+    .topic_publish               = platform_topic_publish,
+    .topic_subscribe             = platform_topic_subscribe,
+    .topic_unsubscribe           = platform_topic_unsubscribe,
+    .topic_advertise             = platform_topic_advertise,
+    .topic_on_subscription_error = platform_topic_on_subscription_error,
+
+    .wake = platform_wake,
+
+    .node_id_max      = CY_SHM_POSIX_NODE_ID_MAX,
+    .transfer_id_mask = UINT64_MAX,
+};
+
+// ---------------------------------------- SEGMENT ----------------------------------------
+
+static void seg_init(seg_t* const seg)
+{
+    seg->participant_count = CY_SHM_POSIX_PARTICIPANT_COUNT_MAX;
+    seg->inbox_capacity    = CY_SHM_POSIX_INBOX_CAPACITY;
+    seg->block_size        = CY_SHM_POSIX_BLOCK_SIZE;
+    seg->block_count       = CY_SHM_POSIX_BLOCK_COUNT;
+    atomic_init(&seg->join_lock, 0);
+    for (uint32_t i = 0; i < CY_SHM_POSIX_PARTICIPANT_COUNT_MAX; i++) {
+        seg_participant_t* const p = &seg->participants[i];
+        atomic_init(&p->state, slot_free);
+        atomic_init(&p->pid, 0);
+        atomic_init(&p->node_id, CY_NODE_ID_INVALID);
+        atomic_init(&p->doorbell, 0U);
+        atomic_init(&p->sleeping, 0U);
+        atomic_init(&p->inbox_tail, 0U);
+        atomic_init(&p->inbox_head, 0U);
+        for (size_t k = 0; k < SUBJECT_WORD_COUNT; k++) {
+            atomic_init(&p->subjects[k], 0U);
+        }
+        for (uint32_t k = 0; k < CY_SHM_POSIX_INBOX_CAPACITY; k++) {
+            atomic_init(&p->inbox[k].seq, k);
+        }
+    }
+    // Build the free list such that the lowest blocks are used first.
+    for (uint32_t i = 0; i < CY_SHM_POSIX_BLOCK_COUNT; i++) {
+        atomic_init(&seg->blocks[i].next_free, ((i + 1U) < CY_SHM_POSIX_BLOCK_COUNT) ? (i + 1U) : BLOCK_NIL);
+        atomic_init(&seg->blocks[i].refcount, 0U);
+        atomic_init(&seg->blocks[i].holders, 0U);
+        seg->blocks[i].next = BLOCK_NIL;
+        seg->blocks[i].size = 0;
+    }
+    atomic_init(&seg->free_top, 0U);
+    atomic_init(&seg->blocks_free, CY_SHM_POSIX_BLOCK_COUNT);
+    atomic_store_explicit(&seg->magic, SEG_MAGIC, memory_order_release);
+}
+
+static bool seg_is_compatible(const seg_t* const seg)
+{
+    return (seg->participant_count == CY_SHM_POSIX_PARTICIPANT_COUNT_MAX) &&
+           (seg->inbox_capacity == CY_SHM_POSIX_INBOX_CAPACITY) && (seg->block_size == CY_SHM_POSIX_BLOCK_SIZE) &&
+           (seg->block_count == CY_SHM_POSIX_BLOCK_COUNT);
+}
+
+/// Creates the segment if it does not exist yet, otherwise waits for its creator to finish the initialization.
+static cy_err_t seg_open(cy_shm_posix_t* const cy_shm, const char* const domain_name)
+{
+    const size_t size = sizeof(seg_t);
+    bool         init = true;
+    int          fd   = shm_open(domain_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if ((fd < 0) && (errno == EEXIST)) {
+        init = false;
+        fd   = shm_open(domain_name, O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        return CY_ERR_MEDIA;
+    }
+    if (init && (ftruncate(fd, (off_t)size) != 0)) {
+        (void)close(fd);
+        (void)shm_unlink(domain_name);
+        return CY_ERR_MEDIA;
+    }
+    // The creator may not have sized the segment yet.
+    const cy_us_t deadline = cy_shm_posix_now() + SEG_INIT_TIMEOUT_us;
+    struct stat   st       = { 0 };
+    while ((fstat(fd, &st) == 0) && (((size_t)st.st_size) < size) && (cy_shm_posix_now() < deadline)) {
+        sleep_us(POLL_PERIOD_us);
+    }
+    if (((size_t)st.st_size) != size) {
+        (void)close(fd);
+        return CY_ERR_MEDIA; // Either a different layout or a stale segment left by a crashed creator.
+    }
+    void* const mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        (void)close(fd);
+        return CY_ERR_MEDIA;
+    }
+    seg_t* const seg = (seg_t*)mem;
+    if (init) {
+        seg_init(seg);
+    }
+    while ((atomic_load_explicit(&seg->magic, memory_order_acquire) != SEG_MAGIC) &&
+           (cy_shm_posix_now() < deadline)) {
+        sleep_us(POLL_PERIOD_us);
+    }
+    if ((atomic_load_explicit(&seg->magic, memory_order_acquire) != SEG_MAGIC) || !seg_is_compatible(seg)) {
+        (void)munmap(mem, size);
+        (void)close(fd);
+        return CY_ERR_MEDIA;
+    }
+    cy_shm->shm_fd   = fd;
+    cy_shm->shm_size = size;
+    cy_shm->seg      = seg;
+    return CY_OK;
+}
+
+static void seg_close(cy_shm_posix_t* const cy_shm)
+{
+    if (cy_shm->seg != NULL) {
+        (void)munmap(cy_shm->seg, cy_shm->shm_size);
+        (void)close(cy_shm->shm_fd);
+        cy_shm->seg = NULL;
+    }
+}
+
+// ---------------------------------------- PUBLIC API ----------------------------------------
+
+cy_us_t cy_shm_posix_now(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) { // NOLINT(*-include-cleaner)
+        abort();
+    }
+    return (ts.tv_sec * MEGA) + (ts.tv_nsec / KILO);
+}
+
+cy_err_t cy_shm_posix_new(cy_shm_posix_t* const cy_shm,
+                          const uint64_t        uid,
+                          const wkv_str_t       namespace_,
+                          const char* const     domain_name,
+                          const uint16_t        node_id)
+{
+    if ((cy_shm == NULL) || (domain_name == NULL)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memset(cy_shm, 0, sizeof(*cy_shm));
+    cy_shm->shm_fd                 = -1;
+    cy_shm->node_id_bloom.storage  = cy_shm->node_id_bloom_storage;
+    cy_shm->node_id_bloom.n_bits   = (sizeof(cy_shm->node_id_bloom_storage) * CHAR_BIT) / CY_BLOOM64_GENERATIONS;
+    cy_shm->node_id_bloom.popcount = 0;
+
+    cy_err_t res = seg_open(cy_shm, domain_name);
+    if (res == CY_OK) {
+        res = participant_claim(cy_shm->seg, &cy_shm->self_index) ? CY_OK : CY_ERR_CAPACITY;
+        if (res != CY_OK) {
+            seg_close(cy_shm);
+        }
+    }
+    if (res == CY_OK) {
+        res = cy_new(&cy_shm->base, &g_platform, uid, node_id, namespace_);
+        if (res != CY_OK) {
+            participant_release(cy_shm->seg, cy_shm->self_index);
+            seg_close(cy_shm);
+        }
+    }
+    if (res == CY_OK) {
+        // There are no frames, so the heartbeat is only limited by what the receivers accept.
+        cy_shm->base.heartbeat_size_max = CY_SHM_POSIX_BLOCK_SIZE;
+    }
+    return res;
+}
+
+static cy_err_t spin_once_until(cy_shm_posix_t* const cy_shm, const cy_us_t deadline)
+{
+    inbox_wait(self_participant(cy_shm), &cy_shm->base, deadline);
+    inbox_drain(cy_shm);
+    // The update needs to be invoked after all incoming transfers are handled in this cycle, not before.
+    return cy_update(&cy_shm->base);
+}
+
+cy_err_t cy_shm_posix_spin_until(cy_shm_posix_t* const cy_shm, const cy_us_t deadline)
+{
+    cy_err_t res = CY_OK;
+    while (res == CY_OK) {
+        res = spin_once_until(cy_shm, min_i64(deadline, cy_next_deadline(&cy_shm->base)));
+        if (deadline <= cy_shm_posix_now()) {
+            break;
+        }
+    }
+    return res;
+}
+
+cy_err_t cy_shm_posix_spin_once(cy_shm_posix_t* const cy_shm)
+{
+    assert(cy_shm != NULL);
+    return spin_once_until(cy_shm, cy_next_deadline(&cy_shm->base));
+}
+
+size_t cy_shm_posix_blocks_free(const cy_shm_posix_t* const cy_shm)
+{
+    return atomic_load_explicit(&cy_shm->seg->blocks_free, memory_order_relaxed);
+}
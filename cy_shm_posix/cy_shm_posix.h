@@ -0,0 +1,144 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// Intra-host transport for the Cy nodes running in different processes on the same machine.
+/// The nodes that share the same domain name join one POSIX shared memory segment, which contains:
+///
+///     - The participant table: one slot per node holding its node-ID and the bitmap of its subscribed subject-IDs.
+///     - One bounded lock-free multi-producer single-consumer inbox of transfer descriptors per participant.
+///     - A pool of fixed-size payload blocks with a lock-free free list.
+///
+/// A publisher copies the payload once into a chain of blocks and posts a descriptor into the inbox of every
+/// participant that is subscribed to the subject; P2P transfers go to the participant holding the destination
+/// node-ID. The receivers get the payload as cy_buffer_owned_t fragments that point directly into the blocks,
+/// so no copying takes place on the receiving side regardless of the transfer size and the number of subscribers.
+/// The blocks are reference-counted and returned to the pool when the last receiver releases the payload.
+/// There is no fragmentation into frames and no transfer reassembly; the MTU is the entire pool.
+///
+/// A receiver that is blocked waiting for transfers sleeps on a futex in its slot (on GNU/Linux; elsewhere it falls
+/// back to short sleeps); the publishers wake it up only if it is actually sleeping, so no system calls are made on
+/// the hot path while the receiver keeps up.
+///
+/// The gossip, the topic allocation, and the node-ID allocation are handled by Cy as usual; this layer only moves
+/// the transfers. The shared segment is never unlinked automatically because the participants may come and go;
+/// the slots and the blocks held by the participants whose processes are gone are reclaimed when a new participant
+/// joins. All participants of a domain shall be built with the same CY_SHM_POSIX_* layout options.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include <cy_platform.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CY_SHM_POSIX_NODE_ID_BLOOM_64BIT_WORDS 128
+#define CY_SHM_POSIX_NODE_ID_MAX               65534U
+
+/// The maximum number of nodes in one domain.
+#ifndef CY_SHM_POSIX_PARTICIPANT_COUNT_MAX
+#define CY_SHM_POSIX_PARTICIPANT_COUNT_MAX 32
+#endif
+
+/// The number of transfers that can be pending in the inbox of one participant; a power of two.
+/// If a receiver does not keep up and its inbox is full, the new transfers addressed to it are dropped.
+#ifndef CY_SHM_POSIX_INBOX_CAPACITY
+#define CY_SHM_POSIX_INBOX_CAPACITY 1024
+#endif
+
+/// The payload pool geometry. A transfer occupies ceil(size/block_size) blocks (at least one) until the last
+/// receiver releases it. The defaults give a 64 MiB pool; the pages of the segment are only committed when touched.
+#ifndef CY_SHM_POSIX_BLOCK_SIZE
+#define CY_SHM_POSIX_BLOCK_SIZE 65536
+#endif
+#ifndef CY_SHM_POSIX_BLOCK_COUNT
+#define CY_SHM_POSIX_BLOCK_COUNT 1024
+#endif
+
+#ifndef __cplusplus
+typedef struct cy_shm_posix_t       cy_shm_posix_t;
+typedef struct cy_shm_posix_topic_t cy_shm_posix_topic_t;
+#endif
+
+struct cy_shm_posix_topic_t
+{
+    cy_topic_t base;
+
+    /// The subject-ID the participant bit is set for, valid while subscribed. It is stored because the subject-ID
+    /// of the topic may already be changed by the time the unsubscription is requested.
+    uint16_t subscribed_subject_id;
+    bool     subscribed;
+};
+
+struct cy_shm_posix_t
+{
+    cy_t base;
+
+    uint64_t     node_id_bloom_storage[CY_SHM_POSIX_NODE_ID_BLOOM_64BIT_WORDS * CY_BLOOM64_GENERATIONS];
+    cy_bloom64_t node_id_bloom;
+
+    /// The mapping of the shared segment. The layout is private.
+    int                        shm_fd;
+    size_t                     shm_size;
+    struct cy_shm_posix_seg_t* seg;
+    uint32_t                   self_index; ///< The index of the local slot in the participant table.
+
+    /// Transfers not delivered to some receivers because their inboxes were full.
+    uint64_t tx_rejected_count;
+    /// Transfers not sent because the payload pool was exhausted.
+    uint64_t tx_oom_count;
+    /// Transfers received but dropped because the local topic was not subscribed or its hash did not match.
+    uint64_t rx_dropped_count;
+    /// Local memory allocation failures on the receiving side; every one implies a lost transfer.
+    uint64_t rx_oom_count;
+};
+
+/// A simple helper that returns monotonic time in microseconds. The time value is always non-negative.
+/// The clock is shared by all processes on the host.
+cy_us_t cy_shm_posix_now(void);
+
+/// Joins the domain with the specified name, creating the shared segment if this is the first participant.
+/// The domain name shall begin with a slash and contain no other slashes, as required by shm_open().
+/// The namespace may be NULL or empty, in which case it defaults to "~".
+/// The local node ID should be set to CY_NODE_ID_INVALID unless manual configuration is required.
+/// Returns CY_ERR_CAPACITY if all participant slots are taken, CY_ERR_MEDIA if the segment could not be mapped
+/// or it was created with a different layout.
+cy_err_t cy_shm_posix_new(cy_shm_posix_t* const cy_shm,
+                          const uint64_t        uid,
+                          const wkv_str_t       namespace_,
+                          const char* const     domain_name,
+                          const uint16_t        node_id);
+static inline cy_err_t cy_shm_posix_new_c(cy_shm_posix_t* const cy_shm,
+                                          const uint64_t        uid,
+                                          const char* const     namespace_,
+                                          const char* const     domain_name,
+                                          const uint16_t        node_id)
+{
+    return cy_shm_posix_new(cy_shm, uid, wkv_key(namespace_), domain_name, node_id);
+}
+
+/// Keep running the event loop until the deadline is reached or until the first error.
+/// If the deadline is not in the future, the function will process pending events once and return without blocking.
+/// If the deadline is in the future and there are currently no transfers to process, the function will block until
+/// the deadline is reached or until a transfer arrives. The function may return early even if no events are available.
+/// The current monotonic time is as defined in cy_shm_posix_now().
+cy_err_t cy_shm_posix_spin_until(cy_shm_posix_t* const cy_shm, const cy_us_t deadline);
+
+/// Wait for events (blocking), process them, and return. Invoke this in a tight superloop to keep the system alive.
+/// The function returns when an event is processed or by cy_next_deadline() at the latest, so while the node is idle
+/// it may block for up to the heartbeat period. If the application has its own timers, use the spin_until variant.
+cy_err_t cy_shm_posix_spin_once(cy_shm_posix_t* const cy_shm);
+
+/// The number of free blocks in the shared payload pool; for diagnostics only, the value may be stale.
+size_t cy_shm_posix_blocks_free(const cy_shm_posix_t* const cy_shm);
+
+#ifdef __cplusplus
+}
+#endif
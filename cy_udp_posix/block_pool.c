@@ -0,0 +1,123 @@
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#include "block_pool.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/// The head word holds the index of the top free block plus one in the lower half (zero if none),
+/// and the modification counter in the upper half.
+#define HEAD_INDEX_MASK 0xFFFFFFFFULL
+#define HEAD_TAG_SHIFT  32U
+
+struct block_pool_impl_t
+{
+    unsigned char*   storage;
+    size_t           block_size;
+    size_t           block_count;
+    _Atomic uint64_t head;
+    /// The i-th entry holds the index plus one of the next free block when the i-th block is free.
+    _Atomic uint32_t next[];
+};
+
+static uint64_t make_head(const uint64_t prev, const uint32_t index_plus_one)
+{
+    return (((prev >> HEAD_TAG_SHIFT) + 1U) << HEAD_TAG_SHIFT) | index_plus_one;
+}
+
+block_pool_t block_pool_new(void)
+{
+    return (block_pool_t){ .impl = NULL };
+}
+
+bool block_pool_is_initialized(const block_pool_t* const self)
+{
+    return (self != NULL) && (self->impl != NULL);
+}
+
+int16_t block_pool_init(block_pool_t* const self, const size_t block_size, const size_t block_count)
+{
+    const size_t align = alignof(max_align_t);
+    if ((self == NULL) || (block_size == 0) || (block_count == 0) || (block_count >= UINT32_MAX) ||
+        (block_size > (SIZE_MAX / block_count) - align)) {
+        return -EINVAL;
+    }
+    struct block_pool_impl_t* const impl =
+      malloc(sizeof(struct block_pool_impl_t) + (block_count * sizeof(_Atomic uint32_t)));
+    if (impl == NULL) {
+        return -ENOMEM;
+    }
+    impl->block_size  = ((block_size + align - 1U) / align) * align;
+    impl->block_count = block_count;
+    impl->storage     = malloc(impl->block_size * block_count);
+    if (impl->storage == NULL) {
+        free(impl);
+        return -ENOMEM;
+    }
+    // Initially, the free list is ordered by address, which is friendlier to the cache.
+    for (size_t i = 0; i < block_count; i++) {
+        atomic_init(&impl->next[i], ((i + 1U) < block_count) ? (uint32_t)(i + 2U) : 0U);
+    }
+    atomic_init(&impl->head, 1U);
+    self->impl = impl;
+    return 0;
+}
+
+void* block_pool_alloc(block_pool_t* const self, const size_t size)
+{
+    if (!block_pool_is_initialized(self) || (size > self->impl->block_size)) {
+        return NULL;
+    }
+    struct block_pool_impl_t* const impl = self->impl;
+    uint64_t                        head = atomic_load_explicit(&impl->head, memory_order_acquire);
+    while (true) {
+        const uint32_t top = (uint32_t)(head & HEAD_INDEX_MASK);
+        if (top == 0) {
+            return NULL; // Exhausted.
+        }
+        // The top may be taken by another thread before we read its link; then the tag check below will fail.
+        const uint32_t next = atomic_load_explicit(&impl->next[top - 1U], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(
+              &impl->head, &head, make_head(head, next), memory_order_acquire, memory_order_acquire)) {
+            return impl->storage + ((size_t)(top - 1U) * impl->block_size);
+        }
+    }
+}
+
+void block_pool_free(block_pool_t* const self, void* const pointer)
+{
+    if ((pointer == NULL) || !block_pool_is_initialized(self)) {
+        return;
+    }
+    struct block_pool_impl_t* const impl   = self->impl;
+    const size_t                    offset = (size_t)((unsigned char*)pointer - impl->storage);
+    assert((unsigned char*)pointer >= impl->storage);
+    assert((offset % impl->block_size) == 0);
+    const size_t index = offset / impl->block_size;
+    assert(index < impl->block_count);
+    uint64_t head = atomic_load_explicit(&impl->head, memory_order_relaxed);
+    do {
+        atomic_store_explicit(&impl->next[index], (uint32_t)(head & HEAD_INDEX_MASK), memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&impl->head, //
+                                                    &head,
+                                                    make_head(head, (uint32_t)(index + 1U)),
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+size_t block_pool_block_size(const block_pool_t* const self)
+{
+    return block_pool_is_initialized(self) ? self->impl->block_size : 0U;
+}
+
+void block_pool_close(block_pool_t* const self)
+{
+    if (block_pool_is_initialized(self)) {
+        free(self->impl->storage);
+        free(self->impl);
+        self->impl = NULL;
+    }
+}
@@ -0,0 +1,64 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// A fixed-block memory pool with constant-time lock-free allocation and deallocation.
+/// The storage is allocated once at initialization; afterward, the pool never invokes the heap.
+/// A request is served if it fits into one block; larger requests fail, as do requests when the pool is exhausted.
+///
+/// The free list is a Treiber stack over block indexes with a version tag in the head word to avoid the ABA problem,
+/// so the pool can be shared between threads safely; if that is not needed, the overhead is negligible.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef __cplusplus
+typedef struct block_pool_t block_pool_t;
+#endif
+
+/// The contents are private; the implementation details are hidden to keep the atomics out of the header.
+struct block_pool_t
+{
+    struct block_pool_impl_t* impl;
+};
+
+/// Helper for constructing an uninitialized handle.
+block_pool_t block_pool_new(void);
+
+/// Return false unless the pool has been successfully initialized and not yet closed.
+bool block_pool_is_initialized(const block_pool_t* const self);
+
+/// The block size will be rounded up to the maximum fundamental alignment.
+/// The block count shall be positive and below UINT32_MAX.
+/// On error returns a negative error code.
+int16_t block_pool_init(block_pool_t* const self, const size_t block_size, const size_t block_count);
+
+/// Returns NULL if the pool is exhausted or the size exceeds the block size.
+void* block_pool_alloc(block_pool_t* const self, const size_t size);
+
+/// The pointer shall have been returned by block_pool_alloc() of the same pool. NULL pointer is ignored.
+void block_pool_free(block_pool_t* const self, void* const pointer);
+
+/// The actual block size after the alignment adjustment; zero if not initialized.
+size_t block_pool_block_size(const block_pool_t* const self);
+
+/// No effect if the argument is invalid. The outstanding blocks become invalid.
+/// This function is guaranteed to invalidate the handle.
+void block_pool_close(block_pool_t* const self);
+
+#ifdef __cplusplus
+}
+#endif
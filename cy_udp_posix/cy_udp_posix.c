@@ -7,6 +7,14 @@
 ///
 /// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
 
+/// The header includes pthread.h, so the feature macros needed for pthread_condattr_setclock() and, on GNU/Linux,
+/// for pthread_setaffinity_np() must precede it.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#elif !defined(_POSIX_C_SOURCE) && !defined(_DEFAULT_SOURCE) && !defined(_GNU_SOURCE)
+#define _POSIX_C_SOURCE 200809L // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#endif
+
 #include "cy_udp_posix.h"
 
 #ifndef __USE_POSIX199309
@@ -21,11 +29,41 @@
 #include <time.h>
 #include <errno.h>
 
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#if CY_UDP_POSIX_RX_THREADS
+#include "spsc_ring.h"
+#endif
+
 /// Maximum expected incoming datagram size. If larger jumbo frames are expected, this value should be increased.
 #ifndef CY_UDP_SOCKET_READ_BUFFER_SIZE
 #define CY_UDP_SOCKET_READ_BUFFER_SIZE 2000
 #endif
 
+/// Fill freed memory with a pattern to make use-after-free bugs manifest sooner. Costly, so only for debugging.
+#ifndef CY_UDP_POSIX_MEM_POISON
+#ifdef NDEBUG
+#define CY_UDP_POSIX_MEM_POISON 0
+#else
+#define CY_UDP_POSIX_MEM_POISON 1
+#endif
+#endif
+
+/// The maximum number of socket events processed per event loop iteration. Events that did not fit will be reported
+/// in the next iteration, so this only affects the batching efficiency, not correctness.
+#ifndef CY_UDP_POSIX_MUX_EVENT_CAPACITY
+#define CY_UDP_POSIX_MUX_EVENT_CAPACITY 64
+#endif
+
+// C++ sees the wake_pending flags as plain bools; see cy_udp_posix_t.
+static_assert((sizeof(atomic_bool) == sizeof(bool)) && (_Alignof(atomic_bool) == _Alignof(bool)),
+              "cy_udp_posix_t layout differs from C++");
+
 static int64_t min_i64(const int64_t a, const int64_t b)
 {
     return (a < b) ? a : b;
@@ -59,15 +97,16 @@ static bool is_valid_ip(const uint32_t ip)
     return (ip > 0) && (ip < UINT32_MAX);
 }
 
+/// The user reference points to the cy_udp_posix_mem_t of the memory domain.
 static void* mem_alloc(void* const user, const size_t size)
 {
-    cy_udp_posix_t* const cy_udp = (cy_udp_posix_t*)user;
-    void* const           out    = malloc(size);
+    cy_udp_posix_mem_t* const mem = (cy_udp_posix_mem_t*)user;
+    void* const out = block_pool_is_initialized(&mem->pool) ? block_pool_alloc(&mem->pool, size) : malloc(size);
     if (size > 0) {
         if (out != NULL) {
-            cy_udp->mem_allocated_fragments++;
+            mem->allocated_fragments++;
         } else {
-            cy_udp->mem_oom_count++;
+            mem->oom_count++;
         }
     }
     return out;
@@ -75,23 +114,29 @@ static void* mem_alloc(void* const user, const size_t size)
 
 static void mem_free(void* const user, const size_t size, void* const pointer)
 {
-    cy_udp_posix_t* const cy_udp = (cy_udp_posix_t*)user;
+    cy_udp_posix_mem_t* const mem = (cy_udp_posix_mem_t*)user;
     (void)size;
     if (pointer != NULL) {
-        assert(cy_udp->mem_allocated_fragments > 0);
-        cy_udp->mem_allocated_fragments--;
+        assert(mem->allocated_fragments > 0);
+        mem->allocated_fragments--;
+#if CY_UDP_POSIX_MEM_POISON
         memset(pointer, 0xA5, size); // a simple diagnostic aid
-        free(pointer);
+#endif
+        if (block_pool_is_initialized(&mem->pool)) {
+            block_pool_free(&mem->pool, pointer);
+        } else {
+            free(pointer);
+        }
     }
 }
 
 static void purge_tx(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
 {
-    struct UdpardTx* const     tx = &cy_udp->tx[iface_index].udpard_tx;
-    const struct UdpardTxItem* it = NULL;
-    while ((it = udpardTxPeek(tx))) {
-        udpardTxFree(tx->memory, udpardTxPop(tx, it));
+    for (size_t k = 0; k < cy_udp->tx[iface_index].staged_count; k++) {
+        tx_frame_release(cy_udp->tx[iface_index].staged[k], cy_udp->tx_mem);
     }
+    cy_udp->tx[iface_index].staged_count = 0;
+    tx_queue_purge(&cy_udp->tx[iface_index].queue, cy_udp->tx_mem);
 }
 
 static void rpc_listen(cy_udp_posix_t* const cy_udp)
@@ -110,6 +155,14 @@ static void rpc_listen(cy_udp_posix_t* const cy_udp)
              "🎧 RPC service_id=%04x extent=%zu",
              cy_udp->rpc_rx_port_topic_response.service_id,
              cy_udp->response_extent_with_overhead);
+    // The acknowledgments of the retransmitted transfers reuse the transfer-ID, so they shall not be deduplicated.
+    const int_fast8_t res_ack = udpardRxRPCDispatcherListen(&cy_udp->rpc_rx_dispatcher,
+                                                            &cy_udp->rpc_rx_port_reliable_ack,
+                                                            CY_P2P_SERVICE_ID_RELIABLE_ACK,
+                                                            true,
+                                                            CY_RELIABLE_ACK_EXTENT);
+    assert(res_ack >= 0);
+    cy_udp->rpc_rx_port_reliable_ack.port.transfer_id_timeout_usec = 0;
 }
 
 static void rpc_unlisten(cy_udp_posix_t* const cy_udp)
@@ -117,6 +170,9 @@ static void rpc_unlisten(cy_udp_posix_t* const cy_udp)
     const int_fast8_t res =
       udpardRxRPCDispatcherCancel(&cy_udp->rpc_rx_dispatcher, CY_P2P_SERVICE_ID_TOPIC_RESPONSE, true);
     assert(res >= 0); // infallible by design
+    const int_fast8_t res_ack =
+      udpardRxRPCDispatcherCancel(&cy_udp->rpc_rx_dispatcher, CY_P2P_SERVICE_ID_RELIABLE_ACK, true);
+    assert(res_ack >= 0);
 }
 
 static cy_err_t err_from_udpard(const int32_t e)
@@ -149,6 +205,546 @@ static cy_err_t err_from_udp_wrapper(const int16_t e)
     }
 }
 
+static struct UdpardMemoryResource mem_resource(cy_udp_posix_mem_t* const mem)
+{
+    return (struct UdpardMemoryResource){ .allocate = mem_alloc, .deallocate = mem_free, .user_reference = mem };
+}
+
+/// Zero block count leaves the domain heap-backed.
+static cy_err_t mem_pool_init(cy_udp_posix_mem_t* const mem, const size_t block_size, const size_t block_count)
+{
+    return (block_count > 0) ? err_from_udp_wrapper(block_pool_init(&mem->pool, block_size, block_count)) : CY_OK;
+}
+
+static void mem_pools_close(cy_udp_posix_t* const cy_udp)
+{
+    block_pool_close(&cy_udp->mem_tx.pool);
+    block_pool_close(&cy_udp->mem_session.pool);
+    block_pool_close(&cy_udp->mem_fragment.pool);
+    block_pool_close(&cy_udp->mem_datagram.pool);
+}
+
+/// Keep an unused RX buffer for the next read instead of freeing it.
+static void rx_spare_put(cy_udp_posix_t* const cy_udp, void* const buffer)
+{
+    if (cy_udp->rx_spare_count < CY_UDP_POSIX_RX_BATCH_SIZE) {
+        cy_udp->rx_spare[cy_udp->rx_spare_count++] = buffer;
+    } else {
+        mem_free(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE, buffer);
+    }
+}
+
+/// Fetch the source node-ID from the Cyphal/UDP frame header.
+/// TODO: the header needs to be verified (version & CRC) and it has to be done by LibUDPard; perhaps we need
+/// to expose something like bool udpardRxFrameParse(payload, out_transfer_metadata)?
+/// Alternatively, it could be an optional out-parameter of udpardRxSubscriptionReceive()?
+static uint16_t rx_frame_source_node_id(const void* const data)
+{
+    const uint8_t* const bytes = (const uint8_t*)data;
+    return (uint16_t)(bytes[2] | (((uint32_t)bytes[3]) << 8U));
+}
+
+/// The kernel arrival timestamp if available, otherwise the time the socket was read at.
+/// The kernel timestamp cannot be later than the completion of the read (ts_returned); if it appears so, the clocks
+/// were adjusted in between. Bounding it by the start of the read instead would reject the datagrams that arrived
+/// while the batch was being read.
+static cy_us_t rx_arrival_time(const int64_t kernel_timestamp, const cy_us_t ts_read, const cy_us_t ts_returned)
+{
+    return ((kernel_timestamp >= 0) && (kernel_timestamp <= ts_returned)) ? (cy_us_t)kernel_timestamp : ts_read;
+}
+
+/// The members of a hub register their sockets with the multiplexer of the hub, which runs the shared event loop.
+static udp_wrapper_mux_t* udp_mux(cy_udp_posix_t* const cy_udp)
+{
+    return (cy_udp->hub != NULL) ? &cy_udp->hub->mux : &cy_udp->mux;
+}
+
+// ----------------------------------------  RX THREADS  ----------------------------------------
+
+#if CY_UDP_POSIX_RX_THREADS
+
+/// How often an idle RX thread checks whether it is requested to stop.
+#define RX_WORKER_IDLE_TIMEOUT_us 100000
+
+/// One datagram handed over from an RX thread to the core thread. A NULL buffer reports a socket error instead.
+typedef struct
+{
+    cy_udp_posix_rx_sock_t* sock;
+    uint32_t                generation; ///< The socket generation at the time of reading.
+    uint32_t                err_no;
+    uint16_t                src_node_id; ///< Pre-parsed from the frame header by the RX thread.
+    cy_us_t                 ts;
+    size_t                  size;
+    void*                   buffer;
+} rx_item_t;
+
+typedef struct cy_udp_posix_rx_worker_t cy_udp_posix_rx_worker_t;
+
+/// The RX sockets of the iface are registered with the multiplexer of its RX thread instead of the main one.
+/// The datagram buffers are allocated and freed by the core thread only, so the memory accounting is not shared:
+/// the core keeps the vacant ring topped up, and the RX thread returns the buffers via the filled ring.
+struct cy_udp_posix_rx_worker_t
+{
+    pthread_t            thread;
+    pthread_mutex_t      lock; ///< Held by the RX thread while reading, by the core while opening/closing sockets.
+    udp_wrapper_mux_t    mux;
+    udp_wrapper_signal_t signal; ///< Raised by the RX thread to wake up the core when there is something to drain.
+    spsc_ring_t          filled; ///< RX thread to core: rx_item_t.
+    spsc_ring_t          vacant; ///< Core to RX thread: void* buffers of CY_UDP_SOCKET_READ_BUFFER_SIZE bytes.
+    bool                 lock_initialized;
+    bool                 thread_started;
+    atomic_bool          signaled; ///< Avoids redundant signal raises while the core has not drained the ring yet.
+    atomic_bool          stop;
+    _Atomic int16_t      failure; ///< The negative error code that terminated the RX thread; zero if none.
+
+    /// Maintained by the RX thread, collected by the core.
+    _Atomic uint64_t overruns;
+    _Atomic uint64_t batches;
+    _Atomic uint64_t datagrams;
+    _Atomic uint64_t saturated;
+
+    /// Accessed by the RX thread only. The spare buffers were taken from the vacant ring but not filled.
+    void*         spare[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t        spare_count;
+    unsigned char discard[CY_UDP_SOCKET_READ_BUFFER_SIZE]; ///< Sink for the datagrams that cannot be accepted.
+};
+
+static void rx_worker_notify(cy_udp_posix_rx_worker_t* const worker)
+{
+    if (!atomic_exchange_explicit(&worker->signaled, true, memory_order_acq_rel)) {
+        udp_wrapper_signal_raise(&worker->signal);
+    }
+}
+
+/// Invoked by the RX thread with the lock held, so the socket cannot be closed concurrently.
+static void rx_worker_read(cy_udp_posix_rx_worker_t* const worker, cy_udp_posix_rx_sock_t* const sock)
+{
+    void*  buffers[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t sizes[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t count = 0;
+    while (count < CY_UDP_POSIX_RX_BATCH_SIZE) {
+        void* buf = NULL;
+        if (worker->spare_count > 0) {
+            buf = worker->spare[--worker->spare_count];
+        } else if (!spsc_ring_pop(&worker->vacant, &buf)) {
+            break;
+        }
+        buffers[count] = buf;
+        sizes[count]   = CY_UDP_SOCKET_READ_BUFFER_SIZE;
+        count++;
+    }
+    if (count == 0) {
+        // The core did not supply new buffers in time. The datagram has to be consumed anyway because otherwise
+        // the socket would remain readable and this thread would spin.
+        void* const sink[1]   = { worker->discard };
+        size_t      size[1]   = { sizeof(worker->discard) };
+        const bool  discarded = udp_wrapper_rx_receive_batch(&sock->handle, 1, size, sink, NULL, NULL) > 0;
+        atomic_fetch_add_explicit(&worker->overruns, discarded ? 1U : 0U, memory_order_relaxed);
+        return;
+    }
+
+    int64_t       stamps[CY_UDP_POSIX_RX_BATCH_SIZE];
+    const cy_us_t ts        = cy_udp_posix_now(); // immediately after unblocking
+    const int16_t rx_result = udp_wrapper_rx_receive_batch(&sock->handle, count, sizes, buffers, stamps, NULL);
+    const size_t  received  = (rx_result > 0) ? (size_t)rx_result : 0U;
+    const cy_us_t ts_done   = (received > 0) ? cy_udp_posix_now() : ts;
+    assert(received <= count);
+    bool pushed = false;
+    if (rx_result < 0) { // The error is reported by the core; if the ring is full, the report is lost, that's fine.
+        const rx_item_t item = {
+            .sock = sock, .generation = sock->generation, .err_no = (uint32_t)-rx_result, .buffer = NULL
+        };
+        pushed = spsc_ring_push(&worker->filled, &item);
+    }
+    if (received > 0) {
+        atomic_fetch_add_explicit(&worker->batches, 1U, memory_order_relaxed);
+        atomic_fetch_add_explicit(&worker->datagrams, received, memory_order_relaxed);
+        atomic_fetch_add_explicit(
+          &worker->saturated, (received >= CY_UDP_POSIX_RX_BATCH_SIZE) ? 1U : 0U, memory_order_relaxed);
+    }
+    for (size_t i = 0; i < count; i++) {
+        // Zero size means that the dgram was dropped by filters (own traffic or wrong iface).
+        if ((i < received) && (sizes[i] > 0)) {
+            const rx_item_t item = { .sock        = sock,
+                                     .generation  = sock->generation,
+                                     .err_no      = 0,
+                                     .src_node_id = rx_frame_source_node_id(buffers[i]),
+                                     .ts          = rx_arrival_time(stamps[i], ts, ts_done),
+                                     .size        = sizes[i],
+                                     .buffer      = buffers[i] };
+            if (spsc_ring_push(&worker->filled, &item)) {
+                pushed = true;
+                continue;
+            }
+            atomic_fetch_add_explicit(&worker->overruns, 1U, memory_order_relaxed);
+        }
+        assert(worker->spare_count < CY_UDP_POSIX_RX_BATCH_SIZE);
+        worker->spare[worker->spare_count++] = buffers[i];
+    }
+    if (pushed) {
+        rx_worker_notify(worker);
+    }
+}
+
+static void* rx_worker_main(void* const arg)
+{
+    cy_udp_posix_rx_worker_t* const worker = (cy_udp_posix_rx_worker_t*)arg;
+    while (!atomic_load_explicit(&worker->stop, memory_order_relaxed)) {
+        udp_wrapper_mux_event_t events[CY_UDP_POSIX_MUX_EVENT_CAPACITY];
+        const int16_t           event_count =
+          udp_wrapper_mux_wait(&worker->mux, RX_WORKER_IDLE_TIMEOUT_us, CY_UDP_POSIX_MUX_EVENT_CAPACITY, events);
+        if (event_count < 0) {
+            atomic_store_explicit(&worker->failure, event_count, memory_order_relaxed);
+            rx_worker_notify(worker);
+            break;
+        }
+        (void)pthread_mutex_lock(&worker->lock);
+        for (int16_t i = 0; i < event_count; i++) {
+            cy_udp_posix_rx_sock_t* const sock = (cy_udp_posix_rx_sock_t*)events[i].user;
+            // The socket may have been closed (or even reopened) by the core since the event was reported.
+            if ((sock != NULL) && events[i].readable && udp_wrapper_rx_is_initialized(&sock->handle)) {
+                rx_worker_read(worker, sock);
+            }
+        }
+        (void)pthread_mutex_unlock(&worker->lock);
+    }
+    return NULL;
+}
+
+/// Top up the vacant ring of the RX thread with empty buffers. Invoked by the core thread only.
+static void rx_worker_refill(cy_udp_posix_t* const cy_udp, cy_udp_posix_rx_worker_t* const worker)
+{
+    const size_t capacity = spsc_ring_capacity(&worker->vacant);
+    for (size_t k = 0; k < capacity; k++) {
+        void* const buf = (cy_udp->rx_spare_count > 0)
+                            ? cy_udp->rx_spare[--cy_udp->rx_spare_count]
+                            : mem_alloc(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE);
+        if (buf == NULL) {
+            break; // Try again later; meanwhile, the RX thread will be discarding the datagrams.
+        }
+        if (!spsc_ring_push(&worker->vacant, &buf)) {
+            rx_spare_put(cy_udp, buf);
+            break;
+        }
+    }
+}
+
+/// Stops the RX thread of the iface and releases its resources, including the buffers it holds.
+/// Works with partially initialized workers; no effect if there is no worker.
+static void rx_worker_stop(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    cy_udp_posix_rx_worker_t* const worker = cy_udp->rx_worker[iface_index];
+    if (worker == NULL) {
+        return;
+    }
+    if (worker->thread_started) {
+        atomic_store_explicit(&worker->stop, true, memory_order_relaxed);
+        (void)pthread_join(worker->thread, NULL);
+    }
+    void* buf = NULL;
+    while (spsc_ring_is_initialized(&worker->vacant) && spsc_ring_pop(&worker->vacant, &buf)) {
+        mem_free(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE, buf);
+    }
+    rx_item_t item;
+    while (spsc_ring_is_initialized(&worker->filled) && spsc_ring_pop(&worker->filled, &item)) {
+        mem_free(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE, item.buffer);
+    }
+    while (worker->spare_count > 0) {
+        mem_free(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE, worker->spare[--worker->spare_count]);
+    }
+    if (udp_wrapper_signal_is_initialized(&worker->signal)) {
+        udp_wrapper_mux_signal_remove(&cy_udp->mux, &worker->signal);
+    }
+    udp_wrapper_signal_close(&worker->signal);
+    udp_wrapper_mux_close(&worker->mux);
+    spsc_ring_close(&worker->filled);
+    spsc_ring_close(&worker->vacant);
+    if (worker->lock_initialized) {
+        (void)pthread_mutex_destroy(&worker->lock);
+    }
+    mem_free(&cy_udp->mem_general, sizeof(cy_udp_posix_rx_worker_t), worker);
+    cy_udp->rx_worker[iface_index] = NULL;
+}
+
+/// Creates the RX thread of the iface. Its signal is registered with the main multiplexer to wake up the core.
+static cy_err_t rx_worker_start(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    assert(cy_udp->rx_worker[iface_index] == NULL);
+    cy_udp_posix_rx_worker_t* const worker =
+      (cy_udp_posix_rx_worker_t*)mem_alloc(&cy_udp->mem_general, sizeof(cy_udp_posix_rx_worker_t));
+    if (worker == NULL) {
+        return CY_ERR_MEMORY;
+    }
+    memset(worker, 0, sizeof(*worker));
+    worker->mux    = udp_wrapper_mux_new();
+    worker->signal = udp_wrapper_signal_new();
+    worker->filled = spsc_ring_new();
+    worker->vacant = spsc_ring_new();
+    atomic_init(&worker->signaled, false);
+    atomic_init(&worker->stop, false);
+    atomic_init(&worker->failure, 0);
+    atomic_init(&worker->overruns, 0U);
+    atomic_init(&worker->batches, 0U);
+    atomic_init(&worker->datagrams, 0U);
+    atomic_init(&worker->saturated, 0U);
+    cy_udp->rx_worker[iface_index] = worker;
+
+    worker->lock_initialized = pthread_mutex_init(&worker->lock, NULL) == 0;
+    cy_err_t res             = worker->lock_initialized ? CY_OK : CY_ERR_MEMORY;
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(udp_wrapper_mux_init(&worker->mux));
+    }
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(udp_wrapper_signal_init(&worker->signal));
+    }
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(spsc_ring_init(&worker->filled, sizeof(rx_item_t), CY_UDP_POSIX_RX_RING_CAPACITY));
+    }
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(spsc_ring_init(&worker->vacant, sizeof(void*), CY_UDP_POSIX_RX_RING_CAPACITY));
+    }
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(udp_wrapper_mux_signal_add(&cy_udp->mux, &worker->signal, worker));
+    }
+    if (res == CY_OK) {
+        rx_worker_refill(cy_udp, worker);
+        worker->thread_started = pthread_create(&worker->thread, NULL, &rx_worker_main, worker) == 0;
+        res                    = worker->thread_started ? CY_OK : CY_ERR_MEMORY;
+    }
+    if (res != CY_OK) {
+        rx_worker_stop(cy_udp, iface_index);
+    }
+    return res;
+}
+
+/// The sockets of the iface shall not be opened or closed while its RX thread is reading from them.
+static void rx_lock(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    if (cy_udp->rx_worker[iface_index] != NULL) {
+        (void)pthread_mutex_lock(&cy_udp->rx_worker[iface_index]->lock);
+    }
+}
+static void rx_unlock(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    if (cy_udp->rx_worker[iface_index] != NULL) {
+        (void)pthread_mutex_unlock(&cy_udp->rx_worker[iface_index]->lock);
+    }
+}
+static udp_wrapper_mux_t* rx_mux(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    return (cy_udp->rx_worker[iface_index] != NULL) ? &cy_udp->rx_worker[iface_index]->mux : &cy_udp->mux;
+}
+
+#else
+
+static void rx_lock(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    (void)cy_udp;
+    (void)iface_index;
+}
+static void rx_unlock(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    (void)cy_udp;
+    (void)iface_index;
+}
+static udp_wrapper_mux_t* rx_mux(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    (void)iface_index;
+    return udp_mux(cy_udp);
+}
+
+#endif // CY_UDP_POSIX_RX_THREADS
+
+// ----------------------------------------  END OF RX THREADS  ----------------------------------------
+
+static cy_udp_posix_rx_sock_t rx_sock_new(cy_udp_posix_t* const       owner,
+                                          cy_udp_posix_topic_t* const topic,
+                                          const uint_fast8_t          iface_index)
+{
+    return (cy_udp_posix_rx_sock_t){ .handle      = udp_wrapper_rx_new(),
+                                     .topic       = topic,
+                                     .owner       = owner,
+                                     .group       = NULL,
+                                     .iface_index = iface_index,
+                                     .generation  = 0 };
+}
+
+/// Opens the RX socket and registers it with the event multiplexer. The socket is left closed on failure.
+static cy_err_t rx_sock_open(cy_udp_posix_t* const         cy_udp,
+                             cy_udp_posix_rx_sock_t* const sock,
+                             const uint32_t                multicast_group,
+                             const uint16_t                remote_port)
+{
+    const uint_fast8_t i = sock->iface_index;
+    rx_lock(cy_udp, i);
+    sock->generation++;
+    cy_err_t res = err_from_udp_wrapper(udp_wrapper_rx_init(&sock->handle,
+                                                            cy_udp->local_iface_address[i],
+                                                            multicast_group,
+                                                            remote_port,
+                                                            cy_udp->tx[i].local_port,
+                                                            CY_UDP_POSIX_KERNEL_TIMESTAMPS != 0));
+    if ((res == CY_OK) && (cy_udp->spin.socket_budget_us > 0)) {
+        (void)udp_wrapper_rx_busy_poll(&sock->handle, cy_udp->spin.socket_budget_us); // Best effort.
+    }
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(udp_wrapper_mux_rx_add(rx_mux(cy_udp, i), &sock->handle, sock));
+        if (res != CY_OK) {
+            udp_wrapper_rx_close(&sock->handle);
+        }
+    }
+    rx_unlock(cy_udp, i);
+    return res;
+}
+
+/// The handle may be invalid, in which case this is a no-op.
+static void rx_sock_close(cy_udp_posix_t* const cy_udp, cy_udp_posix_rx_sock_t* const sock)
+{
+    if (udp_wrapper_rx_is_initialized(&sock->handle)) {
+        rx_lock(cy_udp, sock->iface_index);
+        udp_wrapper_mux_rx_remove(rx_mux(cy_udp, sock->iface_index), &sock->handle);
+        udp_wrapper_rx_close(&sock->handle);
+        rx_unlock(cy_udp, sock->iface_index);
+    }
+}
+
+// ----------------------------------------  HUB SOCKET GROUPS  ----------------------------------------
+
+#if !CY_UDP_POSIX_RX_THREADS
+
+/// The shared RX sockets of one subject in a hub and the member topics subscribed to it.
+/// A group is allocated when the subject is first subscribed via the hub and is kept until the hub is destroyed,
+/// because a datagram from its sockets may be in the middle of being delivered when the last member leaves.
+struct cy_udp_posix_rx_group_t
+{
+    cy_udp_posix_hub_t*    hub;
+    cy_udp_posix_rx_sock_t sock[CY_UDP_POSIX_IFACE_COUNT_MAX];
+    cy_udp_posix_topic_t*  head;
+    uint32_t               version; ///< Incremented on every membership change; see hub_deliver().
+};
+
+static void hub_group_close(struct cy_udp_posix_rx_group_t* const group)
+{
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+        if (udp_wrapper_rx_is_initialized(&group->sock[i].handle)) {
+            udp_wrapper_mux_rx_remove(&group->hub->mux, &group->sock[i].handle);
+            udp_wrapper_rx_close(&group->sock[i].handle);
+        }
+    }
+}
+
+/// The own traffic is not filtered out by these sockets because it may be addressed to the other members;
+/// instead, the datagrams are attributed to their senders by the source port. The socket is left closed on failure.
+static cy_err_t hub_group_open(struct cy_udp_posix_rx_group_t* const   group,
+                               const struct UdpardUDPIPEndpoint* const endpoint)
+{
+    cy_udp_posix_hub_t* const hub = group->hub;
+    cy_err_t                  res = CY_OK;
+    for (uint_fast8_t i = 0; (i < CY_UDP_POSIX_IFACE_COUNT_MAX) && (res == CY_OK); i++) {
+        if (is_valid_ip(hub->local_iface_address[i])) {
+            cy_udp_posix_rx_sock_t* const sock = &group->sock[i];
+            sock->generation++;
+            res = err_from_udp_wrapper(udp_wrapper_rx_init(&sock->handle,
+                                                           hub->local_iface_address[i],
+                                                           endpoint->ip_address,
+                                                           endpoint->udp_port,
+                                                           0,
+                                                           CY_UDP_POSIX_KERNEL_TIMESTAMPS != 0));
+            if ((res == CY_OK) && (hub->spin.socket_budget_us > 0)) {
+                (void)udp_wrapper_rx_busy_poll(&sock->handle, hub->spin.socket_budget_us); // Best effort.
+            }
+            if (res == CY_OK) {
+                res = err_from_udp_wrapper(udp_wrapper_mux_rx_add(&hub->mux, &sock->handle, sock));
+                if (res != CY_OK) {
+                    udp_wrapper_rx_close(&sock->handle);
+                }
+            }
+        }
+    }
+    if (res != CY_OK) {
+        hub_group_close(group);
+    }
+    return res;
+}
+
+/// Adds the subscribed topic to the socket group of its subject, opening the shared sockets if it is the first member.
+static cy_err_t hub_join(cy_udp_posix_t* const cy_udp, cy_udp_posix_topic_t* const topic)
+{
+    cy_udp_posix_hub_t* const      hub        = cy_udp->hub;
+    cy_udp_posix_topic_rx_t* const rx         = topic->rx;
+    const uint16_t                 subject_id = cy_topic_subject_id(&topic->base);
+    assert((hub != NULL) && (rx != NULL) && (rx->group == NULL) && (subject_id < CY_TOTAL_SUBJECT_COUNT));
+    struct cy_udp_posix_rx_group_t* group = hub->groups[subject_id];
+    if (group == NULL) {
+        group = (struct cy_udp_posix_rx_group_t*)malloc(sizeof(struct cy_udp_posix_rx_group_t));
+        if (group == NULL) {
+            return CY_ERR_MEMORY;
+        }
+        memset(group, 0, sizeof(*group));
+        group->hub = hub;
+        for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+            group->sock[i]       = rx_sock_new(NULL, NULL, i);
+            group->sock[i].group = group;
+        }
+        hub->groups[subject_id] = group;
+    }
+    if (group->head == NULL) {
+        const cy_err_t res = hub_group_open(group, &rx->sub.udp_ip_endpoint);
+        if (res != CY_OK) {
+            return res;
+        }
+    }
+    rx->group      = group;
+    rx->group_prev = NULL;
+    rx->group_next = group->head;
+    if (group->head != NULL) {
+        group->head->rx->group_prev = topic;
+    }
+    group->head = topic;
+    group->version++;
+    return CY_OK;
+}
+
+/// Removes the topic from its socket group; the shared sockets are closed when the last member leaves.
+static void hub_leave(cy_udp_posix_topic_t* const topic)
+{
+    cy_udp_posix_topic_rx_t* const        rx    = topic->rx;
+    struct cy_udp_posix_rx_group_t* const group = rx->group;
+    assert(group != NULL);
+    if (rx->group_prev != NULL) {
+        rx->group_prev->rx->group_next = rx->group_next;
+    } else {
+        group->head = rx->group_next;
+    }
+    if (rx->group_next != NULL) {
+        rx->group_next->rx->group_prev = rx->group_prev;
+    }
+    rx->group      = NULL;
+    rx->group_prev = NULL;
+    rx->group_next = NULL;
+    group->version++;
+    if (group->head == NULL) {
+        hub_group_close(group);
+    }
+}
+
+#else
+
+static cy_err_t hub_join(cy_udp_posix_t* const cy_udp, cy_udp_posix_topic_t* const topic)
+{
+    (void)cy_udp;
+    (void)topic;
+    return CY_ERR_ARGUMENT; // The hub is not available with the RX threads.
+}
+static void hub_leave(cy_udp_posix_topic_t* const topic)
+{
+    (void)topic;
+}
+
+#endif // !CY_UDP_POSIX_RX_THREADS
+
+// ----------------------------------------  END OF HUB SOCKET GROUPS  ----------------------------------------
+
 // ----------------------------------------  PLATFORM INTERFACE  ----------------------------------------
 
 static cy_us_t platform_now(const cy_t* const cy)
@@ -206,19 +802,14 @@ static cy_err_t platform_node_id_set(cy_t* const cy)
     }
     rpc_listen(cy_udp);
 
-    // Now it is finally time to open the multicast RX sockets.
+    // Now it is finally time to open the multicast RX sockets. The socket objects were set up at initialization.
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        cy_udp->rpc_rx[i].sock      = udp_wrapper_rx_new();
         cy_udp->rpc_rx[i].oom_count = 0;
     }
     cy_err_t res = CY_OK;
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
         if (is_valid_ip(cy_udp->local_iface_address[i])) {
-            res = err_from_udp_wrapper(udp_wrapper_rx_init(&cy_udp->rpc_rx[i].sock,
-                                                           cy_udp->local_iface_address[i],
-                                                           ep.ip_address,
-                                                           ep.udp_port,
-                                                           cy_udp->tx[i].local_port));
+            res = rx_sock_open(cy_udp, &cy_udp->rpc_rx[i].sock, ep.ip_address, ep.udp_port);
             if (res != CY_OK) {
                 break;
             }
@@ -228,7 +819,7 @@ static cy_err_t platform_node_id_set(cy_t* const cy)
     // Cleanup on error.
     if (res != CY_OK) {
         for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-            udp_wrapper_rx_close(&cy_udp->rpc_rx[i].sock);
+            rx_sock_close(cy_udp, &cy_udp->rpc_rx[i].sock);
         }
     }
     return res;
@@ -241,7 +832,7 @@ static void platform_node_id_clear(cy_t* const cy)
 
     // Turn off the RPC plane. Close the sockets and stop the RPC ports. The RPC dispatcher holds no resources.
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        udp_wrapper_rx_close(&cy_udp->rpc_rx[i].sock);
+        rx_sock_close(cy_udp, &cy_udp->rpc_rx[i].sock);
     }
     rpc_unlisten(cy_udp);
 
@@ -260,45 +851,50 @@ static cy_bloom64_t* platform_node_id_bloom(cy_t* const cy)
     return &cy_udp->node_id_bloom;
 }
 
+/// Enqueues the transfer into the queues of all enabled ifaces sharing the same frames.
+static cy_err_t tx_push(cy_udp_posix_t* const cy_udp, tx_transfer_t* const tr, const cy_buffer_borrowed_t payload)
+{
+    tr->source_node_id = (cy_udp->base.node_id <= UDPARD_NODE_ID_MAX) ? cy_udp->base.node_id : UDPARD_NODE_ID_UNSET;
+    tr->remote_port    = TX_UDP_PORT;
+    tr->ts_enqueued    = cy_udp_posix_now();
+    tx_queue_t* queues[CY_UDP_POSIX_IFACE_COUNT_MAX];
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+        queues[i] = &cy_udp->tx[i].queue;
+    }
+    const int32_t e = tx_queue_push(CY_UDP_POSIX_IFACE_COUNT_MAX, queues, cy_udp->mtu, tr, payload, cy_udp->tx_mem);
+    if (e < 0) {
+        return (e == -ENOMEM) ? CY_ERR_MEMORY : CY_ERR_ARGUMENT;
+    }
+    return (e > 0) ? CY_ERR_CAPACITY : CY_OK; // Some queues may have accepted the transfer even if others did not.
+}
+
 static cy_err_t platform_p2p(cy_t* const                  cy,
                              const uint16_t               service_id,
                              const cy_transfer_metadata_t metadata,
                              const cy_us_t                tx_deadline,
                              const cy_buffer_borrowed_t   payload)
 {
-    CY_BUFFER_GATHER_ON_STACK(linear_payload, payload);
     cy_udp_posix_t* const cy_udp = (cy_udp_posix_t*)cy;
-    cy_err_t              res    = CY_OK;
-    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        if (cy_udp->tx[i].udpard_tx.queue_capacity > 0) {
-            const int32_t e =
-              udpardTxRequest(&cy_udp->tx[i].udpard_tx,
-                              (UdpardMicrosecond)tx_deadline,
-                              (enum UdpardPriority)metadata.priority,
-                              service_id,
-                              metadata.remote_node_id,
-                              metadata.transfer_id,
-                              (struct UdpardPayload){ .size = linear_payload.size, .data = linear_payload.data },
-                              NULL);
-            if (e < 0) {
-                res = err_from_udpard(e);
-            } else {
-                res = (res != CY_OK) ? res : err_from_udpard(e);
-            }
-        }
+    if ((cy->node_id > UDPARD_NODE_ID_MAX) || (metadata.remote_node_id > UDPARD_NODE_ID_MAX)) {
+        return CY_ERR_ARGUMENT; // Anonymous nodes cannot engage in P2P exchanges.
     }
-    return res;
+    tx_transfer_t tr = { .deadline            = tx_deadline,
+                         .priority            = metadata.priority,
+                         .destination_node_id = metadata.remote_node_id,
+                         .data_specifier      = tx_service_data_specifier(service_id, true),
+                         .transfer_id         = metadata.transfer_id,
+                         .remote_address      = tx_service_address(metadata.remote_node_id) };
+    return tx_push(cy_udp, &tr, payload);
 }
 
 static cy_topic_t* platform_topic_new(cy_t* const cy)
 {
-    const cy_udp_posix_t* const cy_udp = (cy_udp_posix_t*)cy;
-    cy_udp_posix_topic_t* const topic  = (cy_udp_posix_topic_t*)mem_alloc(cy, sizeof(cy_udp_posix_topic_t));
+    cy_udp_posix_t* const       cy_udp = (cy_udp_posix_t*)cy;
+    cy_udp_posix_topic_t* const topic =
+      (cy_udp_posix_topic_t*)mem_alloc(&cy_udp->mem_general, sizeof(cy_udp_posix_topic_t));
     if (topic != NULL) {
         memset(topic, 0, sizeof(cy_udp_posix_topic_t));
-        for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-            topic->sock_rx[i] = udp_wrapper_rx_new();
-        }
+        topic->rx                  = NULL; // Allocated on the first subscription.
         topic->rx_sock_err_handler = cy_udp->rx_sock_err_handler;
     }
     return (cy_topic_t*)topic;
@@ -306,40 +902,37 @@ static cy_topic_t* platform_topic_new(cy_t* const cy)
 
 static void platform_topic_destroy(cy_t* const cy, cy_topic_t* const topic)
 {
+    cy_udp_posix_t* const       cy_udp    = (cy_udp_posix_t*)cy;
     cy_udp_posix_topic_t* const udp_topic = (cy_udp_posix_topic_t*)topic;
-    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        udp_wrapper_rx_close(&udp_topic->sock_rx[i]);
+    if (udp_topic->rx != NULL) {
+        if (udp_topic->rx->group != NULL) {
+            hub_leave(udp_topic);
+        }
+        for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+            rx_sock_close(cy_udp, &udp_topic->rx->sock[i]);
+        }
+        mem_free(&cy_udp->mem_general, sizeof(cy_udp_posix_topic_rx_t), udp_topic->rx);
     }
-    mem_free(cy, sizeof(cy_udp_posix_topic_t), topic);
+    mem_free(&cy_udp->mem_general, sizeof(cy_udp_posix_topic_t), topic);
 }
 
 // ReSharper disable once CppParameterMayBeConstPtrOrRef
 static cy_err_t platform_topic_publish(cy_t* const                cy,
                                        cy_publisher_t* const      pub,
                                        const cy_us_t              tx_deadline,
+                                       const uint64_t             transfer_id,
                                        const cy_buffer_borrowed_t payload)
 {
-    CY_BUFFER_GATHER_ON_STACK(linear_payload, payload);
-    cy_udp_posix_t* const cy_udp = (cy_udp_posix_t*)cy;
-    cy_err_t              res    = CY_OK;
-    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        if (cy_udp->tx[i].udpard_tx.queue_capacity > 0) {
-            const int32_t e =
-              udpardTxPublish(&cy_udp->tx[i].udpard_tx,
-                              (UdpardMicrosecond)tx_deadline,
-                              (enum UdpardPriority)pub->priority,
-                              cy_topic_subject_id(pub->topic),
-                              pub->topic->pub_transfer_id,
-                              (struct UdpardPayload){ .size = linear_payload.size, .data = linear_payload.data },
-                              NULL);
-            if (e < 0) {
-                res = err_from_udpard(e);
-            } else {
-                res = (res != CY_OK) ? res : err_from_udpard(e);
-            }
-        }
-    }
-    return res;
+    cy_udp_posix_t* const cy_udp     = (cy_udp_posix_t*)cy;
+    const uint16_t        subject_id = cy_topic_subject_id(pub->topic);
+    tx_transfer_t         tr         = { .deadline            = tx_deadline,
+                                         .priority            = pub->priority,
+                                         .destination_node_id = UDPARD_NODE_ID_UNSET,
+                                         .data_specifier      = subject_id,
+                                         .transfer_id         = transfer_id,
+                                         .remote_address      = tx_subject_address(subject_id),
+                                         .probe               = cy->latency_tx_probe };
+    return tx_push(cy_udp, &tr, payload);
 }
 
 static cy_err_t platform_topic_subscribe(cy_t* const                    cy,
@@ -347,34 +940,57 @@ static cy_err_t platform_topic_subscribe(cy_t* const                    cy,
                                          const cy_subscription_params_t params)
 {
     cy_udp_posix_topic_t* const topic  = (cy_udp_posix_topic_t*)cy_topic;
-    const cy_udp_posix_t* const cy_udp = (cy_udp_posix_t*)cy;
+    cy_udp_posix_t* const       cy_udp = (cy_udp_posix_t*)cy;
+
+    // The socket objects are set up once when the topic is first subscribed; closed sockets stay invalid, so there is
+    // no need to reinitialize them later. This matters with RX threads, which may still be looking at a closed socket.
+    if (topic->rx == NULL) {
+        topic->rx = (cy_udp_posix_topic_rx_t*)mem_alloc(&cy_udp->mem_general, sizeof(cy_udp_posix_topic_rx_t));
+        if (topic->rx == NULL) {
+            return CY_ERR_MEMORY;
+        }
+        memset(topic->rx, 0, sizeof(cy_udp_posix_topic_rx_t));
+        for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+            topic->rx->sock[i] = rx_sock_new(cy_udp, topic, i);
+        }
+    }
+    cy_udp_posix_topic_rx_t* const rx = topic->rx;
 
     // Set up the udpard subscription. This does not yet allocate any resources.
-    cy_err_t res = err_from_udpard(udpardRxSubscriptionInit(&topic->sub, //
+    cy_err_t res = err_from_udpard(udpardRxSubscriptionInit(&rx->sub, //
                                                             cy_topic_subject_id(cy_topic),
                                                             params.extent,
                                                             cy_udp->rx_mem));
     if (res != CY_OK) {
         return res; // No cleanup needed, no resources allocated yet.
     }
-    topic->sub.port.transfer_id_timeout_usec = (UdpardMicrosecond)params.transfer_id_timeout;
+    rx->sub.port.transfer_id_timeout_usec = (UdpardMicrosecond)params.transfer_id_timeout;
+    rx->transfer_id_timeout               = params.transfer_id_timeout;
+    for (size_t i = 0; i < CY_UDP_POSIX_RX_DEDUP_SLOTS; i++) {
+        rx->dedup[i].node_id = UDPARD_NODE_ID_UNSET;
+    }
+
+    // The members of a hub share the sockets of the subject instead of opening their own.
+    if (cy_udp->hub != NULL) {
+        res = hub_join(cy_udp, topic);
+        if (res != CY_OK) {
+            udpardRxSubscriptionFree(&rx->sub);
+        }
+        return res;
+    }
 
     // Open the sockets for this subscription.
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        topic->sock_rx[i] = udp_wrapper_rx_new();
         if ((res == CY_OK) && is_valid_ip(cy_udp->local_iface_address[i])) {
-            res = err_from_udp_wrapper(udp_wrapper_rx_init(&topic->sock_rx[i],
-                                                           cy_udp->local_iface_address[i],
-                                                           topic->sub.udp_ip_endpoint.ip_address,
-                                                           topic->sub.udp_ip_endpoint.udp_port,
-                                                           cy_udp->tx[i].local_port));
+            res = rx_sock_open(
+              cy_udp, &rx->sock[i], rx->sub.udp_ip_endpoint.ip_address, rx->sub.udp_ip_endpoint.udp_port);
         }
     }
 
     // Cleanup on error.
     if (res != CY_OK) {
         for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-            udp_wrapper_rx_close(&topic->sock_rx[i]);
+            rx_sock_close(cy_udp, &rx->sock[i]);
         }
     }
     return res;
@@ -383,10 +999,15 @@ static cy_err_t platform_topic_subscribe(cy_t* const                    cy,
 // ReSharper disable once CppParameterMayBeConstPtrOrRef
 static void platform_topic_unsubscribe(cy_t* const cy, cy_topic_t* const cy_topic)
 {
-    (void)cy;
-    udpardRxSubscriptionFree(&((cy_udp_posix_topic_t*)cy_topic)->sub);
+    cy_udp_posix_t* const       cy_udp = (cy_udp_posix_t*)cy;
+    cy_udp_posix_topic_t* const topic  = (cy_udp_posix_topic_t*)cy_topic;
+    assert(topic->rx != NULL); // Only invoked after a successful subscription.
+    udpardRxSubscriptionFree(&topic->rx->sub);
+    if (topic->rx->group != NULL) {
+        hub_leave(topic);
+    }
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        udp_wrapper_rx_close(&((cy_udp_posix_topic_t*)cy_topic)->sock_rx[i]);
+        rx_sock_close(cy_udp, &topic->rx->sock[i]);
     }
 }
 
@@ -414,6 +1035,19 @@ static void platform_topic_on_subscription_error(cy_t* const cy, cy_topic_t* con
     CY_TRACE(cy, "⚠️ Subscription error on topic '%s': %d", (cy_topic != NULL) ? cy_topic->name : "", error);
 }
 
+/// Invoked from arbitrary threads; the system call is only made if the event loop has not been woken up already.
+/// The members of a hub wake up the shared event loop.
+static void platform_wake(cy_t* const cy)
+{
+    cy_udp_posix_t* const       cy_udp  = (cy_udp_posix_t*)cy;
+    cy_udp_posix_hub_t* const   hub     = cy_udp->hub;
+    atomic_bool* const          pending = (hub != NULL) ? &hub->wake_pending : &cy_udp->wake_pending;
+    udp_wrapper_signal_t* const signal  = (hub != NULL) ? &hub->wake_signal : &cy_udp->wake_signal;
+    if (!atomic_exchange_explicit(pending, true, memory_order_acq_rel)) {
+        udp_wrapper_signal_raise(signal);
+    }
+}
+
 static const cy_platform_t g_platform = {
     .now            = platform_now,
     .realloc        = platform_realloc,
@@ -434,6 +1068,8 @@ static const cy_platform_t g_platform = {
     .topic_advertise             = platform_topic_advertise,
     .topic_on_subscription_error = platform_topic_on_subscription_error,
 
+    .wake = platform_wake,
+
     .node_id_max      = UDPARD_NODE_ID_MAX,
     .transfer_id_mask = UINT64_MAX,
 };
@@ -449,102 +1085,262 @@ cy_us_t cy_udp_posix_now(void)
     return (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
 }
 
-cy_err_t cy_udp_posix_new(cy_udp_posix_t* const cy_udp,
-                          const uint64_t        uid,
-                          const wkv_str_t       namespace_,
-                          const uint32_t        local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX],
-                          const size_t          tx_queue_capacity_per_iface)
+/// The hub is NULL for a standalone instance. The members of a hub use its multiplexer and wakeup signal.
+static cy_err_t udp_new(cy_udp_posix_t* const                   cy_udp,
+                        cy_udp_posix_hub_t* const               hub,
+                        const uint64_t                          uid,
+                        const wkv_str_t                         namespace_,
+                        const uint32_t                          local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX],
+                        const size_t                            tx_queue_capacity_per_iface,
+                        const cy_udp_posix_pool_config_t* const pools)
 {
     assert(cy_udp != NULL);
     memset(cy_udp, 0, sizeof(*cy_udp));
+    cy_udp->hub                           = hub;
+    cy_udp->hub_next                      = NULL;
     cy_udp->response_extent_with_overhead = 64; // We start from an arbitrary value that just makes sense.
-    // Set up the memory resources. We could use block pool allocator here as well!
-    cy_udp->mem.allocate                  = mem_alloc;
-    cy_udp->mem.deallocate                = mem_free;
-    cy_udp->mem.user_reference            = cy_udp;
-    cy_udp->rx_mem.session                = cy_udp->mem;
-    cy_udp->rx_mem.fragment               = cy_udp->mem;
+    // Set up the memory resources. The TX and RX domains are heap-backed unless the pools are configured below.
+    cy_udp->mem_general.pool              = block_pool_new();
+    cy_udp->mem_tx.pool                   = block_pool_new();
+    cy_udp->mem_session.pool              = block_pool_new();
+    cy_udp->mem_fragment.pool             = block_pool_new();
+    cy_udp->mem_datagram.pool             = block_pool_new();
+    cy_udp->mem                           = mem_resource(&cy_udp->mem_general);
+    cy_udp->tx_mem                        = mem_resource(&cy_udp->mem_tx);
+    cy_udp->rx_mem.session                = mem_resource(&cy_udp->mem_session);
+    cy_udp->rx_mem.fragment               = mem_resource(&cy_udp->mem_fragment);
     cy_udp->rx_mem.payload.deallocate     = mem_free;
-    cy_udp->rx_mem.payload.user_reference = cy_udp;
+    cy_udp->rx_mem.payload.user_reference = &cy_udp->mem_datagram;
     cy_udp->rx_sock_err_handler           = default_rx_sock_err_handler;
     cy_udp->tx_sock_err_handler           = default_tx_sock_err_handler;
     cy_udp->rpc_rx_sock_err_handler       = default_rpc_rx_sock_err_handler;
+    cy_udp->tx_writable_handler           = NULL;
 
     cy_udp->node_id_bloom.storage  = cy_udp->node_id_bloom_storage;
-    cy_udp->node_id_bloom.n_bits   = sizeof(cy_udp->node_id_bloom_storage) * CHAR_BIT;
+    cy_udp->node_id_bloom.n_bits   = (sizeof(cy_udp->node_id_bloom_storage) * CHAR_BIT) / CY_BLOOM64_GENERATIONS;
     cy_udp->node_id_bloom.popcount = 0;
 
-    // Initialize the udpard tx pipelines. They are all initialized always even if the corresponding iface is disabled,
-    // for regularity, because an unused tx pipline needs no resources, so it's not a problem.
+    cy_udp->mux         = udp_wrapper_mux_new();
+    cy_udp->wake_signal = udp_wrapper_signal_new();
+    atomic_init(&cy_udp->wake_pending, false);
+    cy_udp->mtu = UDPARD_MTU_DEFAULT;
+
+    cy_udp->spin.since            = cy_udp_posix_now();
+    cy_udp->spin.socket_budget_us = (hub != NULL) ? hub->spin.socket_budget_us : 0;
+
+    // The pools are allocated once here and never grow.
     cy_err_t res = CY_OK;
-    for (uint_fast8_t i = 0; (i < CY_UDP_POSIX_IFACE_COUNT_MAX) && (res == CY_OK); i++) {
+    if (pools != NULL) {
+        res = mem_pool_init(&cy_udp->mem_tx,
+                            sizeof(tx_frame_t) + TX_FRAME_HEADER_SIZE + UDPARD_MTU_DEFAULT,
+                            pools->tx_frame_block_count);
+        if (res == CY_OK) {
+            res = mem_pool_init(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE, pools->datagram_block_count);
+        }
+        if (res == CY_OK) {
+            res = mem_pool_init(&cy_udp->mem_fragment,
+                                (pools->fragment_block_size > 0) ? pools->fragment_block_size
+                                                                 : CY_UDP_POSIX_POOL_FRAGMENT_BLOCK_SIZE,
+                                pools->fragment_block_count);
+        }
+        if (res == CY_OK) {
+            res = mem_pool_init(&cy_udp->mem_session,
+                                (pools->session_block_size > 0) ? pools->session_block_size
+                                                                : CY_UDP_POSIX_POOL_SESSION_BLOCK_SIZE,
+                                pools->session_block_count);
+        }
+        if (res != CY_OK) {
+            mem_pools_close(cy_udp);
+            return res;
+        }
+    }
+
+    // Initialize the tx pipelines. They are all initialized always even if the corresponding iface is disabled,
+    // for regularity, because an unused tx pipline needs no resources, so it's not a problem.
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
         cy_udp->local_iface_address[i] = 0;
+        cy_udp->tx[i].queue            = tx_queue_new(tx_queue_capacity_per_iface, i);
         cy_udp->tx[i].sock             = udp_wrapper_tx_new();
-        cy_udp->rpc_rx[i].sock         = udp_wrapper_rx_new();
-        res                            = err_from_udpard(
-          udpardTxInit(&cy_udp->tx[i].udpard_tx, &cy_udp->base.node_id, tx_queue_capacity_per_iface, cy_udp->mem));
-    }
-    if (res != CY_OK) {
-        return res; // Cleanup not required -- no resources allocated yet.
+        cy_udp->rpc_rx[i].sock         = rx_sock_new(cy_udp, NULL, i);
     }
     // FYI: the RPC dispatcher is only initialized ad-hoc when setting the node-ID.
 
     // Initialize the bottom layer first. Rx sockets are initialized per subscription, so not here.
+    if (hub == NULL) {
+        res = err_from_udp_wrapper(udp_wrapper_mux_init(&cy_udp->mux));
+        if (res == CY_OK) {
+            res = err_from_udp_wrapper(udp_wrapper_signal_init(&cy_udp->wake_signal));
+        }
+        if (res == CY_OK) { // The wakeup event carries no user reference, so the event loop needs not handle it.
+            res = err_from_udp_wrapper(udp_wrapper_mux_signal_add(&cy_udp->mux, &cy_udp->wake_signal, NULL));
+        }
+    }
     for (uint_fast8_t i = 0; (i < CY_UDP_POSIX_IFACE_COUNT_MAX) && (res == CY_OK); i++) {
         if (is_valid_ip(local_iface_address[i])) {
             cy_udp->local_iface_address[i] = local_iface_address[i];
             res                            = err_from_udp_wrapper(
               udp_wrapper_tx_init(&cy_udp->tx[i].sock, local_iface_address[i], &cy_udp->tx[i].local_port));
         } else {
-            cy_udp->tx[i].udpard_tx.queue_capacity = 0;
+            cy_udp->tx[i].queue.capacity = 0;
         }
     }
 
-    // Initialize Cy. It will not emit any transfers; this only happens from cy_heartbeat() and cy_publish().
+#if CY_UDP_POSIX_RX_THREADS
+    // The RX threads must be running before Cy is initialized because it opens the heartbeat subscription.
+    for (uint_fast8_t i = 0; (i < CY_UDP_POSIX_IFACE_COUNT_MAX) && (res == CY_OK); i++) {
+        if (is_valid_ip(local_iface_address[i])) {
+            res = rx_worker_start(cy_udp, i);
+        }
+    }
+#endif
+
+    // Initialize Cy. It will not emit any transfers; this only happens from cy_heartbeat() and cy_publish().
     if (res == CY_OK) {
         res = cy_new(&cy_udp->base, &g_platform, uid, UDPARD_NODE_ID_UNSET, namespace_);
+        // Pack the heartbeat gossips up to one frame; a multi-frame heartbeat would be lost entirely with one frame.
+        cy_udp->base.heartbeat_size_max = cy_udp->mtu - TX_TRANSFER_CRC_SIZE;
     }
 
     // Cleanup on error.
     if (res != CY_OK) {
         for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+#if CY_UDP_POSIX_RX_THREADS
+            rx_worker_stop(cy_udp, i);
+#endif
             purge_tx(cy_udp, i);
             udp_wrapper_tx_close(&cy_udp->tx[i].sock); // The handle may be invalid, but we don't care.
         }
+        if (hub == NULL) {
+            udp_wrapper_mux_signal_remove(&cy_udp->mux, &cy_udp->wake_signal);
+            udp_wrapper_signal_close(&cy_udp->wake_signal);
+            udp_wrapper_mux_close(&cy_udp->mux);
+        }
+        mem_pools_close(cy_udp);
     }
     return res;
 }
 
+cy_err_t cy_udp_posix_new(cy_udp_posix_t* const                   cy_udp,
+                          const uint64_t                          uid,
+                          const wkv_str_t                         namespace_,
+                          const uint32_t                          local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX],
+                          const size_t                            tx_queue_capacity_per_iface,
+                          const cy_udp_posix_pool_config_t* const pools)
+{
+    return udp_new(cy_udp, NULL, uid, namespace_, local_iface_address, tx_queue_capacity_per_iface, pools);
+}
+
+static void batch_stats_update(cy_udp_posix_batch_stats_t* const stats, const size_t count, const size_t capacity)
+{
+    if (count > 0) {
+        stats->batches++;
+        stats->datagrams += count;
+        stats->saturated += (count >= capacity) ? 1U : 0U;
+    }
+}
+
+static bool tx_frame_is_alive(const tx_frame_t* const frame, const cy_us_t now)
+{
+    return (frame->deadline == 0) || (frame->deadline > now);
+}
+
+static void tx_frame_expire(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index, tx_frame_t* const frame)
+{
+    cy_udp->tx[iface_index].frames_expired++;
+    cy_udp->tx[iface_index].frames_expired_per_priority[(size_t)frame->priority]++;
+    tx_frame_release(frame, cy_udp->tx_mem);
+}
+
+/// Top up the staging area of the specified iface from the head of the TX queue.
+/// Frames that have timed out while waiting in the queue or in the staging area are dropped.
+static void tx_stage(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index, const cy_us_t now)
+{
+    size_t kept = 0;
+    for (size_t k = 0; k < cy_udp->tx[iface_index].staged_count; k++) {
+        tx_frame_t* const frame = cy_udp->tx[iface_index].staged[k];
+        if (tx_frame_is_alive(frame, now)) {
+            cy_udp->tx[iface_index].staged[kept++] = frame;
+        } else {
+            tx_frame_expire(cy_udp, iface_index, frame);
+        }
+    }
+    cy_udp->tx[iface_index].staged_count = kept;
+    while (cy_udp->tx[iface_index].staged_count < CY_UDP_POSIX_TX_BATCH_SIZE) {
+        tx_frame_t* const frame = tx_queue_pop(&cy_udp->tx[iface_index].queue);
+        if (frame == NULL) {
+            break;
+        }
+        if (tx_frame_is_alive(frame, now)) {
+            cy_udp->tx[iface_index].staged[cy_udp->tx[iface_index].staged_count++] = frame;
+        } else {
+            tx_frame_expire(cy_udp, iface_index, frame);
+        }
+    }
+}
+
+/// Lets the producers of the rejected priority levels know once the queue has drained with some hysteresis.
+static void tx_notify_writable(cy_udp_posix_t* const cy_udp, const uint_fast8_t iface_index)
+{
+    tx_queue_t* const q = &cy_udp->tx[iface_index].queue;
+    for (uint_fast8_t prio = 0; (prio < TX_QUEUE_PRIORITY_COUNT) && (q->blocked != 0); prio++) {
+        const uint32_t bit = 1UL << prio;
+        if (((q->blocked & bit) != 0) && ((q->size * 2U) <= tx_queue_limit(q, (cy_prio_t)prio))) {
+            q->blocked &= ~bit;
+            if (cy_udp->tx_writable_handler != NULL) {
+                cy_udp->tx_writable_handler(cy_udp, iface_index, (cy_prio_t)prio);
+            }
+        }
+    }
+}
+
 /// Write as many frames as possible from the tx queues to the network interfaces without blocking.
+/// The frames are sent in batches of up to CY_UDP_POSIX_TX_BATCH_SIZE per system call.
 static void tx_offload(cy_udp_posix_t* const cy_udp)
 {
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        if (cy_udp->tx[i].udpard_tx.queue_capacity > 0) {
-            const struct UdpardTxItem* tqi = udpardTxPeek(&cy_udp->tx[i].udpard_tx);
-            const cy_us_t              ts  = cy_udp_posix_now(); // Do not call it for every frame, it's costly.
-            while (tqi != NULL) {
+        if (cy_udp->tx[i].queue.capacity > 0) {
+            const cy_us_t ts = cy_udp_posix_now(); // Do not call it for every frame, it's costly.
+            while (true) {
                 // Attempt transmission only if the frame is not yet timed out while waiting in the TX queue.
-                // Otherwise, just drop it and move on to the next one.
-                if ((tqi->deadline_usec == 0) || (tqi->deadline_usec > (UdpardMicrosecond)ts)) {
-                    const int16_t send_res = udp_wrapper_tx_send(&cy_udp->tx[i].sock,
-                                                                 tqi->destination.ip_address,
-                                                                 tqi->destination.udp_port,
-                                                                 tqi->dscp,
-                                                                 tqi->datagram_payload.size,
-                                                                 tqi->datagram_payload.data);
-                    if (send_res == 0) {
-                        break; // Socket no longer writable, stop sending for now to retry later.
-                    }
-                    if (send_res < 0) {
-                        assert(cy_udp->tx_sock_err_handler != NULL);
-                        cy_udp->tx_sock_err_handler(cy_udp, i, (uint32_t)-send_res);
-                    }
+                // Otherwise, just drop it and move on to the next one; this is taken care of by the staging.
+                tx_stage(cy_udp, i, ts);
+                const size_t count = cy_udp->tx[i].staged_count;
+                if (count == 0) {
+                    break; // Nothing left to transmit.
+                }
+                udp_wrapper_tx_datagram_t dgrams[CY_UDP_POSIX_TX_BATCH_SIZE];
+                for (size_t k = 0; k < count; k++) {
+                    const tx_frame_t* const frame = cy_udp->tx[i].staged[k];
+                    dgrams[k] = (udp_wrapper_tx_datagram_t){ .remote_address = frame->remote_address,
+                                                             .remote_port    = frame->remote_port,
+                                                             .dscp = cy_udp->dscp_value_per_priority[frame->priority],
+                                                             .payload_size = frame->size,
+                                                             .payload      = frame->data,
+                                                             .stamp_tag    = frame->probe };
+                }
+                const int16_t send_res = udp_wrapper_tx_send_batch(&cy_udp->tx[i].sock, count, dgrams);
+                if (send_res == 0) {
+                    break; // Socket no longer writable, stop sending for now to retry later.
+                }
+                size_t done = 1; // On error, the offending frame is dropped.
+                if (send_res < 0) {
+                    assert(cy_udp->tx_sock_err_handler != NULL);
+                    cy_udp->tx_sock_err_handler(cy_udp, i, (uint32_t)-send_res);
                 } else {
-                    cy_udp->tx[i].frames_expired++;
+                    done = (size_t)send_res;
+                    batch_stats_update(&cy_udp->tx[i].batch_stats, done, CY_UDP_POSIX_TX_BATCH_SIZE);
                 }
-                udpardTxFree(cy_udp->tx[i].udpard_tx.memory, udpardTxPop(&cy_udp->tx[i].udpard_tx, tqi));
-                tqi = udpardTxPeek(&cy_udp->tx[i].udpard_tx);
+                assert(done <= count);
+                for (size_t k = 0; k < done; k++) {
+                    cy_notify_tx_latency(&cy_udp->base, ts - cy_udp->tx[i].staged[k]->ts_enqueued);
+                    tx_frame_release(cy_udp->tx[i].staged[k], cy_udp->tx_mem);
+                }
+                memmove(&cy_udp->tx[i].staged[0],
+                        &cy_udp->tx[i].staged[done],
+                        (count - done) * sizeof(cy_udp->tx[i].staged[0]));
+                cy_udp->tx[i].staged_count = count - done;
             }
+            tx_notify_writable(cy_udp, i);
         }
     }
 }
@@ -571,17 +1367,46 @@ static cy_buffer_owned_t make_rx_buffer(const struct UdpardFragment head)
     };
 }
 
+/// Only used while LibUDPard does not deduplicate the transfers of the topic; see CY_UDP_POSIX_RX_DEDUP_SLOTS.
+/// The transfers from the reliable sources are let through because Cy deduplicates them itself.
+static bool rx_is_duplicate(cy_udp_posix_topic_t* const topic, const struct UdpardRxTransfer* const transfer)
+{
+    const uint16_t src = transfer->source_node_id;
+    if ((src > UDPARD_NODE_ID_MAX) || cy_topic_is_reliable_source(&topic->base, src)) {
+        return false;
+    }
+    cy_udp_posix_topic_rx_t* const rx = topic->rx;
+    const cy_us_t                  ts = (cy_us_t)transfer->timestamp_usec;
+    const size_t                   i  = src % CY_UDP_POSIX_RX_DEDUP_SLOTS;
+    if ((rx->dedup[i].node_id == src) && (rx->dedup[i].transfer_id == transfer->transfer_id) &&
+        ((ts - rx->dedup[i].ts) <= rx->transfer_id_timeout)) {
+        return true;
+    }
+    rx->dedup[i].node_id     = src;
+    rx->dedup[i].transfer_id = transfer->transfer_id;
+    rx->dedup[i].ts          = ts;
+    return false;
+}
+
 static void ingest_topic_frame(cy_udp_posix_t* const             cy_udp,
                                cy_udp_posix_topic_t* const       topic,
                                const cy_us_t                     ts,
                                const uint_fast8_t                iface_index,
                                const struct UdpardMutablePayload dgram)
 {
-    if ((topic->base.couplings != NULL) && topic->base.subscribed) {
-        struct UdpardRxTransfer transfer = { 0 }; // udpard takes ownership of the dgram payload buffer.
+    if (topic->base.subscribed && (topic->base.couplings != NULL)) { // The socket exists, so the RX state does, too.
+        // LibUDPard cannot let the repeated transfer-IDs through for some sources only, so its deduplication is
+        // disabled for the entire topic while it has reliable sources; see cy_topic_is_reliable_source().
+        cy_udp_posix_topic_rx_t* const rx       = topic->rx;
+        const bool                     reliable = cy_topic_has_reliable_sources(&topic->base);
+        rx->sub.port.transfer_id_timeout_usec   = reliable ? 0U : (UdpardMicrosecond)rx->transfer_id_timeout;
+        struct UdpardRxTransfer transfer        = { 0 }; // udpard takes ownership of the dgram payload buffer.
         const int_fast8_t       er =
-          udpardRxSubscriptionReceive(&topic->sub, (UdpardMicrosecond)ts, dgram, iface_index, &transfer);
-        if (er == 1) {
+          udpardRxSubscriptionReceive(&rx->sub, (UdpardMicrosecond)ts, dgram, iface_index, &transfer);
+        if ((er == 1) && reliable && rx_is_duplicate(topic, &transfer)) {
+            udpardRxFragmentFree(transfer.payload, cy_udp->rx_mem.fragment, cy_udp->rx_mem.payload);
+            cy_stat_add(&topic->base.stats.duplicates, 1U);
+        } else if (er == 1) {
             const cy_transfer_owned_t tr = { .timestamp = (cy_us_t)transfer.timestamp_usec,
                                              .metadata  = make_metadata(&transfer),
                                              .payload   = make_rx_buffer(transfer.payload) };
@@ -590,11 +1415,12 @@ static void ingest_topic_frame(cy_udp_posix_t* const             cy_udp,
             (void)0; // Transfer is not yet completed, nothing to do for now.
         } else if (er == -UDPARD_ERROR_MEMORY) {
             topic->rx_oom_count++;
+            cy_stat_add(&topic->base.stats.drops, 1U);
         } else {
             assert(false); // Unreachable -- internal error: unanticipated UDPARD error state (not possible).
         }
     } else { // The subscription was disabled while processing other socket reads. Ignore it.
-        cy_udp->mem.deallocate(cy_udp->mem.user_reference, CY_UDP_SOCKET_READ_BUFFER_SIZE, dgram.data);
+        mem_free(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE, dgram.data);
     }
 }
 
@@ -615,6 +1441,12 @@ static void ingest_rpc_frame(cy_udp_posix_t* const             cy_udp,
                                              .metadata  = make_metadata(&transfer.base),
                                              .payload   = make_rx_buffer(transfer.base.payload) };
             cy_ingest_topic_response_transfer(&cy_udp->base, tr);
+        } else if (port == &cy_udp->rpc_rx_port_reliable_ack) {
+            assert(port->service_id == CY_P2P_SERVICE_ID_RELIABLE_ACK);
+            const cy_transfer_owned_t tr = { .timestamp = (cy_us_t)transfer.base.timestamp_usec,
+                                             .metadata  = make_metadata(&transfer.base),
+                                             .payload   = make_rx_buffer(transfer.base.payload) };
+            cy_ingest_reliable_ack_transfer(&cy_udp->base, tr);
         } else {
             assert(false); // Forgot to handle?
         }
@@ -627,133 +1459,346 @@ static void ingest_rpc_frame(cy_udp_posix_t* const             cy_udp,
     }
 }
 
-static void read_socket(cy_udp_posix_t* const       cy_udp,
-                        const cy_us_t               ts,
-                        cy_udp_posix_topic_t* const topic,
-                        udp_wrapper_rx_t* const     sock,
-                        const uint_fast8_t          iface_index)
+static void rx_sock_report_error(cy_udp_posix_t* const         cy_udp,
+                                 cy_udp_posix_rx_sock_t* const sock,
+                                 const uint32_t                err_no)
+{
+    if (sock->topic != NULL) {
+        assert(sock->topic->rx_sock_err_handler != NULL);
+        sock->topic->rx_sock_err_handler(cy_udp, sock->topic, sock->iface_index, err_no);
+    } else {
+        assert(cy_udp->rpc_rx_sock_err_handler != NULL);
+        cy_udp->rpc_rx_sock_err_handler(cy_udp, sock->iface_index, err_no);
+    }
+}
+
+/// Pass the data buffer into LibUDPard then into Cy for further processing. It takes ownership of the buffer.
+static void rx_dispatch(cy_udp_posix_t* const             cy_udp,
+                        cy_udp_posix_rx_sock_t* const     sock,
+                        const cy_us_t                     ts,
+                        const uint16_t                    src_node_id,
+                        const struct UdpardMutablePayload dgram)
+{
+    // TODO: realloc the buffer to fit the actual size of the datagram to reduce inner fragmentation.
+
+    // Check for address collisions. This must be done at the frame level because if there are multiple nodes
+    // sitting at our ID, we may be unable to receive any multiframe transfers from them.
+    if ((src_node_id <= UDPARD_NODE_ID_MAX) && (src_node_id == cy_udp->base.node_id)) {
+        cy_notify_node_id_collision(&cy_udp->base);
+    }
+    if (sock->topic != NULL) {
+        ingest_topic_frame(cy_udp, sock->topic, ts, sock->iface_index, dgram);
+    } else {
+        ingest_rpc_frame(cy_udp, ts, sock->iface_index, dgram);
+    }
+}
+
+#if !CY_UDP_POSIX_RX_THREADS
+/// Drains up to CY_UDP_POSIX_RX_BATCH_SIZE datagrams from the socket in one system call.
+static void read_socket(cy_udp_posix_t* const cy_udp, const cy_us_t ts, cy_udp_posix_rx_sock_t* const sock)
 {
+    cy_udp_posix_topic_t* const topic       = sock->topic;
+    const uint_fast8_t          iface_index = sock->iface_index;
+
     // Allocate memory that we will read the data into. The ownership of this memory will be transferred
     // to LibUDPard, which will free it when it is no longer needed.
     // A deeply embedded system may be able to transfer this memory directly from the NIC driver to eliminate copy.
-    struct UdpardMutablePayload dgram = {
-        .size = CY_UDP_SOCKET_READ_BUFFER_SIZE,
-        .data = cy_udp->mem.allocate(cy_udp->mem.user_reference, CY_UDP_SOCKET_READ_BUFFER_SIZE),
-    };
-    if (NULL == dgram.data) { // ReSharper disable once CppRedundantDereferencingAndTakingAddress
+    // The buffers that remain unused after the read are kept for the next one, so normally only the buffers
+    // consumed by the previous read need to be allocated.
+    void*  buffers[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t sizes[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t count = 0;
+    while (count < CY_UDP_POSIX_RX_BATCH_SIZE) {
+        void* const buf = (cy_udp->rx_spare_count > 0)
+                            ? cy_udp->rx_spare[--cy_udp->rx_spare_count]
+                            : mem_alloc(&cy_udp->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE);
+        if (buf == NULL) {
+            break; // Proceed with a smaller batch; the remaining datagrams will stay in the socket for now.
+        }
+        buffers[count] = buf;
+        sizes[count]   = CY_UDP_SOCKET_READ_BUFFER_SIZE;
+        count++;
+    }
+    if (count == 0) { // ReSharper disable once CppRedundantDereferencingAndTakingAddress
         ++*((topic != NULL) ? &topic->rx_oom_count : &cy_udp->rpc_rx[iface_index].oom_count);
+        if (topic != NULL) {
+            cy_stat_add(&topic->base.stats.drops, 1U);
+        }
         return;
     }
 
-    // Read the data from the socket into the buffer we just allocated.
-    const int16_t rx_result = udp_wrapper_rx_receive(sock, &dgram.size, dgram.data);
+    // Read the data from the socket into the buffers we just allocated.
+    int64_t       stamps[CY_UDP_POSIX_RX_BATCH_SIZE];
+    const int16_t rx_result = udp_wrapper_rx_receive_batch(&sock->handle, count, sizes, buffers, stamps, NULL);
     if (rx_result < 0) {
-        // We end up here if the socket was closed while processing another datagram.
+        rx_sock_report_error(cy_udp, sock, (uint32_t)-rx_result);
+    }
+    const size_t  received = (rx_result > 0) ? (size_t)rx_result : 0U;
+    const cy_us_t ts_done  = (received > 0) ? cy_udp_posix_now() : ts;
+    assert(received <= count);
+    batch_stats_update(&cy_udp->rx_batch_stats, received, CY_UDP_POSIX_RX_BATCH_SIZE);
+    for (size_t i = received; i < count; i++) {
+        rx_spare_put(cy_udp, buffers[i]);
+    }
+
+    for (size_t i = 0; i < received; i++) {
+        // Zero size means that the dgram was dropped by filters (own traffic or wrong iface).
+        // The socket may also have been closed while processing the preceding datagrams of this batch.
         // This happens if a subscriber chose to unsubscribe dynamically or caused the node-ID to be changed.
-        cy_udp->mem.deallocate(cy_udp->mem.user_reference, CY_UDP_SOCKET_READ_BUFFER_SIZE, dgram.data);
-        if (topic != NULL) {
-            assert(topic->rx_sock_err_handler != NULL);
-            topic->rx_sock_err_handler(cy_udp, topic, iface_index, (uint32_t)-rx_result);
-        } else {
-            assert(cy_udp->rpc_rx_sock_err_handler != NULL);
-            cy_udp->rpc_rx_sock_err_handler(cy_udp, iface_index, (uint32_t)-rx_result);
+        if ((sizes[i] == 0) || !udp_wrapper_rx_is_initialized(&sock->handle)) {
+            rx_spare_put(cy_udp, buffers[i]);
+            continue;
         }
-        return;
+        const struct UdpardMutablePayload dgram = { .size = sizes[i], .data = buffers[i] };
+        rx_dispatch(
+          cy_udp, sock, rx_arrival_time(stamps[i], ts, ts_done), rx_frame_source_node_id(dgram.data), dgram);
     }
-    if (rx_result == 0) { // Nothing to read OR dgram dropped by filters (own traffic or wrong iface).
-        cy_udp->mem.deallocate(cy_udp->mem.user_reference, CY_UDP_SOCKET_READ_BUFFER_SIZE, dgram.data);
-        return;
+}
+
+/// Copies the datagram into every member of the group except its sender. A member may join or leave the group,
+/// including its own topic, from the callbacks invoked during the delivery; if that happens, the scan is restarted,
+/// and the members that have already received this datagram are recognized by the sequence number.
+static void hub_deliver(struct cy_udp_posix_rx_group_t* const group,
+                        const uint_fast8_t                    iface_index,
+                        const cy_us_t                         ts,
+                        const uint16_t                        src_port,
+                        const struct UdpardPayload       dgram)
+{
+    cy_udp_posix_hub_t* const hub         = group->hub;
+    const uint64_t            seq         = ++hub->seq;
+    const uint16_t            src_node_id = rx_frame_source_node_id(dgram.data);
+    cy_udp_posix_topic_t*     topic       = group->head;
+    while (topic != NULL) {
+        cy_udp_posix_topic_rx_t* const rx = topic->rx;
+        if (rx->group_seq == seq) {
+            topic = rx->group_next;
+            continue;
+        }
+        rx->group_seq                = seq;
+        cy_udp_posix_t* const member = rx->sock[iface_index].owner;
+        if ((src_port == 0) || (member->tx[iface_index].local_port != src_port)) {
+            void* const buf = mem_alloc(&member->mem_datagram, CY_UDP_SOCKET_READ_BUFFER_SIZE);
+            if (buf != NULL) {
+                memcpy(buf, dgram.data, dgram.size);
+                hub->rx_copies++;
+                const uint32_t version = group->version; // The group may change from the callbacks.
+                const struct UdpardMutablePayload copy = { .size = dgram.size, .data = buf };
+                rx_dispatch(member, &rx->sock[iface_index], ts, src_node_id, copy);
+                if (version != group->version) {
+                    topic = group->head;
+                    continue;
+                }
+            } else {
+                hub->rx_oom_count++;
+                topic->rx_oom_count++;
+                cy_stat_add(&topic->base.stats.drops, 1U);
+            }
+        }
+        topic = rx->group_next;
     }
-    // TODO: realloc the buffer to fit the actual size of the datagram to reduce inner fragmentation.
+}
 
-    // Check for address collisions. This must be done at the frame level because if there are multiple nodes
-    // sitting at our ID, we may be unable to receive any multiframe transfers from them.
-    // TODO: the header needs to be verified (version & CRC) and it has to be done by LibUDPard; perhaps we need
-    // to expose something like bool udpardRxFrameParse(payload, out_transfer_metadata)?
-    // Alternatively, it could be an optional out-parameter of udpardRxSubscriptionReceive()?
-    {
-        const uint16_t src_nid = (uint16_t)(((const uint8_t*)dgram.data)[2] | //
-                                            (((uint32_t)((const uint8_t*)dgram.data)[3]) << 8U));
-        if ((src_nid <= UDPARD_NODE_ID_MAX) && (src_nid == cy_udp->base.node_id)) {
-            cy_notify_node_id_collision(&cy_udp->base);
+/// Drains up to CY_UDP_POSIX_RX_BATCH_SIZE datagrams from a shared socket into the scratch buffers of the hub.
+static void hub_read_socket(cy_udp_posix_hub_t* const hub, const cy_us_t ts, cy_udp_posix_rx_sock_t* const sock)
+{
+    struct cy_udp_posix_rx_group_t* const group       = sock->group;
+    const uint_fast8_t                    iface_index = sock->iface_index;
+    size_t                                sizes[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t                                count = 0;
+    while (count < CY_UDP_POSIX_RX_BATCH_SIZE) {
+        if (hub->scratch[count] == NULL) {
+            hub->scratch[count] = malloc(CY_UDP_SOCKET_READ_BUFFER_SIZE);
+            if (hub->scratch[count] == NULL) {
+                break; // Proceed with a smaller batch; the remaining datagrams will stay in the socket for now.
+            }
         }
+        sizes[count] = CY_UDP_SOCKET_READ_BUFFER_SIZE;
+        count++;
+    }
+    if (count == 0) {
+        hub->rx_oom_count++;
+        return;
     }
 
-    // Pass the data buffer into LibUDPard then into Cy for further processing. It takes ownership of the buffer.
-    if (topic != NULL) {
-        ingest_topic_frame(cy_udp, topic, ts, iface_index, dgram);
-    } else {
-        ingest_rpc_frame(cy_udp, ts, iface_index, dgram);
+    int64_t       stamps[CY_UDP_POSIX_RX_BATCH_SIZE];
+    uint16_t      ports[CY_UDP_POSIX_RX_BATCH_SIZE];
+    const int16_t rx_result = udp_wrapper_rx_receive_batch(&sock->handle, count, sizes, hub->scratch, stamps, ports);
+    if ((rx_result < 0) && (group->head != NULL)) { // Reported to the most recent member on behalf of all.
+        cy_udp_posix_topic_t* const topic = group->head;
+        assert(topic->rx_sock_err_handler != NULL);
+        topic->rx_sock_err_handler(topic->rx->sock[iface_index].owner, topic, iface_index, (uint32_t)-rx_result);
+    }
+    const size_t  received = (rx_result > 0) ? (size_t)rx_result : 0U;
+    const cy_us_t ts_done  = (received > 0) ? cy_udp_posix_now() : ts;
+    assert(received <= count);
+    batch_stats_update(&hub->rx_batch_stats, received, CY_UDP_POSIX_RX_BATCH_SIZE);
+
+    // The group outlives its sockets, so it is safe to access even if the last member left during the delivery.
+    for (size_t i = 0; (i < received) && udp_wrapper_rx_is_initialized(&sock->handle); i++) {
+        if (sizes[i] > 0) {
+            const struct UdpardPayload dgram = { .size = sizes[i], .data = hub->scratch[i] };
+            hub_deliver(group, iface_index, rx_arrival_time(stamps[i], ts, ts_done), ports[i], dgram);
+        }
     }
 }
 
-static cy_err_t spin_once_until(cy_udp_posix_t* const cy_udp, const cy_us_t deadline)
-{
-    tx_offload(cy_udp); // Free up space in the TX queues and ensure all TX sockets are blocked.
+#else
 
-    // Fill out the TX awaitable array. May be empty if there's nothing to transmit at the moment.
-    size_t            tx_count                               = 0;
-    udp_wrapper_tx_t* tx_await[CY_UDP_POSIX_IFACE_COUNT_MAX] = { 0 };
+/// Process the datagrams received by the RX threads and supply them with fresh buffers. Invoked by the core thread.
+/// Returns CY_ERR_MEDIA if an RX thread has failed.
+static cy_err_t rx_workers_drain(cy_udp_posix_t* const cy_udp)
+{
+    cy_err_t                   res   = CY_OK;
+    cy_udp_posix_batch_stats_t stats = { 0 };
+    uint64_t                   overruns = 0;
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        if (cy_udp->tx[i].udpard_tx.queue_size > 0) { // There's something to transmit!
-            tx_await[tx_count] = &cy_udp->tx[i].sock;
-            tx_count++;
-        }
-    }
-
-    // Fill out the RX awaitable array. The total number of RX sockets is the interface count times number of topics
-    // we are subscribed to plus RPC RX sockets (whose number is not dependent on the number of RPC ports).
-    // Currently, we don't have a simple value that says how many topics we are subscribed to,
-    // so we simply use the total number of topics; it's a bit wasteful but it's not a huge deal and we definitely
-    // don't want to scan the topic index to count the ones we are subscribed to.
-    // This is a rather cumbersome operation as we need to traverse the topic tree; perhaps we should switch to epoll?
-    const size_t          max_rx_count = CY_UDP_POSIX_IFACE_COUNT_MAX * (cy_udp->base.topic_count + 1);
-    size_t                rx_count     = 0;
-    udp_wrapper_rx_t*     rx_await[max_rx_count]; // Initialization is not possible and is very wasteful anyway.
-    cy_udp_posix_topic_t* rx_topics[max_rx_count];
-    uint_fast8_t          rx_iface_indexes[max_rx_count];
-    for (cy_udp_posix_topic_t* topic = (cy_udp_posix_topic_t*)cy_topic_iter_first(&cy_udp->base); topic != NULL;
-         topic                       = (cy_udp_posix_topic_t*)cy_topic_iter_next(&topic->base)) {
-        if (topic->base.couplings != NULL) {
-            for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-                if (is_valid_ip(cy_udp->local_iface_address[i])) {
-                    assert(udp_wrapper_rx_is_initialized(&topic->sock_rx[i]));
-                    assert(rx_count < max_rx_count);
-                    rx_await[rx_count]         = &topic->sock_rx[i];
-                    rx_topics[rx_count]        = topic;
-                    rx_iface_indexes[rx_count] = i;
-                    rx_count++;
+        cy_udp_posix_rx_worker_t* const worker = cy_udp->rx_worker[i];
+        if (worker == NULL) {
+            continue;
+        }
+        // Clear the signal before draining; the items pushed afterward will raise it again.
+        udp_wrapper_signal_clear(&worker->signal);
+        atomic_store_explicit(&worker->signaled, false, memory_order_release);
+        // The number of items processed per spin is bounded because the RX thread keeps pushing concurrently.
+        // If the ring could not be drained completely, re-raise the signal to come back here immediately.
+        const size_t capacity = spsc_ring_capacity(&worker->filled);
+        size_t       k        = 0;
+        rx_item_t    item;
+        while ((k < capacity) && spsc_ring_pop(&worker->filled, &item)) {
+            k++;
+            cy_udp_posix_rx_sock_t* const sock = item.sock;
+            // The socket may have been closed or reopened since the datagram was read; if so, it is stale.
+            const bool current = udp_wrapper_rx_is_initialized(&sock->handle) && (sock->generation == item.generation);
+            if (item.buffer == NULL) {
+                if (current) {
+                    rx_sock_report_error(cy_udp, sock, item.err_no);
                 }
+            } else if (current) {
+                rx_dispatch(cy_udp,
+                            sock,
+                            item.ts,
+                            item.src_node_id,
+                            (struct UdpardMutablePayload){ .size = item.size, .data = item.buffer });
+            } else {
+                rx_spare_put(cy_udp, item.buffer);
             }
         }
+        if (k >= capacity) {
+            rx_worker_notify(worker);
+        }
+        rx_worker_refill(cy_udp, worker);
+        stats.batches += atomic_load_explicit(&worker->batches, memory_order_relaxed);
+        stats.datagrams += atomic_load_explicit(&worker->datagrams, memory_order_relaxed);
+        stats.saturated += atomic_load_explicit(&worker->saturated, memory_order_relaxed);
+        overruns += atomic_load_explicit(&worker->overruns, memory_order_relaxed);
+        if (atomic_load_explicit(&worker->failure, memory_order_relaxed) != 0) {
+            res = CY_ERR_MEDIA;
+        }
     }
-    // Add the RPC RX sockets.
+    cy_udp->rx_batch_stats   = stats;
+    cy_udp->rx_overrun_count = overruns;
+    return res;
+}
+#endif
+
+/// Ensure that the TX sockets are awaited for writability if and only if there is something to transmit.
+/// The registration is only altered when the state changes, so normally this involves no system calls.
+static void tx_update_await(cy_udp_posix_t* const cy_udp)
+{
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+        const bool want = ((cy_udp->tx[i].queue.size > 0) || (cy_udp->tx[i].staged_count > 0)) &&
+                          udp_wrapper_tx_is_initialized(&cy_udp->tx[i].sock);
+        if (want != cy_udp->tx[i].awaiting_writable) {
+            const int16_t e = udp_wrapper_mux_tx_await(udp_mux(cy_udp), &cy_udp->tx[i].sock, NULL, want);
+            if (e >= 0) {
+                cy_udp->tx[i].awaiting_writable = want;
+            } else {
+                assert(cy_udp->tx_sock_err_handler != NULL);
+                cy_udp->tx_sock_err_handler(cy_udp, i, (uint32_t)-e);
+            }
+        }
+    }
+}
+
+/// Reports the departure times of the traced transfers to the core. A transfer is sent over every interface,
+/// so it may be reported more than once; the first report wins and the rest are ignored by the core.
+static void tx_stamps_collect(cy_udp_posix_t* const cy_udp)
+{
     for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
-        if (is_valid_ip(cy_udp->local_iface_address[i]) && udp_wrapper_rx_is_initialized(&cy_udp->rpc_rx[i].sock)) {
-            rx_await[rx_count]         = &cy_udp->rpc_rx[i].sock;
-            rx_topics[rx_count]        = NULL; // No topic associated with this socket.
-            rx_iface_indexes[rx_count] = i;
-            rx_count++;
+        uint32_t tag = 0;
+        int64_t  ts  = 0;
+        while (udp_wrapper_tx_stamp(&cy_udp->tx[i].sock, &tag, &ts) > 0) { // No system calls unless stamps pending.
+            cy_notify_tx_departure(&cy_udp->base, tag, (cy_us_t)ts);
+        }
+    }
+}
+
+/// In the blocking mode, this is a single wait until the deadline. In the busy-poll mode, the multiplexer is polled
+/// without blocking until there are events to process or the deadline is reached; the thread never yields the CPU.
+static int16_t mux_poll(udp_wrapper_mux_t* const       mux,
+                        cy_udp_posix_spin_t* const     spin,
+                        const cy_us_t                  deadline,
+                        udp_wrapper_mux_event_t* const events)
+{
+    int16_t event_count = 0;
+    cy_us_t now         = cy_udp_posix_now();
+    for (;;) {
+        const cy_us_t timeout = spin->busy ? 0 : (deadline - min_i64(now, deadline));
+        event_count           = udp_wrapper_mux_wait(mux, timeout, CY_UDP_POSIX_MUX_EVENT_CAPACITY, events);
+        spin->polls++;
+        if (event_count != 0) {
+            break;
+        }
+        spin->polls_idle++;
+        if (!spin->busy) {
+            break;
+        }
+        now = cy_udp_posix_now();
+        if (now >= deadline) {
+            break;
         }
     }
+    return event_count;
+}
 
-    // Do a blocking wait.
-    const cy_us_t wait_timeout = deadline - min_i64(cy_udp_posix_now(), deadline);
-    cy_err_t      res = err_from_udp_wrapper(udp_wrapper_wait(wait_timeout, tx_count, tx_await, rx_count, rx_await));
+static cy_err_t spin_once_until(cy_udp_posix_t* const cy_udp, const cy_us_t deadline)
+{
+    tx_offload(cy_udp); // Free up space in the TX queues and ensure all TX sockets are blocked.
+    tx_update_await(cy_udp);
+
+    // Wait for events (blocking unless busy-polling). All open sockets are already registered with the multiplexer,
+    // so unlike poll(), the cost of this call does not depend on the number of topics.
+    udp_wrapper_mux_event_t events[CY_UDP_POSIX_MUX_EVENT_CAPACITY];
+    const int16_t           event_count = mux_poll(&cy_udp->mux, &cy_udp->spin, deadline, events);
+    cy_err_t                res         = err_from_udp_wrapper(event_count);
     if (res == CY_OK) {
+        // Clear the wakeup before cy_update() takes the submissions; those submitted afterward will raise it again.
+        if (atomic_load_explicit(&cy_udp->wake_pending, memory_order_acquire)) {
+            udp_wrapper_signal_clear(&cy_udp->wake_signal);
+            atomic_store_explicit(&cy_udp->wake_pending, false, memory_order_release);
+        }
+        tx_stamps_collect(cy_udp);
+#if CY_UDP_POSIX_RX_THREADS
+        // The RX sockets are served by the RX threads; the only events carrying a user reference are their signals.
+        // Every RX thread is checked regardless of the events, which is cheap.
+        res = rx_workers_drain(cy_udp);
+#else
         const cy_us_t ts = cy_udp_posix_now(); // immediately after unblocking
 
-        // Process readable handles. The writable ones will be taken care of later.
-        for (size_t i = 0; i < rx_count; i++) {
-            if (rx_await[i] != NULL) {
-                read_socket(cy_udp, ts, rx_topics[i], rx_await[i], rx_iface_indexes[i]);
+        // Process readable handles. The writable ones will be taken care of later; they carry no user reference.
+        for (int16_t i = 0; i < event_count; i++) {
+            cy_udp_posix_rx_sock_t* const sock = (cy_udp_posix_rx_sock_t*)events[i].user;
+            // The socket may have been closed while processing another datagram in this batch.
+            if ((sock != NULL) && events[i].readable && udp_wrapper_rx_is_initialized(&sock->handle)) {
+                read_socket(cy_udp, ts, sock);
             }
         }
+#endif
 
         // Remember that we need to periodically poll cy_update() even if no traffic is received.
         // The update needs to be invoked after all incoming transfers are handled in this cycle, not before.
-        assert(res == CY_OK);
-        res = cy_update(&cy_udp->base);
+        const cy_err_t update_res = cy_update(&cy_udp->base);
+        res                       = (res == CY_OK) ? update_res : res;
 
         // While handling the events, we could have generated additional TX items, so we need to process them again.
         // We do it even in case of failure such that transient errors do not stall the TX queue.
@@ -764,9 +1809,14 @@ static cy_err_t spin_once_until(cy_udp_posix_t* const cy_udp, const cy_us_t dead
 
 cy_err_t cy_udp_posix_spin_until(cy_udp_posix_t* const cy_udp, const cy_us_t deadline)
 {
+#if !CY_UDP_POSIX_RX_THREADS
+    if (cy_udp->hub != NULL) {
+        return cy_udp_posix_hub_spin_until(cy_udp->hub, deadline);
+    }
+#endif
     cy_err_t res = CY_OK;
     while (res == CY_OK) {
-        res = spin_once_until(cy_udp, min_i64(deadline, cy_udp->base.heartbeat_next));
+        res = spin_once_until(cy_udp, min_i64(deadline, cy_next_deadline(&cy_udp->base)));
         if (deadline <= cy_udp_posix_now()) {
             break;
         }
@@ -777,5 +1827,391 @@ cy_err_t cy_udp_posix_spin_until(cy_udp_posix_t* const cy_udp, const cy_us_t dea
 cy_err_t cy_udp_posix_spin_once(cy_udp_posix_t* const cy_udp)
 {
     assert(cy_udp != NULL);
-    return spin_once_until(cy_udp, min_i64(cy_udp_posix_now() + 1000, cy_udp->base.heartbeat_next));
+#if !CY_UDP_POSIX_RX_THREADS
+    if (cy_udp->hub != NULL) {
+        return cy_udp_posix_hub_spin_once(cy_udp->hub);
+    }
+#endif
+    return spin_once_until(cy_udp, cy_next_deadline(&cy_udp->base));
+}
+
+/// Applies the budget to the RPC sockets and to the topic sockets of the instance that are currently open.
+/// The sockets served by the RX threads may be read concurrently, which is safe because only this thread closes them.
+/// The sockets are not touched while the budget stays zero, so that they keep the system default, and so that the
+/// mode can be switched on platforms without SO_BUSY_POLL.
+static cy_err_t busy_poll_apply(cy_udp_posix_t* const cy_udp, const uint32_t socket_budget_us)
+{
+    if ((socket_budget_us == 0) && (cy_udp->spin.socket_budget_us == 0)) {
+        return CY_OK;
+    }
+    cy_err_t res                  = CY_OK;
+    cy_udp->spin.socket_budget_us = socket_budget_us;
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+        if (udp_wrapper_rx_is_initialized(&cy_udp->rpc_rx[i].sock.handle)) {
+            const cy_err_t e =
+              err_from_udp_wrapper(udp_wrapper_rx_busy_poll(&cy_udp->rpc_rx[i].sock.handle, socket_budget_us));
+            res = (res == CY_OK) ? e : res;
+        }
+    }
+    for (cy_topic_t* t = cy_topic_iter_first(&cy_udp->base); t != NULL; t = cy_topic_iter_next(t)) {
+        const cy_udp_posix_topic_t* const topic = (const cy_udp_posix_topic_t*)t;
+        for (uint_fast8_t i = 0; (topic->rx != NULL) && (i < CY_UDP_POSIX_IFACE_COUNT_MAX); i++) {
+            if (udp_wrapper_rx_is_initialized(&topic->rx->sock[i].handle)) {
+                const cy_err_t e =
+                  err_from_udp_wrapper(udp_wrapper_rx_busy_poll(&topic->rx->sock[i].handle, socket_budget_us));
+                res = (res == CY_OK) ? e : res;
+            }
+        }
+    }
+    return res;
+}
+
+cy_err_t cy_udp_posix_busy_poll(cy_udp_posix_t* const cy_udp, const bool enabled, const uint32_t socket_budget_us)
+{
+    if (cy_udp == NULL) {
+        return CY_ERR_ARGUMENT;
+    }
+#if !CY_UDP_POSIX_RX_THREADS
+    if (cy_udp->hub != NULL) {
+        return cy_udp_posix_hub_busy_poll(cy_udp->hub, enabled, socket_budget_us);
+    }
+#endif
+    cy_udp->spin.busy = enabled;
+    return busy_poll_apply(cy_udp, socket_budget_us);
+}
+
+cy_err_t cy_udp_posix_pin_thread(const uint16_t cpu)
+{
+#if defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        return CY_ERR_ARGUMENT;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) ? CY_OK : CY_ERR_ARGUMENT;
+#else
+    (void)cpu;
+    return CY_ERR_ARGUMENT;
+#endif
+}
+
+// ----------------------------------------  HUB  ----------------------------------------
+
+#if !CY_UDP_POSIX_RX_THREADS
+
+cy_err_t cy_udp_posix_hub_new(cy_udp_posix_hub_t* const hub, const uint32_t local_iface_address[])
+{
+    if ((hub == NULL) || (local_iface_address == NULL)) {
+        return CY_ERR_ARGUMENT;
+    }
+    memset(hub, 0, sizeof(*hub));
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+        hub->local_iface_address[i] = local_iface_address[i];
+    }
+    hub->mux         = udp_wrapper_mux_new();
+    hub->wake_signal = udp_wrapper_signal_new();
+    atomic_init(&hub->wake_pending, false);
+    hub->spin.since = cy_udp_posix_now();
+    cy_err_t res = err_from_udp_wrapper(udp_wrapper_mux_init(&hub->mux));
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(udp_wrapper_signal_init(&hub->wake_signal));
+    }
+    if (res == CY_OK) {
+        res = err_from_udp_wrapper(udp_wrapper_mux_signal_add(&hub->mux, &hub->wake_signal, NULL));
+    }
+    if (res != CY_OK) {
+        udp_wrapper_mux_signal_remove(&hub->mux, &hub->wake_signal);
+        udp_wrapper_signal_close(&hub->wake_signal);
+        udp_wrapper_mux_close(&hub->mux);
+    }
+    return res;
+}
+
+void cy_udp_posix_hub_destroy(cy_udp_posix_hub_t* const hub)
+{
+    if (hub != NULL) {
+        for (size_t i = 0; i < CY_TOTAL_SUBJECT_COUNT; i++) {
+            if (hub->groups[i] != NULL) {
+                hub_group_close(hub->groups[i]);
+                free(hub->groups[i]);
+                hub->groups[i] = NULL;
+            }
+        }
+        for (size_t i = 0; i < CY_UDP_POSIX_RX_BATCH_SIZE; i++) {
+            free(hub->scratch[i]);
+            hub->scratch[i] = NULL;
+        }
+        udp_wrapper_mux_signal_remove(&hub->mux, &hub->wake_signal);
+        udp_wrapper_signal_close(&hub->wake_signal);
+        udp_wrapper_mux_close(&hub->mux);
+        hub->members      = NULL;
+        hub->member_count = 0;
+    }
+}
+
+cy_err_t cy_udp_posix_new_shared(cy_udp_posix_t* const                   cy_udp,
+                                 cy_udp_posix_hub_t* const               hub,
+                                 const uint64_t                          uid,
+                                 const wkv_str_t                         namespace_,
+                                 const size_t                            tx_queue_capacity_per_iface,
+                                 const cy_udp_posix_pool_config_t* const pools)
+{
+    if ((cy_udp == NULL) || (hub == NULL)) {
+        return CY_ERR_ARGUMENT;
+    }
+    const cy_err_t res =
+      udp_new(cy_udp, hub, uid, namespace_, hub->local_iface_address, tx_queue_capacity_per_iface, pools);
+    if (res == CY_OK) {
+        cy_udp->hub_next = hub->members;
+        hub->members     = cy_udp;
+        hub->member_count++;
+    }
+    return res;
+}
+
+/// Same as spin_once_until() but for all members at once; see there.
+static cy_err_t hub_spin_once_until(cy_udp_posix_hub_t* const hub, const cy_us_t deadline)
+{
+    for (cy_udp_posix_t* m = hub->members; m != NULL; m = m->hub_next) {
+        tx_offload(m);
+        tx_update_await(m);
+    }
+
+    udp_wrapper_mux_event_t events[CY_UDP_POSIX_MUX_EVENT_CAPACITY];
+    const int16_t           event_count = mux_poll(&hub->mux, &hub->spin, deadline, events);
+    cy_err_t                res         = err_from_udp_wrapper(event_count);
+    if (res == CY_OK) {
+        if (atomic_load_explicit(&hub->wake_pending, memory_order_acquire)) {
+            udp_wrapper_signal_clear(&hub->wake_signal);
+            atomic_store_explicit(&hub->wake_pending, false, memory_order_release);
+        }
+        for (cy_udp_posix_t* m = hub->members; m != NULL; m = m->hub_next) {
+            tx_stamps_collect(m);
+        }
+        const cy_us_t ts = cy_udp_posix_now();
+        for (int16_t i = 0; i < event_count; i++) {
+            cy_udp_posix_rx_sock_t* const sock = (cy_udp_posix_rx_sock_t*)events[i].user;
+            if ((sock != NULL) && events[i].readable && udp_wrapper_rx_is_initialized(&sock->handle)) {
+                if (sock->group != NULL) {
+                    hub_read_socket(hub, ts, sock);
+                } else {
+                    read_socket(sock->owner, ts, sock); // The RPC sockets remain per member.
+                }
+            }
+        }
+        for (cy_udp_posix_t* m = hub->members; m != NULL; m = m->hub_next) {
+            const cy_err_t update_res = cy_update(&m->base);
+            res                       = (res == CY_OK) ? update_res : res;
+            tx_offload(m);
+        }
+    }
+    return res;
+}
+
+/// The earliest deadline across all members.
+static cy_us_t hub_next_deadline(cy_udp_posix_hub_t* const hub)
+{
+    cy_us_t out = INT64_MAX;
+    for (cy_udp_posix_t* m = hub->members; m != NULL; m = m->hub_next) {
+        out = min_i64(out, cy_next_deadline(&m->base));
+    }
+    return out;
+}
+
+cy_err_t cy_udp_posix_hub_spin_until(cy_udp_posix_hub_t* const hub, const cy_us_t deadline)
+{
+    assert(hub != NULL);
+    cy_err_t res = CY_OK;
+    while (res == CY_OK) {
+        res = hub_spin_once_until(hub, min_i64(deadline, hub_next_deadline(hub)));
+        if (deadline <= cy_udp_posix_now()) {
+            break;
+        }
+    }
+    return res;
+}
+
+cy_err_t cy_udp_posix_hub_spin_once(cy_udp_posix_hub_t* const hub)
+{
+    assert(hub != NULL);
+    return hub_spin_once_until(hub, hub_next_deadline(hub));
+}
+
+cy_err_t cy_udp_posix_hub_busy_poll(cy_udp_posix_hub_t* const hub, const bool enabled, const uint32_t socket_budget_us)
+{
+    if (hub == NULL) {
+        return CY_ERR_ARGUMENT;
+    }
+    cy_err_t   res             = CY_OK;
+    const bool keep            = (socket_budget_us == 0) && (hub->spin.socket_budget_us == 0); // See busy_poll_apply().
+    hub->spin.busy             = enabled;
+    hub->spin.socket_budget_us = socket_budget_us;
+    for (size_t k = 0; (k < CY_TOTAL_SUBJECT_COUNT) && !keep; k++) {
+        for (uint_fast8_t i = 0; (hub->groups[k] != NULL) && (i < CY_UDP_POSIX_IFACE_COUNT_MAX); i++) {
+            if (udp_wrapper_rx_is_initialized(&hub->groups[k]->sock[i].handle)) {
+                const cy_err_t e =
+                  err_from_udp_wrapper(udp_wrapper_rx_busy_poll(&hub->groups[k]->sock[i].handle, socket_budget_us));
+                res = (res == CY_OK) ? e : res;
+            }
+        }
+    }
+    for (cy_udp_posix_t* m = hub->members; m != NULL; m = m->hub_next) {
+        const cy_err_t e = busy_poll_apply(m, socket_budget_us); // Only the RPC sockets are open in the members.
+        res              = (res == CY_OK) ? e : res;
+    }
+    return res;
+}
+
+#endif // !CY_UDP_POSIX_RX_THREADS
+
+// ----------------------------------------  END OF HUB  ----------------------------------------
+
+size_t cy_udp_posix_tx_backlog(const cy_udp_posix_t* const cy_udp,
+                               const uint_fast8_t          iface_index,
+                               const cy_prio_t             priority)
+{
+    size_t out = 0;
+    if ((cy_udp != NULL) && (iface_index < CY_UDP_POSIX_IFACE_COUNT_MAX) &&
+        (((size_t)priority) < TX_QUEUE_PRIORITY_COUNT) && (cy_udp->tx[iface_index].queue.capacity > 0)) {
+        out = tx_queue_backlog(&cy_udp->tx[iface_index].queue, priority);
+        for (size_t k = 0; k < cy_udp->tx[iface_index].staged_count; k++) {
+            out += (cy_udp->tx[iface_index].staged[k]->priority <= priority) ? 1U : 0U;
+        }
+    }
+    return out;
+}
+
+size_t cy_udp_posix_tx_headroom(const cy_udp_posix_t* const cy_udp,
+                                const uint_fast8_t          iface_index,
+                                const cy_prio_t             priority)
+{
+    size_t out = 0;
+    if ((cy_udp != NULL) && (iface_index < CY_UDP_POSIX_IFACE_COUNT_MAX) &&
+        (((size_t)priority) < TX_QUEUE_PRIORITY_COUNT)) {
+        const tx_queue_t* const q     = &cy_udp->tx[iface_index].queue;
+        const size_t            limit = tx_queue_limit(q, priority);
+        out                           = (limit > q->size) ? (limit - q->size) : 0U;
+    }
+    return out;
+}
+
+void cy_udp_posix_tx_shed(cy_udp_posix_t* const cy_udp, const size_t threshold)
+{
+    assert(cy_udp != NULL);
+    for (uint_fast8_t i = 0; i < CY_UDP_POSIX_IFACE_COUNT_MAX; i++) {
+        cy_udp->tx[i].queue.limit[cy_prio_slow]     = threshold;
+        cy_udp->tx[i].queue.limit[cy_prio_optional] = threshold;
+    }
+}
+
+// ----------------------------------------  WAITER  ----------------------------------------
+
+cy_err_t cy_udp_posix_waiter_init(cy_udp_posix_waiter_t* const waiter)
+{
+    assert(waiter != NULL);
+    waiter->done    = false;
+    waiter->release = NULL;
+    if (pthread_mutex_init(&waiter->lock, NULL) != 0) {
+        return CY_ERR_MEDIA;
+    }
+    // The deadlines are given per cy_udp_posix_now(), so the condition variable shall use the same clock.
+    // Darwin lacks pthread_condattr_setclock(); the relative wait is used there instead.
+    pthread_condattr_t attr;
+    bool               ok = pthread_condattr_init(&attr) == 0;
+    if (ok) {
+#ifndef __APPLE__
+        ok = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0;
+#endif
+        ok = ok && (pthread_cond_init(&waiter->cond, &attr) == 0);
+        (void)pthread_condattr_destroy(&attr);
+    }
+    if (!ok) {
+        (void)pthread_mutex_destroy(&waiter->lock);
+        return CY_ERR_MEDIA;
+    }
+    return CY_OK;
+}
+
+void cy_udp_posix_waiter_destroy(cy_udp_posix_waiter_t* const waiter)
+{
+    assert(waiter != NULL);
+    (void)pthread_cond_destroy(&waiter->cond);
+    (void)pthread_mutex_destroy(&waiter->lock);
+}
+
+void cy_udp_posix_waiter_reset(cy_udp_posix_waiter_t* const waiter)
+{
+    assert(waiter != NULL);
+    (void)pthread_mutex_lock(&waiter->lock);
+    waiter->done    = false;
+    waiter->release = NULL;
+    (void)pthread_mutex_unlock(&waiter->lock);
+}
+
+bool cy_udp_posix_waiter_wait(cy_udp_posix_waiter_t* const waiter, const cy_us_t deadline)
+{
+    assert(waiter != NULL);
+    (void)pthread_mutex_lock(&waiter->lock);
+    int rc = 0;
+    while (!waiter->done && (rc == 0)) { // Spurious wakeups are handled by the loop.
+#ifdef __APPLE__
+        const cy_us_t         left = max_i64(0, deadline - cy_udp_posix_now());
+        const struct timespec ts   = { .tv_sec = (time_t)(left / 1000000), .tv_nsec = (long)((left % 1000000) * 1000) };
+        rc                         = pthread_cond_timedwait_relative_np(&waiter->cond, &waiter->lock, &ts);
+#else
+        const struct timespec ts = { .tv_sec  = (time_t)(deadline / 1000000),
+                                     .tv_nsec = (long)((deadline % 1000000) * 1000) };
+        rc                       = pthread_cond_timedwait(&waiter->cond, &waiter->lock, &ts);
+#endif
+    }
+    const bool done = waiter->done;
+    (void)pthread_mutex_unlock(&waiter->lock);
+    return done;
+}
+
+bool cy_udp_posix_waiter_detach(cy_udp_posix_waiter_t* const waiter, const cy_udp_posix_waiter_release_t release)
+{
+    assert((waiter != NULL) && (release != NULL));
+    (void)pthread_mutex_lock(&waiter->lock);
+    const bool done = waiter->done;
+    if (!done) {
+        waiter->release = release;
+    }
+    (void)pthread_mutex_unlock(&waiter->lock);
+    return done;
+}
+
+/// The waiter may be destroyed by the waiting thread as soon as the mutex is released, so it is not touched afterward,
+/// unless it has been detached, in which case nobody else is going to touch it.
+static void waiter_signal(cy_udp_posix_waiter_t* const waiter)
+{
+    assert(waiter != NULL);
+    (void)pthread_mutex_lock(&waiter->lock);
+    const cy_udp_posix_waiter_release_t release = waiter->release;
+    waiter->done                                = true;
+    (void)pthread_cond_signal(&waiter->cond);
+    (void)pthread_mutex_unlock(&waiter->lock);
+    if (release != NULL) {
+        release(waiter);
+    }
+}
+
+void cy_udp_posix_waiter_on_submission(cy_t* const cy, cy_submission_t* const submission)
+{
+    (void)cy;
+    assert(submission != NULL);
+    // If the publication succeeded and a response is expected, the waiter is signaled once the future is resolved.
+    if ((submission->result != CY_OK) || (submission->future == NULL)) {
+        waiter_signal((cy_udp_posix_waiter_t*)submission->user);
+    }
+}
+
+void cy_udp_posix_waiter_on_future(cy_t* const cy, cy_future_t* const future)
+{
+    (void)cy;
+    assert(future != NULL);
+    if (future->state != cy_future_pending) {
+        waiter_signal((cy_udp_posix_waiter_t*)future->user);
+    }
 }
@@ -10,27 +10,179 @@
 #pragma once
 
 #include "udp_wrapper.h"
+#include "block_pool.h"
+#include "tx_queue.h"
 #include <cy_platform.h>
 #include <udpard.h>
+#include <pthread.h>
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-#define CY_UDP_POSIX_IFACE_COUNT_MAX           UDPARD_NETWORK_INTERFACE_COUNT_MAX
+#define CY_UDP_POSIX_IFACE_COUNT_MAX UDPARD_NETWORK_INTERFACE_COUNT_MAX
+
+/// The size of one generation of the node-ID occupancy Bloom filter; the filter holds CY_BLOOM64_GENERATIONS of them.
+/// Every bit stands for a node-ID modulo the filter size, so a larger filter lets a node pick a free node-ID with
+/// fewer collisions in a large network: the default of 8192 bits per generation is comfortable for about 2000 nodes.
+#ifndef CY_UDP_POSIX_NODE_ID_BLOOM_64BIT_WORDS
 #define CY_UDP_POSIX_NODE_ID_BLOOM_64BIT_WORDS 128
+#endif
+
+/// The maximum number of datagrams read from one socket per wakeup (one recvmmsg() call).
+#ifndef CY_UDP_POSIX_RX_BATCH_SIZE
+#define CY_UDP_POSIX_RX_BATCH_SIZE 16
+#endif
+
+/// While a topic has remote reliable publishers, LibUDPard does not deduplicate its transfers, and the copies of the
+/// transfers from the other publishers that arrive via the redundant interfaces are filtered by the last transfer-ID
+/// per source instead; see cy_topic_is_reliable_source(). This is the size of the direct-mapped table of the sources
+/// per topic; the sources that map onto the same entry evict each other, which may let a duplicate through.
+#ifndef CY_UDP_POSIX_RX_DEDUP_SLOTS
+#define CY_UDP_POSIX_RX_DEDUP_SLOTS 8
+#endif
+
+/// The maximum number of datagrams written into one socket per system call (one sendmmsg() call).
+#ifndef CY_UDP_POSIX_TX_BATCH_SIZE
+#define CY_UDP_POSIX_TX_BATCH_SIZE 16
+#endif
+
+/// If enabled, each redundant interface gets a dedicated receive thread that reads the datagrams from the RX sockets
+/// of that interface and hands them over to the core thread via a lock-free SPSC ring. The core thread (the one that
+/// invokes cy_udp_posix_spin_*()) still performs the transfer reassembly and invokes all callbacks, so the threading
+/// semantics of cy_t are unchanged; however, a slow callback no longer stalls the reception.
+/// If the core thread does not keep up and the ring fills up, the newest datagrams are dropped and counted.
+/// Requires POSIX threads.
+#ifndef CY_UDP_POSIX_RX_THREADS
+#define CY_UDP_POSIX_RX_THREADS 0
+#endif
+
+/// If enabled, the datagrams are stamped by the kernel on arrival, so the transfer timestamps do not include the time
+/// the datagram spent in the socket buffer while the application was busy. Where the kernel timestamps are not
+/// available, the time of reading the socket is used instead. The TX departure times used for the latency tracing
+/// are likewise taken from the kernel where possible, otherwise from the time of handing the datagram over to it.
+/// Disabled by default because it changes the meaning of the timestamps seen by the application, and because the
+/// TX departure times are collected from the socket error queue, which costs extra system calls.
+#ifndef CY_UDP_POSIX_KERNEL_TIMESTAMPS
+#define CY_UDP_POSIX_KERNEL_TIMESTAMPS 0
+#endif
+
+/// The number of datagrams that can be in flight between one RX thread and the core thread.
+/// Each slot holds a datagram buffer of CY_UDP_SOCKET_READ_BUFFER_SIZE bytes, which is taken from the datagram pool
+/// if one is configured, so the pool should have at least this many blocks per interface on top of the normal needs.
+#ifndef CY_UDP_POSIX_RX_RING_CAPACITY
+#define CY_UDP_POSIX_RX_RING_CAPACITY 256
+#endif
 
 #ifndef __cplusplus
 typedef struct cy_udp_posix_t       cy_udp_posix_t;
 typedef struct cy_udp_posix_topic_t cy_udp_posix_topic_t;
+typedef struct cy_udp_posix_hub_t   cy_udp_posix_hub_t;
 #endif
 
-struct cy_udp_posix_topic_t
+/// Default block sizes for the fixed-block pools; see cy_udp_posix_pool_config_t.
+/// The sizes of the fragment and session objects are internal to LibUDPard and may vary between versions,
+/// so the defaults are chosen with a margin. An undersized block causes every allocation to fail (counted as OOM).
+#ifndef CY_UDP_POSIX_POOL_FRAGMENT_BLOCK_SIZE
+#define CY_UDP_POSIX_POOL_FRAGMENT_BLOCK_SIZE 128
+#endif
+#ifndef CY_UDP_POSIX_POOL_SESSION_BLOCK_SIZE
+#define CY_UDP_POSIX_POOL_SESSION_BLOCK_SIZE 1024
+#endif
+
+/// Optional fixed-block pools that back the RX path and the TX frames instead of the heap. A zero block count leaves
+/// the corresponding memory on the heap. A zero block size selects the default. The datagram buffers are always of
+/// the socket read buffer size (CY_UDP_SOCKET_READ_BUFFER_SIZE). The TX frame blocks fit one frame of the default MTU;
+/// if the MTU is increased after initialization, the frames will not fit and the transmission will fail (OOM).
+typedef struct cy_udp_posix_pool_config_t
+{
+    size_t tx_frame_block_count;
+    size_t datagram_block_count;
+    size_t fragment_block_count;
+    size_t fragment_block_size;
+    size_t session_block_count;
+    size_t session_block_size;
+} cy_udp_posix_pool_config_t;
+
+/// One memory domain: a fixed-block pool if initialized, otherwise the heap.
+typedef struct cy_udp_posix_mem_t
+{
+    block_pool_t pool;
+
+    size_t allocated_fragments;
+
+    /// Every OOM implies that either a frame or a full transfer were lost.
+    uint64_t oom_count;
+} cy_udp_posix_mem_t;
+
+/// Statistics of the batched socket I/O that help choose the batch sizes.
+/// The mean batch size is datagrams/batches. If most batches are saturated, the batch size should be increased;
+/// if the mean batch size is much lower than the capacity, it can be decreased to save memory.
+typedef struct cy_udp_posix_batch_stats_t
+{
+    uint64_t batches;   ///< System calls that transferred at least one datagram.
+    uint64_t datagrams; ///< Total datagrams transferred, including those dropped by the filters.
+    uint64_t saturated; ///< Batches that used up the entire batch capacity.
+} cy_udp_posix_batch_stats_t;
+
+/// The event loop mode and its statistics; see cy_udp_posix_busy_poll().
+/// The statistics are counted in either mode so that the two can be compared on the same deployment. The iteration
+/// rate is polls/(now-since) and the idle ratio is polls_idle/polls; the application may reset the counters at any
+/// time by zeroing them and setting the start time to cy_udp_posix_now().
+typedef struct cy_udp_posix_spin_t
+{
+    bool     busy;             ///< If set, the event multiplexer is polled without blocking.
+    uint32_t socket_budget_us; ///< SO_BUSY_POLL budget of the RX sockets; zero leaves the system default.
+
+    uint64_t polls;      ///< Event multiplexer polls, i.e., event loop iterations, including the idle ones.
+    uint64_t polls_idle; ///< Polls that returned no events; in the blocking mode, these are the wait timeouts.
+    int64_t  since;      ///< The time when the counting began, initially the time of initialization.
+} cy_udp_posix_spin_t;
+
+/// An RX socket registered with the event multiplexer. The multiplexer yields a pointer to this structure
+/// when the socket becomes readable, so the owner of the socket is found in constant time.
+typedef struct cy_udp_posix_rx_sock_t
+{
+    udp_wrapper_rx_t                handle;
+    cy_udp_posix_topic_t*           topic; ///< NULL for the RPC sockets and for the shared sockets of a hub.
+    cy_udp_posix_t*                 owner; ///< The instance that reads the socket; NULL for the shared sockets.
+    struct cy_udp_posix_rx_group_t* group; ///< The hub socket group this socket belongs to; NULL if not shared.
+    uint_fast8_t                    iface_index;
+    /// Incremented every time the socket is opened. This allows discarding the datagrams that were read by an RX
+    /// thread before the socket was closed and reopened (e.g., for another subject) but not yet processed.
+    uint32_t generation;
+} cy_udp_posix_rx_sock_t;
+
+/// The receiving side of a topic, allocated when the topic is first subscribed and kept until the topic is destroyed,
+/// because the RX threads may still refer to its sockets after the unsubscription. The topics that are only published
+/// on do not carry it; the per-topic overhead of this transport is then limited to cy_udp_posix_topic_t itself.
+/// If the instance is attached to a hub, the sockets of the topic stay closed and the topic joins the socket group
+/// of its subject in the hub instead; the members of a group are linked into a list.
+typedef struct cy_udp_posix_topic_rx_t
 {
-    cy_topic_t                  base;
     struct UdpardRxSubscription sub;
-    udp_wrapper_rx_t            sock_rx[CY_UDP_POSIX_IFACE_COUNT_MAX];
+    cy_udp_posix_rx_sock_t      sock[CY_UDP_POSIX_IFACE_COUNT_MAX];
+
+    /// The transfer-ID timeout requested by the subscribers, applied to LibUDPard unless there are reliable sources.
+    cy_us_t transfer_id_timeout;
+    struct
+    {
+        uint16_t node_id; ///< UDPARD_NODE_ID_UNSET if the entry is unused.
+        uint64_t transfer_id;
+        cy_us_t  ts;
+    } dedup[CY_UDP_POSIX_RX_DEDUP_SLOTS];
+
+    struct cy_udp_posix_rx_group_t* group; ///< NULL unless subscribed via a hub.
+    cy_udp_posix_topic_t*           group_prev;
+    cy_udp_posix_topic_t*           group_next;
+    uint64_t                        group_seq; ///< The last hub datagram sequence number seen by this member.
+} cy_udp_posix_topic_rx_t;
+
+struct cy_udp_posix_topic_t
+{
+    cy_topic_t               base;
+    cy_udp_posix_topic_rx_t* rx; ///< NULL until first subscribed.
 
     /// The count of out-of-memory errors that occurred while processing this topic.
     /// Every OOM implies that either a frame or a full transfer were lost.
@@ -47,36 +199,98 @@ struct cy_udp_posix_t
 {
     cy_t base;
 
+    /// The shared transport context this instance is attached to, NULL if it is standalone; see cy_udp_posix_hub_t.
+    cy_udp_posix_hub_t* hub;
+    cy_udp_posix_t*     hub_next;
+
     /// Maximum seen value across all topics since initialization.
     size_t response_extent_with_overhead;
 
-    uint64_t     node_id_bloom_storage[CY_UDP_POSIX_NODE_ID_BLOOM_64BIT_WORDS];
+    uint64_t     node_id_bloom_storage[CY_UDP_POSIX_NODE_ID_BLOOM_64BIT_WORDS * CY_BLOOM64_GENERATIONS];
     cy_bloom64_t node_id_bloom;
 
+    /// The general-purpose memory is used for the topic objects; it is always heap-backed.
+    /// The TX frames and the RX memory are in separate domains, each optionally backed by its own fixed-block pool.
     struct UdpardMemoryResource    mem;
+    struct UdpardMemoryResource    tx_mem;
     struct UdpardRxMemoryResources rx_mem;
+    cy_udp_posix_mem_t             mem_general;
+    cy_udp_posix_mem_t             mem_tx;
+    cy_udp_posix_mem_t             mem_session;
+    cy_udp_posix_mem_t             mem_fragment;
+    cy_udp_posix_mem_t             mem_datagram;
 
     struct UdpardRxRPCDispatcher rpc_rx_dispatcher;
     struct UdpardRxRPCPort       rpc_rx_port_topic_response;
+    struct UdpardRxRPCPort       rpc_rx_port_reliable_ack;
 
     uint32_t local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX];
 
+    /// All open sockets are registered here once when opened and removed when closed;
+    /// the event loop does not need to enumerate the topics. Unused if the instance is attached to a hub.
+    udp_wrapper_mux_t mux;
+
+    /// Raised by cy_submit() from other threads to unblock the event loop; see cy_platform_wake_t.
+    /// The pending flag avoids redundant signal raises while the event loop is not yet awake. C++ translation units
+    /// see a plain flag of the same layout (enforced in cy_udp_posix.c) and shall not access it.
+    udp_wrapper_signal_t wake_signal;
+#ifndef __cplusplus
+    atomic_bool wake_pending;
+#else
+    bool wake_pending;
+#endif
+
+    /// The maximum transfer payload per frame, excluding the Cyphal/UDP header; the same for all ifaces because the
+    /// frames are shared between them. May be changed at any time; affects only transfers enqueued afterward.
+    size_t mtu;
+
+    /// The DSCP values per priority level, zero by default. May be changed at any time.
+    uint8_t dscp_value_per_priority[TX_QUEUE_PRIORITY_COUNT];
+
     struct
     {
-        struct UdpardTx  udpard_tx;
+        tx_queue_t       queue; ///< Zero capacity if the iface is disabled. The frames are shared between ifaces.
         udp_wrapper_tx_t sock;
         uint16_t         local_port;
         uint64_t         frames_expired; ///< Number of tx frames that have timed out while waiting in the queue.
+        uint64_t         frames_expired_per_priority[TX_QUEUE_PRIORITY_COUNT]; ///< Breakdown of the above.
+        bool             awaiting_writable; ///< Whether the socket is currently registered for writability events.
+
+        /// Frames taken from the head of the queue that are awaiting the next batched send.
+        /// They are sent before the remaining queue contents.
+        tx_frame_t* staged[CY_UDP_POSIX_TX_BATCH_SIZE];
+        size_t      staged_count;
+
+        cy_udp_posix_batch_stats_t batch_stats;
     } tx[CY_UDP_POSIX_IFACE_COUNT_MAX];
 
     struct
     {
-        udp_wrapper_rx_t sock;
+        cy_udp_posix_rx_sock_t sock;
         /// The count of out-of-memory errors that occurred while reading from this socket.
         /// Every OOM implies that either a frame or a full transfer were lost.
         uint64_t oom_count;
     } rpc_rx[CY_UDP_POSIX_IFACE_COUNT_MAX];
 
+    /// RX buffers that were allocated for a batched read but were not filled; they are reused at the next read.
+    /// Each is CY_UDP_SOCKET_READ_BUFFER_SIZE bytes large and is accounted for in the memory statistics.
+    void*  rx_spare[CY_UDP_POSIX_RX_BATCH_SIZE];
+    size_t rx_spare_count;
+
+    /// Aggregated across all RX sockets.
+    cy_udp_posix_batch_stats_t rx_batch_stats;
+
+    /// Unused if the instance is attached to a hub, except the socket budget, which is then set from the hub.
+    cy_udp_posix_spin_t spin;
+
+#if CY_UDP_POSIX_RX_THREADS
+    /// One per enabled iface, NULL otherwise. The contents are private.
+    struct cy_udp_posix_rx_worker_t* rx_worker[CY_UDP_POSIX_IFACE_COUNT_MAX];
+
+    /// Datagrams dropped by the RX threads because the core thread did not keep up. Updated on every spin.
+    uint64_t rx_overrun_count;
+#endif
+
     /// Handler for errors occurring while reading from the socket of the topic on the specified iface.
     /// The default handler is provided which will use CY_TRACE() to report the error.
     /// This is only used to initialize the corresponding field of cy_udp_posix_topic_t when a new topic is created.
@@ -91,13 +305,54 @@ struct cy_udp_posix_t
     /// The default handler is provided which will use CY_TRACE() to report the error.
     void (*tx_sock_err_handler)(cy_udp_posix_t* cy_udp, uint_fast8_t iface_index, uint32_t err_no);
 
+    /// Invoked when the TX queue of the specified iface, after having rejected a transfer at the specified priority
+    /// level, drains down to half of the limit of that level (see tx_queue_t), meaning that the producers of that
+    /// level may resume. The handler may publish. NULL by default.
+    void (*tx_writable_handler)(cy_udp_posix_t* cy_udp, uint_fast8_t iface_index, cy_prio_t priority);
+
     /// Handler for errors occurring while reading from an RPC RX socket on the specified iface.
     /// These are platform-specific.
     /// The default handler is provided which will use CY_TRACE() to report the error.
     void (*rpc_rx_sock_err_handler)(cy_udp_posix_t* topic, uint_fast8_t iface_index, uint32_t err_no);
+};
 
-    size_t   mem_allocated_fragments;
-    uint64_t mem_oom_count;
+/// A shared transport context for several Cy instances running in the same process, such as multiple nodes
+/// simulated on one host or a gateway that joins several namespaces. Without the hub, every instance opens its own
+/// multicast socket per subscribed subject and iface, so the kernel duplicates every datagram into each of them and
+/// each instance runs its own event loop. The members of a hub instead share one RX socket per subject and iface;
+/// the datagrams are demultiplexed in user space into the members subscribed to the subject, except the sender,
+/// and all members are served by one event loop. The TX sockets and the RPC sockets remain per instance, so the
+/// members retain their own node-ID and their own source port, which is how the sender is recognized.
+///
+/// The members are attached using cy_udp_posix_new_shared(); like the instances themselves, they are never detached.
+/// The hub is not available if CY_UDP_POSIX_RX_THREADS is enabled. The contents are private except the statistics.
+struct cy_udp_posix_hub_t
+{
+    uint32_t local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX];
+
+    /// The shared sockets and the sockets of all members are registered here.
+    udp_wrapper_mux_t    mux;
+    udp_wrapper_signal_t wake_signal;
+#ifndef __cplusplus
+    atomic_bool wake_pending; ///< See cy_udp_posix_t.
+#else
+    bool wake_pending;
+#endif
+    cy_udp_posix_spin_t spin;
+
+    cy_udp_posix_t* members; ///< Linked via hub_next, most recently attached first.
+    size_t          member_count;
+
+    /// Indexed by subject-ID; allocated when the subject is first subscribed by any member.
+    struct cy_udp_posix_rx_group_t* groups[CY_TOTAL_SUBJECT_COUNT];
+
+    /// The datagrams are read from the shared sockets into these buffers and then copied into the members.
+    void*    scratch[CY_UDP_POSIX_RX_BATCH_SIZE];
+    uint64_t seq;
+
+    cy_udp_posix_batch_stats_t rx_batch_stats; ///< Aggregated across the shared sockets.
+    uint64_t                   rx_copies;      ///< The number of datagram copies made for the members.
+    uint64_t                   rx_oom_count;   ///< Datagrams lost by some members because they were out of memory.
 };
 
 /// A simple helper that returns monotonic time in microseconds. The time value is always non-negative.
@@ -109,18 +364,22 @@ cy_us_t cy_udp_posix_now(void);
 /// to parse IP addresses from string see udp_wrapper_parse_iface_address().
 ///
 /// The local node ID should be set to CY_NODE_ID_INVALID unless manual configuration is required.
-cy_err_t               cy_udp_posix_new(cy_udp_posix_t* const cy_udp,
-                                        const uint64_t        uid,
-                                        const wkv_str_t       namespace_,
-                                        const uint32_t        local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX],
-                                        const size_t          tx_queue_capacity_per_iface);
-static inline cy_err_t cy_udp_posix_new_c(cy_udp_posix_t* const cy_udp,
-                                          const uint64_t        uid,
-                                          const char* const     namespace_,
-                                          const uint32_t        local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX],
-                                          const size_t          tx_queue_capacity_per_iface)
+///
+/// The pool config may be NULL, in which case all memory is taken from the heap.
+cy_err_t cy_udp_posix_new(cy_udp_posix_t* const                   cy_udp,
+                          const uint64_t                          uid,
+                          const wkv_str_t                         namespace_,
+                          const uint32_t                          local_iface_address[CY_UDP_POSIX_IFACE_COUNT_MAX],
+                          const size_t                            tx_queue_capacity_per_iface,
+                          const cy_udp_posix_pool_config_t* const pools);
+static inline cy_err_t cy_udp_posix_new_c(cy_udp_posix_t* const                   cy_udp,
+                                          const uint64_t                          uid,
+                                          const char* const                       namespace_,
+                                          const uint32_t                          local_iface_address[],
+                                          const size_t                            tx_queue_capacity_per_iface,
+                                          const cy_udp_posix_pool_config_t* const pools)
 {
-    return cy_udp_posix_new(cy_udp, uid, wkv_key(namespace_), local_iface_address, tx_queue_capacity_per_iface);
+    return cy_udp_posix_new(cy_udp, uid, wkv_key(namespace_), local_iface_address, tx_queue_capacity_per_iface, pools);
 }
 
 /// Keep running the event loop until the deadline is reached or until the first error.
@@ -131,9 +390,128 @@ static inline cy_err_t cy_udp_posix_new_c(cy_udp_posix_t* const cy_udp,
 cy_err_t cy_udp_posix_spin_until(cy_udp_posix_t* const cy_udp, const cy_us_t deadline);
 
 /// Wait for events (blocking), process them, and return. Invoke this in a tight superloop to keep the system alive.
-/// The function is guaranteed to return no later than in the heartbeat period, or in a few ms, which ever is sooner.
+/// The function returns when an event is processed or by cy_next_deadline() at the latest, so while the node is idle
+/// it may block for up to the heartbeat period. If the application has its own timers, use the spin_until variant.
 cy_err_t cy_udp_posix_spin_once(cy_udp_posix_t* const cy_udp);
 
+/// The low-latency spin mode for control loops where the wake-up latency of a blocking wait dominates the end-to-end
+/// latency. If enabled, the spin functions poll the event multiplexer without blocking until an event arrives or the
+/// deadline is reached, so the thread running the event loop keeps its core fully loaded even while idle; it should
+/// be pinned to a dedicated core using cy_udp_posix_pin_thread(). The semantics of the spin functions are unchanged.
+/// With the RX threads enabled, only the core thread spins; the RX threads keep blocking.
+///
+/// A nonzero socket budget additionally enables SO_BUSY_POLL on all RX sockets, open and opened afterward, such that
+/// every read polls the device queue directly instead of waiting for the interrupt; this is only available on
+/// GNU/Linux, and the budgets above net.core.busy_read require CAP_NET_ADMIN. For the multiplexer itself to poll the
+/// device queues, the net.core.busy_poll sysctl should be set as well. A zero budget leaves the sockets untouched
+/// unless a nonzero one was set before, in which case SO_BUSY_POLL is reset to zero.
+///
+/// If the instance is attached to a hub, the setting is applied to the hub; see cy_udp_posix_hub_busy_poll().
+/// Returns CY_ERR_MEDIA if the budget could not be applied to some of the open sockets; the mode is changed anyway.
+/// The sockets opened afterward are configured on a best-effort basis.
+cy_err_t cy_udp_posix_busy_poll(cy_udp_posix_t* const cy_udp, const bool enabled, const uint32_t socket_budget_us);
+
+/// Restricts the calling thread to the specified CPU core; meant for the thread running a busy-polled event loop.
+/// Returns CY_ERR_ARGUMENT if the core does not exist or if the platform does not support thread affinity
+/// (only GNU/Linux does at the moment).
+cy_err_t cy_udp_posix_pin_thread(const uint16_t cpu);
+
+#if !CY_UDP_POSIX_RX_THREADS
+/// Initializes the hub on the specified ifaces; the same conventions apply as in cy_udp_posix_new().
+/// The hub shall not be moved while in use. Returns CY_ERR_MEDIA if the event multiplexer could not be created.
+cy_err_t cy_udp_posix_hub_new(cy_udp_posix_hub_t* const hub, const uint32_t local_iface_address[]);
+
+/// Closes the shared sockets and frees the memory held by the hub. The members shall not be used afterward.
+void cy_udp_posix_hub_destroy(cy_udp_posix_hub_t* const hub);
+
+/// Like cy_udp_posix_new(), but the new instance is attached to the hub and uses its ifaces.
+cy_err_t cy_udp_posix_new_shared(cy_udp_posix_t* const                   cy_udp,
+                                 cy_udp_posix_hub_t* const               hub,
+                                 const uint64_t                          uid,
+                                 const wkv_str_t                         namespace_,
+                                 const size_t                            tx_queue_capacity_per_iface,
+                                 const cy_udp_posix_pool_config_t* const pools);
+static inline cy_err_t cy_udp_posix_new_shared_c(cy_udp_posix_t* const                   cy_udp,
+                                                 cy_udp_posix_hub_t* const               hub,
+                                                 const uint64_t                          uid,
+                                                 const char* const                       namespace_,
+                                                 const size_t                            tx_queue_capacity_per_iface,
+                                                 const cy_udp_posix_pool_config_t* const pools)
+{
+    return cy_udp_posix_new_shared(cy_udp, hub, uid, wkv_key(namespace_), tx_queue_capacity_per_iface, pools);
+}
+
+/// The event loop of all members of the hub; the semantics are the same as of the standalone variants.
+/// The spin functions of a member delegate here, so serving any one member serves all of them.
+cy_err_t cy_udp_posix_hub_spin_until(cy_udp_posix_hub_t* const hub, const cy_us_t deadline);
+cy_err_t cy_udp_posix_hub_spin_once(cy_udp_posix_hub_t* const hub);
+
+/// Same as cy_udp_posix_busy_poll() but for the hub event loop; the budget is applied to the shared sockets
+/// and to the sockets of all members, including those attached afterward.
+cy_err_t cy_udp_posix_hub_busy_poll(cy_udp_posix_hub_t* const hub, const bool enabled, const uint32_t socket_budget_us);
+#endif
+
+/// The number of frames that a new transfer at the specified priority level would have to wait behind on the iface:
+/// those enqueued at this and the more important levels, including the ones staged for the next send.
+/// Zero if the iface is disabled or the arguments are invalid.
+size_t cy_udp_posix_tx_backlog(const cy_udp_posix_t* const cy_udp,
+                               const uint_fast8_t          iface_index,
+                               const cy_prio_t             priority);
+
+/// The number of frames that can be enqueued on the iface at the specified priority level before the transfers of
+/// that level are rejected with CY_ERR_CAPACITY. A producer can use this to slow down ahead of time instead of
+/// building up a backlog that would expire in the queue. Zero if the iface is disabled or the arguments are invalid.
+size_t cy_udp_posix_tx_headroom(const cy_udp_posix_t* const cy_udp,
+                                const uint_fast8_t          iface_index,
+                                const cy_prio_t             priority);
+
+/// Load shedding policy: once the TX queue of an iface holds this many frames, the transfers at cy_prio_slow and
+/// cy_prio_optional are rejected so that the rest of the capacity is kept for the more important traffic,
+/// whose queueing latency then stays low under overload. SIZE_MAX disables the shedding, which is the default.
+/// The per-level limits of the queues can also be adjusted individually; see tx_queue_t.
+void cy_udp_posix_tx_shed(cy_udp_posix_t* const cy_udp, const size_t threshold);
+
+/// A completion event that lets a thread other than the event loop block until its submission (see cy_submit())
+/// is published and, if a response is expected, until the response future is resolved, without polling.
+/// The waiter is referenced by the user pointers of the submission and of the future, and the callbacks below
+/// are used as their callbacks. Once the wait returns true, the submission and the future belong to the submitter
+/// again: the outcome is in the result field of the submission and in the state of the future.
+///
+/// The callbacks touch the waiter after the wait has timed out, so the waiter (and the submission and the future)
+/// shall outlive them; a submitter that stops waiting shall hand the waiter over using cy_udp_posix_waiter_detach().
+struct cy_udp_posix_waiter_t;
+typedef void (*cy_udp_posix_waiter_release_t)(struct cy_udp_posix_waiter_t*);
+typedef struct cy_udp_posix_waiter_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    bool            done;
+
+    /// Set by cy_udp_posix_waiter_detach(), NULL otherwise.
+    cy_udp_posix_waiter_release_t release;
+} cy_udp_posix_waiter_t;
+
+/// On error returns CY_ERR_MEDIA. The waiter shall be destroyed when no longer needed.
+cy_err_t cy_udp_posix_waiter_init(cy_udp_posix_waiter_t* const waiter);
+void     cy_udp_posix_waiter_destroy(cy_udp_posix_waiter_t* const waiter);
+
+/// Shall be invoked before every new submission that reuses the waiter.
+void cy_udp_posix_waiter_reset(cy_udp_posix_waiter_t* const waiter);
+
+/// Blocks until the waiter is signaled or until the deadline (per cy_udp_posix_now()); returns whether signaled.
+bool cy_udp_posix_waiter_wait(cy_udp_posix_waiter_t* const waiter, const cy_us_t deadline);
+
+/// Lets the submitter give up on a waiter whose wait has timed out. Returns true if the waiter has been signaled
+/// meanwhile, in which case it belongs to the submitter as usual. Otherwise, the submitter shall no longer touch
+/// the waiter, the submission, and the future; the release callback is invoked from the event loop thread right
+/// after the waiter is signaled, and it is responsible for destroying the waiter and disposing of its storage.
+bool cy_udp_posix_waiter_detach(cy_udp_posix_waiter_t* const waiter, const cy_udp_posix_waiter_release_t release);
+
+/// The submission callback signals the waiter unless the submission has a future that is to be resolved later;
+/// the future callback signals it when the future is resolved. Both are invoked from the event loop thread.
+void cy_udp_posix_waiter_on_submission(cy_t* const cy, cy_submission_t* const submission);
+void cy_udp_posix_waiter_on_future(cy_t* const cy, cy_future_t* const future);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,103 @@
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#include "spsc_ring.h"
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The indexes are placed in separate cache lines of this size.
+#define CACHE_LINE_SIZE 64U
+
+/// The indexes grow monotonically and wrap around at SIZE_MAX+1, which is a multiple of the capacity.
+/// The ring is empty if they are equal and full if they differ by the capacity.
+struct spsc_ring_impl_t
+{
+    alignas(CACHE_LINE_SIZE) _Atomic size_t head; ///< Next item to pop; written by the consumer only.
+    alignas(CACHE_LINE_SIZE) _Atomic size_t tail; ///< Next slot to push; written by the producer only.
+    alignas(CACHE_LINE_SIZE) size_t item_size;
+    size_t         mask;
+    unsigned char* storage;
+};
+
+spsc_ring_t spsc_ring_new(void)
+{
+    return (spsc_ring_t){ .impl = NULL };
+}
+
+bool spsc_ring_is_initialized(const spsc_ring_t* const self)
+{
+    return (self != NULL) && (self->impl != NULL);
+}
+
+int16_t spsc_ring_init(spsc_ring_t* const self, const size_t item_size, const size_t capacity)
+{
+    if ((self == NULL) || (item_size == 0) || (capacity == 0) || (capacity > (SIZE_MAX / 2U))) {
+        return -EINVAL;
+    }
+    size_t cap = 1;
+    while (cap < capacity) {
+        cap <<= 1U;
+    }
+    if (item_size > (SIZE_MAX / cap)) {
+        return -EINVAL;
+    }
+    // aligned_alloc() requires the size to be a multiple of the alignment; the struct size is such by construction.
+    struct spsc_ring_impl_t* const impl = aligned_alloc(alignof(struct spsc_ring_impl_t), sizeof(*impl));
+    if (impl == NULL) {
+        return -ENOMEM;
+    }
+    impl->storage = malloc(item_size * cap);
+    if (impl->storage == NULL) {
+        free(impl);
+        return -ENOMEM;
+    }
+    impl->item_size = item_size;
+    impl->mask      = cap - 1U;
+    atomic_init(&impl->head, 0U);
+    atomic_init(&impl->tail, 0U);
+    self->impl = impl;
+    return 0;
+}
+
+bool spsc_ring_push(spsc_ring_t* const self, const void* const item)
+{
+    struct spsc_ring_impl_t* const impl = self->impl;
+    const size_t                   tail = atomic_load_explicit(&impl->tail, memory_order_relaxed);
+    const size_t                   head = atomic_load_explicit(&impl->head, memory_order_acquire);
+    if ((tail - head) > impl->mask) {
+        return false; // Full.
+    }
+    memcpy(&impl->storage[(tail & impl->mask) * impl->item_size], item, impl->item_size);
+    atomic_store_explicit(&impl->tail, tail + 1U, memory_order_release); // Publish the item to the consumer.
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t* const self, void* const out_item)
+{
+    struct spsc_ring_impl_t* const impl = self->impl;
+    const size_t                   head = atomic_load_explicit(&impl->head, memory_order_relaxed);
+    const size_t                   tail = atomic_load_explicit(&impl->tail, memory_order_acquire);
+    if (head == tail) {
+        return false; // Empty.
+    }
+    memcpy(out_item, &impl->storage[(head & impl->mask) * impl->item_size], impl->item_size);
+    atomic_store_explicit(&impl->head, head + 1U, memory_order_release); // Hand the slot back to the producer.
+    return true;
+}
+
+size_t spsc_ring_capacity(const spsc_ring_t* const self)
+{
+    return spsc_ring_is_initialized(self) ? (self->impl->mask + 1U) : 0U;
+}
+
+void spsc_ring_close(spsc_ring_t* const self)
+{
+    if (spsc_ring_is_initialized(self)) {
+        free(self->impl->storage);
+        free(self->impl);
+        self->impl = NULL;
+    }
+}
@@ -0,0 +1,62 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// A bounded lock-free single-producer single-consumer ring of fixed-size items.
+/// The storage is allocated once at initialization; push and pop are constant-time and never block or allocate.
+/// Exactly one thread may push and exactly one (possibly other) thread may pop at any given time.
+///
+/// The producer and consumer indexes are kept in separate cache lines to avoid false sharing between the threads.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef __cplusplus
+typedef struct spsc_ring_t spsc_ring_t;
+#endif
+
+/// The contents are private; the implementation details are hidden to keep the atomics out of the header.
+struct spsc_ring_t
+{
+    struct spsc_ring_impl_t* impl;
+};
+
+/// Helper for constructing an uninitialized handle.
+spsc_ring_t spsc_ring_new(void);
+
+/// Return false unless the ring has been successfully initialized and not yet closed.
+bool spsc_ring_is_initialized(const spsc_ring_t* const self);
+
+/// The capacity will be rounded up to a power of two. The item size and capacity shall be positive.
+/// On error returns a negative error code.
+int16_t spsc_ring_init(spsc_ring_t* const self, const size_t item_size, const size_t capacity);
+
+/// Producer side. Copies the item into the ring. Returns false if the ring is full.
+bool spsc_ring_push(spsc_ring_t* const self, const void* const item);
+
+/// Consumer side. Copies the oldest item out of the ring. Returns false if the ring is empty.
+bool spsc_ring_pop(spsc_ring_t* const self, void* const out_item);
+
+/// The capacity after the rounding; zero if not initialized.
+size_t spsc_ring_capacity(const spsc_ring_t* const self);
+
+/// No effect if the argument is invalid. The ring shall not be in use by either side.
+/// This function is guaranteed to invalidate the handle.
+void spsc_ring_close(spsc_ring_t* const self);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,299 @@
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#include "tx_queue.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#define HEADER_VERSION       1U
+#define HEADER_CRC_SIZE      2U
+#define FRAME_INDEX_EOT_MASK 0x80000000UL
+#define BYTE_WIDTH           8U
+#define BYTE_MASK            0xFFU
+
+/// The checksums are computed nibble-wise; this is several times faster than the bitwise method while the tables
+/// are small enough to stay in the L1 cache.
+static const uint16_t g_crc16_ccitt_nibble[16] = {
+    0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50A5U, 0x60C6U, 0x70E7U,
+    0x8108U, 0x9129U, 0xA14AU, 0xB16BU, 0xC18CU, 0xD1ADU, 0xE1CEU, 0xF1EFU,
+};
+static const uint32_t g_crc32c_nibble[16] = {
+    0x00000000UL, 0x105EC76FUL, 0x20BD8EDEUL, 0x30E349B1UL, 0x417B1DBCUL, 0x5125DAD3UL, 0x61C69362UL, 0x7198540DUL,
+    0x82F63B78UL, 0x92A8FC17UL, 0xA24BB5A6UL, 0xB21572C9UL, 0xC38D26C4UL, 0xD3D3E1ABUL, 0xE330A81AUL, 0xF36E6F75UL,
+};
+
+/// CRC-16/CCITT-FALSE; the initial value is 0xFFFF.
+static uint16_t crc16_add(uint16_t crc, const size_t size, const unsigned char* const data)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc = (uint16_t)((unsigned)(crc << 4U) ^ g_crc16_ccitt_nibble[((crc >> 12U) ^ (data[i] >> 4U)) & 0xFU]);
+        crc = (uint16_t)((unsigned)(crc << 4U) ^ g_crc16_ccitt_nibble[((crc >> 12U) ^ data[i]) & 0xFU]);
+    }
+    return crc;
+}
+
+/// CRC-32C without the output XOR; the initial value is 0xFFFFFFFF.
+static uint32_t crc32c_add(uint32_t crc, const size_t size, const unsigned char* const data)
+{
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 4U) ^ g_crc32c_nibble[(crc ^ data[i]) & 0xFU];
+        crc = (crc >> 4U) ^ g_crc32c_nibble[(crc ^ (data[i] >> 4U)) & 0xFU];
+    }
+    return crc;
+}
+
+static unsigned char* serialize_u16(unsigned char* ptr, const uint16_t value)
+{
+    *ptr++ = (unsigned char)(value & BYTE_MASK);
+    *ptr++ = (unsigned char)((value >> BYTE_WIDTH) & BYTE_MASK);
+    return ptr;
+}
+
+static unsigned char* serialize_u32(unsigned char* ptr, const uint32_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * BYTE_WIDTH)) & BYTE_MASK);
+    }
+    return ptr;
+}
+
+static unsigned char* serialize_u64(unsigned char* ptr, const uint64_t value)
+{
+    for (size_t i = 0; i < sizeof(value); i++) {
+        *ptr++ = (unsigned char)((value >> (i * BYTE_WIDTH)) & BYTE_MASK);
+    }
+    return ptr;
+}
+
+static void serialize_header(unsigned char* const       buffer,
+                             const tx_transfer_t* const tr,
+                             const uint32_t             frame_index,
+                             const bool                 end_of_transfer)
+{
+    unsigned char* ptr = buffer;
+    *ptr++             = HEADER_VERSION;
+    *ptr++             = (unsigned char)tr->priority;
+    ptr                = serialize_u16(ptr, tr->source_node_id);
+    ptr                = serialize_u16(ptr, tr->destination_node_id);
+    ptr                = serialize_u16(ptr, tr->data_specifier);
+    ptr                = serialize_u64(ptr, tr->transfer_id);
+    ptr                = serialize_u32(ptr, frame_index | (end_of_transfer ? FRAME_INDEX_EOT_MASK : 0U));
+    ptr                = serialize_u16(ptr, 0); // opaque user data
+    // The header CRC is big-endian, unlike the rest of the header.
+    const uint16_t crc = crc16_add(0xFFFFU, TX_FRAME_HEADER_SIZE - HEADER_CRC_SIZE, buffer);
+    *ptr++             = (unsigned char)((crc >> BYTE_WIDTH) & BYTE_MASK);
+    *ptr++             = (unsigned char)(crc & BYTE_MASK);
+    assert(ptr == (buffer + TX_FRAME_HEADER_SIZE));
+}
+
+/// Reads the payload stream sequentially from the fragment chain.
+typedef struct
+{
+    const cy_buffer_borrowed_t* frag;
+    size_t                      offset;
+} payload_reader_t;
+
+static size_t payload_read(payload_reader_t* const self, const size_t size, unsigned char* const out)
+{
+    size_t done = 0;
+    while ((done < size) && (self->frag != NULL)) {
+        const size_t chunk = self->frag->view.size - self->offset;
+        const size_t n     = ((size - done) < chunk) ? (size - done) : chunk;
+        if (n > 0) {
+            memcpy(&out[done], ((const unsigned char*)self->frag->view.data) + self->offset, n);
+        }
+        done += n;
+        self->offset += n;
+        if (self->offset >= self->frag->view.size) {
+            self->frag   = self->frag->next;
+            self->offset = 0;
+        }
+    }
+    return done;
+}
+
+tx_queue_t tx_queue_new(const size_t capacity, const uint_fast8_t link)
+{
+    assert(link < TX_QUEUE_LINK_COUNT);
+    tx_queue_t out = { .size = 0, .capacity = capacity, .link = link, .blocked = 0 };
+    for (size_t i = 0; i < TX_QUEUE_PRIORITY_COUNT; i++) {
+        out.head[i]              = NULL;
+        out.tail[i]              = NULL;
+        out.limit[i]             = SIZE_MAX;
+        out.size_per_priority[i] = 0;
+        out.rejected[i]          = 0;
+    }
+    return out;
+}
+
+size_t tx_queue_backlog(const tx_queue_t* const self, const cy_prio_t priority)
+{
+    size_t out = 0;
+    for (size_t i = 0; (i <= (size_t)priority) && (i < TX_QUEUE_PRIORITY_COUNT); i++) {
+        out += self->size_per_priority[i];
+    }
+    return out;
+}
+
+void tx_frame_release(tx_frame_t* const frame, const struct UdpardMemoryResource memory)
+{
+    if (frame != NULL) {
+        assert(frame->refcount > 0);
+        frame->refcount--;
+        if (frame->refcount == 0) {
+            memory.deallocate(memory.user_reference, frame->allocation_size, frame);
+        }
+    }
+}
+
+static void free_chain(tx_frame_t* head, const struct UdpardMemoryResource memory)
+{
+    while (head != NULL) {
+        tx_frame_t* const next = head->next[0];
+        memory.deallocate(memory.user_reference, head->allocation_size, head);
+        head = next;
+    }
+}
+
+int32_t tx_queue_push(const size_t                      queue_count,
+                      tx_queue_t* const                 queues[],
+                      const size_t                      mtu,
+                      const tx_transfer_t* const        transfer,
+                      const cy_buffer_borrowed_t        payload,
+                      const struct UdpardMemoryResource memory)
+{
+    if ((queue_count > TX_QUEUE_LINK_COUNT) || (queues == NULL) || (mtu <= TX_TRANSFER_CRC_SIZE) ||
+        (transfer == NULL) || (((size_t)transfer->priority) >= TX_QUEUE_PRIORITY_COUNT)) {
+        return -EINVAL;
+    }
+    const size_t payload_size = cy_buffer_borrowed_size(payload);
+    const size_t stream_size  = payload_size + TX_TRANSFER_CRC_SIZE;
+    const size_t frame_count  = (stream_size + mtu - 1U) / mtu;
+    if ((frame_count > 1) && (transfer->source_node_id > UDPARD_NODE_ID_MAX)) {
+        return -EINVAL; // Anonymous transfers cannot be multi-frame.
+    }
+
+    // Decide which queues will take the transfer before allocating anything.
+    bool         take[TX_QUEUE_LINK_COUNT] = { 0 };
+    int32_t      rejected                  = 0;
+    size_t       accepted                  = 0;
+    for (size_t i = 0; i < queue_count; i++) {
+        assert((queues[i] != NULL) && (queues[i]->link < TX_QUEUE_LINK_COUNT));
+        if (queues[i]->capacity > 0) {
+            take[i] = (queues[i]->size + frame_count) <= tx_queue_limit(queues[i], transfer->priority);
+            accepted += take[i] ? 1U : 0U;
+            rejected += take[i] ? 0 : 1;
+            if (!take[i]) {
+                queues[i]->rejected[(size_t)transfer->priority]++;
+                queues[i]->blocked |= 1UL << (unsigned)transfer->priority;
+            }
+        }
+    }
+    if (accepted == 0) {
+        return rejected;
+    }
+
+    // Serialize the frames into a temporary chain linked via the first link, computing the transfer CRC on the go.
+    // The CRC is appended to the stream after the payload, so it may straddle the last two frames.
+    payload_reader_t reader    = { .frag = &payload, .offset = 0 };
+    uint32_t         crc       = 0xFFFFFFFFUL;
+    tx_frame_t*      chain     = NULL;
+    tx_frame_t*      last      = NULL;
+    size_t           remaining = stream_size;
+    for (uint32_t index = 0; remaining > 0; index++) {
+        const size_t      chunk = (remaining < mtu) ? remaining : mtu;
+        const size_t      alloc = sizeof(tx_frame_t) + TX_FRAME_HEADER_SIZE + chunk;
+        tx_frame_t* const frame = memory.allocate(memory.user_reference, alloc);
+        if (frame == NULL) {
+            free_chain(chain, memory);
+            return -ENOMEM;
+        }
+        memset(frame, 0, sizeof(tx_frame_t));
+        frame->deadline        = transfer->deadline;
+        frame->ts_enqueued     = transfer->ts_enqueued;
+        frame->remote_address  = transfer->remote_address;
+        frame->remote_port     = transfer->remote_port;
+        frame->priority        = transfer->priority;
+        frame->probe           = (chunk == remaining) ? transfer->probe : 0U;
+        frame->allocation_size = alloc;
+        frame->size            = TX_FRAME_HEADER_SIZE + chunk;
+        frame->data            = ((unsigned char*)frame) + sizeof(tx_frame_t);
+        serialize_header(frame->data, transfer, index, chunk == remaining);
+        unsigned char* const out = frame->data + TX_FRAME_HEADER_SIZE;
+        const size_t         got = payload_read(&reader, chunk, out);
+        crc                      = crc32c_add(crc, got, out);
+        if (got < chunk) { // This frame contains (a part of) the transfer CRC; remaining-got bytes of it are pending.
+            unsigned char crc_bytes[TX_TRANSFER_CRC_SIZE];
+            (void)serialize_u32(crc_bytes, crc ^ 0xFFFFFFFFUL);
+            memcpy(&out[got], &crc_bytes[TX_TRANSFER_CRC_SIZE - (remaining - got)], chunk - got);
+        }
+        remaining -= chunk;
+        if (last == NULL) {
+            chain = frame;
+        } else {
+            last->next[0] = frame;
+        }
+        last = frame;
+    }
+
+    // Link the frames into the accepting queues. No allocation or failure is possible past this point.
+    // The first link is overwritten last because it is used to walk the temporary chain.
+    for (tx_frame_t* frame = chain; frame != NULL;) {
+        tx_frame_t* const next = frame->next[0];
+        frame->next[0]         = NULL;
+        for (size_t i = 0; i < queue_count; i++) {
+            if (take[i]) {
+                tx_queue_t* const q    = queues[i];
+                const size_t      prio = (size_t)frame->priority;
+                frame->next[q->link]   = NULL;
+                if (q->tail[prio] != NULL) {
+                    q->tail[prio]->next[q->link] = frame;
+                } else {
+                    q->head[prio] = frame;
+                }
+                q->tail[prio] = frame;
+                q->size++;
+                q->size_per_priority[prio]++;
+                frame->refcount++;
+            }
+        }
+        frame = next;
+    }
+    return rejected;
+}
+
+tx_frame_t* tx_queue_peek(const tx_queue_t* const self)
+{
+    for (size_t i = 0; i < TX_QUEUE_PRIORITY_COUNT; i++) {
+        if (self->head[i] != NULL) {
+            return self->head[i];
+        }
+    }
+    return NULL;
+}
+
+tx_frame_t* tx_queue_pop(tx_queue_t* const self)
+{
+    tx_frame_t* const frame = tx_queue_peek(self);
+    if (frame != NULL) {
+        const size_t prio = (size_t)frame->priority;
+        self->head[prio]  = frame->next[self->link];
+        if (self->head[prio] == NULL) {
+            self->tail[prio] = NULL;
+        }
+        frame->next[self->link] = NULL;
+        assert((self->size > 0) && (self->size_per_priority[prio] > 0));
+        self->size--;
+        self->size_per_priority[prio]--;
+    }
+    return frame;
+}
+
+void tx_queue_purge(tx_queue_t* const self, const struct UdpardMemoryResource memory)
+{
+    tx_frame_t* frame = NULL;
+    while ((frame = tx_queue_pop(self)) != NULL) {
+        tx_frame_release(frame, memory);
+    }
+}
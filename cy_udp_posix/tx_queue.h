@@ -0,0 +1,166 @@
+///                            ____                   ______            __          __
+///                           / __ `____  ___  ____  / ____/_  ______  / /_  ____  / /
+///                          / / / / __ `/ _ `/ __ `/ /   / / / / __ `/ __ `/ __ `/ /
+///                         / /_/ / /_/ /  __/ / / / /___/ /_/ / /_/ / / / / /_/ / /
+///                         `____/ .___/`___/_/ /_/`____/`__, / .___/_/ /_/`__,_/_/
+///                             /_/                     /____/_/
+///
+/// Cyphal/UDP transmission pipeline with scatter-gather serialization and frames shared between redundant interfaces.
+///
+/// LibUDPard v2 accepts only contiguous payloads and serializes a separate copy of every frame per interface.
+/// Here, the frames are serialized directly from the scattered payload fragments, once per transfer, and the same
+/// frame object is then linked into the queue of every redundant interface; it is reference-counted and freed when
+/// the last interface is done with it. The payload is thus copied exactly once regardless of the interface count.
+///
+/// Each queue is a set of intrusive FIFO lists, one per priority level, so push and pop are constant-time.
+/// The wire format is as defined by the Cyphal/UDP specification and is identical to that of LibUDPard.
+///
+/// Copyright (c) Pavel Kirienko <pavel@opencyphal.org>
+
+#pragma once
+
+#include <cy.h>
+#include <udpard.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TX_QUEUE_LINK_COUNT     UDPARD_NETWORK_INTERFACE_COUNT_MAX
+#define TX_QUEUE_PRIORITY_COUNT 8U
+
+/// The Cyphal/UDP header that prefixes every frame.
+#define TX_FRAME_HEADER_SIZE 24U
+
+/// The transfer CRC that follows the payload; a transfer is single-frame if its payload plus this fits into the MTU.
+#define TX_TRANSFER_CRC_SIZE 4U
+
+/// Cyphal/UDP transport model constants per the specification.
+#define TX_UDP_PORT                      9382U
+#define TX_MULTICAST_PREFIX              0xEF000000UL
+#define TX_MULTICAST_SERVICE_MASK        0x00010000UL
+#define TX_DATA_SPECIFIER_SERVICE        0x8000U
+#define TX_DATA_SPECIFIER_REQUEST        0x4000U
+#define TX_SUBJECT_ID_MASK               0x7FFFU
+#define TX_NODE_ID_MASK                  0xFFFFU
+
+#ifndef __cplusplus
+typedef struct tx_frame_t    tx_frame_t;
+typedef struct tx_queue_t    tx_queue_t;
+typedef struct tx_transfer_t tx_transfer_t;
+#endif
+
+/// One serialized datagram shared by reference among the queues of the redundant interfaces.
+/// The data is in the same allocation as the frame object itself.
+struct tx_frame_t
+{
+    tx_frame_t*    next[TX_QUEUE_LINK_COUNT]; ///< Intrusive links of the queues, one per interface.
+    cy_us_t        deadline;                  ///< Zero if the frame never expires.
+    cy_us_t        ts_enqueued;               ///< Copied from the transfer.
+    uint32_t       remote_address;
+    uint16_t       remote_port;
+    cy_prio_t      priority;
+    uint32_t       probe;                     ///< Latency probe token of the transfer; only on the last frame.
+    uint_fast8_t   refcount;
+    size_t         allocation_size;
+    size_t         size;
+    unsigned char* data;
+};
+
+/// The queue of one interface. The link index selects the frame link used by this queue; it shall be unique
+/// among the queues that may share frames, which normally means that it equals the interface index.
+///
+/// A transfer is admitted only if the fill level of the queue stays within the limit of its priority level after
+/// the transfer is enqueued. The limits are SIZE_MAX by default, meaning that only the capacity applies; setting
+/// lower limits for the less important levels reserves the rest of the capacity for the more important traffic.
+/// The limits are checked before the frames are serialized, so a rejected transfer costs nothing.
+struct tx_queue_t
+{
+    tx_frame_t*  head[TX_QUEUE_PRIORITY_COUNT];
+    tx_frame_t*  tail[TX_QUEUE_PRIORITY_COUNT];
+    size_t       size;     ///< The number of frames currently enqueued.
+    size_t       capacity; ///< Zero capacity disables the queue.
+    uint_fast8_t link;
+
+    size_t limit[TX_QUEUE_PRIORITY_COUNT];
+    size_t size_per_priority[TX_QUEUE_PRIORITY_COUNT];
+
+    /// The number of transfers not admitted due to the capacity or the limit, per priority level.
+    uint64_t rejected[TX_QUEUE_PRIORITY_COUNT];
+    /// One bit per priority level, set when a transfer of that level is rejected. Cleared by the owner of the queue
+    /// once the queue has drained enough to admit that level again; in cy_udp_posix, by tx_notify_writable().
+    uint32_t blocked;
+};
+
+/// The parameters of one outgoing transfer. Use the helpers below to populate the endpoint and data specifier.
+struct tx_transfer_t
+{
+    cy_us_t   deadline;
+    cy_us_t   ts_enqueued; ///< Only used for the queue latency statistics.
+    cy_prio_t priority;
+    uint16_t  source_node_id;      ///< UDPARD_NODE_ID_UNSET if anonymous; anonymous transfers are single-frame.
+    uint16_t  destination_node_id; ///< UDPARD_NODE_ID_UNSET for broadcast transfers.
+    uint16_t  data_specifier;
+    uint64_t  transfer_id;
+    uint32_t  remote_address;
+    uint16_t  remote_port;
+    uint32_t  probe; ///< Zero unless the departure time of the transfer is to be reported; see cy_notify_tx_departure.
+};
+
+tx_queue_t tx_queue_new(const size_t capacity, const uint_fast8_t link);
+
+/// Serializes the transfer into frames of at most TX_FRAME_HEADER_SIZE+mtu bytes each and pushes the same frames
+/// into every queue that has sufficient free capacity. Disabled queues (zero capacity) are skipped silently.
+/// The payload is read directly from the fragments; no intermediate contiguous buffer is made.
+///
+/// Returns the number of queues that did not accept the transfer due to insufficient capacity (normally zero),
+/// or a negative error code: -EINVAL if the arguments are invalid, -ENOMEM if the frames could not be allocated.
+/// The queues are not modified if an error is returned.
+int32_t tx_queue_push(const size_t                      queue_count,
+                      tx_queue_t* const                 queues[],
+                      const size_t                      mtu,
+                      const tx_transfer_t* const        transfer,
+                      const cy_buffer_borrowed_t        payload,
+                      const struct UdpardMemoryResource memory);
+
+/// The maximum fill level at which a transfer of the specified priority level is admitted: min(capacity, limit).
+static inline size_t tx_queue_limit(const tx_queue_t* const self, const cy_prio_t priority)
+{
+    const size_t limit = self->limit[(size_t)priority];
+    return (limit < self->capacity) ? limit : self->capacity;
+}
+
+/// The number of frames enqueued at the specified priority level and all more important levels; i.e., the number
+/// of frames that a new frame of the specified level would have to wait behind. Linear in the number of levels.
+size_t tx_queue_backlog(const tx_queue_t* const self, const cy_prio_t priority);
+
+/// The highest-priority frame that has been waiting for the longest time, or NULL if the queue is empty.
+tx_frame_t* tx_queue_peek(const tx_queue_t* const self);
+
+/// Removes the frame returned by tx_queue_peek() from the queue. The frame reference held by the queue is passed
+/// to the caller, who is responsible for releasing it via tx_frame_release() once done.
+tx_frame_t* tx_queue_pop(tx_queue_t* const self);
+
+/// Drops one reference; the frame is freed when the last reference is dropped. NULL is ignored.
+void tx_frame_release(tx_frame_t* const frame, const struct UdpardMemoryResource memory);
+
+/// Releases all enqueued frames; the queue remains usable.
+void tx_queue_purge(tx_queue_t* const self, const struct UdpardMemoryResource memory);
+
+static inline uint32_t tx_subject_address(const uint16_t subject_id)
+{
+    return (uint32_t)(TX_MULTICAST_PREFIX | (subject_id & TX_SUBJECT_ID_MASK));
+}
+static inline uint32_t tx_service_address(const uint16_t destination_node_id)
+{
+    return (uint32_t)(TX_MULTICAST_PREFIX | TX_MULTICAST_SERVICE_MASK | (destination_node_id & TX_NODE_ID_MASK));
+}
+static inline uint16_t tx_service_data_specifier(const uint16_t service_id, const bool request)
+{
+    return (uint16_t)(TX_DATA_SPECIFIER_SERVICE | (request ? TX_DATA_SPECIFIER_REQUEST : 0U) | service_id);
+}
+
+#ifdef __cplusplus
+}
+#endif
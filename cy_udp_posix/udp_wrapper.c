@@ -4,6 +4,11 @@
 /// SPDX-License-Identifier: MIT
 /// Author: Pavel Kirienko <pavel@opencyphal.org>
 
+/// Enable recvmmsg() and sendmmsg() on GNU/Linux. Unlike the other feature macros, this one must precede all includes.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+#endif
+
 #include "udp_wrapper.h"
 
 /// Enable SO_REUSEPORT.
@@ -18,9 +23,35 @@
 #include <net/if.h>
 #include <unistd.h>
 #include <poll.h>
+#include <time.h>
 #include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#define MUX_EPOLL    1
+#define HAS_MMSG     1
+#define HAS_TX_STAMP 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || \
+  defined(__DragonFly__)
+#include <sys/event.h>
+#define MUX_EPOLL    0
+#define HAS_MMSG     0
+#define HAS_TX_STAMP 0
+#else
+#error "udp_wrapper_mux requires either epoll or kqueue"
+#endif
+
+/// The number of kernel events fetched per system call in udp_wrapper_mux_wait().
+#define MUX_WAIT_CHUNK 64
+
+/// The maximum number of datagrams transferred per system call by the batched I/O functions.
+/// Larger batches supplied by the caller are truncated to this size; the caller will see a partial batch.
+#define MMSG_CHUNK 64
 
 /// This is the value recommended by the Cyphal/UDP specification.
 #define OVERRIDE_TTL 16
@@ -28,18 +59,118 @@
 /// RFC 2474.
 #define DSCP_MAX 63
 
+#ifndef _GNU_SOURCE // Otherwise, provided by the system headers.
 struct in_pktinfo
 {
     unsigned ipi_ifindex;  // incoming ifindex
     uint32_t ipi_spec_dst; // local destination address
     uint32_t ipi_addr;     // header source address
 };
+#endif
+
+/// The arrival timestamps are in nanoseconds where available, otherwise in microseconds; both on CLOCK_REALTIME.
+#if defined(SO_TIMESTAMPNS)
+#define RX_STAMP_OPTION SO_TIMESTAMPNS
+#define RX_STAMP_TYPE   SCM_TIMESTAMPNS
+#define RX_STAMP_SIZE   sizeof(struct timespec)
+#elif defined(SO_TIMESTAMP)
+#define RX_STAMP_OPTION SO_TIMESTAMP
+#define RX_STAMP_TYPE   SCM_TIMESTAMP
+#define RX_STAMP_SIZE   sizeof(struct timeval)
+#endif
+
+/// The size of the control buffer required to receive IP_PKTINFO and the arrival timestamp.
+#ifdef RX_STAMP_OPTION
+#define RX_CMSG_SIZE (CMSG_SPACE(sizeof(struct in_pktinfo)) + CMSG_SPACE(RX_STAMP_SIZE))
+#else
+#define RX_CMSG_SIZE CMSG_SPACE(sizeof(struct in_pktinfo))
+#endif
+
+/// Only the software timestamps are used because the hardware ones are on the clock of the NIC, not of the host.
+#if HAS_TX_STAMP
+#define TX_STAMP_FLAGS_IDLE (SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY)
+#define TX_STAMP_FLAGS_SEND (TX_STAMP_FLAGS_IDLE | SOF_TIMESTAMPING_TX_SOFTWARE)
+#endif
+
+static int64_t timespec_to_ns(const struct timespec ts)
+{
+    return (((int64_t)ts.tv_sec) * 1000000000LL) + (int64_t)ts.tv_nsec;
+}
+
+static int64_t now_monotonic_us(void)
+{
+    struct timespec ts = { 0 };
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespec_to_ns(ts) / 1000;
+}
+
+/// The kernel stamps the datagrams using the real-time clock, which is converted to the monotonic clock by
+/// subtracting this offset sampled at the time of the conversion. The error is bounded by the clock adjustments
+/// made since the datagram was stamped, which is normally negligible.
+static int64_t realtime_offset_ns(void)
+{
+    struct timespec mono = { 0 };
+    struct timespec real = { 0 };
+    (void)clock_gettime(CLOCK_MONOTONIC, &mono);
+    (void)clock_gettime(CLOCK_REALTIME, &real);
+    return timespec_to_ns(real) - timespec_to_ns(mono);
+}
+
+/// Returns a negative value if the message carries no arrival timestamp.
+static int64_t rx_timestamp(struct msghdr* const msg, const int64_t realtime_offset)
+{
+#ifdef RX_STAMP_OPTION
+    for (struct cmsghdr* c = CMSG_FIRSTHDR(msg); c; c = CMSG_NXTHDR(msg, c)) {
+        if ((c->cmsg_level == SOL_SOCKET) && (c->cmsg_type == RX_STAMP_TYPE)) {
+#if defined(SO_TIMESTAMPNS)
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+#else
+            struct timeval tv;
+            memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+            const struct timespec ts = { .tv_sec = tv.tv_sec, .tv_nsec = (long)tv.tv_usec * 1000L };
+#endif
+            return (timespec_to_ns(ts) - realtime_offset) / 1000;
+        }
+    }
+#else
+    (void)msg;
+    (void)realtime_offset;
+#endif
+    return -1;
+}
 
 static bool is_multicast(const uint32_t address)
 {
     return (address & 0xF0000000UL) == 0xE0000000UL; // NOLINT(*-magic-numbers)
 }
 
+/// Returns 1 if the received datagram shall be accepted, 0 if it is to be ignored, or a negative error code.
+/// Drops own traffic and only accepts packets from the right iface.
+static int16_t rx_filter(const udp_wrapper_rx_t* const self, struct msghdr* const msg)
+{
+    const struct in_pktinfo* pi = NULL;
+    for (struct cmsghdr* c = CMSG_FIRSTHDR(msg); c; c = CMSG_NXTHDR(msg, c)) {
+        if (c->cmsg_level == IPPROTO_IP && c->cmsg_type == IP_PKTINFO) {
+            pi = (const struct in_pktinfo*)CMSG_DATA(c);
+            break;
+        }
+    }
+    const struct sockaddr_in* const src = (const struct sockaddr_in*)msg->msg_name;
+    int16_t                         res = 1;
+    if (pi == NULL) {
+        res = -EIO;
+    } else if ((uint32_t)pi->ipi_ifindex != self->allow_iface_index) {
+        res = 0; // wrong iface -- ignore
+    } else if ((ntohl(src->sin_addr.s_addr) == self->deny_source_address) &&
+               (ntohs(src->sin_port) == self->deny_source_port)) {
+        res = 0; // own traffic -- ignore
+    } else {
+        (void)0; // accept
+    }
+    return res;
+}
+
 /// Zero on error, otherwise the interface index. Zero is not a valid interface index.
 static uint32_t get_local_iface_index(const uint32_t local_iface_address)
 {
@@ -63,7 +194,7 @@ static uint32_t get_local_iface_index(const uint32_t local_iface_address)
 
 udp_wrapper_tx_t udp_wrapper_tx_new(void)
 {
-    return (udp_wrapper_tx_t){ .fd = -1 };
+    return (udp_wrapper_tx_t){ .fd = -1, .stamp_head = 0, .stamp_count = 0, .stamp_kernel = false };
 }
 udp_wrapper_rx_t udp_wrapper_rx_new(void)
 {
@@ -108,6 +239,17 @@ int16_t udp_wrapper_tx_init(udp_wrapper_tx_t* const self,
         ok = ok && setsockopt(self->fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == 0;
         // Specify the egress interface for multicast traffic.
         ok = ok && setsockopt(self->fd, IPPROTO_IP, IP_MULTICAST_IF, &local_iface_be, sizeof(local_iface_be)) == 0;
+        // The timestamps are only generated while sending the stamped datagrams; this only enables the reporting.
+        // Keeping OPT_ID enabled throughout ensures that the kernel does not reset the key counter. Best effort.
+        self->stamp_head        = 0;
+        self->stamp_count       = 0;
+        self->stamp_key_next    = 0;
+        self->stamp_outstanding = 0;
+        self->stamp_kernel      = false;
+#if HAS_TX_STAMP
+        const int stamp_flags = TX_STAMP_FLAGS_IDLE;
+        self->stamp_kernel = ok && (setsockopt(self->fd, SOL_SOCKET, SO_TIMESTAMPING, &stamp_flags, sizeof(int)) == 0);
+#endif
         if (ok) {
             res = 0;
         } else {
@@ -150,6 +292,161 @@ int16_t udp_wrapper_tx_send(udp_wrapper_tx_t* const self,
     return res;
 }
 
+/// The oldest datagram is forgotten if the ring is full; its report will be ignored.
+static void tx_stamp_push(udp_wrapper_tx_t* const self, const uint32_t tag)
+{
+    if (self->stamp_count >= UDP_WRAPPER_TX_STAMP_CAPACITY) {
+        self->stamp_head = (uint8_t)((self->stamp_head + 1U) % UDP_WRAPPER_TX_STAMP_CAPACITY);
+        self->stamp_count--;
+    }
+    const size_t idx      = (self->stamp_head + self->stamp_count) % UDP_WRAPPER_TX_STAMP_CAPACITY;
+    self->stamps[idx].tag = tag;
+    self->stamps[idx].key = self->stamp_key_next++;
+    self->stamps[idx].ts  = self->stamp_kernel ? -1 : now_monotonic_us();
+    self->stamp_count++;
+    self->stamp_outstanding += self->stamp_kernel ? 1U : 0U;
+}
+
+int16_t udp_wrapper_tx_send_batch(udp_wrapper_tx_t* const                self,
+                                  const size_t                           count,
+                                  const udp_wrapper_tx_datagram_t* const dgrams)
+{
+    int16_t res = -EINVAL;
+    if ((self != NULL) && (self->fd >= 0) && (count > 0) && (dgrams != NULL) && (dgrams[0].dscp <= DSCP_MAX)) {
+        // The DSCP is a socket option, so only the leading run of datagrams sharing the same DSCP can be sent at once.
+        // The same goes for the timestamping: a stamped datagram is sent alone.
+        const bool stamped = dgrams[0].stamp_tag != 0;
+        size_t     n       = 0;
+        while ((n < count) && (n < MMSG_CHUNK) && (dgrams[n].dscp == dgrams[0].dscp) &&
+               ((n == 0) || (!stamped && (dgrams[n].stamp_tag == 0)))) {
+            if ((dgrams[n].remote_address == 0) || (dgrams[n].remote_port == 0) || (dgrams[n].payload == NULL)) {
+                return -EINVAL;
+            }
+            n++;
+        }
+        const int dscp_int = dgrams[0].dscp << 2U; // The 2 least significant bits are used for the ECN field.
+        (void)setsockopt(self->fd, IPPROTO_IP, IP_TOS, &dscp_int, sizeof(dscp_int)); // Best effort.
+#if HAS_TX_STAMP
+        if (stamped && self->stamp_kernel) {
+            const int flags = TX_STAMP_FLAGS_SEND;
+            (void)setsockopt(self->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+        }
+#endif
+        struct sockaddr_in addr[MMSG_CHUNK];
+        struct iovec       iov[MMSG_CHUNK];
+        for (size_t i = 0; i < n; i++) {
+            addr[i] = (struct sockaddr_in){ .sin_family = AF_INET,
+                                            .sin_addr   = { .s_addr = htonl(dgrams[i].remote_address) },
+                                            .sin_port   = htons(dgrams[i].remote_port) };
+            iov[i]  = (struct iovec){ .iov_base = (void*)dgrams[i].payload, .iov_len = dgrams[i].payload_size };
+        }
+#if HAS_MMSG
+        struct mmsghdr msg[MMSG_CHUNK];
+        for (size_t i = 0; i < n; i++) {
+            msg[i] = (struct mmsghdr){ .msg_hdr = { .msg_name    = &addr[i],
+                                                    .msg_namelen = sizeof(struct sockaddr_in),
+                                                    .msg_iov     = &iov[i],
+                                                    .msg_iovlen  = 1 } };
+        }
+        const int sent = sendmmsg(self->fd, msg, (unsigned)n, MSG_DONTWAIT);
+        const int err  = errno;
+#else
+        int sent = 0;
+        while ((size_t)sent < n) {
+            const struct msghdr msg = { .msg_name    = &addr[sent],
+                                        .msg_namelen = sizeof(struct sockaddr_in),
+                                        .msg_iov     = &iov[sent],
+                                        .msg_iovlen  = 1 };
+            if (sendmsg(self->fd, &msg, MSG_DONTWAIT) < 0) {
+                sent = (sent > 0) ? sent : -1; // Report the error only if nothing was sent; otherwise retry later.
+                break;
+            }
+            sent++;
+        }
+        const int err = errno;
+#endif
+#if HAS_TX_STAMP
+        if (stamped && self->stamp_kernel) {
+            const int flags = TX_STAMP_FLAGS_IDLE;
+            (void)setsockopt(self->fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+        }
+#endif
+        if (stamped && (sent > 0)) {
+            tx_stamp_push(self, dgrams[0].stamp_tag);
+        }
+        if (sent > 0) {
+            res = (int16_t)sent;
+        } else if ((err == EAGAIN) || (err == EWOULDBLOCK)) {
+            res = 0;
+        } else {
+            res = (int16_t)-err;
+        }
+    }
+    return res;
+}
+
+int16_t udp_wrapper_tx_stamp(udp_wrapper_tx_t* const self, uint32_t* const out_tag, int64_t* const out_ts)
+{
+    if ((self == NULL) || (self->fd < 0) || (out_tag == NULL) || (out_ts == NULL)) {
+        return -EINVAL;
+    }
+#if HAS_TX_STAMP
+    while (self->stamp_kernel && (self->stamp_outstanding > 0)) {
+        char          cbuf[CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct sock_extended_err))];
+        struct msghdr msg = { .msg_control = cbuf, .msg_controllen = sizeof(cbuf) };
+        if (recvmsg(self->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                return (int16_t)-errno;
+            }
+            if (self->stamp_count == 0) {
+                self->stamp_outstanding = 0; // The reports remaining in the queue, if any, are no longer needed.
+            }
+            break;
+        }
+        self->stamp_outstanding--;
+        const struct scm_timestamping*  stamp = NULL;
+        const struct sock_extended_err* ext   = NULL;
+        for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+            if ((c->cmsg_level == SOL_SOCKET) && (c->cmsg_type == SCM_TIMESTAMPING)) {
+                stamp = (const struct scm_timestamping*)CMSG_DATA(c);
+            } else if ((c->cmsg_level == IPPROTO_IP) && (c->cmsg_type == IP_RECVERR)) {
+                ext = (const struct sock_extended_err*)CMSG_DATA(c);
+            } else {
+                (void)0; // Not relevant.
+            }
+        }
+        if ((stamp == NULL) || (ext == NULL) || (ext->ee_origin != SO_EE_ORIGIN_TIMESTAMPING)) {
+            continue;
+        }
+        // Match the key; the older datagrams whose reports were lost are dropped.
+        const int64_t ts = (timespec_to_ns(stamp->ts[0]) - realtime_offset_ns()) / 1000;
+        while (self->stamp_count > 0) {
+            const uint32_t key = self->stamps[self->stamp_head].key;
+            if ((int32_t)(ext->ee_data - key) < 0) {
+                break; // The report is for a datagram already dropped.
+            }
+            if (key == ext->ee_data) {
+                self->stamps[self->stamp_head].ts = ts;
+                break;
+            }
+            self->stamp_head = (uint8_t)((self->stamp_head + 1U) % UDP_WRAPPER_TX_STAMP_CAPACITY);
+            self->stamp_count--;
+        }
+        if ((self->stamp_count > 0) && (self->stamps[self->stamp_head].ts >= 0)) {
+            break;
+        }
+    }
+#endif
+    if ((self->stamp_count > 0) && (self->stamps[self->stamp_head].ts >= 0)) {
+        *out_tag         = self->stamps[self->stamp_head].tag;
+        *out_ts          = self->stamps[self->stamp_head].ts;
+        self->stamp_head = (uint8_t)((self->stamp_head + 1U) % UDP_WRAPPER_TX_STAMP_CAPACITY);
+        self->stamp_count--;
+        return 1;
+    }
+    return 0;
+}
+
 void udp_wrapper_tx_close(udp_wrapper_tx_t* const self)
 {
     if ((self != NULL) && (self->fd >= 0)) {
@@ -162,7 +459,8 @@ int16_t udp_wrapper_rx_init(udp_wrapper_rx_t* const self,
                             const uint32_t          local_iface_address,
                             const uint32_t          multicast_group,
                             const uint16_t          remote_port,
-                            const uint16_t          deny_source_port)
+                            const uint16_t          deny_source_port,
+                            const bool              timestamping)
 {
     int16_t res = -EINVAL;
     if ((self != NULL) && (local_iface_address > 0) && is_multicast(multicast_group) && (remote_port > 0)) {
@@ -182,6 +480,13 @@ int16_t udp_wrapper_rx_init(udp_wrapper_rx_t* const self,
 #endif
         // Request extended metadata on rx so that we could only accept traffic from our own iface.
         ok = ok && (setsockopt(self->fd, IPPROTO_IP, IP_PKTINFO, &one, sizeof(one)) == 0);
+#ifdef RX_STAMP_OPTION
+        if (ok && timestamping) {
+            (void)setsockopt(self->fd, SOL_SOCKET, RX_STAMP_OPTION, &one, sizeof(one)); // Best effort.
+        }
+#else
+        (void)timestamping;
+#endif
         // Binding to the multicast group address is necessary on GNU/Linux: https://habr.com/ru/post/141021/
         // Binding to a multicast address is not allowed on Windows, and it is not necessary there;
         // instead, one should bind to INADDR_ANY with the specific port.
@@ -212,13 +517,31 @@ int16_t udp_wrapper_rx_init(udp_wrapper_rx_t* const self,
     return res;
 }
 
-int16_t udp_wrapper_rx_receive(udp_wrapper_rx_t* const self, size_t* const inout_payload_size, void* const out_payload)
+int16_t udp_wrapper_rx_busy_poll(udp_wrapper_rx_t* const self, const uint32_t budget_us)
+{
+    int16_t res = -EINVAL;
+    if ((self != NULL) && (self->fd >= 0) && (budget_us <= INT_MAX)) {
+#ifdef SO_BUSY_POLL // Linux
+        const int value = (int)budget_us;
+        const int rc    = setsockopt(self->fd, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value));
+        res             = (rc == 0) ? 0 : (int16_t)-errno;
+#else
+        res = -ENOTSUP;
+#endif
+    }
+    return res;
+}
+
+int16_t udp_wrapper_rx_receive(udp_wrapper_rx_t* const self,
+                               size_t* const           inout_payload_size,
+                               void* const             out_payload,
+                               int64_t* const          out_timestamp)
 {
     int16_t res = -EINVAL;
     if ((self != NULL) && (self->fd >= 0) && (inout_payload_size != NULL) && (out_payload != NULL)) {
         struct sockaddr_in src = { 0 };
         struct iovec       iov = { .iov_base = out_payload, .iov_len = *inout_payload_size };
-        char               cbuf[CMSG_SPACE(sizeof(struct in_pktinfo))];
+        _Alignas(struct cmsghdr) char cbuf[RX_CMSG_SIZE];
         struct msghdr      msg = { .msg_name       = &src,
                                    .msg_namelen    = sizeof(src),
                                    .msg_iov        = &iov,
@@ -227,25 +550,85 @@ int16_t udp_wrapper_rx_receive(udp_wrapper_rx_t* const self, size_t* const inout
                                    .msg_controllen = sizeof(cbuf) };
         const ssize_t      n   = recvmsg(self->fd, &msg, MSG_DONTWAIT);
         if (n >= 0) {
-            // locate IP_PKTINFO
-            struct in_pktinfo* pi = NULL;
-            for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
-                if (c->cmsg_level == IPPROTO_IP && c->cmsg_type == IP_PKTINFO) {
-                    pi = (struct in_pktinfo*)CMSG_DATA(c);
-                    break;
-                }
-            }
-            // drop out own traffic and only accept packets from the right iface.
-            if (pi == NULL) {
-                res = -EIO;
-            } else if (pi->ipi_ifindex != self->allow_iface_index) {
-                res = 0; // wrong iface -- ignore
-            } else if ((ntohl(src.sin_addr.s_addr) == self->deny_source_address) &&
-                       (ntohs(src.sin_port) == self->deny_source_port)) {
-                res = 0; // own traffic -- ignore
-            } else {
+            res = rx_filter(self, &msg);
+            if (res > 0) {
                 *inout_payload_size = (size_t)n;
-                res                 = 1;
+            }
+            if (out_timestamp != NULL) {
+                *out_timestamp = rx_timestamp(&msg, realtime_offset_ns());
+            }
+        } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            res = 0;
+        } else {
+            res = (int16_t)-errno;
+        }
+    }
+    return res;
+}
+
+int16_t udp_wrapper_rx_receive_batch(udp_wrapper_rx_t* const self,
+                                     const size_t            count,
+                                     size_t* const           inout_payload_sizes,
+                                     void* const* const      out_payloads,
+                                     int64_t* const          out_timestamps,
+                                     uint16_t* const         out_local_source_ports)
+{
+    int16_t res = -EINVAL;
+    if ((self != NULL) && (self->fd >= 0) && (count > 0) && (inout_payload_sizes != NULL) && (out_payloads != NULL)) {
+        const size_t       n = (count < MMSG_CHUNK) ? count : MMSG_CHUNK;
+        struct sockaddr_in src[MMSG_CHUNK];
+        struct iovec       iov[MMSG_CHUNK];
+        _Alignas(struct cmsghdr) char cbuf[MMSG_CHUNK][RX_CMSG_SIZE];
+        struct msghdr      hdr[MMSG_CHUNK];
+        for (size_t i = 0; i < n; i++) {
+            if (out_payloads[i] == NULL) {
+                return -EINVAL;
+            }
+            iov[i] = (struct iovec){ .iov_base = out_payloads[i], .iov_len = inout_payload_sizes[i] };
+            hdr[i] = (struct msghdr){ .msg_name       = &src[i],
+                                      .msg_namelen    = sizeof(struct sockaddr_in),
+                                      .msg_iov        = &iov[i],
+                                      .msg_iovlen     = 1,
+                                      .msg_control    = cbuf[i],
+                                      .msg_controllen = sizeof(cbuf[i]) };
+        }
+        size_t sizes[MMSG_CHUNK];
+#if HAS_MMSG
+        struct mmsghdr msg[MMSG_CHUNK];
+        for (size_t i = 0; i < n; i++) {
+            msg[i] = (struct mmsghdr){ .msg_hdr = hdr[i], .msg_len = 0 };
+        }
+        const int received = recvmmsg(self->fd, msg, (unsigned)n, MSG_DONTWAIT, NULL);
+        for (int i = 0; i < received; i++) {
+            hdr[i]   = msg[i].msg_hdr; // The kernel updates the lengths of the name and control data.
+            sizes[i] = msg[i].msg_len;
+        }
+#else
+        int received = 0;
+        while ((size_t)received < n) {
+            const ssize_t r = recvmsg(self->fd, &hdr[received], MSG_DONTWAIT);
+            if (r < 0) {
+                received = (received > 0) ? received : -1; // Report the error only if nothing was received.
+                break;
+            }
+            sizes[received] = (size_t)r;
+            received++;
+        }
+#endif
+        if (received >= 0) {
+            res = (int16_t)received;
+            // The offset is sampled once per batch; it is only used if the timestamps are requested.
+            const int64_t realtime_offset = (out_timestamps != NULL) ? realtime_offset_ns() : 0;
+            for (int i = 0; i < received; i++) {
+                const int16_t accept   = rx_filter(self, &hdr[i]);
+                inout_payload_sizes[i] = (accept > 0) ? sizes[i] : 0;
+                if (out_timestamps != NULL) {
+                    out_timestamps[i] = rx_timestamp(&hdr[i], realtime_offset);
+                }
+                if (out_local_source_ports != NULL) {
+                    const bool local = ntohl(src[i].sin_addr.s_addr) == self->deny_source_address;
+                    out_local_source_ports[i] = local ? ntohs(src[i].sin_port) : 0U;
+                }
             }
         } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
             res = 0;
@@ -314,6 +697,203 @@ int16_t udp_wrapper_wait(const int64_t            timeout_us,
     return res;
 }
 
+udp_wrapper_mux_t udp_wrapper_mux_new(void)
+{
+    return (udp_wrapper_mux_t){ .fd = -1 };
+}
+
+bool udp_wrapper_mux_is_initialized(const udp_wrapper_mux_t* const self)
+{
+    return self->fd >= 0;
+}
+
+int16_t udp_wrapper_mux_init(udp_wrapper_mux_t* const self)
+{
+    int16_t res = -EINVAL;
+    if (self != NULL) {
+#if MUX_EPOLL
+        self->fd = epoll_create1(EPOLL_CLOEXEC);
+#else
+        self->fd = kqueue();
+#endif
+        res = (self->fd >= 0) ? 0 : (int16_t)-errno;
+    }
+    return res;
+}
+
+void udp_wrapper_mux_close(udp_wrapper_mux_t* const self)
+{
+    if ((self != NULL) && (self->fd >= 0)) {
+        (void)close(self->fd);
+        self->fd = -1;
+    }
+}
+
+/// Adds or removes the read or write interest for the specified descriptor.
+static int16_t mux_control(udp_wrapper_mux_t* const self,
+                           const int                fd,
+                           void* const              user,
+                           const bool               write,
+                           const bool               enable)
+{
+    int16_t res = -EINVAL;
+    if ((self != NULL) && (self->fd >= 0) && (fd >= 0)) {
+#if MUX_EPOLL
+        // A non-NULL event is required for EPOLL_CTL_DEL by kernels older than 2.6.9.
+        struct epoll_event ev = { .events = write ? EPOLLOUT : EPOLLIN, .data = { .ptr = user } };
+        const int          ok = epoll_ctl(self->fd, enable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &ev);
+#else
+        struct kevent ev;
+        EV_SET(&ev, fd, write ? EVFILT_WRITE : EVFILT_READ, enable ? EV_ADD : EV_DELETE, 0, 0, user);
+        const int ok = kevent(self->fd, &ev, 1, NULL, 0, NULL);
+#endif
+        res = (ok == 0) ? 0 : (int16_t)-errno;
+    }
+    return res;
+}
+
+int16_t udp_wrapper_mux_rx_add(udp_wrapper_mux_t* const self, const udp_wrapper_rx_t* const rx, void* const user)
+{
+    return (rx != NULL) ? mux_control(self, rx->fd, user, false, true) : -EINVAL;
+}
+
+void udp_wrapper_mux_rx_remove(udp_wrapper_mux_t* const self, const udp_wrapper_rx_t* const rx)
+{
+    if ((rx != NULL) && (rx->fd >= 0)) {
+        (void)mux_control(self, rx->fd, NULL, false, false);
+    }
+}
+
+int16_t udp_wrapper_mux_tx_await(udp_wrapper_mux_t* const      self,
+                                 const udp_wrapper_tx_t* const tx,
+                                 void* const                   user,
+                                 const bool                    writable)
+{
+    return (tx != NULL) ? mux_control(self, tx->fd, user, true, writable) : -EINVAL;
+}
+
+int16_t udp_wrapper_mux_signal_add(udp_wrapper_mux_t* const          self,
+                                   const udp_wrapper_signal_t* const sig,
+                                   void* const                       user)
+{
+    return (sig != NULL) ? mux_control(self, sig->fd_read, user, false, true) : -EINVAL;
+}
+
+void udp_wrapper_mux_signal_remove(udp_wrapper_mux_t* const self, const udp_wrapper_signal_t* const sig)
+{
+    if ((sig != NULL) && (sig->fd_read >= 0)) {
+        (void)mux_control(self, sig->fd_read, NULL, false, false);
+    }
+}
+
+int16_t udp_wrapper_mux_wait(udp_wrapper_mux_t* const       self,
+                             const int64_t                  timeout_us,
+                             const size_t                   capacity,
+                             udp_wrapper_mux_event_t* const out_events)
+{
+    int16_t res = -EINVAL;
+    if ((self != NULL) && (self->fd >= 0) && (out_events != NULL) && (capacity > 0)) {
+        const int     max_events = (int)((capacity < MUX_WAIT_CHUNK) ? capacity : MUX_WAIT_CHUNK);
+        const int64_t timeout    = (timeout_us > 0) ? timeout_us : 0;
+#if MUX_EPOLL
+        // The timeout is rounded up; otherwise, the caller would spin for up to 1 ms before every deadline.
+        struct epoll_event evs[MUX_WAIT_CHUNK];
+        const int64_t      timeout_ms = (timeout / 1000) + (((timeout % 1000) != 0) ? 1 : 0);
+        const int          n =
+          epoll_wait(self->fd, evs, max_events, (int)((timeout_ms > INT_MAX) ? INT_MAX : timeout_ms));
+        for (int i = 0; i < n; i++) {
+            const bool failed     = (evs[i].events & (EPOLLERR | EPOLLHUP)) != 0; // NOLINT(*-signed-bitwise)
+            out_events[i].user     = evs[i].data.ptr;
+            out_events[i].readable = failed || ((evs[i].events & EPOLLIN) != 0);  // NOLINT(*-signed-bitwise)
+            out_events[i].writable = failed || ((evs[i].events & EPOLLOUT) != 0); // NOLINT(*-signed-bitwise)
+        }
+#else
+        struct kevent         evs[MUX_WAIT_CHUNK];
+        const struct timespec ts = { .tv_sec  = (time_t)(timeout / 1000000),
+                                     .tv_nsec = (long)((timeout % 1000000) * 1000) };
+        const int             n  = kevent(self->fd, NULL, 0, evs, max_events, &ts);
+        for (int i = 0; i < n; i++) {
+            const bool failed      = (evs[i].flags & EV_ERROR) != 0;
+            out_events[i].user     = evs[i].udata;
+            out_events[i].readable = failed || (evs[i].filter == EVFILT_READ);
+            out_events[i].writable = failed || (evs[i].filter == EVFILT_WRITE);
+        }
+#endif
+        if (n >= 0) {
+            res = (int16_t)n;
+        } else if (errno == EINTR) {
+            res = 0; // Interrupted by a signal -- not an error, there are simply no events to report.
+        } else {
+            res = (int16_t)-errno;
+        }
+    }
+    return res;
+}
+
+udp_wrapper_signal_t udp_wrapper_signal_new(void)
+{
+    return (udp_wrapper_signal_t){ .fd_read = -1, .fd_write = -1 };
+}
+
+bool udp_wrapper_signal_is_initialized(const udp_wrapper_signal_t* const self)
+{
+    return (self->fd_read >= 0) && (self->fd_write >= 0);
+}
+
+int16_t udp_wrapper_signal_init(udp_wrapper_signal_t* const self)
+{
+    int16_t res = -EINVAL;
+    if (self != NULL) {
+        int  fds[2] = { -1, -1 };
+        bool ok     = pipe(fds) == 0;
+        res         = ok ? 0 : (int16_t)-errno;
+        // Both ends are non-blocking: a full pipe means that the signal is already raised, which is all we need.
+        for (size_t i = 0; ok && (i < 2); i++) {
+            ok = (fcntl(fds[i], F_SETFL, O_NONBLOCK) == 0) && (fcntl(fds[i], F_SETFD, FD_CLOEXEC) == 0);
+            if (!ok) {
+                res = (int16_t)-errno;
+                (void)close(fds[0]);
+                (void)close(fds[1]);
+            }
+        }
+        self->fd_read  = ok ? fds[0] : -1;
+        self->fd_write = ok ? fds[1] : -1;
+    }
+    return res;
+}
+
+void udp_wrapper_signal_raise(udp_wrapper_signal_t* const self)
+{
+    if ((self != NULL) && (self->fd_write >= 0)) {
+        const unsigned char token = 1;
+        if (write(self->fd_write, &token, 1) < 0) {
+            (void)0; // EAGAIN means that the pipe is full, so the signal is already raised. Nothing to do.
+        }
+    }
+}
+
+void udp_wrapper_signal_clear(udp_wrapper_signal_t* const self)
+{
+    if ((self != NULL) && (self->fd_read >= 0)) {
+        unsigned char sink[64];
+        while (read(self->fd_read, sink, sizeof(sink)) > 0) {}
+    }
+}
+
+void udp_wrapper_signal_close(udp_wrapper_signal_t* const self)
+{
+    if (self != NULL) {
+        if (self->fd_read >= 0) {
+            (void)close(self->fd_read);
+        }
+        if (self->fd_write >= 0) {
+            (void)close(self->fd_write);
+        }
+        self->fd_read  = -1;
+        self->fd_write = -1;
+    }
+}
+
 uint32_t udp_wrapper_parse_iface_address(const char* const address)
 {
     uint32_t out = 0;
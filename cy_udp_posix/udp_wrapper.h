@@ -33,15 +33,35 @@ extern "C"
 #endif
 
 #ifndef __cplusplus
-typedef struct udp_wrapper_tx_t udp_wrapper_tx_t;
-typedef struct udp_wrapper_rx_t udp_wrapper_rx_t;
+typedef struct udp_wrapper_tx_t        udp_wrapper_tx_t;
+typedef struct udp_wrapper_rx_t        udp_wrapper_rx_t;
+typedef struct udp_wrapper_mux_t       udp_wrapper_mux_t;
+typedef struct udp_wrapper_mux_event_t udp_wrapper_mux_event_t;
+typedef struct udp_wrapper_tx_datagram_t udp_wrapper_tx_datagram_t;
+typedef struct udp_wrapper_signal_t    udp_wrapper_signal_t;
 #endif
 
+/// The number of datagrams per TX socket whose completion timestamps can be awaited at once.
+#define UDP_WRAPPER_TX_STAMP_CAPACITY 8U
+
 /// These definitions are highly platform-specific.
 /// Note that LibUDPard does not require the same socket to be usable for both transmission and reception.
 struct udp_wrapper_tx_t
 {
     int fd;
+    // The datagrams awaiting their completion timestamps in the order of transmission; see udp_wrapper_tx_stamp().
+    // The key is the number of stamped datagrams sent before; the kernel reports it with the timestamp.
+    struct
+    {
+        uint32_t tag;
+        uint32_t key;
+        int64_t  ts; ///< Negative until known.
+    } stamps[UDP_WRAPPER_TX_STAMP_CAPACITY];
+    uint8_t  stamp_head;
+    uint8_t  stamp_count;
+    uint32_t stamp_key_next;
+    uint32_t stamp_outstanding; ///< Kernel reports not yet read from the error queue.
+    bool     stamp_kernel;      ///< If false, the time of the hand-over to the kernel is reported instead.
 };
 struct udp_wrapper_rx_t
 {
@@ -52,6 +72,43 @@ struct udp_wrapper_rx_t
     uint16_t deny_source_port;
 };
 
+/// A persistent readiness multiplexer: epoll on GNU/Linux, kqueue on the BSD family including macOS.
+/// Unlike udp_wrapper_wait(), handles are registered once and stay registered until removed, so the cost of
+/// waiting depends only on the number of handles that are actually ready, not on the total number of handles.
+struct udp_wrapper_mux_t
+{
+    int fd;
+};
+/// The user pointer is the one that was supplied when the handle was registered.
+/// Error conditions on a handle are reported as both readable and writable to let the owner discover the error
+/// on the next I/O attempt.
+struct udp_wrapper_mux_event_t
+{
+    void* user;
+    bool  readable;
+    bool  writable;
+};
+
+/// A wakeup event that can be raised from any thread to unblock udp_wrapper_mux_wait() in another one.
+/// It is level-triggered: once raised, it is reported as readable until cleared, no matter how many times it was
+/// raised in the meantime. On POSIX this is the self-pipe trick.
+struct udp_wrapper_signal_t
+{
+    int fd_read;
+    int fd_write;
+};
+
+/// An outgoing datagram for use with udp_wrapper_tx_send_batch().
+struct udp_wrapper_tx_datagram_t
+{
+    uint32_t    remote_address;
+    uint16_t    remote_port;
+    uint8_t     dscp;
+    size_t      payload_size;
+    const void* payload;
+    uint32_t    stamp_tag; ///< If nonzero, the completion timestamp will be reported with this tag.
+};
+
 /// Helpers for constructing uninitialized handles.
 udp_wrapper_tx_t udp_wrapper_tx_new(void);
 udp_wrapper_rx_t udp_wrapper_rx_new(void);
@@ -85,6 +142,26 @@ int16_t udp_wrapper_tx_send(udp_wrapper_tx_t* const self,
                             const size_t            payload_size,
                             const void* const       payload);
 
+/// Send up to count datagrams without blocking using sendmmsg() where available, one system call per batch.
+/// Since the DSCP is a per-socket setting, only the leading datagrams that share the DSCP of the first one are sent;
+/// the batch may also be truncated to an internal limit. The caller is expected to resubmit the remainder.
+/// The timestamping is also a per-socket setting, so a datagram with a stamp tag is always sent alone and ends the
+/// batch that precedes it.
+/// Returns the number of datagrams sent (at least one), 0 if the socket is not ready for sending,
+/// or a negative error code if the first datagram could not be sent.
+int16_t udp_wrapper_tx_send_batch(udp_wrapper_tx_t* const                self,
+                                  const size_t                           count,
+                                  const udp_wrapper_tx_datagram_t* const dgrams);
+
+/// Fetches the next completion timestamp of the datagrams sent with a stamp tag, without blocking.
+/// On GNU/Linux it is the time the datagram was handed over to the network device driver, as reported by the kernel;
+/// elsewhere, or if the kernel does not support it, it is the time the datagram was accepted by the kernel.
+/// The timestamp is in microseconds on CLOCK_MONOTONIC. Should be invoked after every wait while stamps are awaited
+/// to keep the error queue of the socket empty. If more than UDP_WRAPPER_TX_STAMP_CAPACITY datagrams are awaiting
+/// their timestamps, the oldest ones are never reported.
+/// Returns 1 if a timestamp is reported, 0 if there are none available at the moment, or a negative error code.
+int16_t udp_wrapper_tx_stamp(udp_wrapper_tx_t* const self, uint32_t* const out_tag, int64_t* const out_ts);
+
 /// No effect if the argument is invalid.
 /// This function is guaranteed to invalidate the handle.
 void udp_wrapper_tx_close(udp_wrapper_tx_t* const self);
@@ -94,12 +171,20 @@ void udp_wrapper_tx_close(udp_wrapper_tx_t* const self);
 /// Most socket APIs, in particular the Berkeley sockets, require the local iface address to be known,
 /// because it is used to decide which egress port to send IGMP membership reports over.
 /// Dgrams whose source port matches the specified deny_source_port will be ignored; this is to ignore own tx dgrams.
+/// If timestamping is requested, the kernel will stamp the datagrams on arrival where supported (best effort).
 /// On error returns a negative error code.
 int16_t udp_wrapper_rx_init(udp_wrapper_rx_t* const self,
                             const uint32_t          local_iface_address,
                             const uint32_t          multicast_group,
                             const uint16_t          remote_port,
-                            const uint16_t          deny_source_port);
+                            const uint16_t          deny_source_port,
+                            const bool              timestamping);
+
+/// Set the SO_BUSY_POLL budget of the socket in microseconds: while a read finds the socket empty, the kernel polls
+/// the device queue for up to this long (once if the socket is non-blocking) instead of waiting for the interrupt.
+/// Zero restores the interrupt-driven reception. Setting a budget above the system default usually requires
+/// elevated privileges. Returns -ENOTSUP if the platform does not support busy polling, or a negative error code.
+int16_t udp_wrapper_rx_busy_poll(udp_wrapper_rx_t* const self, const uint32_t budget_us);
 
 /// Read one datagram from the socket without blocking.
 /// The size of the destination buffer is specified in inout_payload_size; it is updated to the actual size of the
@@ -108,11 +193,38 @@ int16_t udp_wrapper_rx_init(udp_wrapper_rx_t* const self,
 /// The remote address and port are reported to allow the reader filter out own datagrams that were looped back
 /// from the TX socket to the local RX sockets.
 ///
+/// The arrival timestamp, if not NULL, is set to the kernel timestamp of the datagram in microseconds on
+/// CLOCK_MONOTONIC, or to a negative value if not available, e.g., if the timestamping was not requested.
+///
 /// Returns:
 ///     1 on success
 ///     0 if the socket is not ready for reading OR if the received dgram is a looped back own datagram
 ///     negative error code
-int16_t udp_wrapper_rx_receive(udp_wrapper_rx_t* const self, size_t* const inout_payload_size, void* const out_payload);
+int16_t udp_wrapper_rx_receive(udp_wrapper_rx_t* const self,
+                               size_t* const           inout_payload_size,
+                               void* const             out_payload,
+                               int64_t* const          out_timestamp);
+
+/// Read up to count datagrams without blocking using recvmmsg() where available, one system call per batch.
+/// The i-th datagram is stored into out_payloads[i], whose capacity is given in inout_payload_sizes[i].
+/// Upon return, the sizes of the consumed buffers are updated to the sizes of the received datagrams;
+/// zero size means that the datagram was consumed but dropped by the filters (looped back own datagram, wrong iface).
+/// The arrival timestamps, if not NULL, are populated as in udp_wrapper_rx_receive().
+/// The local source ports, if not NULL, are set to the source port of each datagram that was sent from the local
+/// iface address, and to zero for the datagrams from other hosts; this allows attributing the looped back datagrams
+/// to the local TX sockets that sent them when the socket does not filter them out (zero deny_source_port).
+/// The batch may be truncated to an internal limit.
+///
+/// Returns:
+///     the number of consumed buffers, at least one
+///     0 if the socket is not ready for reading
+///     negative error code
+int16_t udp_wrapper_rx_receive_batch(udp_wrapper_rx_t* const self,
+                                     const size_t            count,
+                                     size_t* const           inout_payload_sizes,
+                                     void* const* const      out_payloads,
+                                     int64_t* const          out_timestamps,
+                                     uint16_t* const         out_local_source_ports);
 
 /// No effect if the argument is invalid.
 /// This function is guaranteed to invalidate the handle.
@@ -137,6 +249,74 @@ int16_t udp_wrapper_wait(const int64_t            timeout_us,
                          const size_t             rx_count,
                          udp_wrapper_rx_t** const rx);
 
+/// Helper for constructing an uninitialized handle.
+udp_wrapper_mux_t udp_wrapper_mux_new(void);
+
+/// Return false unless the handle has been successfully initialized and not yet closed.
+bool udp_wrapper_mux_is_initialized(const udp_wrapper_mux_t* const self);
+
+/// Create the kernel event queue. On error returns a negative error code.
+int16_t udp_wrapper_mux_init(udp_wrapper_mux_t* const self);
+
+/// No effect if the argument is invalid. Registered handles are not closed.
+/// This function is guaranteed to invalidate the handle.
+void udp_wrapper_mux_close(udp_wrapper_mux_t* const self);
+
+/// Register an RX handle for read readiness. The user pointer will be reported with every readiness event.
+/// The handle shall be removed from the multiplexer before it is closed.
+/// On error returns a negative error code.
+int16_t udp_wrapper_mux_rx_add(udp_wrapper_mux_t* const self, const udp_wrapper_rx_t* const rx, void* const user);
+
+/// Unregister an RX handle. No effect if the handle is not registered or is not initialized.
+void udp_wrapper_mux_rx_remove(udp_wrapper_mux_t* const self, const udp_wrapper_rx_t* const rx);
+
+/// Enable or disable the write readiness monitoring for a TX handle.
+/// A TX socket is nearly always writable, so the interest should only be enabled while there is something to send;
+/// otherwise, the wait will return immediately. The interest shall be disabled before the handle is closed.
+/// On error returns a negative error code.
+int16_t udp_wrapper_mux_tx_await(udp_wrapper_mux_t* const      self,
+                                 const udp_wrapper_tx_t* const tx,
+                                 void* const                   user,
+                                 const bool                    writable);
+
+/// Register a signal for read readiness; the event is reported as readable while the signal is raised.
+/// The signal shall be removed from the multiplexer before it is closed.
+/// On error returns a negative error code.
+int16_t udp_wrapper_mux_signal_add(udp_wrapper_mux_t* const          self,
+                                   const udp_wrapper_signal_t* const sig,
+                                   void* const                       user);
+
+/// Unregister a signal. No effect if the signal is not registered or is not initialized.
+void udp_wrapper_mux_signal_remove(udp_wrapper_mux_t* const self, const udp_wrapper_signal_t* const sig);
+
+/// Suspend execution until the expiration of the timeout (in microseconds) or until any of the registered handles
+/// become ready. Up to capacity events are stored into out_events; the remaining events, if any, will be reported
+/// by the next call. The function may return earlier than the timeout even if no handles are ready.
+/// Returns the number of events stored, or a negative error code.
+int16_t udp_wrapper_mux_wait(udp_wrapper_mux_t* const       self,
+                             const int64_t                  timeout_us,
+                             const size_t                   capacity,
+                             udp_wrapper_mux_event_t* const out_events);
+
+/// Helper for constructing an uninitialized handle.
+udp_wrapper_signal_t udp_wrapper_signal_new(void);
+
+/// Return false unless the handle has been successfully initialized and not yet closed.
+bool udp_wrapper_signal_is_initialized(const udp_wrapper_signal_t* const self);
+
+/// The signal is initially cleared. On error returns a negative error code.
+int16_t udp_wrapper_signal_init(udp_wrapper_signal_t* const self);
+
+/// Non-blocking and safe to invoke from any thread; raising an already raised signal has no effect.
+void udp_wrapper_signal_raise(udp_wrapper_signal_t* const self);
+
+/// Non-blocking. Raises that happen after this call are not lost; they will be reported by the multiplexer.
+void udp_wrapper_signal_clear(udp_wrapper_signal_t* const self);
+
+/// No effect if the argument is invalid.
+/// This function is guaranteed to invalidate the handle.
+void udp_wrapper_signal_close(udp_wrapper_signal_t* const self);
+
 /// Convert an interface address from string to binary representation; e.g., "127.0.0.1" --> 0x7F000001.
 /// Returns zero if the address is not recognized.
 uint32_t udp_wrapper_parse_iface_address(const char* const address);
@@ -0,0 +1,364 @@
+/// Simulates a large network of Cy nodes in one process over the loopback bus and reports how fast the topic
+/// allocation and the node-ID assignment converge, and at what gossip traffic cost.
+///
+/// Usage: loopback_sim [key=value ...]; see load_config() for the keys. The report is a single JSON line in stdout;
+/// the progress is reported in stderr once per simulated second. With trace=1, the Cy trace goes to stderr as well.
+///
+/// The network is considered converged when all nodes have a node-ID, the node-IDs are unique, every topic has the
+/// same eviction counter on all nodes that know it, and no subject-ID is taken by more than one topic hash.
+/// The simulation stops when the network has stayed converged for the settle time or when the duration runs out.
+
+#include "cy_loopback.h"
+#include <time.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MEGA 1000000LL
+
+struct config_t
+{
+    size_t  node_count;
+    size_t  topic_count;     ///< The number of distinct topic names in the network.
+    size_t  topics_per_node; ///< Each node advertises this many topics, spread uniformly over the topic names.
+    bool    pnp;             ///< Use the automatic node-ID allocation instead of assigning the node-IDs explicitly.
+    cy_us_t duration;
+    cy_us_t settle;
+    cy_us_t check_period;
+    bool    trace;
+
+    cy_loopback_bus_config_t bus;
+};
+
+static bool g_trace = false;
+
+void cy_trace(cy_t* const         cy,
+              const char* const   file,
+              const uint_fast16_t line,
+              const char* const   func,
+              const char* const   format,
+              ...)
+{
+    (void)file;
+    if (g_trace) {
+        const cy_us_t now = cy_now(cy);
+        fprintf(stderr,
+                "CY(%016llx %05lld.%06lld) %04u:%s: ",
+                (unsigned long long)cy->uid,
+                (long long)(now / MEGA),
+                (long long)(now % MEGA),
+                (unsigned)line,
+                func);
+        va_list args;
+        va_start(args, format);
+        (void)vfprintf(stderr, format, args);
+        va_end(args);
+        (void)fputc('\n', stderr);
+    }
+}
+
+static cy_us_t parse_seconds(const char* const value)
+{
+    return (cy_us_t)(strtod(value, NULL) * (double)MEGA);
+}
+
+static struct config_t load_config(const int argc, char* argv[])
+{
+    struct config_t cfg = {
+        .node_count      = 100,
+        .topic_count     = 500,
+        .topics_per_node = 50,
+        .pnp             = false,
+        .duration        = 600 * MEGA,
+        .settle          = 10 * MEGA,
+        .check_period    = 100000,
+        .trace           = false,
+        .bus             = cy_loopback_bus_config_default(),
+    };
+    for (int i = 1; i < argc; i++) {
+        char* const key   = argv[i];
+        char* const q     = strchr(key, '=');
+        const char* value = "";
+        if (q != NULL) {
+            *q    = '\0';
+            value = q + 1;
+        }
+        if (strcmp(key, "nodes") == 0) {
+            cfg.node_count = strtoul(value, NULL, 0);
+        } else if (strcmp(key, "topics") == 0) {
+            cfg.topic_count = strtoul(value, NULL, 0);
+        } else if (strcmp(key, "topics_per_node") == 0) {
+            cfg.topics_per_node = strtoul(value, NULL, 0);
+        } else if (strcmp(key, "pnp") == 0) {
+            cfg.pnp = strtoul(value, NULL, 0) != 0;
+        } else if (strcmp(key, "duration") == 0) {
+            cfg.duration = parse_seconds(value);
+        } else if (strcmp(key, "settle") == 0) {
+            cfg.settle = parse_seconds(value);
+        } else if (strcmp(key, "trace") == 0) {
+            cfg.trace = strtoul(value, NULL, 0) != 0;
+        } else if (strcmp(key, "seed") == 0) {
+            cfg.bus.seed = strtoull(value, NULL, 0);
+        } else if (strcmp(key, "loss") == 0) {
+            cfg.bus.loss = strtod(value, NULL);
+        } else if (strcmp(key, "latency_min") == 0) {
+            cfg.bus.latency_min = parse_seconds(value);
+        } else if (strcmp(key, "latency_max") == 0) {
+            cfg.bus.latency_max = parse_seconds(value);
+        } else if (strcmp(key, "mtu") == 0) {
+            cfg.bus.mtu = strtoul(value, NULL, 0);
+        } else if (strcmp(key, "node_id_max") == 0) {
+            cfg.bus.node_id_max = (uint16_t)strtoul(value, NULL, 0);
+        } else if (strcmp(key, "hash_check") == 0) {
+            cfg.bus.topic_hash_check = strtoul(value, NULL, 0) != 0;
+        } else {
+            fprintf(stderr,
+                    "Unexpected key #%d: '%s'\nKnown keys: nodes topics topics_per_node pnp duration settle trace "
+                    "seed loss latency_min latency_max mtu node_id_max hash_check\n"
+                    "The durations and latencies are in seconds.\n",
+                    i,
+                    key);
+            exit(1);
+        }
+    }
+    if ((cfg.node_count == 0) || (cfg.topics_per_node > cfg.topic_count)) {
+        fprintf(stderr, "Invalid configuration\n");
+        exit(1);
+    }
+    return cfg;
+}
+
+/// Maps the topic hash to the eviction counter seen first during the current check.
+struct hash_table_t
+{
+    size_t    mask;
+    bool*     used;
+    uint64_t* hash;
+    uint64_t* evictions;
+};
+
+static struct hash_table_t hash_table_new(const size_t min_capacity)
+{
+    size_t cap = 1;
+    while (cap < (min_capacity * 2U)) {
+        cap <<= 1U;
+    }
+    const struct hash_table_t out = { .mask      = cap - 1U,
+                                      .used      = calloc(cap, sizeof(bool)),
+                                      .hash      = calloc(cap, sizeof(uint64_t)),
+                                      .evictions = calloc(cap, sizeof(uint64_t)) };
+    if ((out.used == NULL) || (out.hash == NULL) || (out.evictions == NULL)) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return out;
+}
+
+/// Returns false if the hash is already present with a different eviction counter.
+static bool hash_table_check(struct hash_table_t* const self, const uint64_t hash, const uint64_t evictions)
+{
+    size_t i = (size_t)(hash ^ (hash >> 32U)) & self->mask;
+    while (self->used[i]) {
+        if (self->hash[i] == hash) {
+            return self->evictions[i] == evictions;
+        }
+        i = (i + 1U) & self->mask;
+    }
+    self->used[i]      = true;
+    self->hash[i]      = hash;
+    self->evictions[i] = evictions;
+    return true;
+}
+
+struct checker_t
+{
+    struct hash_table_t topics;
+    bool*               subject_used;
+    uint64_t*           subject_hash;
+    bool*               node_id_used;
+};
+
+static bool is_topic_allocation_converged(struct checker_t* const self, const cy_loopback_bus_t* const bus)
+{
+    memset(self->topics.used, 0, (self->topics.mask + 1U) * sizeof(bool));
+    memset(self->subject_used, 0, CY_TOTAL_SUBJECT_COUNT * sizeof(bool));
+    for (const cy_loopback_t* node = bus->node_head; node != NULL; node = node->next) {
+        for (cy_topic_t* t = cy_topic_iter_first(&node->base); t != NULL; t = cy_topic_iter_next(t)) {
+            if (!hash_table_check(&self->topics, t->hash, t->evictions)) {
+                return false; // Divergence.
+            }
+            const uint16_t sid = cy_topic_subject_id(t);
+            if (self->subject_used[sid] && (self->subject_hash[sid] != t->hash)) {
+                return false; // Collision.
+            }
+            self->subject_used[sid] = true;
+            self->subject_hash[sid] = t->hash;
+        }
+    }
+    return true;
+}
+
+static bool is_node_id_assignment_converged(struct checker_t* const self, const cy_loopback_bus_t* const bus)
+{
+    memset(self->node_id_used, 0, ((size_t)bus->config.node_id_max + 1U) * sizeof(bool));
+    for (const cy_loopback_t* node = bus->node_head; node != NULL; node = node->next) {
+        const uint16_t nid = node->base.node_id;
+        if ((nid > bus->config.node_id_max) || self->node_id_used[nid]) {
+            return false;
+        }
+        self->node_id_used[nid] = true;
+    }
+    return true;
+}
+
+/// The time since which the condition holds continuously, or -1 if it does not hold.
+static void track(cy_us_t* const since, const bool condition, const cy_us_t now)
+{
+    if (!condition) {
+        *since = -1;
+    } else if (*since < 0) {
+        *since = now;
+    }
+}
+
+int main(const int argc, char* argv[])
+{
+    const struct config_t cfg = load_config(argc, argv);
+    g_trace                   = cfg.trace;
+
+    cy_loopback_bus_t bus;
+    if (cy_loopback_bus_new(&bus, cfg.bus) != CY_OK) {
+        fprintf(stderr, "cy_loopback_bus_new: invalid bus configuration\n");
+        return 1;
+    }
+    cy_loopback_t* const  nodes = calloc(cfg.node_count, sizeof(cy_loopback_t));
+    cy_publisher_t* const pubs  = calloc(cfg.node_count * cfg.topics_per_node, sizeof(cy_publisher_t));
+    if ((nodes == NULL) || ((pubs == NULL) && (cfg.topics_per_node > 0))) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < cfg.node_count; i++) {
+        const uint64_t uid     = (((uint64_t)UINT16_MAX) << 48U) | (uint64_t)(i + 1U);
+        const uint16_t node_id = cfg.pnp ? CY_NODE_ID_INVALID : (uint16_t)(i % ((size_t)cfg.bus.node_id_max + 1U));
+        cy_err_t       res     = cy_loopback_new(&nodes[i], &bus, uid, node_id, wkv_key("sim"));
+        if (res != CY_OK) {
+            fprintf(stderr, "cy_loopback_new: %d\n", res);
+            return 1;
+        }
+        for (size_t j = 0; j < cfg.topics_per_node; j++) {
+            char name[32];
+            (void)snprintf(name, sizeof(name), "/sim/%zu", ((i * cfg.topics_per_node) + j) % cfg.topic_count);
+            res = cy_advertise_c(&nodes[i].base, &pubs[(i * cfg.topics_per_node) + j], name, 0);
+            if (res != CY_OK) {
+                fprintf(stderr, "cy_advertise: %d\n", res);
+                return 1;
+            }
+        }
+    }
+
+    struct checker_t checker = {
+        .topics       = hash_table_new(cfg.topic_count + 1U), // Plus the heartbeat topic.
+        .subject_used = calloc(CY_TOTAL_SUBJECT_COUNT, sizeof(bool)),
+        .subject_hash = calloc(CY_TOTAL_SUBJECT_COUNT, sizeof(uint64_t)),
+        .node_id_used = calloc((size_t)cfg.bus.node_id_max + 1U, sizeof(bool)),
+    };
+    if ((checker.subject_used == NULL) || (checker.subject_hash == NULL) || (checker.node_id_used == NULL)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // Run the simulation until the network settles or the time runs out.
+    const clock_t wall_started   = clock();
+    cy_us_t       topics_since   = -1;
+    cy_us_t       node_ids_since = -1;
+    cy_us_t       all_since      = -1;
+    while (bus.now < cfg.duration) {
+        (void)cy_loopback_bus_spin_until(&bus, bus.now + cfg.check_period);
+        const bool node_ids_ok = is_node_id_assignment_converged(&checker, &bus);
+        const bool topics_ok   = is_topic_allocation_converged(&checker, &bus);
+        track(&node_ids_since, node_ids_ok, bus.now);
+        track(&topics_since, topics_ok, bus.now);
+        track(&all_since, node_ids_ok && topics_ok, bus.now);
+        if ((bus.now % MEGA) == 0) {
+            fprintf(stderr,
+                    "t=%llds node_ids=%d topics=%d heartbeat_bytes=%llu\n",
+                    (long long)(bus.now / MEGA),
+                    (int)node_ids_ok,
+                    (int)topics_ok,
+                    (unsigned long long)bus.stats.heartbeat_bytes);
+        }
+        if ((all_since >= 0) && ((bus.now - all_since) >= cfg.settle)) {
+            break;
+        }
+    }
+    const double wall_seconds = (double)(clock() - wall_started) / (double)CLOCKS_PER_SEC;
+
+    // Aggregate the per-node statistics.
+    uint64_t reallocations  = 0;
+    uint64_t evictions      = 0;
+    uint64_t collisions     = 0;
+    uint64_t divergences    = 0;
+    uint64_t nid_collisions = 0;
+    for (size_t i = 0; i < cfg.node_count; i++) {
+        cy_stats_t st;
+        cy_stats(&nodes[i].base, &st);
+        collisions += st.collisions;
+        divergences += st.divergences;
+        nid_collisions += st.node_id_collisions;
+        for (cy_topic_t* t = cy_topic_iter_first(&nodes[i].base); t != NULL; t = cy_topic_iter_next(t)) {
+            cy_topic_stats_t ts;
+            cy_topic_stats(t, &ts);
+            reallocations += ts.reallocations;
+            evictions += ts.evictions;
+        }
+    }
+
+    // The time to convergence is the start of the final converged streak.
+    const double elapsed = (double)bus.now / (double)MEGA;
+    printf("{\"nodes\":%zu,\"topics\":%zu,\"topics_per_node\":%zu,\"pnp\":%d,\"loss\":%.4f,\"seed\":%llu,"
+           "\"converged\":%d,\"convergence_s\":%.3f,\"topic_convergence_s\":%.3f,\"node_id_convergence_s\":%.3f,"
+           "\"simulated_s\":%.3f,\"wall_s\":%.3f,"
+           "\"heartbeats\":%llu,\"heartbeat_bytes\":%llu,\"heartbeat_bytes_per_node_per_s\":%.1f,"
+           "\"reallocations\":%llu,\"evictions\":%llu,\"collisions\":%llu,\"divergences\":%llu,"
+           "\"node_id_collisions\":%llu,\"deliveries\":%llu,\"losses\":%llu}\n",
+           cfg.node_count,
+           cfg.topic_count,
+           cfg.topics_per_node,
+           (int)cfg.pnp,
+           cfg.bus.loss,
+           (unsigned long long)cfg.bus.seed,
+           (int)(all_since >= 0),
+           (double)all_since / (double)MEGA,
+           (double)topics_since / (double)MEGA,
+           (double)node_ids_since / (double)MEGA,
+           elapsed,
+           wall_seconds,
+           (unsigned long long)bus.stats.heartbeat_transfers,
+           (unsigned long long)bus.stats.heartbeat_bytes,
+           (double)bus.stats.heartbeat_bytes / ((double)cfg.node_count * elapsed),
+           (unsigned long long)reallocations,
+           (unsigned long long)evictions,
+           (unsigned long long)collisions,
+           (unsigned long long)divergences,
+           (unsigned long long)nid_collisions,
+           (unsigned long long)bus.stats.deliveries,
+           (unsigned long long)bus.stats.losses);
+
+    // The bus goes first because the pending deliveries refer to the nodes.
+    cy_loopback_bus_destroy(&bus);
+    for (size_t i = 0; i < cfg.node_count; i++) {
+        cy_loopback_destroy(&nodes[i]);
+    }
+    free(nodes);
+    free(pubs);
+    free(checker.topics.used);
+    free(checker.topics.hash);
+    free(checker.topics.evictions);
+    free(checker.subject_used);
+    free(checker.subject_hash);
+    free(checker.node_id_used);
+    return (all_since >= 0) ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include "cy_udp_posix.h"
+#include "cy_bulk.h"
 #include <time.h>
 #include <stdio.h>
 #include <string.h>
@@ -10,20 +11,9 @@
 
 #define MEGA 1000000LL
 
-#define RESPONSE_TIMEOUT (3 * MEGA)
-
-struct file_read_request_t
-{
-    uint64_t read_offset;
-    uint16_t path_len;
-    char     path[256];
-};
-struct file_read_response_t
-{
-    uint32_t error;
-    uint16_t data_len;
-    uint8_t  data[256];
-};
+#define CHUNK_SIZE_DEFAULT 8192U
+#define SLOT_COUNT_DEFAULT 32U
+#define SLOT_COUNT_MAX     1024U
 
 static uint64_t random_uid(void)
 {
@@ -33,40 +23,48 @@ static uint64_t random_uid(void)
     return (((uint64_t)vid) << 48U) | (((uint64_t)pid) << 32U) | iid;
 }
 
-/// Command line arguments: namespace, file name.
-/// The read file will be written into stdout as-is.
+static void on_chunk(cy_t* const cy, cy_bulk_reader_t* const reader, const uint64_t offset, const cy_bytes_t data)
+{
+    (void)cy;
+    (void)reader;
+    (void)offset; // The chunks arrive in order, so the output is simply appended.
+    if (fwrite(data.data, 1, data.size, stdout) != data.size) {
+        err(1, "fwrite");
+    }
+}
+
+/// Command line arguments: namespace, file name, [chunk size], [requests in flight], [offset to resume from].
+/// The read file will be written into stdout as-is; the throughput is reported into stderr.
 int main(const int argc, char* argv[])
 {
     if (argc < 3) {
-        fprintf(stderr, "Usage: %s <namespace> <file>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <namespace> <file> [chunk_size] [slots] [offset]\n", argv[0]);
         return 1;
     }
     srand((unsigned)time(NULL));
-
-    // PREPARE THE FILE REQUEST OBJECT.
-    struct file_read_request_t req;
-    req.read_offset = 0;
-    req.path_len    = (uint16_t)strlen(argv[2]);
-    if (req.path_len > 256) {
-        fprintf(stderr, "File path length %u is too long\n", req.path_len);
+    const uint32_t chunk_size = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : CHUNK_SIZE_DEFAULT;
+    const size_t   slot_count = (argc > 4) ? (size_t)strtoul(argv[4], NULL, 0) : SLOT_COUNT_DEFAULT;
+    const uint64_t offset     = (argc > 5) ? (uint64_t)strtoull(argv[5], NULL, 0) : 0U;
+    if ((slot_count == 0) || (slot_count > SLOT_COUNT_MAX)) {
+        fprintf(stderr, "The slot count shall be in [1, %u]\n", SLOT_COUNT_MAX);
         return 1;
     }
-    memcpy(req.path, argv[2], req.path_len);
 
     // SET UP THE NODE. This is the only platform-specific part; the rest is platform- and transport-agnostic.
     cy_udp_posix_t cy_udp;
     cy_err_t       res = cy_udp_posix_new_c(
-      &cy_udp, random_uid(), argv[1], (uint32_t[3]){ udp_wrapper_parse_iface_address("127.0.0.1") }, 1000);
+      &cy_udp, random_uid(), argv[1], (uint32_t[3]){ udp_wrapper_parse_iface_address("127.0.0.1") }, 1000, NULL);
     if (res != CY_OK) {
         errx(res, "cy_udp_posix_new");
     }
     cy_t* const cy = &cy_udp.base;
 
-    // SET UP THE FILE READ PUBLISHER.
-    cy_publisher_t pub_file_read;
-    res = cy_advertise_c(cy, &pub_file_read, "file/read", 1024);
+    // SET UP THE FILE READER.
+    static cy_bulk_slot_t slots[SLOT_COUNT_MAX];
+    cy_bulk_reader_t      reader;
+    res = cy_bulk_reader_new(cy, &reader, wkv_key("file/read"), chunk_size, slots, slot_count);
     if (res != CY_OK) {
-        errx(res, "cy_advertise_c");
+        errx(res, "cy_bulk_reader_new");
     }
 
     // WAIT FOR THE NODE TO JOIN THE NETWORK.
@@ -80,58 +78,36 @@ int main(const int argc, char* argv[])
         }
     }
 
-    // READ THE FILE SEQUENTIALLY.
-    while (true) {
-        const cy_us_t now = cy_udp_posix_now();
-
-        // Send the request.
-        cy_future_t future;
-        cy_future_new(&future, NULL, NULL);
-        fprintf(stderr, "\nRequesting offset %llu...\n", (unsigned long long)req.read_offset);
-        res = cy_publish(cy,
-                         &pub_file_read,
-                         now + MEGA,
-                         (cy_buffer_borrowed_t){ .view = { .size = req.path_len + 10, .data = &req } },
-                         now + RESPONSE_TIMEOUT,
-                         &future);
+    // READ THE FILE. The reader keeps the requests in flight and puts the chunks in order; we just spin the loop.
+    const cy_us_t started_at = cy_udp_posix_now();
+    res                      = cy_bulk_read_start(cy, &reader, wkv_key(argv[2]), offset, on_chunk);
+    if (res != CY_OK) {
+        errx(res, "cy_bulk_read_start");
+    }
+    while (reader.state == cy_bulk_reading) {
+        res = cy_udp_posix_spin_once(&cy_udp);
         if (res != CY_OK) {
-            errx(res, "cy_publish");
-        }
-
-        // Wait for the response while spinning the event loop.
-        // We could do it asynchronously as well, but in this simple application it is easier to do it synchronously.
-        // We could also spin the loop in a background thread and use a condition variable to wake up the main thread.
-        assert(future.state == cy_future_pending);
-        while (future.state == cy_future_pending) {
-            res = cy_udp_posix_spin_once(&cy_udp);
-            if (res != CY_OK) {
-                errx(res, "cy_udp_posix_spin_once");
-            }
-        }
-        if (future.state == cy_future_response_timeout) {
-            errx(0, "Request timed out");
-        }
-        assert(future.state == cy_future_success);
-
-        // Process the next chunk.
-        struct file_read_response_t resp;
-        const size_t                resp_size =
-          cy_buffer_owned_gather(future.last_response.payload, (cy_bytes_mut_t){ .size = sizeof(resp), .data = &resp });
-        if (resp_size < 6) {
-            errx(0, "Invalid response size %zu", resp_size);
-        }
-        if (resp.error != 0) {
-            errx((int)resp.error, "Remote error");
-        }
-        if (resp.data_len > 0) {
-            fwrite(resp.data, 1, resp.data_len, stdout);
-            fflush(stdout);
-            req.read_offset += resp.data_len;
-        } else {
-            fprintf(stderr, "\nFinished transferring %llu bytes\n", (unsigned long long)req.read_offset);
-            break;
+            errx(res, "cy_udp_posix_spin_once");
         }
+        (void)cy_bulk_read_update(cy, &reader); // Publication failures are retried by the reader.
+    }
+    fflush(stdout);
+    const double elapsed = (double)(cy_udp_posix_now() - started_at) / (double)MEGA;
+    const double size    = (double)(reader.offset_delivered - offset);
+    fprintf(stderr,
+            "\n%s: %llu bytes in %.3f s, %.1f KiB/s; chunk=%u slots=%zu retries=%llu\n",
+            (reader.state == cy_bulk_done) ? "Finished" : "Failed",
+            (unsigned long long)(reader.offset_delivered - offset),
+            elapsed,
+            (elapsed > 0) ? (size / elapsed / 1024.0) : 0.0,
+            chunk_size,
+            slot_count,
+            (unsigned long long)reader.retries);
+    if (reader.state != cy_bulk_done) {
+        errx((int)(reader.error & 0xFFU),
+             "Error %08lx; resume from offset %llu",
+             (unsigned long)reader.error,
+             (unsigned long long)reader.offset_delivered);
     }
-
     return 0;
 }
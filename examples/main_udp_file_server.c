@@ -1,4 +1,5 @@
 #include "cy_udp_posix.h"
+#include "cy_bulk.h"
 #include <time.h>
 #include <stdio.h>
 #include <string.h>
@@ -17,64 +18,48 @@ static uint64_t random_uid(void)
     return (((uint64_t)vid) << 48U) | (((uint64_t)pid) << 32U) | iid;
 }
 
-/// Request schema:
-///     uint64      read_offset
-///     utf8[<=256] file_path
-/// Response schema:
-///     uint32      errno
-///     byte[<=256] data
-void on_file_read_msg(cy_t* const cy, const cy_arrival_t* const arv)
-{
-    CY_BUFFER_GATHER_ON_STACK(payload, arv->transfer->payload.base)
-    if ((payload.size < 10) || (payload.size > (256 + 2 + 8))) {
-        CY_TRACE(cy, "Malformed request: Payload size %zu is invalid", payload.size);
-        return;
-    }
-    assert(payload.data != NULL);
+/// The largest chunk the server accepts. The file served most recently is kept open because the requests for the
+/// consecutive chunks of the same file usually arrive back-to-back.
+#define CHUNK_SIZE_MAX 65536U
 
-    // Deserialize the payload.
-    uint64_t read_offset = 0;
-    memcpy(&read_offset, payload.data, 8);
-    uint16_t path_len = 0;
-    memcpy(&path_len, ((const char*)payload.data) + 8, 2);
-    char file_name[257];
-    if (path_len > 256) {
-        CY_TRACE(cy, "Malformed request: File path length %u is too long", path_len);
-        return;
+static FILE* file_open(const wkv_str_t name)
+{
+    static char  open_name[CY_BULK_NAME_MAX + 1] = { 0 };
+    static FILE* open_file                       = NULL;
+    if ((open_file == NULL) || (strlen(open_name) != name.len) || (memcmp(open_name, name.str, name.len) != 0)) {
+        if (open_file != NULL) {
+            (void)fclose(open_file);
+        }
+        memcpy(open_name, name.str, name.len);
+        open_name[name.len] = '\0';
+        open_file           = fopen(open_name, "rb");
     }
-    memcpy(file_name, ((const char*)payload.data) + 10, path_len);
-    file_name[path_len] = '\0';
-
-    // Prepare response buffer.
-    struct response_t
-    {
-        uint32_t error;
-        uint16_t data_len;
-        uint8_t  data[256];
-    } response;
-    response.data_len = 0;
+    return open_file;
+}
 
-    // Read the file, 256 bytes max, at the specified offset.
+/// Reads the requested chunk of the file; see cy_bulk.h for the protocol.
+static uint32_t on_file_read(cy_t* const             cy,
+                             cy_bulk_server_t* const server,
+                             const wkv_str_t         name,
+                             const uint64_t          offset,
+                             cy_bytes_mut_t* const   data)
+{
+    (void)server;
     errno            = 0;
-    FILE* const file = fopen(file_name, "rb");
-    if ((file != NULL) && (fseek(file, (long)read_offset, SEEK_SET) == 0)) {
-        response.data_len = (uint16_t)fread(response.data, 1, 256, file);
+    FILE* const file = file_open(name);
+    if ((file != NULL) && (fseek(file, (long)offset, SEEK_SET) == 0)) {
+        data->size = fread(data->data, 1, data->size, file);
+    } else {
+        data->size = 0;
     }
-    response.error = (uint32_t)errno;
-    (void)fclose(file);
-
-    // Send the response.
     CY_TRACE(cy,
-             "Responding to file read request: %s, offset %llu, size %u, error %u",
-             file_name,
-             (unsigned long long)read_offset,
-             response.data_len,
-             response.error);
-    (void)cy_respond(cy,
-                     arv->topic, //
-                     arv->transfer->timestamp + 1000000,
-                     arv->transfer->metadata,
-                     (cy_buffer_borrowed_t){ .view = { .data = &response, .size = response.data_len + 6 } });
+             "File read request: %.*s, offset %llu, size %zu, error %d",
+             (int)name.len,
+             name.str,
+             (unsigned long long)offset,
+             data->size,
+             errno);
+    return (uint32_t)errno;
 }
 
 /// The only command line argument is the node namespace.
@@ -88,17 +73,20 @@ int main(const int argc, char* argv[])
                                       random_uid(),
                                       (argc > 1) ? argv[1] : "~",
                                       (uint32_t[3]){ udp_wrapper_parse_iface_address("127.0.0.1") },
-                                      1000);
+                                      1000,
+                                      NULL);
     if (res != CY_OK) {
         errx(res, "cy_udp_posix_new");
     }
     cy_t* const cy = &cy_udp.base;
 
-    // SET UP THE FILE READ SUBSCRIBER.
-    cy_subscriber_t sub_file_read;
-    res = cy_subscribe_c(cy, &sub_file_read, "file/read", 1024, on_file_read_msg);
+    // SET UP THE FILE READ SERVER.
+    static unsigned char buffer[CY_BULK_RESPONSE_HEADER_SIZE + CHUNK_SIZE_MAX];
+    cy_bulk_server_t     server;
+    res = cy_bulk_server_new(
+      cy, &server, wkv_key("file/read"), (cy_bytes_mut_t){ .size = sizeof(buffer), .data = buffer }, on_file_read);
     if (res != CY_OK) {
-        errx(res, "cy_subscribe_c");
+        errx(res, "cy_bulk_server_new");
     }
 
     // SPIN THE EVENT LOOP.
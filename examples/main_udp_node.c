@@ -260,7 +260,8 @@ int main(const int argc, char* argv[])
                                                 cfg.local_uid,
                                                 cfg.namespace,
                                                 cfg.iface_address,
-                                                cfg.tx_queue_capacity_per_iface);
+                                                cfg.tx_queue_capacity_per_iface,
+                                                NULL);
         if (res != CY_OK) {
             fprintf(stderr, "cy_udp_posix_new: %d\n", res);
             return 1;
@@ -298,10 +299,10 @@ int main(const int argc, char* argv[])
     // Spin the event loop and publish the topics.
     cy_us_t next_publish_at = cy_now(cy) + 10000000;
     while (true) {
-        // The event loop spin API is platform-specific, too.
-        const cy_err_t err_spin = cy_udp_posix_spin_once(&cy_udp_posix);
+        // The event loop spin API is platform-specific, too. It sleeps until there is something to do.
+        const cy_err_t err_spin = cy_udp_posix_spin_until(&cy_udp_posix, next_publish_at);
         if (err_spin != CY_OK) {
-            fprintf(stderr, "cy_udp_posix_spin_once: %d\n", err_spin);
+            fprintf(stderr, "cy_udp_posix_spin_until: %d\n", err_spin);
             break;
         }
 